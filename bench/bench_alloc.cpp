@@ -0,0 +1,163 @@
+/**
+ * @file bench_alloc.cpp
+ *
+ * Benchmark of allocation-heavy expressions with different allocators
+ *
+ * reference computation (per call)
+ *
+ *   t1 = a + b;  t2 = t1 * a;  t3 = t2 - b;  dst = t3 + t1;
+ *
+ * each temporary being a dynamic dense matrix
+ *
+ * @author Dahua Lin
+ */
+
+#include "bench_base.h"
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/common/arena_alloc.h>
+
+using namespace lmat;
+using namespace ltest;
+using namespace lmat::bench;
+
+
+template<typename T>
+struct bench_alloc_base
+{
+	cref_matrix<T> a;
+	cref_matrix<T> b;
+	mutable ref_matrix<T> dst;
+
+	bench_alloc_base(index_t m, index_t n, const T *pa, const T* pb, T *pd)
+	: a(pa, m, n)
+	, b(pb, m, n)
+	, dst(pd, m, n) { }
+
+	size_t size() const
+	{
+		return (size_t)(a.nelems());
+	}
+
+	template<class Allocator>
+	LMAT_ENSURE_INLINE
+	void compute() const
+	{
+		typedef dense_matrix<T, 0, 0, Allocator> mat_t;
+
+		mat_t t1 = a + b;
+		mat_t t2 = t1 * a;
+		mat_t t3 = t2 - b;
+		dst = t3 + t1;
+	}
+};
+
+
+template<typename T>
+struct bench_heap_alloc : public bench_alloc_base<T>
+{
+	bench_heap_alloc(const bench_alloc_base<T>& base)
+	: bench_alloc_base<T>(base) { }
+
+	const char *name() const { return "heap-alloc"; }
+
+	void operator() () const
+	{
+		this->template compute<aligned_allocator<T> >();
+	}
+};
+
+
+template<typename T>
+struct bench_arena_alloc : public bench_alloc_base<T>
+{
+	memory_arena& arena;
+
+	bench_arena_alloc(const bench_alloc_base<T>& base, memory_arena& a)
+	: bench_alloc_base<T>(base), arena(a) { }
+
+	const char *name() const { return "arena-alloc"; }
+
+	void operator() () const
+	{
+		arena_scope s(arena);
+		this->template compute<arena_allocator<T> >();
+	}
+};
+
+
+template<typename T>
+struct bench_pool_alloc : public bench_alloc_base<T>
+{
+	memory_pool& pool;
+
+	bench_pool_alloc(const bench_alloc_base<T>& base, memory_pool& p)
+	: bench_alloc_base<T>(base), pool(p) { }
+
+	const char *name() const { return "pool-alloc"; }
+
+	void operator() () const
+	{
+		pool_scope s(pool);
+		this->template compute<pool_allocator<T> >();
+	}
+};
+
+
+index_t sizes[] = {2, 4, 8, 16, 32, 64, 128, 256 };
+const size_t nsizes = sizeof(sizes) / sizeof(index_t);
+
+
+template<typename T>
+void run_bench()
+{
+	const index_t max_siz = 256;
+
+	dense_matrix<T> a(max_siz, max_siz);
+	dense_matrix<T> b(max_siz, max_siz);
+	dense_matrix<T> d(max_siz, max_siz, zero());
+
+	fill_rand(a);
+	fill_rand(b);
+
+	memory_arena arena;
+	memory_pool pool;
+
+	std_bench_monitor mon;
+
+	for (size_t k = 0; k < nsizes; ++k)
+	{
+		index_t siz = sizes[k];
+		index_t m = siz;
+		index_t n = siz;
+		size_t pbsiz = 2000000 / size_t(m * n) + 10;
+
+		benchmark_option opt(pbsiz);
+
+		std::cout << "size = " << m << " x " << n << "\n";
+		std::cout << "=======================================\n";
+
+		bench_alloc_base<T> base(m, n, a.ptr_data(), b.ptr_data(), d.ptr_data());
+
+		run_benchmark(bench_heap_alloc<T>(base), mon, opt);
+		run_benchmark(bench_arena_alloc<T>(base, arena), mon, opt);
+		run_benchmark(bench_pool_alloc<T>(base, pool), mon, opt);
+
+		std::cout << "\n";
+	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	std::printf("On float\n");
+	std::printf("**************************************\n");
+	run_bench<float>();
+
+	std::printf("\n");
+
+	std::printf("On double\n");
+	std::printf("**************************************\n");
+	run_bench<double>();
+
+	std::printf("\n");
+}
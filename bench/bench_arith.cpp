@@ -290,7 +290,7 @@ struct bench_expr_default : public bench_arith_base<T>
 
 
 index_t max_size = 2048;
-index_t sizes[] = {4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+index_t sizes[] = {4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048 };
 const size_t nsizes = sizeof(sizes) / sizeof(index_t);
 
 
@@ -0,0 +1,173 @@
+/**
+ * @file bench_batched.cpp
+ *
+ * Benchmark of batched Cholesky factorization & solve of
+ * many small matrices
+ *
+ * - per-matrix: factorize and solve one matrix at a time
+ * - batched:    mat_batch + batch_chol + batch_chol_solve
+ *
+ * @author Dahua Lin
+ */
+
+#include "bench_base.h"
+#include <light_mat/linalg/batched_fac.h>
+
+using namespace lmat;
+using namespace ltest;
+using namespace lmat::bench;
+
+
+template<typename T>
+struct bench_chol_permat
+{
+	index_t n;
+	index_t cnt;
+	const dense_matrix<T>& as;
+	const dense_matrix<T>& bs;
+	mutable dense_matrix<T> l;
+	mutable dense_matrix<T> xs;
+
+	bench_chol_permat(index_t n_, index_t cnt_, const dense_matrix<T>& as_, const dense_matrix<T>& bs_)
+	: n(n_), cnt(cnt_), as(as_), bs(bs_), l(n_, n_), xs(n_, cnt_) { }
+
+	const char *name() const { return "per-matrix"; }
+
+	size_t size() const
+	{
+		return (size_t)cnt;
+	}
+
+	void operator() () const
+	{
+		for (index_t k = 0; k < cnt; ++k)
+		{
+			const T *a = as.ptr_data() + k * n * n;
+			const T *b = bs.ptr_data() + k * n;
+			T *x = xs.ptr_data() + k * n;
+
+			for (index_t j = 0; j < n; ++j)
+			{
+				T d = a[j * n + j];
+				for (index_t t = 0; t < j; ++t) d -= l(j, t) * l(j, t);
+				d = math::sqrt(d);
+				l(j, j) = d;
+
+				for (index_t i = j + 1; i < n; ++i)
+				{
+					T s = a[j * n + i];
+					for (index_t t = 0; t < j; ++t) s -= l(i, t) * l(j, t);
+					l(i, j) = s / d;
+				}
+			}
+
+			for (index_t i = 0; i < n; ++i)
+			{
+				T s = b[i];
+				for (index_t t = 0; t < i; ++t) s -= l(i, t) * x[t];
+				x[i] = s / l(i, i);
+			}
+
+			for (index_t i = n - 1; i >= 0; --i)
+			{
+				T s = x[i];
+				for (index_t t = i + 1; t < n; ++t) s -= l(t, i) * x[t];
+				x[i] = s / l(i, i);
+			}
+		}
+	}
+};
+
+
+template<typename T>
+struct bench_chol_batched
+{
+	const mat_batch<T>& a0;
+	const mat_batch<T>& b0;
+	mutable mat_batch<T> a;
+	mutable mat_batch<T> b;
+
+	bench_chol_batched(const mat_batch<T>& a0_, const mat_batch<T>& b0_)
+	: a0(a0_), b0(b0_)
+	, a(a0_.nrows(), a0_.ncolumns(), a0_.count())
+	, b(b0_.nrows(), b0_.ncolumns(), b0_.count()) { }
+
+	const char *name() const { return "batched"; }
+
+	size_t size() const
+	{
+		return (size_t)a0.count();
+	}
+
+	void operator() () const
+	{
+		copy_vec(a0.ngroups() * a0.group_size(), a0.ptr_group(0), a.ptr_group(0));
+		copy_vec(b0.ngroups() * b0.group_size(), b0.ptr_group(0), b.ptr_group(0));
+
+		batch_chol(a);
+		batch_chol_solve(a, b);
+	}
+};
+
+
+index_t dims[] = {2, 3, 4, 6, 8, 12};
+const size_t ndims = sizeof(dims) / sizeof(index_t);
+
+
+template<typename T>
+void run_bench()
+{
+	const index_t cnt = 10000;
+
+	std_bench_monitor mon;
+
+	for (size_t k = 0; k < ndims; ++k)
+	{
+		index_t n = dims[k];
+
+		dense_matrix<T> as(n, n * cnt);
+		dense_matrix<T> bs(n, cnt);
+		fill_rand(as);
+		fill_rand(bs);
+
+		// make each matrix positive definite
+		for (index_t c = 0; c < cnt; ++c)
+		{
+			for (index_t j = 0; j < n; ++j)
+			{
+				for (index_t i = 0; i < j; ++i)
+					as(i, c * n + j) = as(j, c * n + i);
+				as(j, c * n + j) += T(n);
+			}
+		}
+
+		mat_batch<T> a0(as, n);
+		mat_batch<T> b0(bs, 1);
+
+		benchmark_option opt(10);
+
+		std::cout << "dim = " << n << " (x " << cnt << " matrices)\n";
+		std::cout << "=======================================\n";
+
+		run_benchmark(bench_chol_permat<T>(n, cnt, as, bs), mon, opt);
+		run_benchmark(bench_chol_batched<T>(a0, b0), mon, opt);
+
+		std::cout << "\n";
+	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	std::printf("On float\n");
+	std::printf("**************************************\n");
+	run_bench<float>();
+
+	std::printf("\n");
+
+	std::printf("On double\n");
+	std::printf("**************************************\n");
+	run_bench<double>();
+
+	std::printf("\n");
+}
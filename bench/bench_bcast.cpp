@@ -0,0 +1,180 @@
+/**
+ * @file bench_bcast.cpp
+ *
+ * Benchmark of expressions over broadcast vectors
+ *
+ * - bias-add:     a + repcol(v, n), with v of length m
+ * - feature scale: a * reprow(w, m), with w of length n
+ *
+ * over m x n matrices with m from 2 to 1000 (and m * n fixed),
+ * compared against hand-written loops
+ *
+ * @author Dahua Lin
+ */
+
+#include "bench_base.h"
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/matexpr/repvec_expr.h>
+
+using namespace lmat;
+using namespace ltest;
+using namespace lmat::bench;
+
+
+template<typename T>
+struct bench_bias_loop
+{
+	const dense_matrix<T>& a;
+	const dense_col<T>& v;
+	dense_matrix<T>& r;
+
+	const char *name() const { return "bias (loop)"; }
+
+	size_t size() const
+	{
+		return (size_t)a.nelems();
+	}
+
+	void operator() () const
+	{
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+
+		for (index_t j = 0; j < n; ++j)
+		{
+			const T *pa = a.ptr_col(j);
+			T *pr = r.ptr_col(j);
+			for (index_t i = 0; i < m; ++i) pr[i] = pa[i] + v[i];
+		}
+	}
+};
+
+template<typename T>
+struct bench_bias_expr
+{
+	const dense_matrix<T>& a;
+	const dense_col<T>& v;
+	dense_matrix<T>& r;
+
+	const char *name() const { return "bias (expr)"; }
+
+	size_t size() const
+	{
+		return (size_t)a.nelems();
+	}
+
+	void operator() () const
+	{
+		r = a + repcol(v, a.ncolumns());
+	}
+};
+
+template<typename T>
+struct bench_scale_loop
+{
+	const dense_matrix<T>& a;
+	const dense_row<T>& w;
+	dense_matrix<T>& r;
+
+	const char *name() const { return "scale (loop)"; }
+
+	size_t size() const
+	{
+		return (size_t)a.nelems();
+	}
+
+	void operator() () const
+	{
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+
+		for (index_t j = 0; j < n; ++j)
+		{
+			const T *pa = a.ptr_col(j);
+			T *pr = r.ptr_col(j);
+			const T s = w[j];
+			for (index_t i = 0; i < m; ++i) pr[i] = pa[i] * s;
+		}
+	}
+};
+
+template<typename T>
+struct bench_scale_expr
+{
+	const dense_matrix<T>& a;
+	const dense_row<T>& w;
+	dense_matrix<T>& r;
+
+	const char *name() const { return "scale (expr)"; }
+
+	size_t size() const
+	{
+		return (size_t)a.nelems();
+	}
+
+	void operator() () const
+	{
+		r = a * reprow(w, a.nrows());
+	}
+};
+
+
+index_t nrows[] = {2, 3, 4, 8, 16, 31, 64, 1000};
+const size_t nnrows = sizeof(nrows) / sizeof(index_t);
+
+
+template<typename T>
+void run_bench()
+{
+	const index_t len = 60000;
+
+	std_bench_monitor mon;
+
+	for (size_t k = 0; k < nnrows; ++k)
+	{
+		const index_t m = nrows[k];
+		const index_t n = len / m;
+
+		dense_matrix<T> a(m, n);
+		dense_matrix<T> r(m, n);
+		dense_col<T> v(m);
+		dense_row<T> w(n);
+
+		fill_rand(a);
+		fill_rand(v);
+		fill_rand(w);
+
+		benchmark_option opt(10);
+
+		std::cout << "m = " << m << ", n = " << n << "\n";
+		std::cout << "=======================================\n";
+
+		bench_bias_loop<T> bl = { a, v, r };
+		bench_bias_expr<T> be = { a, v, r };
+		bench_scale_loop<T> sl = { a, w, r };
+		bench_scale_expr<T> se = { a, w, r };
+
+		run_benchmark(bl, mon, opt);
+		run_benchmark(be, mon, opt);
+		run_benchmark(sl, mon, opt);
+		run_benchmark(se, mon, opt);
+
+		std::cout << "\n";
+	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	std::printf("On float\n");
+	std::printf("**************************************\n");
+	run_bench<float>();
+
+	std::printf("\n");
+
+	std::printf("On double\n");
+	std::printf("**************************************\n");
+	run_bench<double>();
+
+	std::printf("\n");
+}
@@ -9,6 +9,7 @@
 
 #include "bench_base.h"
 #include <light_mat/mateval/mat_reduce.h>
+#include <light_mat/mateval/mat_accsum.h>
 
 using namespace lmat;
 using namespace ltest;
@@ -142,6 +143,21 @@ struct bench_full_sum_eval : public bench_fullreduc<T>
 	}
 };
 
+#define DEFINE_BENCH_FULL_ACCSUM( Mode, Name ) \
+	template<typename T> \
+	struct bench_full_sum_##Mode : public bench_fullreduc<T> { \
+		bench_full_sum_##Mode( const bench_fullreduc<T>& base ) \
+		: bench_fullreduc<T>(base) \
+		{ this->set_name(Name);  } \
+		LMAT_ENSURE_INLINE \
+		void operator() () const { \
+			T s = sum(this->a, sumacc::Mode##_()); \
+			this->force_res(s); } };
+
+DEFINE_BENCH_FULL_ACCSUM( compensated,  "full-sum-compensated" )
+DEFINE_BENCH_FULL_ACCSUM( pairwise,     "full-sum-pairwise" )
+DEFINE_BENCH_FULL_ACCSUM( reproducible, "full-sum-reproducible" )
+
 template<typename T>
 struct bench_full_dot_rawloop : public bench_fullreduc<T>
 {
@@ -416,6 +432,10 @@ index_t max_size = 2048;
 index_t sizes[] = {4, 8, 16, 32, 64, 128, 256, 512, 1024 };
 const size_t nsizes = sizeof(sizes) / sizeof(index_t);
 
+index_t tall_nrows[] = {1048576, 262144};
+index_t tall_ncols[] = {16, 64};
+const size_t ntall = sizeof(tall_nrows) / sizeof(index_t);
+
 
 template<typename T>
 void run_bench()
@@ -449,6 +469,9 @@ void run_bench()
 
 		run_benchmark(bench_full_sum_rawloop<T>(full_base), mon, opt);
 		run_benchmark(bench_full_sum_eval<T>(full_base),    mon, opt);
+		run_benchmark(bench_full_sum_compensated<T>(full_base),  mon, opt);
+		run_benchmark(bench_full_sum_pairwise<T>(full_base),     mon, opt);
+		run_benchmark(bench_full_sum_reproducible<T>(full_base), mon, opt);
 		run_benchmark(bench_full_dot_rawloop<T>(full_base), mon, opt);
 		run_benchmark(bench_full_dot_eval<T>(full_base),    mon, opt);
 
@@ -466,6 +489,34 @@ void run_bench()
 
 		std::cout << "\n";
 	}
+
+	// tall matrices (rowwise reduction is done strip by strip)
+
+	for (size_t k = 0; k < ntall; ++k)
+	{
+		index_t m = tall_nrows[k];
+		index_t n = tall_ncols[k];
+
+		dense_matrix<T> ta(m, n);
+		dense_matrix<T> tb(m, n);
+		dense_matrix<T> td(m, 1, zero());
+		fill_rand(ta);
+		fill_rand(tb);
+
+		benchmark_option opt(10);
+
+		std::cout << "size = " << m << " x " << n << "\n";
+		std::cout << "=======================================\n";
+
+		bench_rwreduc<T> rw_base(m, n, ta.ptr_data(), tb.ptr_data(), td.ptr_data());
+
+		run_benchmark(bench_rowwise_sum_rawloop<T>(rw_base),   mon, opt);
+		run_benchmark(bench_rowwise_sum_eval<T>(rw_base),      mon, opt);
+		run_benchmark(bench_rowwise_dot_rawloop<T>(rw_base),   mon, opt);
+		run_benchmark(bench_rowwise_dot_eval<T>(rw_base),      mon, opt);
+
+		std::cout << "\n";
+	}
 }
 
 
@@ -0,0 +1,171 @@
+/**
+ * @file bench_small.cpp
+ *
+ * Benchmark of element-wise evaluation and folding on small
+ * matrices of static sizes (e.g. 4 x 4), which are fully unrolled
+ * up to LMAT_UNROLL_MAX_LEN elements.
+ *
+ * Compare with bench_small_nounroll, which is built with
+ * LMAT_UNROLL_MAX_LEN = 0.
+ *
+ * @author Dahua Lin
+ */
+
+#include "bench_base.h"
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/mateval/mat_reduce.h>
+
+using namespace lmat;
+using namespace ltest;
+using namespace lmat::bench;
+
+// the number of evaluations per run
+
+const index_t nrep = 1000;
+
+template<index_t M, index_t N>
+struct bench_small_base
+{
+	dense_matrix<double, M, N> a;
+	dense_matrix<double, M, N> b;
+	mutable dense_matrix<double, M, N> r;
+	mutable volatile double res;
+
+	bench_small_base()
+	: a(M, N), b(M, N), r(M, N), res(0)
+	{
+		fill_rand(a);
+		fill_rand(b);
+		fill_rand(r);
+		for (index_t i = 0; i < M * N; ++i) a[i] *= 0.5;
+	}
+
+	size_t size() const
+	{
+		return (size_t)(M * N * nrep);
+	}
+};
+
+
+template<index_t M, index_t N>
+struct bench_ewise_rawloop : public bench_small_base<M, N>
+{
+	const char *name() const { return "ewise-rawloop"; }
+
+	void operator() () const
+	{
+		const double *pa = this->a.ptr_data();
+		const double *pb = this->b.ptr_data();
+		double *pr = this->r.ptr_data();
+
+		for (index_t k = 0; k < nrep; ++k)
+		{
+			for (index_t i = 0; i < M * N; ++i) pr[i] = pr[i] * pa[i] + pb[i];
+		}
+		this->res = pr[0];
+	}
+};
+
+template<index_t M, index_t N>
+struct bench_ewise_expr : public bench_small_base<M, N>
+{
+	const char *name() const { return "ewise-expr"; }
+
+	void operator() () const
+	{
+		for (index_t k = 0; k < nrep; ++k)
+		{
+			this->r = this->r * this->a + this->b;
+		}
+		this->res = this->r[0];
+	}
+};
+
+template<index_t M, index_t N>
+struct bench_sum_rawloop : public bench_small_base<M, N>
+{
+	const char *name() const { return "sum-rawloop"; }
+
+	void operator() () const
+	{
+		double *pr = this->r.ptr_data();
+		double s = 0;
+
+		for (index_t k = 0; k < nrep; ++k)
+		{
+			double t = 0;
+			for (index_t i = 0; i < M * N; ++i) t += pr[i];
+			s += t;
+			pr[k % (M * N)] = t * 1.0e-3;
+		}
+		this->res = s;
+	}
+};
+
+template<index_t M, index_t N>
+struct bench_sum_eval : public bench_small_base<M, N>
+{
+	const char *name() const { return "sum-eval"; }
+
+	void operator() () const
+	{
+		double s = 0;
+
+		for (index_t k = 0; k < nrep; ++k)
+		{
+			double t = sum(this->r);
+			s += t;
+			this->r[k % (M * N)] = t * 1.0e-3;
+		}
+		this->res = s;
+	}
+};
+
+template<index_t M, index_t N>
+struct bench_max_eval : public bench_small_base<M, N>
+{
+	const char *name() const { return "max-eval"; }
+
+	void operator() () const
+	{
+		double s = 0;
+
+		for (index_t k = 0; k < nrep; ++k)
+		{
+			double t = maximum(this->r);
+			s += t;
+			this->r[k % (M * N)] = t * 0.5;
+		}
+		this->res = s;
+	}
+};
+
+
+template<index_t M, index_t N>
+void run_bench()
+{
+	std_bench_monitor mon;
+	benchmark_option opt(2000);
+
+	std::cout << "size = " << M << " x " << N << "\n";
+	std::cout << "=======================================\n";
+
+	run_benchmark(bench_ewise_rawloop<M, N>(), mon, opt);
+	run_benchmark(bench_ewise_expr<M, N>(), mon, opt);
+	run_benchmark(bench_sum_rawloop<M, N>(), mon, opt);
+	run_benchmark(bench_sum_eval<M, N>(), mon, opt);
+	run_benchmark(bench_max_eval<M, N>(), mon, opt);
+
+	std::cout << "\n";
+}
+
+
+int main(int argc, char *argv[])
+{
+	std::printf("LMAT_UNROLL_MAX_LEN = %d\n\n", (int)LMAT_UNROLL_MAX_LEN);
+
+	run_bench<4, 4>();
+	run_bench<16, 1>();
+	run_bench<13, 1>();
+}
+
@@ -0,0 +1,563 @@
+/**
+ * @file arena_alloc.h
+ *
+ * @brief Arena (bump) and size-class pool allocation devices
+ *
+ * These are meant for short-lived temporaries, e.g. the many
+ * dense matrices created in a single request of a serving loop.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_ARENA_ALLOC_H_
+#define LIGHTMAT_ARENA_ALLOC_H_
+
+#include <light_mat/common/memalloc.h>
+#include <vector>
+
+#ifndef LMAT_DEFAULT_ARENA_BLOCK_SIZE
+#define LMAT_DEFAULT_ARENA_BLOCK_SIZE (size_t(1) << 20)
+#endif
+
+namespace lmat
+{
+
+	/********************************************
+	 *
+	 *  memory arena
+	 *
+	 ********************************************/
+
+	struct arena_marker
+	{
+		size_t chunk;
+		size_t used;
+	};
+
+	class memory_arena : private noncopyable
+	{
+		struct chunk_t
+		{
+			char *base;
+			size_t size;
+			unsigned int align;
+		};
+
+		static const unsigned int chunk_alignment = 64;
+
+	public:
+		explicit memory_arena(size_t block_size = LMAT_DEFAULT_ARENA_BLOCK_SIZE)
+		: m_block_size(block_size), m_cur(0), m_used(0)
+		{
+		}
+
+		~memory_arena()
+		{
+			for (size_t i = 0; i < m_chunks.size(); ++i)
+				internal::aligned_release(m_chunks[i].base);
+		}
+
+		void* allocate(size_t nbytes, unsigned int align)
+		{
+			if (!m_chunks.empty() && align <= m_chunks[m_cur].align)
+			{
+				size_t s = align_up(m_used, align);
+				if (s + nbytes <= m_chunks[m_cur].size)
+				{
+					m_used = s + nbytes;
+					return m_chunks[m_cur].base + s;
+				}
+			}
+			return allocate_from_next(nbytes, align);
+		}
+
+		void deallocate(void *p, size_t nbytes)
+		{
+			// only the most recent allocation can be given back,
+			// others are reclaimed when the arena is rewound
+
+			if (!m_chunks.empty())
+			{
+				char *pc = static_cast<char*>(p);
+				const chunk_t& c = m_chunks[m_cur];
+				if (pc >= c.base && pc + nbytes == c.base + m_used)
+					m_used = static_cast<size_t>(pc - c.base);
+			}
+		}
+
+		arena_marker mark() const
+		{
+			arena_marker mk;
+			mk.chunk = m_cur;
+			mk.used = m_used;
+			return mk;
+		}
+
+		void rewind(const arena_marker& mk)
+		{
+			m_cur = mk.chunk;
+			m_used = mk.used;
+		}
+
+		void reset()
+		{
+			m_cur = 0;
+			m_used = 0;
+		}
+
+		size_t block_size() const
+		{
+			return m_block_size;
+		}
+
+		size_t num_chunks() const
+		{
+			return m_chunks.size();
+		}
+
+		size_t capacity() const
+		{
+			size_t s = 0;
+			for (size_t i = 0; i < m_chunks.size(); ++i) s += m_chunks[i].size;
+			return s;
+		}
+
+		size_t used_bytes() const
+		{
+			size_t s = m_used;
+			for (size_t i = 0; i < m_cur; ++i) s += m_chunks[i].size;
+			return s;
+		}
+
+	public:
+		static memory_arena* current()
+		{
+			return current_ref();
+		}
+
+	private:
+		friend class arena_scope;
+
+		static memory_arena*& current_ref()
+		{
+			static LMAT_THREAD_LOCAL memory_arena *p = 0;
+			return p;
+		}
+
+		static size_t align_up(size_t x, unsigned int align)
+		{
+			return (x + (align - 1)) & ~(size_t)(align - 1);
+		}
+
+		void* allocate_from_next(size_t nbytes, unsigned int align)
+		{
+			if (align < chunk_alignment) align = chunk_alignment;
+			size_t next = m_chunks.empty() ? 0 : m_cur + 1;
+
+			// retained chunks (from before a rewind) are reused when they are
+			// large enough and suitably aligned, others are given back
+
+			while (next < m_chunks.size() &&
+				(m_chunks[next].size < nbytes || m_chunks[next].align < align))
+			{
+				internal::aligned_release(m_chunks[next].base);
+				m_chunks.erase(m_chunks.begin() + (std::ptrdiff_t)next);
+			}
+
+			if (next == m_chunks.size())
+			{
+				chunk_t c;
+				c.size = nbytes > m_block_size ? nbytes : m_block_size;
+				c.align = align;
+				c.base = static_cast<char*>(internal::aligned_allocate(c.size, align));
+				m_chunks.push_back(c);
+			}
+
+			m_cur = next;
+			m_used = nbytes;
+			return m_chunks[next].base;
+		}
+
+	private:
+		size_t m_block_size;
+		std::vector<chunk_t> m_chunks;
+		size_t m_cur;
+		size_t m_used;
+	};
+
+
+	/**
+	 * Makes an arena the current one of the calling thread. Upon exit,
+	 * the arena is rewound to where it was, and the previous one restored.
+	 *
+	 * Memory obtained within the scope must not be used after it exits.
+	 */
+	class arena_scope : private noncopyable
+	{
+	public:
+		explicit arena_scope(memory_arena& arena)
+		: m_arena(arena)
+		, m_prev(memory_arena::current_ref())
+		, m_mark(arena.mark())
+		{
+			memory_arena::current_ref() = &arena;
+		}
+
+		~arena_scope()
+		{
+			m_arena.rewind(m_mark);
+			memory_arena::current_ref() = m_prev;
+		}
+
+	private:
+		memory_arena& m_arena;
+		memory_arena *m_prev;
+		arena_marker m_mark;
+	};
+
+
+	/********************************************
+	 *
+	 *  size-class memory pool
+	 *
+	 ********************************************/
+
+	class memory_pool : private noncopyable
+	{
+	public:
+		static const unsigned int alignment = 64;
+		static const unsigned int min_class_bits = 6;    // 64 bytes
+		static const unsigned int num_classes = 15;      // up to 1 MB
+
+		memory_pool()
+		{
+			for (unsigned int c = 0; c < num_classes; ++c) m_free[c] = 0;
+		}
+
+		~memory_pool()
+		{
+			trim();
+		}
+
+		static size_t max_class_size()
+		{
+			return class_size(num_classes - 1);
+		}
+
+		static size_t class_size(unsigned int c)
+		{
+			return size_t(1) << (c + min_class_bits);
+		}
+
+		static unsigned int class_of(size_t nbytes)
+		{
+			unsigned int c = 0;
+			while (class_size(c) < nbytes) ++c;
+			return c;
+		}
+
+		void* allocate(size_t nbytes)
+		{
+			if (nbytes > max_class_size())
+				return internal::aligned_allocate(nbytes, alignment);
+
+			unsigned int c = class_of(nbytes);
+			free_node *p = m_free[c];
+			if (p)
+			{
+				m_free[c] = p->next;
+				return p;
+			}
+			return internal::aligned_allocate(class_size(c), alignment);
+		}
+
+		void deallocate(void *p, size_t nbytes)
+		{
+			if (nbytes > max_class_size())
+			{
+				internal::aligned_release(p);
+				return;
+			}
+
+			unsigned int c = class_of(nbytes);
+			free_node *nd = static_cast<free_node*>(p);
+			nd->next = m_free[c];
+			m_free[c] = nd;
+		}
+
+		size_t num_cached(unsigned int c) const
+		{
+			size_t k = 0;
+			for (free_node *p = m_free[c]; p; p = p->next) ++k;
+			return k;
+		}
+
+		void trim()
+		{
+			for (unsigned int c = 0; c < num_classes; ++c)
+			{
+				free_node *p = m_free[c];
+				while (p)
+				{
+					free_node *nx = p->next;
+					internal::aligned_release(p);
+					p = nx;
+				}
+				m_free[c] = 0;
+			}
+		}
+
+	public:
+		static memory_pool* current()
+		{
+			return current_ref();
+		}
+
+	private:
+		friend class pool_scope;
+
+		struct free_node
+		{
+			free_node *next;
+		};
+
+		static memory_pool*& current_ref()
+		{
+			static LMAT_THREAD_LOCAL memory_pool *p = 0;
+			return p;
+		}
+
+	private:
+		free_node *m_free[num_classes];
+	};
+
+
+	/**
+	 * Makes a pool the current one of the calling thread,
+	 * and restores the previous one upon exit.
+	 */
+	class pool_scope : private noncopyable
+	{
+	public:
+		explicit pool_scope(memory_pool& pool)
+		: m_prev(memory_pool::current_ref())
+		{
+			memory_pool::current_ref() = &pool;
+		}
+
+		~pool_scope()
+		{
+			memory_pool::current_ref() = m_prev;
+		}
+
+	private:
+		memory_pool *m_prev;
+	};
+
+
+	/********************************************
+	 *
+	 *  allocators
+	 *
+	 *  A default-constructed allocator binds to the
+	 *  current arena/pool of the thread, and falls
+	 *  back to aligned heap allocation if there is none.
+	 *
+	 ********************************************/
+
+    template<typename T, unsigned int Align=LMAT_DEFAULT_ALIGNMENT>
+    class arena_allocator
+    {
+    public:
+    	typedef T value_type;
+    	typedef T* pointer;
+    	typedef T& reference;
+    	typedef const T* const_pointer;
+    	typedef const T& const_reference;
+    	typedef size_t size_type;
+    	typedef ptrdiff_t difference_type;
+
+    	template<typename TOther>
+    	struct rebind
+    	{
+    		typedef arena_allocator<TOther, Align> other;
+    	};
+
+    public:
+    	LMAT_ENSURE_INLINE
+    	arena_allocator() : m_arena(memory_arena::current()) { }
+
+    	LMAT_ENSURE_INLINE
+    	explicit arena_allocator(memory_arena& arena) : m_arena(&arena) { }
+
+    	template<typename U>
+    	LMAT_ENSURE_INLINE
+    	arena_allocator(const arena_allocator<U, Align>& r) : m_arena(r.arena()) { }
+
+    	LMAT_ENSURE_INLINE
+    	unsigned int alignment() const
+    	{
+    		return Align;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	memory_arena* arena() const
+    	{
+    		return m_arena;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	pointer address( reference x ) const
+    	{
+    		return &x;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	const_pointer address( const_reference x ) const
+    	{
+    		return &x;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	size_type max_size() const
+    	{
+    		return std::numeric_limits<size_type>::max() / sizeof(value_type);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	pointer allocate(size_type n, const void* hint=0)
+    	{
+    		return m_arena ?
+    				(pointer)m_arena->allocate(n * sizeof(value_type), Align) :
+    				(pointer)internal::aligned_allocate(n * sizeof(value_type), Align);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	void deallocate(pointer p, size_type n)
+    	{
+    		if (m_arena)
+    			m_arena->deallocate(p, n * sizeof(value_type));
+    		else
+    			internal::aligned_release(p);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	void construct (pointer p, const_reference val)
+    	{
+    		new (p) value_type(val);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	void destroy (pointer p)
+    	{
+    		p->~value_type();
+    	}
+
+    private:
+    	memory_arena *m_arena;
+
+    }; // end class arena_allocator
+
+
+    template<typename T, unsigned int Align=LMAT_DEFAULT_ALIGNMENT>
+    class pool_allocator
+    {
+    	static_assert(Align <= 64, "Align must not exceed the alignment of memory_pool.");
+
+    public:
+    	typedef T value_type;
+    	typedef T* pointer;
+    	typedef T& reference;
+    	typedef const T* const_pointer;
+    	typedef const T& const_reference;
+    	typedef size_t size_type;
+    	typedef ptrdiff_t difference_type;
+
+    	template<typename TOther>
+    	struct rebind
+    	{
+    		typedef pool_allocator<TOther, Align> other;
+    	};
+
+    public:
+    	LMAT_ENSURE_INLINE
+    	pool_allocator() : m_pool(memory_pool::current()) { }
+
+    	LMAT_ENSURE_INLINE
+    	explicit pool_allocator(memory_pool& pool) : m_pool(&pool) { }
+
+    	template<typename U>
+    	LMAT_ENSURE_INLINE
+    	pool_allocator(const pool_allocator<U, Align>& r) : m_pool(r.pool()) { }
+
+    	LMAT_ENSURE_INLINE
+    	unsigned int alignment() const
+    	{
+    		return Align;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	memory_pool* pool() const
+    	{
+    		return m_pool;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	pointer address( reference x ) const
+    	{
+    		return &x;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	const_pointer address( const_reference x ) const
+    	{
+    		return &x;
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	size_type max_size() const
+    	{
+    		return std::numeric_limits<size_type>::max() / sizeof(value_type);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	pointer allocate(size_type n, const void* hint=0)
+    	{
+    		return m_pool ?
+    				(pointer)m_pool->allocate(n * sizeof(value_type)) :
+    				(pointer)internal::aligned_allocate(n * sizeof(value_type), Align);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	void deallocate(pointer p, size_type n)
+    	{
+    		if (m_pool)
+    			m_pool->deallocate(p, n * sizeof(value_type));
+    		else
+    			internal::aligned_release(p);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	void construct (pointer p, const_reference val)
+    	{
+    		new (p) value_type(val);
+    	}
+
+    	LMAT_ENSURE_INLINE
+    	void destroy (pointer p)
+    	{
+    		p->~value_type();
+    	}
+
+    private:
+    	memory_pool *m_pool;
+
+    }; // end class pool_allocator
+
+}
+
+#endif /* ARENA_ALLOC_H_ */
@@ -0,0 +1,636 @@
+/**
+ * @file exec.h
+ *
+ * @brief Executors for library-internal parallelism
+ *
+ * Parallel kernels submit their work through parallel_for, which
+ * runs on the current executor of the calling thread. By default,
+ * this is a process-wide work-stealing thread pool, which can be
+ * replaced (set_default_executor) or overridden for a scope
+ * (executor_scope) by any implementation of executor, e.g. one
+ * that forwards to the worker threads of the host application.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_EXEC_H_
+#define LIGHTMAT_EXEC_H_
+
+#include <light_mat/common/basic_defs.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The number of threads (including the caller) of the default thread
+// pool, 0 for the hardware concurrency
+
+#ifndef LMAT_DEFAULT_NUM_THREADS
+#define LMAT_DEFAULT_NUM_THREADS 0
+#endif
+
+// The number of blocks per thread into which parallel_for divides a
+// range at most (more blocks balance the load better)
+
+#ifndef LMAT_PAR_BLOCKS_PER_THREAD
+#define LMAT_PAR_BLOCKS_PER_THREAD 4
+#endif
+
+// The number of elements that a task of a column-wise parallel
+// algorithm processes at least, unless the grain is given explicitly
+
+#ifndef LMAT_PAR_MIN_TASK_ELEMS
+#define LMAT_PAR_MIN_TASK_ELEMS 16384
+#endif
+
+// The capacity of the task deque of each worker (a power of 2)
+
+#ifndef LMAT_WORK_DEQUE_CAPACITY
+#define LMAT_WORK_DEQUE_CAPACITY 1024
+#endif
+
+namespace lmat
+{
+	/**
+	 * The tag that selects the parallel variant of a column-wise
+	 * algorithm (e.g. colwise_sum(par_(), a, r)), which distributes
+	 * blocks of columns over the current executor.
+	 *
+	 * Each block has at least grain columns, or by default, enough
+	 * columns to make LMAT_PAR_MIN_TASK_ELEMS elements.
+	 */
+	struct par_
+	{
+		index_t grain;
+
+		LMAT_ENSURE_INLINE
+		explicit par_(index_t g = 0) : grain(g) { }
+
+		LMAT_ENSURE_INLINE
+		index_t col_grain(index_t m) const
+		{
+			if (grain > 0) return grain;
+			return m > 0 ? (LMAT_PAR_MIN_TASK_ELEMS + m - 1) / m : 1;
+		}
+	};
+}
+
+namespace lmat { namespace exec {
+
+	typedef std::function<void(index_t)> task_fun;
+
+
+	/********************************************
+	 *
+	 *  executor
+	 *
+	 ********************************************/
+
+	class executor
+	{
+	public:
+		virtual ~executor() { }
+
+		/**
+		 * The number of threads that may run tasks concurrently,
+		 * including the calling thread.
+		 */
+		virtual unsigned int concurrency() const = 0;
+
+		/**
+		 * Runs f(0), ..., f(n-1), possibly concurrently, and returns
+		 * when all of them are done. The first exception thrown by
+		 * a task is re-thrown, after the others are done or skipped.
+		 *
+		 * It must be safe to call this from within a task (nested
+		 * parallelism), which requires the calling thread to help
+		 * run the tasks instead of blocking a worker.
+		 */
+		virtual void bulk_run(index_t n, const task_fun& f) = 0;
+	};
+
+
+	class serial_executor : public executor
+	{
+	public:
+		unsigned int concurrency() const
+		{
+			return 1;
+		}
+
+		void bulk_run(index_t n, const task_fun& f)
+		{
+			for (index_t i = 0; i < n; ++i) f(i);
+		}
+	};
+
+
+	/********************************************
+	 *
+	 *  work-stealing deque
+	 *
+	 *  A lock-free deque (Chase & Lev, 2005), in the
+	 *  formulation for C11 atomics by Le et al. (2013).
+	 *  Only the owner pushes and pops at the bottom,
+	 *  while the others steal from the top. It does not
+	 *  grow: push fails when it is full.
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		struct bulk_job
+		{
+			const task_fun *fun;
+			std::atomic<index_t> remaining;
+			std::atomic<bool> failed;
+			std::exception_ptr error;
+			std::mutex error_mutex;
+
+			bulk_job(const task_fun& f, index_t n)
+			: fun(&f), remaining(n), failed(false) { }
+		};
+
+		struct pool_task
+		{
+			bulk_job *job;
+			index_t index;
+		};
+
+		inline void run_task(pool_task *t)
+		{
+			bulk_job& j = *(t->job);
+
+			if (!j.failed.load(std::memory_order_relaxed))
+			{
+				try
+				{
+					(*j.fun)(t->index);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lk(j.error_mutex);
+					if (!j.error) j.error = std::current_exception();
+					j.failed.store(true, std::memory_order_relaxed);
+				}
+			}
+
+			// the job may be destroyed right after this
+			j.remaining.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+
+	class work_deque : private noncopyable
+	{
+	public:
+		static const int64_t capacity = LMAT_WORK_DEQUE_CAPACITY;
+
+		work_deque() : m_top(0), m_bottom(0)
+		{
+			for (int64_t i = 0; i < capacity; ++i)
+				m_buf[i].store(0, std::memory_order_relaxed);
+		}
+
+		int64_t size() const
+		{
+			int64_t s = m_bottom.load(std::memory_order_relaxed) -
+					m_top.load(std::memory_order_relaxed);
+			return s > 0 ? s : 0;
+		}
+
+		bool push(internal::pool_task *t)  // owner only
+		{
+			const int64_t b = m_bottom.load(std::memory_order_relaxed);
+			const int64_t tp = m_top.load(std::memory_order_acquire);
+			if (b - tp >= capacity) return false;
+
+			m_buf[b & mask].store(t, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		internal::pool_task* pop()  // owner only
+		{
+			const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+			m_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t tp = m_top.load(std::memory_order_relaxed);
+
+			internal::pool_task *t = 0;
+			if (tp <= b)
+			{
+				t = m_buf[b & mask].load(std::memory_order_relaxed);
+				if (tp == b)
+				{
+					// the last one: race against the thieves
+					if (!m_top.compare_exchange_strong(tp, tp + 1,
+							std::memory_order_seq_cst, std::memory_order_relaxed))
+						t = 0;
+					m_bottom.store(b + 1, std::memory_order_relaxed);
+				}
+			}
+			else
+			{
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return t;
+		}
+
+		internal::pool_task* steal()
+		{
+			int64_t tp = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = m_bottom.load(std::memory_order_acquire);
+
+			if (tp < b)
+			{
+				internal::pool_task *t = m_buf[tp & mask].load(std::memory_order_relaxed);
+				if (m_top.compare_exchange_strong(tp, tp + 1,
+						std::memory_order_seq_cst, std::memory_order_relaxed))
+					return t;
+			}
+			return 0;
+		}
+
+	private:
+		static const int64_t mask = capacity - 1;
+
+		std::atomic<int64_t> m_top;
+		char m_pad[64];  // keeps the thieves off the owner's cache line
+		std::atomic<int64_t> m_bottom;
+		std::atomic<internal::pool_task*> m_buf[capacity];
+	};
+
+
+	/********************************************
+	 *
+	 *  thread pool
+	 *
+	 *  Each worker runs the tasks in its own deque (last
+	 *  in, first out), and steals from the others when it
+	 *  runs out. Tasks submitted by a worker (i.e. nested
+	 *  ones) go to its deque, while those submitted by
+	 *  other threads go to a shared inbox. A thread waiting
+	 *  for its tasks helps run the pending ones.
+	 *
+	 ********************************************/
+
+	class thread_pool;
+
+	namespace internal
+	{
+		struct pool_thread_info
+		{
+			const thread_pool *pool;
+			unsigned int index;
+			uint32_t rstate;
+		};
+
+		inline pool_thread_info& this_pool_thread()
+		{
+			static LMAT_THREAD_LOCAL pool_thread_info info = {0, 0, 0};
+			return info;
+		}
+
+		inline unsigned int default_num_threads()
+		{
+			unsigned int n = LMAT_DEFAULT_NUM_THREADS;
+			if (n == 0) n = std::thread::hardware_concurrency();
+			return n > 0 ? n : 1;
+		}
+	}
+
+
+	class thread_pool : public executor, private noncopyable
+	{
+		struct worker
+		{
+			work_deque deque;
+			std::thread thread;
+		};
+
+	public:
+		explicit thread_pool(unsigned int nthreads = internal::default_num_threads())
+		: m_ninbox(0), m_nqueued(0), m_stop(false)
+		{
+			// the calling thread of bulk_run makes one
+			const unsigned int nw = nthreads > 1 ? nthreads - 1 : 0;
+
+			for (unsigned int k = 0; k < nw; ++k)
+				m_workers.push_back(std::unique_ptr<worker>(new worker()));
+
+			for (unsigned int k = 0; k < nw; ++k)
+				m_workers[k]->thread = std::thread(&thread_pool::worker_loop, this, k);
+		}
+
+		~thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lk(m_mutex);
+				m_stop.store(true);
+			}
+			m_cv.notify_all();
+
+			for (size_t k = 0; k < m_workers.size(); ++k)
+				m_workers[k]->thread.join();
+		}
+
+		unsigned int num_workers() const
+		{
+			return static_cast<unsigned int>(m_workers.size());
+		}
+
+		unsigned int concurrency() const
+		{
+			return num_workers() + 1;
+		}
+
+		void bulk_run(index_t n, const task_fun& f)
+		{
+			if (n <= 0) return;
+
+			if (n == 1 || m_workers.empty())
+			{
+				for (index_t i = 0; i < n; ++i) f(i);
+				return;
+			}
+
+			internal::bulk_job job(f, n);
+			std::vector<internal::pool_task> tasks(static_cast<size_t>(n));
+			for (index_t i = 0; i < n; ++i)
+			{
+				tasks[static_cast<size_t>(i)].job = &job;
+				tasks[static_cast<size_t>(i)].index = i;
+			}
+
+			// the caller takes the first one, and shares the rest
+
+			const unsigned int self = self_index();
+			m_nqueued.fetch_add(n - 1);
+
+			index_t i = n - 1;
+			if (self < num_workers())
+			{
+				work_deque& dq = m_workers[self]->deque;
+				for (; i > 0 && dq.push(&tasks[static_cast<size_t>(i)]); --i);
+			}
+
+			{
+				// also keeps a worker from missing the notification
+				// between checking m_nqueued and going to sleep
+
+				std::lock_guard<std::mutex> lk(m_mutex);
+				for (; i > 0; --i) m_inbox.push_back(&tasks[static_cast<size_t>(i)]);
+				m_ninbox.store(static_cast<index_t>(m_inbox.size()), std::memory_order_relaxed);
+			}
+			m_cv.notify_all();
+
+			internal::run_task(&tasks[0]);
+
+			while (job.remaining.load(std::memory_order_acquire) > 0)
+			{
+				internal::pool_task *t = find_task(self);
+				if (t)
+					internal::run_task(t);
+				else
+					std::this_thread::yield();
+			}
+
+			if (job.error) std::rethrow_exception(job.error);
+		}
+
+	private:
+		unsigned int self_index() const
+		{
+			const internal::pool_thread_info& info = internal::this_pool_thread();
+			return info.pool == this ? info.index : num_workers();
+		}
+
+		internal::pool_task* find_task(unsigned int self)
+		{
+			const unsigned int nw = num_workers();
+			internal::pool_task *t = 0;
+
+			if (self < nw) t = m_workers[self]->deque.pop();
+
+			if (!t && m_ninbox.load(std::memory_order_relaxed) > 0)
+			{
+				std::lock_guard<std::mutex> lk(m_mutex);
+				if (!m_inbox.empty())
+				{
+					t = m_inbox.front();
+					m_inbox.pop_front();
+					m_ninbox.store(static_cast<index_t>(m_inbox.size()), std::memory_order_relaxed);
+				}
+			}
+
+			if (!t)
+			{
+				uint32_t& r = internal::this_pool_thread().rstate;
+				r = r * 1664525u + 1013904223u;
+				const unsigned int v0 = (r >> 16) % nw;
+
+				for (unsigned int k = 0; k < nw && !t; ++k)
+				{
+					const unsigned int v = (v0 + k) % nw;
+					if (v != self) t = m_workers[v]->deque.steal();
+				}
+			}
+
+			if (t) m_nqueued.fetch_sub(1);
+			return t;
+		}
+
+		void worker_loop(unsigned int k)
+		{
+			internal::pool_thread_info& info = internal::this_pool_thread();
+			info.pool = this;
+			info.index = k;
+			info.rstate = k + 1;
+
+			for(;;)
+			{
+				internal::pool_task *t = find_task(k);
+
+				for (int s = 0; !t && s < 64; ++s)
+				{
+					std::this_thread::yield();
+					t = find_task(k);
+				}
+
+				if (t)
+				{
+					internal::run_task(t);
+				}
+				else
+				{
+					std::unique_lock<std::mutex> lk(m_mutex);
+					m_cv.wait(lk, [this]() { return m_stop.load() || m_nqueued.load() > 0; });
+					if (m_stop.load() && m_nqueued.load() <= 0) return;
+				}
+			}
+		}
+
+	private:
+		std::vector<std::unique_ptr<worker> > m_workers;
+		std::deque<internal::pool_task*> m_inbox;
+		std::atomic<index_t> m_ninbox;
+		std::atomic<index_t> m_nqueued;  // tasks shared, but not yet taken
+		std::atomic<bool> m_stop;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+	};
+
+
+	/********************************************
+	 *
+	 *  executor selection
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		inline std::atomic<executor*>& default_executor_ref()
+		{
+			static std::atomic<executor*> p(0);
+			return p;
+		}
+
+		inline executor*& scoped_executor_ref()
+		{
+			static LMAT_THREAD_LOCAL executor *p = 0;
+			return p;
+		}
+	}
+
+	inline thread_pool& global_thread_pool()
+	{
+		static thread_pool pool;
+		return pool;
+	}
+
+	inline executor& default_executor()
+	{
+		executor *p = internal::default_executor_ref().load();
+		return p ? *p : global_thread_pool();
+	}
+
+	/**
+	 * Replaces the default executor of all threads (0 restores the
+	 * global thread pool). The executor must outlive its use.
+	 */
+	inline void set_default_executor(executor *e)
+	{
+		internal::default_executor_ref().store(e);
+	}
+
+	inline executor& current_executor()
+	{
+		executor *p = internal::scoped_executor_ref();
+		return p ? *p : default_executor();
+	}
+
+	/**
+	 * Makes an executor the current one of the calling thread,
+	 * and restores the previous one upon exit.
+	 */
+	class executor_scope : private noncopyable
+	{
+	public:
+		explicit executor_scope(executor& e)
+		: m_prev(internal::scoped_executor_ref())
+		{
+			internal::scoped_executor_ref() = &e;
+		}
+
+		~executor_scope()
+		{
+			internal::scoped_executor_ref() = m_prev;
+		}
+
+	private:
+		executor *m_prev;
+	};
+
+
+	/********************************************
+	 *
+	 *  parallel_for
+	 *
+	 *  parallel_for(ex, rgn, grain, f) divides rgn into
+	 *  contiguous blocks of at least grain indices (unless
+	 *  rgn itself is shorter), and calls f(sub) with each
+	 *  sub-range, e.g. of the columns of a matrix. The body
+	 *  runs with ex as the current executor, so that nested
+	 *  parallel_for share its threads.
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		inline index_t num_par_blocks(index_t n, index_t grain, unsigned int nthreads)
+		{
+			if (grain < 1) grain = 1;
+			if (nthreads <= 1 || n <= grain) return 1;
+
+			const index_t nb = n / grain;
+			const index_t max_nb = static_cast<index_t>(nthreads) * LMAT_PAR_BLOCKS_PER_THREAD;
+			return nb < max_nb ? nb : max_nb;
+		}
+
+		inline index_t par_block_begin(index_t n, index_t nb, index_t k)
+		{
+			return static_cast<index_t>(int64_t(n) * int64_t(k) / int64_t(nb));
+		}
+	}
+
+	template<class Fun>
+	inline void parallel_for(executor& ex, const range& rgn, index_t grain, Fun f)
+	{
+		const index_t n = rgn.num();
+		const index_t nb = internal::num_par_blocks(n, grain, ex.concurrency());
+
+		if (nb <= 1)
+		{
+			if (n > 0) f(rgn);
+			return;
+		}
+
+		const index_t i0 = rgn.begin_index();
+
+		ex.bulk_run(nb, [&](index_t k)
+		{
+			executor_scope s(ex);
+			const index_t b = internal::par_block_begin(n, nb, k);
+			const index_t e = internal::par_block_begin(n, nb, k + 1);
+			f(range(i0 + b, e - b));
+		});
+	}
+
+	template<class Fun>
+	inline void parallel_for(const range& rgn, index_t grain, Fun f)
+	{
+		parallel_for(current_executor(), rgn, grain, f);
+	}
+
+	template<class Fun>
+	inline void parallel_for(index_t n, index_t grain, Fun f)
+	{
+		parallel_for(current_executor(), range(0, n), grain, f);
+	}
+
+} }
+
+#endif
@@ -0,0 +1,328 @@
+/**
+ * @file instrument.h
+ *
+ * @brief Opt-in instrumentation counters
+ *
+ * Define LMAT_ENABLE_INSTRUMENTATION (before including any light-mat
+ * header) to turn on the counters. Otherwise, all LMAT_INSTRUMENT_*
+ * macros expand to nothing, and the query functions report zeros.
+ *
+ * Counters are attached to call sites, each identified by a kind and
+ * a tag (a string literal), and can be queried by (kind, tag):
+ *
+ * - allocation_:  memory obtained via aligned_allocator, attributed to
+ *                 the tag of the innermost LMAT_INSTRUMENT_SCOPE of the
+ *                 calling thread ("untagged" if there is none);
+ * - temporary_:   temporaries materialized by the library itself;
+ * - simd_path_:   evaluations that take the SIMD path;
+ * - scalar_path_: evaluations that take the scalar path;
+ * - variant_:     variants chosen at run-time within a path (e.g. the
+ *                 alignment of packs, see pack_align_policy).
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_INSTRUMENT_H_
+#define LIGHTMAT_INSTRUMENT_H_
+
+#include <light_mat/common/basic_defs.h>
+
+#include <cstring>
+#include <ostream>
+
+#ifdef LMAT_ENABLE_INSTRUMENTATION
+#include <atomic>
+#endif
+
+namespace lmat { namespace instrument {
+
+	enum counter_kind
+	{
+		allocation_ = 0,
+		temporary_ = 1,
+		simd_path_ = 2,
+		scalar_path_ = 3,
+		variant_ = 4
+	};
+
+	inline const char* kind_name(counter_kind k)
+	{
+		switch (k)
+		{
+		case allocation_: return "allocation";
+		case temporary_: return "temporary";
+		case simd_path_: return "simd_path";
+		case scalar_path_: return "scalar_path";
+		case variant_: return "variant";
+		}
+		return "unknown";
+	}
+
+	struct site_stats
+	{
+		unsigned long long count;
+		unsigned long long bytes;
+	};
+
+
+#ifdef LMAT_ENABLE_INSTRUMENTATION
+
+	const bool enabled = true;
+
+	/********************************************
+	 *
+	 *  call-site counter
+	 *
+	 *  Each is a function-local static object, which
+	 *  links itself into a global list upon construction.
+	 *
+	 ********************************************/
+
+	class site_counter : private noncopyable
+	{
+	public:
+		site_counter(counter_kind k, const char *tag)
+		: m_kind(k), m_tag(tag), m_count(0), m_bytes(0), m_next(0)
+		{
+			std::atomic<site_counter*>& h = head();
+			site_counter *p = h.load();
+			do { m_next = p; } while (!h.compare_exchange_weak(p, this));
+		}
+
+		LMAT_ENSURE_INLINE
+		void add(size_t nbytes)
+		{
+			m_count.fetch_add(1, std::memory_order_relaxed);
+			m_bytes.fetch_add(nbytes, std::memory_order_relaxed);
+		}
+
+		counter_kind kind() const { return m_kind; }
+
+		const char *tag() const { return m_tag; }
+
+		site_stats stats() const
+		{
+			site_stats s;
+			s.count = m_count.load(std::memory_order_relaxed);
+			s.bytes = m_bytes.load(std::memory_order_relaxed);
+			return s;
+		}
+
+		void reset()
+		{
+			m_count.store(0, std::memory_order_relaxed);
+			m_bytes.store(0, std::memory_order_relaxed);
+		}
+
+		const site_counter *next() const { return m_next; }
+
+		static const site_counter *first()
+		{
+			return head().load();
+		}
+
+	private:
+		static std::atomic<site_counter*>& head()
+		{
+			static std::atomic<site_counter*> h(0);
+			return h;
+		}
+
+	private:
+		counter_kind m_kind;
+		const char *m_tag;
+		std::atomic<unsigned long long> m_count;
+		std::atomic<unsigned long long> m_bytes;
+		site_counter *m_next;
+	};
+
+
+	namespace internal
+	{
+		inline site_counter*& current_alloc_site()
+		{
+			static LMAT_THREAD_LOCAL site_counter *p = 0;
+			return p;
+		}
+
+		inline void count_allocation(size_t nbytes)
+		{
+			site_counter *s = current_alloc_site();
+			if (s)
+			{
+				s->add(nbytes);
+			}
+			else
+			{
+				static site_counter untagged(allocation_, "untagged");
+				untagged.add(nbytes);
+			}
+		}
+	}
+
+
+	/**
+	 * Attributes the allocations made by the calling thread within
+	 * its lifetime to a given site (see LMAT_INSTRUMENT_SCOPE).
+	 */
+	class alloc_scope : private noncopyable
+	{
+	public:
+		explicit alloc_scope(site_counter& site)
+		: m_prev(internal::current_alloc_site())
+		{
+			internal::current_alloc_site() = &site;
+		}
+
+		~alloc_scope()
+		{
+			internal::current_alloc_site() = m_prev;
+		}
+
+	private:
+		site_counter *m_prev;
+	};
+
+
+	/********************************************
+	 *
+	 *  query & reset
+	 *
+	 ********************************************/
+
+	template<class Fun>
+	inline void for_each_site(Fun f)
+	{
+		for (const site_counter *p = site_counter::first(); p; p = p->next())
+			f(p->kind(), p->tag(), p->stats());
+	}
+
+	inline site_stats query(counter_kind k, const char *tag)
+	{
+		site_stats r = {0, 0};
+		for (const site_counter *p = site_counter::first(); p; p = p->next())
+		{
+			if (p->kind() == k && std::strcmp(p->tag(), tag) == 0)
+			{
+				site_stats s = p->stats();
+				r.count += s.count;
+				r.bytes += s.bytes;
+			}
+		}
+		return r;
+	}
+
+	inline site_stats total(counter_kind k)
+	{
+		site_stats r = {0, 0};
+		for (const site_counter *p = site_counter::first(); p; p = p->next())
+		{
+			if (p->kind() == k)
+			{
+				site_stats s = p->stats();
+				r.count += s.count;
+				r.bytes += s.bytes;
+			}
+		}
+		return r;
+	}
+
+	inline void reset()
+	{
+		for (const site_counter *p = site_counter::first(); p; p = p->next())
+			const_cast<site_counter*>(p)->reset();
+	}
+
+#else
+
+	const bool enabled = false;
+
+	template<class Fun>
+	inline void for_each_site(Fun) { }
+
+	inline site_stats query(counter_kind, const char *)
+	{
+		site_stats r = {0, 0};
+		return r;
+	}
+
+	inline site_stats total(counter_kind)
+	{
+		site_stats r = {0, 0};
+		return r;
+	}
+
+	inline void reset() { }
+
+#endif
+
+
+	namespace internal
+	{
+		struct site_printer
+		{
+			std::ostream& out;
+
+			void operator() (counter_kind k, const char *tag, const site_stats& s) const
+			{
+				if (s.count > 0)
+				{
+					out << kind_name(k) << " [" << tag << "]: "
+						<< s.count << " times, " << s.bytes << " bytes\n";
+				}
+			}
+		};
+	}
+
+	inline void report(std::ostream& out)
+	{
+		internal::site_printer pr = {out};
+		for_each_site(pr);
+	}
+
+} }
+
+
+/********************************************
+ *
+ *  instrumentation macros
+ *
+ ********************************************/
+
+#ifdef LMAT_ENABLE_INSTRUMENTATION
+
+#define LMAT_INSTRUMENT_SITE_(kind, tag, nbytes) \
+	{ static ::lmat::instrument::site_counter _lmat_site_(kind, tag); _lmat_site_.add(nbytes); }
+
+#define LMAT_INSTRUMENT_ALLOC(nbytes) \
+	::lmat::instrument::internal::count_allocation(nbytes);
+
+#define LMAT_INSTRUMENT_TEMP(tag, nbytes) \
+	LMAT_INSTRUMENT_SITE_(::lmat::instrument::temporary_, tag, nbytes)
+
+#define LMAT_INSTRUMENT_PATH(tag, is_simd) \
+	{ if (is_simd) LMAT_INSTRUMENT_SITE_(::lmat::instrument::simd_path_, tag, 0) \
+	  else LMAT_INSTRUMENT_SITE_(::lmat::instrument::scalar_path_, tag, 0) }
+
+#define LMAT_INSTRUMENT_VARIANT(tag) \
+	LMAT_INSTRUMENT_SITE_(::lmat::instrument::variant_, tag, 0)
+
+#define LMAT_INSTRUMENT_SCOPE(tag) \
+	static ::lmat::instrument::site_counter _lmat_alloc_site_(::lmat::instrument::allocation_, tag); \
+	::lmat::instrument::alloc_scope _lmat_alloc_scope_(_lmat_alloc_site_);
+
+#else
+
+#define LMAT_INSTRUMENT_ALLOC(nbytes)
+#define LMAT_INSTRUMENT_TEMP(tag, nbytes)
+#define LMAT_INSTRUMENT_PATH(tag, is_simd)
+#define LMAT_INSTRUMENT_VARIANT(tag)
+#define LMAT_INSTRUMENT_SCOPE(tag)
+
+#endif
+
+#endif /* INSTRUMENT_H_ */
@@ -14,6 +14,7 @@
 #define LIGHTMAT_MEMALLOC_H_
 
 #include <light_mat/common/basic_defs.h>
+#include <light_mat/common/instrument.h>
 #include "internal/align_alloc.h"
 
 #include <limits>
@@ -80,6 +81,7 @@ namespace lmat
     	LMAT_ENSURE_INLINE
     	pointer allocate(size_type n, const void* hint=0)
     	{
+    		LMAT_INSTRUMENT_ALLOC(n * sizeof(value_type))
     		return (pointer)internal::aligned_allocate(n * sizeof(value_type), Align);
     	}
 
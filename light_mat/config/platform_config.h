@@ -59,5 +59,13 @@
 	#error Light-Matrix can only be used with Microsoft Visual C++, GCC (G++), or clang (clang++).
 #endif
 
+// thread-local storage (only used with POD types)
+
+#if LIGHTMAT_COMPILER == LIGHTMAT_MSVC
+	#define LMAT_THREAD_LOCAL __declspec(thread)
+#else
+	#define LMAT_THREAD_LOCAL __thread
+#endif
+
 #endif
 
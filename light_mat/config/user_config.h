@@ -21,4 +21,10 @@
 
 #define LMAT_DEFAULT_ALIGNMENT 16
 
+// rowwise reductions over columns longer than this (in bytes)
+// are done strip by strip, each strip staying in L1 cache
+#ifndef LMAT_ROWWISE_BLOCK_BYTES
+#define LMAT_ROWWISE_BLOCK_BYTES 16384
+#endif
+
 #endif 
@@ -0,0 +1,860 @@
+/**
+ * @file matfile.h
+ *
+ * @brief Reading & writing MAT-files (version 5)
+ *
+ * This works without the MATLAB runtime. Supported are dense real
+ * numeric and logical arrays (other variables are skipped on
+ * reading). Arrays with more than two dimensions are read as
+ * m x (n1 * n2 * ...) matrices.
+ *
+ * Compressed data elements (the default of MATLAB 7+) are supported
+ * when LMAT_USE_ZLIB is defined (and the program is linked to zlib).
+ *
+ * The reader visits the variables one at a time, and reads the data
+ * of the current variable directly into the destination matrix.
+ *
+ * Only files of the host byte order are supported.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MATFILE_H_
+#define LIGHTMAT_MATFILE_H_
+
+#include <light_mat/io/matrix_binfile.h>
+#include <string>
+#include <limits>
+
+#ifdef LMAT_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace lmat
+{
+
+	/********************************************
+	 *
+	 *  classes & types
+	 *
+	 ********************************************/
+
+	// the values coincide with mxClassID
+
+	enum mat_class_id
+	{
+		mat_unknown_class = 0,
+		mat_cell_class    = 1,
+		mat_struct_class  = 2,
+		mat_object_class  = 3,
+		mat_char_class    = 4,
+		mat_sparse_class  = 5,
+		mat_double_class  = 6,
+		mat_single_class  = 7,
+		mat_int8_class    = 8,
+		mat_uint8_class   = 9,
+		mat_int16_class   = 10,
+		mat_uint16_class  = 11,
+		mat_int32_class   = 12,
+		mat_uint32_class  = 13,
+		mat_int64_class   = 14,
+		mat_uint64_class  = 15
+	};
+
+	namespace internal
+	{
+		enum mat_data_type
+		{
+			mi_int8       = 1,
+			mi_uint8      = 2,
+			mi_int16      = 3,
+			mi_uint16     = 4,
+			mi_int32      = 5,
+			mi_uint32     = 6,
+			mi_single     = 7,
+			mi_double     = 9,
+			mi_int64      = 12,
+			mi_uint64     = 13,
+			mi_matrix     = 14,
+			mi_compressed = 15
+		};
+
+		const uint32_t mat_complex_flag = 0x0800;
+		const uint32_t mat_logical_flag = 0x0200;
+	}
+
+	template<typename T> struct type_to_mat_class;
+
+#define LMAT_DEFINE_MATFILE_TYPEMAP(C, MI, T, LOGICAL) \
+	template<> struct type_to_mat_class<T> { \
+		static const mat_class_id value = C; \
+		static const internal::mat_data_type data_type = MI; \
+		static const bool is_logical = LOGICAL; };
+
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_double_class, internal::mi_double, double,   false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_single_class, internal::mi_single, float,    false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_int64_class,  internal::mi_int64,  int64_t,  false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_uint64_class, internal::mi_uint64, uint64_t, false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_int32_class,  internal::mi_int32,  int32_t,  false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_uint32_class, internal::mi_uint32, uint32_t, false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_int16_class,  internal::mi_int16,  int16_t,  false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_uint16_class, internal::mi_uint16, uint16_t, false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_int8_class,   internal::mi_int8,   int8_t,   false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_uint8_class,  internal::mi_uint8,  uint8_t,  false)
+	LMAT_DEFINE_MATFILE_TYPEMAP(mat_uint8_class,  internal::mi_uint8,  bool,     true)
+
+#undef LMAT_DEFINE_MATFILE_TYPEMAP
+
+
+	struct matvar_info
+	{
+		std::string name;
+		mat_class_id class_id;
+		bool is_logical;
+		bool is_complex;
+		index_t nrows;
+		index_t ncols;
+
+		bool is_numeric() const
+		{
+			return class_id >= mat_double_class && class_id <= mat_uint64_class;
+		}
+
+		template<typename T>
+		bool is_type() const
+		{
+			return class_id == type_to_mat_class<T>::value &&
+					is_logical == type_to_mat_class<T>::is_logical;
+		}
+	};
+
+
+	namespace internal
+	{
+		LMAT_ENSURE_INLINE
+		inline uint32_t mat_pad8(uint32_t n)
+		{
+			return (n + 7) & ~uint32_t(7);
+		}
+
+		inline size_t mat_data_type_size(uint32_t t)
+		{
+			switch (t)
+			{
+			case mi_int8: case mi_uint8: return 1;
+			case mi_int16: case mi_uint16: return 2;
+			case mi_int32: case mi_uint32: case mi_single: return 4;
+			case mi_double: case mi_int64: case mi_uint64: return 8;
+			default: return 0;
+			}
+		}
+
+		const size_t mat_io_chunk = 16384;
+	}
+
+
+	/********************************************
+	 *
+	 *  reader
+	 *
+	 ********************************************/
+
+	class matfile_reader : private noncopyable
+	{
+	public:
+		explicit matfile_reader(const char *path)
+		: m_fp(std::fopen(path, "rb"))
+		, m_next(128), m_inflating(false), m_data_ok(false), m_small(0)
+		{
+			if (!m_fp) throw io_error("matfile_reader: failed to open the file.");
+
+			char h[128];
+			if (std::fread(h, 1, 128, m_fp) != 128 || h[126] == 0)
+			{
+				std::fclose(m_fp);
+				throw io_error("Not a MAT-file of version 5.");
+			}
+
+			uint16_t ver, endian;
+			std::memcpy(&ver, h + 124, 2);
+			std::memcpy(&endian, h + 126, 2);
+
+			if (endian != (uint16_t)(('M' << 8) | 'I'))
+			{
+				std::fclose(m_fp);
+				throw io_error("The MAT-file has a different byte order.");
+			}
+
+			if (ver != 0x0100)
+			{
+				std::fclose(m_fp);
+				throw io_error("Not a MAT-file of version 5.");
+			}
+		}
+
+		~matfile_reader()
+		{
+			end_inflate();
+			std::fclose(m_fp);
+		}
+
+	public:
+		// move to the next variable, returns false at the end of file
+
+		bool next(matvar_info& info)
+		{
+			m_data_ok = false;
+
+			while (true)
+			{
+				end_inflate();
+				if (!internal::cfile_seek(m_fp, m_next, SEEK_SET))
+					throw io_error("matfile_reader: failed to seek.");
+
+				uint32_t tag[2];
+				size_t nr = std::fread(tag, 4, 2, m_fp);
+				if (nr == 0 && std::feof(m_fp)) return false;
+				if (nr != 2) throw io_error("Corrupted MAT-file.");
+
+				const uint64_t start = m_next + 8;
+
+				if (tag[0] == internal::mi_compressed)
+				{
+					m_next = start + tag[1];
+					begin_inflate(tag[1]);
+					read_raw(tag, 8);
+				}
+				else
+				{
+					m_next = start + internal::mat_pad8(tag[1]);
+				}
+
+				if (tag[0] == internal::mi_matrix && tag[1] > 0)
+				{
+					read_header(info);
+					return true;
+				}
+			}
+		}
+
+		// move to the next variable of the given name
+
+		bool find(const char *name, matvar_info& info)
+		{
+			while (next(info))
+			{
+				if (info.name == name) return true;
+			}
+			return false;
+		}
+
+		// read the current variable into a matrix of the right size,
+		// whose element type must correspond to the class
+
+		template<typename T, class Mat>
+		void read(IRegularMatrix<Mat, T>& dst)
+		{
+			if (!m_data_ok)
+				throw invalid_operation("matfile_reader::read: no numeric variable to read.");
+
+			if (m_info.class_id != type_to_mat_class<T>::value)
+				throw invalid_argument("matfile_reader::read: the element type does not match the class.");
+
+			LMAT_CHECK_DIMS( dst.nrows() == m_info.nrows && dst.ncolumns() == m_info.ncols )
+
+			const index_t m = dst.nrows();
+			const index_t n = dst.ncolumns();
+			const size_t es = internal::mat_data_type_size(m_dtype);
+
+			if (es == 0 || (uint64_t)m_dbytes != (uint64_t)m * (uint64_t)n * es)
+				throw io_error("Corrupted MAT-file.");
+
+			m_data_ok = false;
+			if (m == 0 || n == 0) return;
+
+			Mat& d = dst.derived();
+
+			if (d.row_stride() == 1)
+			{
+				for (index_t j = 0; j < n; ++j)
+					read_data(&d(0, j), (size_t)m);
+			}
+			else
+			{
+				dense_col<T> buf(m);
+				for (index_t j = 0; j < n; ++j)
+				{
+					read_data(buf.ptr_data(), (size_t)m);
+					for (index_t i = 0; i < m; ++i) d(i, j) = buf[i];
+				}
+			}
+		}
+
+		template<typename T, index_t CM, index_t CN, typename Allocator>
+		void read(dense_matrix<T, CM, CN, Allocator>& dst)
+		{
+			if (!m_data_ok)
+				throw invalid_operation("matfile_reader::read: no numeric variable to read.");
+
+			dst.require_size(m_info.nrows, m_info.ncols);
+			read(static_cast<IRegularMatrix<dense_matrix<T, CM, CN, Allocator>, T>&>(dst));
+		}
+
+	private:
+		void read_header(matvar_info& info)
+		{
+			uint32_t tag[2];
+			uint32_t flags[2];
+
+			read_raw(tag, 8);
+			if (tag[0] != internal::mi_uint32 || tag[1] != 8)
+				throw io_error("Corrupted MAT-file.");
+			read_raw(flags, 8);
+
+			info.class_id = (mat_class_id)(flags[0] & 0xff);
+			info.is_logical = (flags[0] & internal::mat_logical_flag) != 0;
+			info.is_complex = (flags[0] & internal::mat_complex_flag) != 0;
+
+			// dimensions
+
+			read_raw(tag, 8);
+			if (tag[0] != internal::mi_int32 || tag[1] < 8 || tag[1] % 4 != 0)
+				throw io_error("Corrupted MAT-file.");
+
+			const uint32_t nd = tag[1] / 4;
+			std::vector<int32_t> dims(internal::mat_pad8(tag[1]) / 4);
+			read_raw(dims.data(), dims.size() * 4);
+
+			const int64_t max_dim = (int64_t)std::numeric_limits<index_t>::max();
+			int64_t ncols = 1;
+			for (uint32_t k = 0; k < nd; ++k)
+			{
+				if (dims[k] < 0)
+					throw io_error("Corrupted MAT-file.");
+				if (k > 0)
+				{
+					ncols *= dims[k];
+					if (ncols > max_dim)
+						throw io_error("matfile_reader: the variable is too large.");
+				}
+			}
+
+			if (dims[0] > 0 && ncols > max_dim / dims[0])
+				throw io_error("matfile_reader: the variable is too large.");
+
+			info.nrows = (index_t)dims[0];
+			info.ncols = (index_t)ncols;
+
+			// name
+
+			read_raw(tag, 8);
+			if ((tag[0] >> 16) != 0)
+			{
+				const uint32_t len = tag[0] >> 16;
+				if (len > 4)
+					throw io_error("Corrupted MAT-file.");
+				info.name.assign(reinterpret_cast<const char*>(tag + 1), len);
+			}
+			else
+			{
+				std::vector<char> s(internal::mat_pad8(tag[1]));
+				read_raw(s.data(), s.size());
+				info.name.assign(s.data(), tag[1]);
+			}
+
+			m_info = info;
+
+			// real part
+
+			if (info.is_numeric() && !info.is_complex)
+			{
+				read_raw(tag, 8);
+				m_small = 0;
+
+				if ((tag[0] >> 16) != 0)
+				{
+					m_dtype = tag[0] & 0xffff;
+					m_dbytes = tag[0] >> 16;
+					if (m_dbytes > 4)
+						throw io_error("Corrupted MAT-file.");
+					m_small_data = tag[1];
+					m_small = 1;
+				}
+				else
+				{
+					m_dtype = tag[0];
+					m_dbytes = tag[1];
+				}
+
+				m_data_ok = true;
+			}
+		}
+
+		template<typename T>
+		void read_data(T *dst, size_t n)
+		{
+			typedef type_to_mat_class<T> tmap;
+
+			if (m_dtype == (uint32_t)tmap::data_type)
+			{
+				read_raw(dst, n * sizeof(T));
+			}
+			else
+			{
+				switch (m_dtype)
+				{
+				case internal::mi_int8:   read_as<int8_t>(dst, n); break;
+				case internal::mi_uint8:  read_as<uint8_t>(dst, n); break;
+				case internal::mi_int16:  read_as<int16_t>(dst, n); break;
+				case internal::mi_uint16: read_as<uint16_t>(dst, n); break;
+				case internal::mi_int32:  read_as<int32_t>(dst, n); break;
+				case internal::mi_uint32: read_as<uint32_t>(dst, n); break;
+				case internal::mi_single: read_as<float>(dst, n); break;
+				case internal::mi_double: read_as<double>(dst, n); break;
+				case internal::mi_int64:  read_as<int64_t>(dst, n); break;
+				case internal::mi_uint64: read_as<uint64_t>(dst, n); break;
+				default:
+					throw io_error("Unsupported data type in MAT-file.");
+				}
+			}
+		}
+
+		// data stored in a narrower type (as MATLAB does to save space)
+
+		template<typename S, typename T>
+		void read_as(T *dst, size_t n)
+		{
+			const size_t cn = internal::mat_io_chunk / sizeof(S);
+			S buf[internal::mat_io_chunk / sizeof(S)];
+
+			while (n > 0)
+			{
+				size_t k = n < cn ? n : cn;
+				read_raw(buf, k * sizeof(S));
+				for (size_t i = 0; i < k; ++i) dst[i] = static_cast<T>(buf[i]);
+				dst += k;
+				n -= k;
+			}
+		}
+
+		void read_raw(void *dst, size_t nbytes)
+		{
+			if (m_small)
+			{
+				if (nbytes > 4) throw io_error("Corrupted MAT-file.");
+				std::memcpy(dst, &m_small_data, nbytes);
+				m_small_data = nbytes < 4 ? m_small_data >> (8 * nbytes) : 0;
+				return;
+			}
+
+			if (m_inflating)
+			{
+				inflate_raw(static_cast<unsigned char*>(dst), nbytes);
+			}
+			else
+			{
+				if (std::fread(dst, 1, nbytes, m_fp) != nbytes)
+					throw io_error("Corrupted MAT-file.");
+			}
+		}
+
+#ifdef LMAT_USE_ZLIB
+
+		void begin_inflate(uint32_t nbytes)
+		{
+			std::memset(&m_zs, 0, sizeof(m_zs));
+			if (inflateInit(&m_zs) != Z_OK)
+				throw io_error("matfile_reader: failed to initialize zlib.");
+			m_inflating = true;
+			m_zleft = nbytes;
+			m_small = 0;
+		}
+
+		void end_inflate()
+		{
+			if (m_inflating)
+			{
+				inflateEnd(&m_zs);
+				m_inflating = false;
+			}
+			m_small = 0;
+		}
+
+		void inflate_raw(unsigned char *dst, size_t nbytes)
+		{
+			while (nbytes > 0)
+			{
+				const size_t k = nbytes < (size_t(1) << 30) ? nbytes : (size_t(1) << 30);
+				m_zs.next_out = dst;
+				m_zs.avail_out = (uInt)k;
+
+				while (m_zs.avail_out > 0)
+				{
+					if (m_zs.avail_in == 0)
+					{
+						if (m_zleft == 0) throw io_error("Corrupted MAT-file.");
+						size_t r = m_zleft < sizeof(m_zbuf) ? m_zleft : sizeof(m_zbuf);
+						if (std::fread(m_zbuf, 1, r, m_fp) != r)
+							throw io_error("Corrupted MAT-file.");
+						m_zleft -= (uint32_t)r;
+						m_zs.next_in = m_zbuf;
+						m_zs.avail_in = (uInt)r;
+					}
+
+					int ret = inflate(&m_zs, Z_NO_FLUSH);
+					if (ret != Z_OK && !(ret == Z_STREAM_END && m_zs.avail_out == 0))
+						throw io_error("Corrupted compressed data in MAT-file.");
+				}
+
+				dst += k;
+				nbytes -= k;
+			}
+		}
+
+#else
+
+		void begin_inflate(uint32_t )
+		{
+			throw io_error("Compressed MAT-file requires zlib (define LMAT_USE_ZLIB).");
+		}
+
+		void end_inflate()
+		{
+			m_small = 0;
+		}
+
+		void inflate_raw(unsigned char *, size_t ) { }
+
+#endif
+
+	private:
+		std::FILE *m_fp;
+		uint64_t m_next;	// offset of the next data element
+		bool m_inflating;
+		bool m_data_ok;
+		int m_small;
+
+		matvar_info m_info;
+		uint32_t m_dtype;
+		uint32_t m_dbytes;
+		uint32_t m_small_data;
+
+#ifdef LMAT_USE_ZLIB
+		z_stream m_zs;
+		uint32_t m_zleft;
+		unsigned char m_zbuf[internal::mat_io_chunk];
+#endif
+	};
+
+
+	/********************************************
+	 *
+	 *  writer
+	 *
+	 ********************************************/
+
+	class matfile_writer : private noncopyable
+	{
+	public:
+		explicit matfile_writer(const char *path, bool compress = false)
+		: m_fp(std::fopen(path, "wb")), m_compress(compress), m_deflating(false)
+		{
+			if (!m_fp) throw io_error("matfile_writer: failed to open the file.");
+
+#ifndef LMAT_USE_ZLIB
+			if (compress)
+			{
+				std::fclose(m_fp);
+				throw invalid_argument("matfile_writer: compression requires zlib (define LMAT_USE_ZLIB).");
+			}
+#endif
+
+			char h[128];
+			std::memset(h, ' ', 116);
+			const char *desc = "MATLAB 5.0 MAT-file, created by light-matrix";
+			std::memcpy(h, desc, std::strlen(desc));
+			std::memset(h + 116, 0, 8);
+
+			uint16_t ver = 0x0100;
+			std::memcpy(h + 124, &ver, 2);
+			h[126] = 'I';
+			h[127] = 'M';
+
+			if (std::fwrite(h, 1, 128, m_fp) != 128)
+			{
+				std::fclose(m_fp);
+				throw io_error("matfile_writer: failed to write the file.");
+			}
+		}
+
+		~matfile_writer()
+		{
+			if (m_fp) std::fclose(m_fp);
+		}
+
+		void close()
+		{
+			if (m_fp)
+			{
+				bool ok = std::fclose(m_fp) == 0;
+				m_fp = 0;
+				if (!ok) throw io_error("matfile_writer: failed to write the file.");
+			}
+		}
+
+	public:
+		template<typename T, class Mat>
+		void write(const char *name, const IRegularMatrix<Mat, T>& a)
+		{
+			typedef type_to_mat_class<T> tmap;
+
+			const uint32_t nlen = (uint32_t)std::strlen(name);
+			check_arg(nlen > 0 && nlen < 64, "matfile_writer::write: invalid variable name.");
+
+			if (!m_fp) throw invalid_operation("matfile_writer::write: the file has been closed.");
+
+			const index_t m = a.nrows();
+			const index_t n = a.ncolumns();
+			const uint64_t dbytes = (uint64_t)m * (uint64_t)n * sizeof(T);
+			if (dbytes > 0xfffffff0u)
+				throw invalid_argument("matfile_writer::write: the variable is too large for MAT v5.");
+
+			const uint32_t nbytes_name = nlen <= 4 ? 8 : 8 + internal::mat_pad8(nlen);
+			const uint32_t total = 16 + 16 + nbytes_name + 8 + internal::mat_pad8((uint32_t)dbytes);
+
+			uint64_t tag_pos;
+			if (!internal::cfile_tell(m_fp, tag_pos))
+				throw io_error("matfile_writer: failed to write the file.");
+
+			element_guard g(*this);
+			begin_element(total);
+
+			// array flags
+
+			uint32_t flags = (uint32_t)tmap::value;
+			if (tmap::is_logical) flags |= internal::mat_logical_flag;
+
+			write_tag(internal::mi_uint32, 8);
+			uint32_t fw[2] = {flags, 0};
+			write_raw(fw, 8);
+
+			// dimensions
+
+			write_tag(internal::mi_int32, 8);
+			int32_t dims[2] = {(int32_t)m, (int32_t)n};
+			write_raw(dims, 8);
+
+			// name
+
+			if (nlen <= 4)
+			{
+				uint32_t t[2] = {(nlen << 16) | internal::mi_int8, 0};
+				std::memcpy(t + 1, name, nlen);
+				write_raw(t, 8);
+			}
+			else
+			{
+				write_tag(internal::mi_int8, nlen);
+				write_raw(name, nlen);
+				write_pad(nlen);
+			}
+
+			// real part
+
+			write_tag(tmap::data_type, (uint32_t)dbytes);
+
+			if (m > 0 && n > 0)
+			{
+				const Mat& a_ = a.derived();
+
+				if (a_.row_stride() == 1)
+				{
+					for (index_t j = 0; j < n; ++j)
+						write_raw(&a_(0, j), (size_t)m * sizeof(T));
+				}
+				else
+				{
+					dense_col<T> buf(m);
+					for (index_t j = 0; j < n; ++j)
+					{
+						for (index_t i = 0; i < m; ++i) buf[i] = a_(i, j);
+						write_raw(buf.ptr_data(), (size_t)m * sizeof(T));
+					}
+				}
+			}
+			write_pad((uint32_t)dbytes);
+
+			end_element(tag_pos);
+		}
+
+	private:
+		class element_guard : private noncopyable
+		{
+		public:
+			explicit element_guard(matfile_writer& w) : m_w(w) { }
+			~element_guard() { m_w.abort_element(); }
+
+		private:
+			matfile_writer& m_w;
+		};
+
+		void write_tag(uint32_t type, uint32_t nbytes)
+		{
+			uint32_t t[2] = {type, nbytes};
+			write_raw(t, 8);
+		}
+
+		void write_pad(uint32_t nbytes)
+		{
+			const uint32_t r = internal::mat_pad8(nbytes) - nbytes;
+			if (r > 0)
+			{
+				char z[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+				write_raw(z, r);
+			}
+		}
+
+		void fwrite_checked(const void *p, size_t nbytes)
+		{
+			if (std::fwrite(p, 1, nbytes, m_fp) != nbytes)
+				throw io_error("matfile_writer: failed to write the file.");
+		}
+
+#ifdef LMAT_USE_ZLIB
+
+		void begin_element(uint32_t total)
+		{
+			if (m_compress)
+			{
+				write_tag(internal::mi_compressed, 0);	// size is patched at the end
+
+				std::memset(&m_zs, 0, sizeof(m_zs));
+				if (deflateInit(&m_zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+					throw io_error("matfile_writer: failed to initialize zlib.");
+				m_deflating = true;
+				m_zbytes = 0;
+			}
+
+			write_tag(internal::mi_matrix, total);
+		}
+
+		void end_element(uint64_t tag_pos)
+		{
+			if (m_deflating)
+			{
+				deflate_raw(0, 0, Z_FINISH);
+				abort_element();
+
+				uint64_t end_pos;
+				uint32_t nb = (uint32_t)m_zbytes;
+				if (!internal::cfile_tell(m_fp, end_pos) ||
+					!internal::cfile_seek(m_fp, tag_pos + 4, SEEK_SET) ||
+					std::fwrite(&nb, 4, 1, m_fp) != 1 ||
+					!internal::cfile_seek(m_fp, end_pos, SEEK_SET))
+					throw io_error("matfile_writer: failed to write the file.");
+			}
+		}
+
+		// releases the stream of an element left unfinished (e.g. by an exception)
+
+		void abort_element()
+		{
+			if (m_deflating)
+			{
+				deflateEnd(&m_zs);
+				m_deflating = false;
+			}
+		}
+
+		void write_raw(const void *p, size_t nbytes)
+		{
+			if (m_deflating)
+				deflate_raw(static_cast<const unsigned char*>(p), nbytes, Z_NO_FLUSH);
+			else
+				fwrite_checked(p, nbytes);
+		}
+
+		void deflate_raw(const unsigned char *p, size_t nbytes, int flush)
+		{
+			m_zs.next_in = const_cast<unsigned char*>(p);
+			m_zs.avail_in = (uInt)nbytes;
+
+			int ret;
+			do
+			{
+				m_zs.next_out = m_zbuf;
+				m_zs.avail_out = (uInt)sizeof(m_zbuf);
+				ret = deflate(&m_zs, flush);
+				if (ret == Z_STREAM_ERROR)
+					throw io_error("matfile_writer: compression failed.");
+
+				size_t k = sizeof(m_zbuf) - m_zs.avail_out;
+				fwrite_checked(m_zbuf, k);
+				m_zbytes += k;
+			}
+			while (m_zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+		}
+
+#else
+
+		void begin_element(uint32_t total)
+		{
+			write_tag(internal::mi_matrix, total);
+		}
+
+		void end_element(uint64_t ) { }
+
+		void abort_element() { }
+
+		void write_raw(const void *p, size_t nbytes)
+		{
+			fwrite_checked(p, nbytes);
+		}
+
+#endif
+
+	private:
+		std::FILE *m_fp;
+		bool m_compress;
+		bool m_deflating;
+
+#ifdef LMAT_USE_ZLIB
+		z_stream m_zs;
+		size_t m_zbytes;
+		unsigned char m_zbuf[internal::mat_io_chunk];
+#endif
+	};
+
+
+	/********************************************
+	 *
+	 *  convenient functions
+	 *
+	 ********************************************/
+
+	template<typename T, index_t CM, index_t CN, typename Allocator>
+	inline bool load_matvar(const char *path, const char *name, dense_matrix<T, CM, CN, Allocator>& a)
+	{
+		matfile_reader rd(path);
+		matvar_info info;
+		if (!rd.find(name, info)) return false;
+		rd.read(a);
+		return true;
+	}
+
+	template<typename T, class Mat>
+	inline void save_matvar(const char *path, const char *name, const IRegularMatrix<Mat, T>& a,
+			bool compress = false)
+	{
+		matfile_writer w(path, compress);
+		w.write(name, a);
+		w.close();
+	}
+
+}
+
+#endif /* MATFILE_H_ */
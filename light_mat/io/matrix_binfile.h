@@ -0,0 +1,546 @@
+/**
+ * @file matrix_binfile.h
+ *
+ * @brief Binary matrix files & memory-mapped views
+ *
+ * A binary matrix file consists of a 64-byte header, followed by
+ * zero padding up to the payload alignment, and the elements in
+ * column-major order:
+ *
+ *   magic        char[8]   "LMATBIN"
+ *   version      uint32
+ *   byte_order   uint32    0x01020304 as written by the host
+ *   dtype        uint32    see binmat_dtype
+ *   elem_size    uint32
+ *   nrows        int64
+ *   ncols        int64
+ *   data_offset  uint64    from the beginning of the file
+ *   data_bytes   uint64
+ *   alignment    uint32
+ *   reserved     uint32
+ *
+ * mapped_binmat maps a file into memory and provides cref_matrix /
+ * ref_matrix views directly over the mapping, so opening a file
+ * costs O(1) regardless of its size. Pages are loaded on demand.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MATRIX_BINFILE_H_
+#define LIGHTMAT_MATRIX_BINFILE_H_
+
+#include <light_mat/matrix/matrix_classes.h>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if LIGHTMAT_PLATFORM == LIGHTMAT_WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// default alignment of the payload (in bytes)
+#ifndef LMAT_BINMAT_ALIGN
+#define LMAT_BINMAT_ALIGN 64
+#endif
+
+namespace lmat
+{
+
+	/********************************************
+	 *
+	 *  errors
+	 *
+	 ********************************************/
+
+	class io_error : public std::exception
+	{
+	public:
+		LMAT_ENSURE_INLINE
+		io_error(const char *msg)
+		: m_msg(msg)
+		{
+		}
+
+		virtual const char* what() const throw()
+		{
+			return m_msg;
+		}
+
+	private:
+		const char *m_msg;
+	};
+
+
+	/********************************************
+	 *
+	 *  element types & header
+	 *
+	 ********************************************/
+
+	enum binmat_dtype
+	{
+		binmat_int8    = 1,
+		binmat_uint8   = 2,
+		binmat_int16   = 3,
+		binmat_uint16  = 4,
+		binmat_int32   = 5,
+		binmat_uint32  = 6,
+		binmat_int64   = 7,
+		binmat_uint64  = 8,
+		binmat_float32 = 9,
+		binmat_float64 = 10,
+		binmat_bool    = 11
+	};
+
+	template<typename T> struct type_to_binmat_dtype;
+
+#define LMAT_DEFINE_BINMAT_TYPEMAP(C, T) \
+	template<> struct type_to_binmat_dtype<T> { static const binmat_dtype value = C; };
+
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_int8,    int8_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_uint8,   uint8_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_int16,   int16_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_uint16,  uint16_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_int32,   int32_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_uint32,  uint32_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_int64,   int64_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_uint64,  uint64_t)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_float32, float)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_float64, double)
+	LMAT_DEFINE_BINMAT_TYPEMAP(binmat_bool,    bool)
+
+#undef LMAT_DEFINE_BINMAT_TYPEMAP
+
+	struct binmat_header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t byte_order;
+		uint32_t dtype;
+		uint32_t elem_size;
+		int64_t nrows;
+		int64_t ncols;
+		uint64_t data_offset;
+		uint64_t data_bytes;
+		uint32_t alignment;
+		uint32_t reserved;
+	};
+
+	static_assert(sizeof(binmat_header) == 64, "binmat_header must have 64 bytes.");
+
+	namespace internal
+	{
+		const uint32_t binmat_version = 1;
+		const uint32_t binmat_byte_order = 0x01020304;
+
+		LMAT_ENSURE_INLINE
+		inline bool binmat_magic_ok(const binmat_header& h)
+		{
+			return std::memcmp(h.magic, "LMATBIN", 8) == 0;
+		}
+
+		template<typename T>
+		inline binmat_header make_binmat_header(index_t m, index_t n, uint32_t align)
+		{
+			binmat_header h;
+			std::memset(&h, 0, sizeof(h));
+			std::memcpy(h.magic, "LMATBIN", 8);
+
+			h.version = binmat_version;
+			h.byte_order = binmat_byte_order;
+			h.dtype = (uint32_t)type_to_binmat_dtype<T>::value;
+			h.elem_size = (uint32_t)sizeof(T);
+			h.nrows = (int64_t)m;
+			h.ncols = (int64_t)n;
+			h.alignment = align;
+			h.data_offset = (uint64_t)((sizeof(binmat_header) + align - 1) / align * align);
+			h.data_bytes = (uint64_t)m * (uint64_t)n * sizeof(T);
+			return h;
+		}
+
+		inline void check_binmat_header(const binmat_header& h, uint64_t file_size)
+		{
+			if (!binmat_magic_ok(h))
+				throw io_error("Not a binary matrix file.");
+
+			if (h.byte_order != binmat_byte_order)
+				throw io_error("The binary matrix file has a different byte order.");
+
+			if (h.version != binmat_version)
+				throw io_error("Unsupported version of binary matrix file.");
+
+			if (h.nrows < 0 || h.ncols < 0 || h.elem_size == 0 ||
+				h.data_offset < sizeof(binmat_header) || h.data_offset > file_size)
+				throw io_error("Corrupted binary matrix file.");
+
+			// the views & matrices count their elements with index_t
+
+			const uint64_t max_elems = (uint64_t)std::numeric_limits<index_t>::max();
+			const uint64_t m = (uint64_t)h.nrows;
+			const uint64_t n = (uint64_t)h.ncols;
+
+			if (m > max_elems || n > max_elems || (m > 0 && n > max_elems / m))
+				throw io_error("The binary matrix file has too many elements.");
+
+			const uint64_t ne = m * n;
+			if (ne > std::numeric_limits<uint64_t>::max() / h.elem_size ||
+				h.data_bytes != ne * h.elem_size ||
+				h.data_bytes > file_size - h.data_offset)
+				throw io_error("Corrupted binary matrix file.");
+		}
+
+		// the payload is viewed in place, hence it has to be aligned
+		// to the element size (the mapping itself is page-aligned)
+
+		template<typename T>
+		LMAT_ENSURE_INLINE
+		inline void check_binmat_payload_align(const binmat_header& h)
+		{
+			if (h.data_offset % sizeof(T) != 0)
+				throw io_error("The payload of the binary matrix file is misaligned.");
+		}
+
+		// 64-bit file positioning (long has 32 bits on LLP64)
+
+		inline bool cfile_seek(std::FILE *fp, uint64_t offset, int origin)
+		{
+#if LIGHTMAT_PLATFORM == LIGHTMAT_WIN32
+			return offset <= (uint64_t)std::numeric_limits<__int64>::max() &&
+					::_fseeki64(fp, (__int64)offset, origin) == 0;
+#else
+			return offset <= (uint64_t)std::numeric_limits<off_t>::max() &&
+					::fseeko(fp, (off_t)offset, origin) == 0;
+#endif
+		}
+
+		inline bool cfile_tell(std::FILE *fp, uint64_t& offset)
+		{
+#if LIGHTMAT_PLATFORM == LIGHTMAT_WIN32
+			const __int64 pos = ::_ftelli64(fp);
+#else
+			const off_t pos = ::ftello(fp);
+#endif
+			if (pos < 0) return false;
+			offset = (uint64_t)pos;
+			return true;
+		}
+
+		inline bool cfile_size(std::FILE *fp, uint64_t& size)
+		{
+			return cfile_seek(fp, 0, SEEK_END) && cfile_tell(fp, size);
+		}
+
+		template<typename T>
+		LMAT_ENSURE_INLINE
+		inline void check_binmat_dtype(const binmat_header& h)
+		{
+			if (h.dtype != (uint32_t)type_to_binmat_dtype<T>::value || h.elem_size != sizeof(T))
+				throw invalid_argument("The element type does not match that of the binary matrix file.");
+		}
+
+		// RAII wrapper of a C file
+
+		class cfile_guard : private noncopyable
+		{
+		public:
+			cfile_guard(const char *path, const char *mode)
+			: m_fp(std::fopen(path, mode)) { }
+
+			~cfile_guard()
+			{
+				if (m_fp) std::fclose(m_fp);
+			}
+
+			std::FILE *get() const { return m_fp; }
+
+			bool close()
+			{
+				bool ok = std::fclose(m_fp) == 0;
+				m_fp = 0;
+				return ok;
+			}
+
+		private:
+			std::FILE *m_fp;
+		};
+	}
+
+
+	/********************************************
+	 *
+	 *  write & read
+	 *
+	 ********************************************/
+
+	template<typename T, class Mat>
+	void write_binmat(const char *path, const IRegularMatrix<Mat, T>& a,
+			uint32_t align = LMAT_BINMAT_ALIGN)
+	{
+		check_arg(align > 0 && (align & (align - 1)) == 0,
+				"write_binmat: align must be a power of 2.");
+
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+		const binmat_header h = internal::make_binmat_header<T>(m, n, align);
+
+		internal::cfile_guard f(path, "wb");
+		if (!f.get()) throw io_error("write_binmat: failed to open the file.");
+
+		bool ok = std::fwrite(&h, sizeof(h), 1, f.get()) == 1;
+
+		const size_t npad = (size_t)h.data_offset - sizeof(h);
+		if (ok && npad > 0)
+		{
+			std::vector<char> pad(npad, 0);
+			ok = std::fwrite(pad.data(), 1, npad, f.get()) == npad;
+		}
+
+		if (ok && m > 0 && n > 0)
+		{
+			const Mat& a_ = a.derived();
+
+			if (a_.row_stride() == 1 && (a_.col_stride() == m || n == 1))
+			{
+				const size_t len = (size_t)m * (size_t)n;
+				ok = std::fwrite(a_.ptr_data(), sizeof(T), len, f.get()) == len;
+			}
+			else
+			{
+				dense_col<T> buf(m);
+				for (index_t j = 0; ok && j < n; ++j)
+				{
+					for (index_t i = 0; i < m; ++i) buf[i] = a_(i, j);
+					ok = std::fwrite(buf.ptr_data(), sizeof(T), (size_t)m, f.get()) == (size_t)m;
+				}
+			}
+		}
+
+		if (!f.close() || !ok)
+			throw io_error("write_binmat: failed to write the file.");
+	}
+
+
+	inline binmat_header read_binmat_header(const char *path)
+	{
+		internal::cfile_guard f(path, "rb");
+		if (!f.get()) throw io_error("read_binmat_header: failed to open the file.");
+
+		binmat_header h;
+		if (std::fread(&h, sizeof(h), 1, f.get()) != 1)
+			throw io_error("Not a binary matrix file.");
+
+		uint64_t file_size = 0;
+		if (!internal::cfile_size(f.get(), file_size))
+			throw io_error("read_binmat_header: failed to get the file size.");
+
+		internal::check_binmat_header(h, file_size);
+		return h;
+	}
+
+
+	template<typename T, index_t CM, index_t CN, typename Allocator>
+	void read_binmat(const char *path, dense_matrix<T, CM, CN, Allocator>& a)
+	{
+		const binmat_header h = read_binmat_header(path);
+		internal::check_binmat_dtype<T>(h);
+
+		a.require_size((index_t)h.nrows, (index_t)h.ncols);
+
+		internal::cfile_guard f(path, "rb");
+		if (!f.get()) throw io_error("read_binmat: failed to open the file.");
+
+		const size_t len = (size_t)(h.nrows * h.ncols);
+		if (!internal::cfile_seek(f.get(), h.data_offset, SEEK_SET) ||
+			std::fread(a.ptr_data(), sizeof(T), len, f.get()) != len)
+			throw io_error("read_binmat: failed to read the file.");
+	}
+
+
+	/********************************************
+	 *
+	 *  memory-mapped file
+	 *
+	 ********************************************/
+
+	class mapped_binmat : private noncopyable
+	{
+	public:
+		explicit mapped_binmat(const char *path, bool writable = false)
+		: m_base(0), m_size(0), m_writable(writable)
+		{
+			map_file(path);
+
+			if (m_size < sizeof(binmat_header))
+			{
+				unmap_file();
+				throw io_error("Not a binary matrix file.");
+			}
+
+			std::memcpy(&m_header, m_base, sizeof(binmat_header));
+
+			try
+			{
+				internal::check_binmat_header(m_header, (uint64_t)m_size);
+			}
+			catch (...)
+			{
+				unmap_file();
+				throw;
+			}
+		}
+
+		~mapped_binmat()
+		{
+			unmap_file();
+		}
+
+	public:
+		LMAT_ENSURE_INLINE const binmat_header& header() const
+		{
+			return m_header;
+		}
+
+		LMAT_ENSURE_INLINE binmat_dtype dtype() const
+		{
+			return (binmat_dtype)m_header.dtype;
+		}
+
+		LMAT_ENSURE_INLINE index_t nrows() const
+		{
+			return (index_t)m_header.nrows;
+		}
+
+		LMAT_ENSURE_INLINE index_t ncolumns() const
+		{
+			return (index_t)m_header.ncols;
+		}
+
+		LMAT_ENSURE_INLINE bool is_writable() const
+		{
+			return m_writable;
+		}
+
+		template<typename T>
+		LMAT_ENSURE_INLINE bool is_type() const
+		{
+			return m_header.dtype == (uint32_t)type_to_binmat_dtype<T>::value;
+		}
+
+		template<typename T>
+		cref_matrix<T> cview() const
+		{
+			internal::check_binmat_dtype<T>(m_header);
+			internal::check_binmat_payload_align<T>(m_header);
+			return cref_matrix<T>(reinterpret_cast<const T*>(m_base + m_header.data_offset),
+					nrows(), ncolumns());
+		}
+
+		// changes made through the view are written back to the file
+
+		template<typename T>
+		ref_matrix<T> view()
+		{
+			if (!m_writable)
+				throw invalid_operation("mapped_binmat::view: the file is mapped as read-only.");
+
+			internal::check_binmat_dtype<T>(m_header);
+			internal::check_binmat_payload_align<T>(m_header);
+			return ref_matrix<T>(reinterpret_cast<T*>(m_base + m_header.data_offset),
+					nrows(), ncolumns());
+		}
+
+	private:
+
+#if LIGHTMAT_PLATFORM == LIGHTMAT_WIN32
+
+		void map_file(const char *path)
+		{
+			HANDLE hf = ::CreateFileA(path,
+					m_writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+					FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (hf == INVALID_HANDLE_VALUE)
+				throw io_error("mapped_binmat: failed to open the file.");
+
+			LARGE_INTEGER sz;
+			if (!::GetFileSizeEx(hf, &sz) || sz.QuadPart == 0)
+			{
+				::CloseHandle(hf);
+				throw io_error("Not a binary matrix file.");
+			}
+			m_size = (size_t)sz.QuadPart;
+
+			HANDLE hm = ::CreateFileMappingA(hf, NULL,
+					m_writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+			::CloseHandle(hf);
+			if (!hm) throw io_error("mapped_binmat: failed to map the file.");
+
+			void *p = ::MapViewOfFile(hm, m_writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+			::CloseHandle(hm);
+			if (!p) throw io_error("mapped_binmat: failed to map the file.");
+
+			m_base = static_cast<char*>(p);
+		}
+
+		void unmap_file()
+		{
+			if (m_base)
+			{
+				::UnmapViewOfFile(m_base);
+				m_base = 0;
+			}
+		}
+
+#else
+
+		void map_file(const char *path)
+		{
+			int fd = ::open(path, m_writable ? O_RDWR : O_RDONLY);
+			if (fd < 0) throw io_error("mapped_binmat: failed to open the file.");
+
+			struct stat st;
+			if (::fstat(fd, &st) != 0 || st.st_size == 0)
+			{
+				::close(fd);
+				throw io_error("Not a binary matrix file.");
+			}
+			m_size = (size_t)st.st_size;
+
+			void *p = ::mmap(0, m_size,
+					m_writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+			::close(fd);
+			if (p == MAP_FAILED) throw io_error("mapped_binmat: failed to map the file.");
+
+			m_base = static_cast<char*>(p);
+		}
+
+		void unmap_file()
+		{
+			if (m_base)
+			{
+				::munmap(m_base, m_size);
+				m_base = 0;
+			}
+		}
+
+#endif
+
+	private:
+		char *m_base;
+		size_t m_size;
+		bool m_writable;
+		binmat_header m_header;
+	};
+
+}
+
+#endif /* MATRIX_BINFILE_H_ */
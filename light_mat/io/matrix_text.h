@@ -0,0 +1,533 @@
+/**
+ * @file matrix_text.h
+ *
+ * @brief Reading & writing matrices as delimited text (CSV/TSV)
+ *
+ * Each non-blank line is a row, and the fields of a row are separated
+ * by a delimiter (',' for CSV and '\t' for TSV). Quoted fields are not
+ * supported, as the files are expected to contain numbers only.
+ *
+ * The reader processes a file in chunks of complete lines. The lines
+ * of a chunk are parsed in parallel on the current executor (see
+ * common/exec.h), in blocks of at least LMAT_TEXTMAT_PAR_LINES lines,
+ * and the values are written directly to their places in the
+ * column-major destination.
+ * When the destination is a dense_matrix, a first pass that merely
+ * counts the lines determines its size. Numbers are parsed with an
+ * exact fast path for decimals with at most 19 significant digits and
+ * a decimal exponent within [-22, 22], and with strtod otherwise.
+ *
+ * The writer formats each floating-point value with the fewest
+ * significant digits that read back to the same value, and writes
+ * the file through a large buffer.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MATRIX_TEXT_H_
+#define LIGHTMAT_MATRIX_TEXT_H_
+
+#include <light_mat/io/matrix_binfile.h>
+#include <light_mat/common/exec.h>
+#include <cstdlib>
+#include <memory>
+
+// number of bytes read in a chunk
+#ifndef LMAT_TEXTMAT_CHUNK
+#define LMAT_TEXTMAT_CHUNK (1 << 24)
+#endif
+
+// minimum number of lines parsed by a parallel task
+#ifndef LMAT_TEXTMAT_PAR_LINES
+#define LMAT_TEXTMAT_PAR_LINES 1024
+#endif
+
+// size of the output buffer of write_textmat (in bytes)
+#ifndef LMAT_TEXTMAT_WBUF
+#define LMAT_TEXTMAT_WBUF (1 << 20)
+#endif
+
+namespace lmat
+{
+
+	/********************************************
+	 *
+	 *  text formats
+	 *
+	 ********************************************/
+
+	struct text_format
+	{
+		char delim;
+		bool skip_header;	// whether the first non-blank line is a header
+
+		LMAT_ENSURE_INLINE
+		text_format(char d, bool sh = false)
+		: delim(d), skip_header(sh) { }
+	};
+
+	LMAT_ENSURE_INLINE
+	inline text_format csv_format(bool skip_header = false)
+	{
+		return text_format(',', skip_header);
+	}
+
+	LMAT_ENSURE_INLINE
+	inline text_format tsv_format(bool skip_header = false)
+	{
+		return text_format('\t', skip_header);
+	}
+
+
+	/********************************************
+	 *
+	 *  parsing & formatting
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		LMAT_ENSURE_INLINE
+		inline bool _tm_is_digit(char c)
+		{
+			return (unsigned)(c - '0') < 10u;
+		}
+
+		LMAT_ENSURE_INLINE
+		inline const char* _tm_skip_space(const char *p, char delim)
+		{
+			while (*p == ' ' || (*p == '\t' && delim != '\t')) ++p;
+			return p;
+		}
+
+		LMAT_ENSURE_INLINE
+		inline bool _tm_is_eol(char c)
+		{
+			return c == '\n' || c == '\r' || c == '\0';
+		}
+
+		// parses a real number starting at p, and returns the end of
+		// the number (p if there is no number at p)
+		//
+		// p must point into a null-terminated buffer
+
+		inline const char* parse_real(const char *p, double& v)
+		{
+			static const double p10[23] = {
+				1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+				1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+				1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+			const char *s = p;
+
+			bool neg = false;
+			if (*p == '-') { neg = true; ++p; }
+			else if (*p == '+') ++p;
+
+			uint64_t m = 0;
+			int nd = 0;		// number of digits in m
+			int e10 = 0;
+			bool exact = true;
+			bool any = false;
+
+			for (; *p == '0'; ++p) any = true;
+			for (; _tm_is_digit(*p); ++p)
+			{
+				any = true;
+				if (nd < 19) { m = m * 10 + (uint64_t)(*p - '0'); ++nd; }
+				else { ++e10; if (*p != '0') exact = false; }
+			}
+
+			if (*p == '.')
+			{
+				++p;
+				if (nd == 0)
+				{
+					for (; *p == '0'; ++p) { any = true; --e10; }
+				}
+				for (; _tm_is_digit(*p); ++p)
+				{
+					any = true;
+					if (nd < 19) { m = m * 10 + (uint64_t)(*p - '0'); ++nd; --e10; }
+					else if (*p != '0') exact = false;
+				}
+			}
+
+			if (any)
+			{
+				if (*p == 'e' || *p == 'E')
+				{
+					const char *q = p + 1;
+					bool eneg = false;
+					if (*q == '-') { eneg = true; ++q; }
+					else if (*q == '+') ++q;
+
+					if (_tm_is_digit(*q))
+					{
+						int ex = 0;
+						for (; _tm_is_digit(*q); ++q)
+						{
+							if (ex < 100000) ex = ex * 10 + (*q - '0');
+						}
+						e10 += eneg ? -ex : ex;
+						p = q;
+					}
+				}
+
+				if (exact && m <= ((uint64_t)1 << 53) && e10 >= -22 && e10 <= 22)
+				{
+					double x = (double)m;
+					x = e10 < 0 ? x / p10[-e10] : x * p10[e10];
+					v = neg ? -x : x;
+					return p;
+				}
+			}
+
+			// inexact, nan, inf, or not a number at all
+
+			char *e;
+			v = std::strtod(s, &e);
+			return e;
+		}
+
+		// parses n fields of a line to out[0], out[os], ..., and returns
+		// whether the line is well formed
+
+		template<typename T>
+		inline bool parse_text_row(const char *p, char delim, index_t n, T *out, index_t os)
+		{
+			for (index_t j = 0; j < n; ++j)
+			{
+				p = _tm_skip_space(p, delim);
+
+				double v;
+				const char *q = parse_real(p, v);
+				if (q == p) return false;
+				out[j * os] = static_cast<T>(v);
+
+				p = _tm_skip_space(q, delim);
+				if (j + 1 < n)
+				{
+					if (*p != delim) return false;
+					++p;
+				}
+			}
+			return _tm_is_eol(*p);
+		}
+
+		inline index_t count_text_fields(const char *p, char delim)
+		{
+			index_t n = 1;
+			for (; !_tm_is_eol(*p); ++p)
+			{
+				if (*p == delim) ++n;
+			}
+			return n;
+		}
+
+		// formats v to buf (of at least 32 chars) with the fewest significant
+		// digits that read back to v, and returns the length
+
+		inline int format_real(char *buf, double v)
+		{
+			for (int prec = 15; prec < 17; ++prec)
+			{
+				int len = std::sprintf(buf, "%.*g", prec, v);
+				if (std::strtod(buf, 0) == v) return len;
+			}
+			return std::sprintf(buf, "%.17g", v);
+		}
+
+		inline int format_real(char *buf, float v)
+		{
+			for (int prec = 6; prec < 9; ++prec)
+			{
+				int len = std::sprintf(buf, "%.*g", prec, (double)v);
+				if (std::strtof(buf, 0) == v) return len;
+			}
+			return std::sprintf(buf, "%.9g", (double)v);
+		}
+
+		template<typename T>
+		inline int format_real(char *buf, const T& v)
+		{
+			static_assert(std::is_integral<T>::value, "T must be an arithmetic type.");
+
+			return std::is_signed<T>::value ?
+					std::sprintf(buf, "%lld", (long long)v) :
+					std::sprintf(buf, "%llu", (unsigned long long)v);
+		}
+	}
+
+
+	/********************************************
+	 *
+	 *  chunked reading
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		// reads a file in chunks of complete lines
+
+		class text_chunk_reader : private noncopyable
+		{
+		public:
+			text_chunk_reader(std::FILE *fp, size_t chunk)
+			: m_fp(fp), m_buf(new char[chunk + 1]), m_cap(chunk)
+			, m_len(0), m_next(0), m_saved(0), m_eof(false) { }
+
+			// gets the next chunk [b, e), where *e == '\0'
+
+			bool next(const char*& b, const char*& e)
+			{
+				if (m_next < m_len)
+				{
+					m_buf[m_next] = m_saved;
+					std::memmove(m_buf.get(), m_buf.get() + m_next, m_len - m_next);
+				}
+				m_len -= m_next;
+				m_next = 0;
+
+				size_t cut = 0;
+				for(;;)
+				{
+					if (!m_eof)
+					{
+						if (m_len == m_cap) grow();
+
+						size_t r = std::fread(m_buf.get() + m_len, 1, m_cap - m_len, m_fp);
+						if (m_len + r < m_cap)
+						{
+							if (std::ferror(m_fp))
+								throw io_error("read_textmat: failed to read the file.");
+							m_eof = true;
+						}
+						m_len += r;
+					}
+
+					if (m_eof)
+					{
+						cut = m_len;
+						break;
+					}
+
+					size_t i = m_len;
+					while (i > 0 && m_buf[i - 1] != '\n') --i;
+					if (i > 0)
+					{
+						cut = i;
+						break;
+					}
+				}
+
+				if (cut == 0) return false;
+
+				m_saved = m_buf[cut];
+				m_buf[cut] = '\0';
+				m_next = cut;
+
+				b = m_buf.get();
+				e = m_buf.get() + cut;
+				return true;
+			}
+
+		private:
+			void grow()
+			{
+				std::unique_ptr<char[]> nb(new char[2 * m_cap + 1]);
+				std::memcpy(nb.get(), m_buf.get(), m_len);
+				m_buf.swap(nb);
+				m_cap *= 2;
+			}
+
+		private:
+			std::FILE *m_fp;
+			std::unique_ptr<char[]> m_buf;
+			size_t m_cap;
+			size_t m_len;
+			size_t m_next;
+			char m_saved;
+			bool m_eof;
+		};
+
+		LMAT_ENSURE_INLINE
+		inline const char* _tm_next_line(const char *p, const char *e)
+		{
+			const char *q = static_cast<const char*>(std::memchr(p, '\n', (size_t)(e - p)));
+			return q ? q + 1 : e;
+		}
+
+		LMAT_ENSURE_INLINE
+		inline bool _tm_is_blank(const char *p, char delim)
+		{
+			return _tm_is_eol(*_tm_skip_space(p, delim));
+		}
+
+		// counts the rows (non-blank lines, excluding the header) and the
+		// fields in the first row
+
+		inline void count_text_rows(std::FILE *fp, const text_format& fmt, index_t& m, index_t& n)
+		{
+			text_chunk_reader rd(fp, LMAT_TEXTMAT_CHUNK);
+			bool skip = fmt.skip_header;
+			m = 0;
+			n = 0;
+
+			const char *b, *e;
+			while (rd.next(b, e))
+			{
+				for (const char *p = b; p < e; p = _tm_next_line(p, e))
+				{
+					if (_tm_is_blank(p, fmt.delim)) continue;
+					if (skip) { skip = false; continue; }
+
+					if (m == 0) n = count_text_fields(p, fmt.delim);
+					++m;
+				}
+			}
+		}
+
+		// parses the rows of a file to a column-major m x n destination,
+		// with (i, j) at p[i * rs + j * cs]
+
+		template<typename T>
+		void read_text_rows(std::FILE *fp, const text_format& fmt,
+				index_t m, index_t n, T *dst, index_t rs, index_t cs)
+		{
+			text_chunk_reader rd(fp, LMAT_TEXTMAT_CHUNK);
+			bool skip = fmt.skip_header;
+			const char delim = fmt.delim;
+
+			std::vector<const char*> lines;
+			index_t i0 = 0;
+
+			const char *b, *e;
+			while (rd.next(b, e))
+			{
+				lines.clear();
+				for (const char *p = b; p < e; p = _tm_next_line(p, e))
+				{
+					if (_tm_is_blank(p, delim)) continue;
+					if (skip) { skip = false; continue; }
+					lines.push_back(p);
+				}
+
+				const index_t nl = (index_t)lines.size();
+				if (i0 + nl > m)
+					throw io_error("read_textmat: the file has more rows than expected.");
+
+				const char * const *pl = lines.data();
+				T *pd = dst + i0 * rs;
+				std::atomic<bool> bad(false);
+
+				exec::parallel_for(range(0, nl), LMAT_TEXTMAT_PAR_LINES, [&](const range& r)
+				{
+					const index_t ke = r.end_index();
+					for (index_t k = r.begin_index(); k < ke; ++k)
+					{
+						if (!parse_text_row(pl[k], delim, n, pd + k * rs, cs))
+						{
+							bad = true;
+							return;
+						}
+					}
+				});
+
+				if (bad)
+					throw io_error("read_textmat: malformed row or unexpected number of fields.");
+
+				i0 += nl;
+			}
+
+			if (i0 < m)
+				throw io_error("read_textmat: the file has fewer rows than expected.");
+		}
+	}
+
+
+	/********************************************
+	 *
+	 *  read & write
+	 *
+	 ********************************************/
+
+	// reads to a preallocated destination, whose size must match the file
+
+	template<typename T, class Mat>
+	void read_textmat(const char *path, IRegularMatrix<Mat, T>& a,
+			const text_format& fmt = csv_format())
+	{
+		internal::cfile_guard f(path, "rb");
+		if (!f.get()) throw io_error("read_textmat: failed to open the file.");
+
+		Mat& a_ = a.derived();
+		internal::read_text_rows(f.get(), fmt, a_.nrows(), a_.ncolumns(),
+				a_.ptr_data(), a_.row_stride(), a_.col_stride());
+	}
+
+	template<typename T, index_t CM, index_t CN, typename Allocator>
+	void read_textmat(const char *path, dense_matrix<T, CM, CN, Allocator>& a,
+			const text_format& fmt = csv_format())
+	{
+		internal::cfile_guard f(path, "rb");
+		if (!f.get()) throw io_error("read_textmat: failed to open the file.");
+
+		index_t m, n;
+		internal::count_text_rows(f.get(), fmt, m, n);
+		a.require_size(m, n);
+
+		if (m > 0)
+		{
+			std::rewind(f.get());
+			internal::read_text_rows(f.get(), fmt, m, n, a.ptr_data(), 1, a.col_stride());
+		}
+	}
+
+	template<typename T, class Mat>
+	void write_textmat(const char *path, const IRegularMatrix<Mat, T>& a,
+			const text_format& fmt = csv_format())
+	{
+		internal::cfile_guard f(path, "wb");
+		if (!f.get()) throw io_error("write_textmat: failed to open the file.");
+
+		const Mat& a_ = a.derived();
+		const index_t m = a_.nrows();
+		const index_t n = a_.ncolumns();
+		const index_t rs = a_.row_stride();
+		const index_t cs = a_.col_stride();
+		const T *pa = a_.ptr_data();
+
+		const size_t cap = LMAT_TEXTMAT_WBUF;
+		std::unique_ptr<char[]> buf(new char[cap]);
+		size_t len = 0;
+		bool ok = true;
+
+		for (index_t i = 0; i < m && ok; ++i)
+		{
+			const T *pr = pa + i * rs;
+			for (index_t j = 0; j < n; ++j)
+			{
+				if (cap - len < 40)
+				{
+					ok = std::fwrite(buf.get(), 1, len, f.get()) == len;
+					len = 0;
+					if (!ok) break;
+				}
+
+				len += (size_t)internal::format_real(buf.get() + len, pr[j * cs]);
+				buf[len++] = j + 1 < n ? fmt.delim : '\n';
+			}
+		}
+
+		if (ok && len > 0) ok = std::fwrite(buf.get(), 1, len, f.get()) == len;
+		if (!f.close() || !ok) throw io_error("write_textmat: failed to write the file.");
+	}
+
+}
+
+#endif /* MATRIX_TEXT_H_ */
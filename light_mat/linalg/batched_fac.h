@@ -0,0 +1,711 @@
+/**
+ * @file batched_fac.h
+ *
+ * @brief Batched factorization and solve of small matrices
+ *
+ * A batch of many small matrices of the same size is stored
+ * in an interleaved (structure-of-arrays) layout, such that
+ * each lane of a SIMD pack corresponds to one matrix. The
+ * factorization kernels thus process a whole pack of matrices
+ * with each instruction, and different groups of matrices
+ * are processed in parallel on the current executor (see
+ * common/exec.h).
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_BATCHED_FAC_H_
+#define LIGHTMAT_BATCHED_FAC_H_
+
+#include <light_mat/linalg/linalg_fwd.h>
+#include <light_mat/common/block.h>
+#include <light_mat/simd/simd.h>
+#include <light_mat/math/math_base.h>
+#include <light_mat/common/exec.h>
+
+// minimum number of groups processed by a parallel task
+#ifndef LMAT_BATCH_PAR_GROUPS
+#define LMAT_BATCH_PAR_GROUPS 64
+#endif
+
+namespace lmat
+{
+
+	/********************************************
+	 *
+	 *  mat_batch
+	 *
+	 *  A batch of count matrices, each of size m x n.
+	 *
+	 *  Matrices are organized into groups of W (the
+	 *  SIMD pack width). Within a group, the entries
+	 *  at (i, j) of the W matrices are contiguous.
+	 *  Hence, the entry (i, j) of the k-th matrix
+	 *  is located at
+	 *
+	 *    ((k / W) * (m * n) + j * m + i) * W + k % W
+	 *
+	 *  Trailing lanes of the last group (when count is
+	 *  not a multiple of W) are filled with identity
+	 *  matrices, so that they factorize cleanly.
+	 *
+	 ********************************************/
+
+	template<typename T, typename Kind=default_simd_kind>
+	class mat_batch
+	{
+	public:
+		typedef T value_type;
+		typedef Kind simd_kind;
+		typedef simd_pack<T, Kind> pack_type;
+
+		static const index_t lane_width = (index_t)simd_traits<T, Kind>::pack_width;
+
+		typedef aligned_allocator<T, simd_traits<T, Kind>::pack_bytes> allocator_type;
+
+	public:
+		mat_batch()
+		: m_nrows(0), m_ncols(0), m_count(0) { }
+
+		mat_batch(index_t m, index_t n, index_t count)
+		: m_nrows(0), m_ncols(0), m_count(0)
+		{
+			resize(m, n, count);
+		}
+
+		/**
+		 * Constructs from a stack of matrices, which is an
+		 * m x (n * count) matrix, where the k-th matrix occupies
+		 * the columns [k * n, (k + 1) * n).
+		 */
+		template<class Mat>
+		mat_batch(const IRegularMatrix<Mat, T>& stack, index_t n)
+		: m_nrows(0), m_ncols(0), m_count(0)
+		{
+			gather(stack, n);
+		}
+
+	public:
+		LMAT_ENSURE_INLINE index_t nrows() const
+		{
+			return m_nrows;
+		}
+
+		LMAT_ENSURE_INLINE index_t ncolumns() const
+		{
+			return m_ncols;
+		}
+
+		LMAT_ENSURE_INLINE index_t count() const
+		{
+			return m_count;
+		}
+
+		LMAT_ENSURE_INLINE index_t ngroups() const
+		{
+			return (m_count + lane_width - 1) / lane_width;
+		}
+
+		LMAT_ENSURE_INLINE index_t group_size() const
+		{
+			return m_nrows * m_ncols * lane_width;
+		}
+
+		LMAT_ENSURE_INLINE const T* ptr_group(index_t g) const
+		{
+			return m_data.ptr_data() + g * group_size();
+		}
+
+		LMAT_ENSURE_INLINE T* ptr_group(index_t g)
+		{
+			return m_data.ptr_data() + g * group_size();
+		}
+
+		LMAT_ENSURE_INLINE const T& operator() (index_t k, index_t i, index_t j) const
+		{
+			return m_data[offset(k, i, j)];
+		}
+
+		LMAT_ENSURE_INLINE T& operator() (index_t k, index_t i, index_t j)
+		{
+			return m_data[offset(k, i, j)];
+		}
+
+	public:
+		void resize(index_t m, index_t n, index_t count)
+		{
+			if (m < 0 || n < 0 || count < 0)
+				throw invalid_argument("mat_batch: the sizes must be non-negative.");
+
+			m_nrows = m;
+			m_ncols = n;
+			m_count = count;
+			m_data.resize(ngroups() * group_size());
+			set_padding();
+		}
+
+		template<class Mat>
+		void gather(const IRegularMatrix<Mat, T>& stack, index_t n)
+		{
+			if (n <= 0 || stack.ncolumns() % n != 0)
+				throw invalid_argument("mat_batch::gather: the stack width must be a multiple of n.");
+
+			const index_t m = stack.nrows();
+			const index_t count = stack.ncolumns() / n;
+			if (m != m_nrows || n != m_ncols || count != m_count)
+				resize(m, n, count);
+
+			for (index_t k = 0; k < count; ++k)
+			{
+				for (index_t j = 0; j < n; ++j)
+				{
+					T *p = m_data.ptr_data() + offset(k, 0, j);
+					for (index_t i = 0; i < m; ++i)
+						p[i * lane_width] = stack(i, k * n + j);
+				}
+			}
+		}
+
+		template<class Mat>
+		void scatter(IRegularMatrix<Mat, T>& stack) const
+		{
+			const index_t m = m_nrows;
+			const index_t n = m_ncols;
+			stack.require_size(m, n * m_count);
+
+			for (index_t k = 0; k < m_count; ++k)
+			{
+				for (index_t j = 0; j < n; ++j)
+				{
+					const T *p = m_data.ptr_data() + offset(k, 0, j);
+					for (index_t i = 0; i < m; ++i)
+						stack(i, k * n + j) = p[i * lane_width];
+				}
+			}
+		}
+
+	private:
+		LMAT_ENSURE_INLINE index_t offset(index_t k, index_t i, index_t j) const
+		{
+			return ((k / lane_width) * (m_nrows * m_ncols) + j * m_nrows + i) * lane_width
+					+ k % lane_width;
+		}
+
+		void set_padding()
+		{
+			const index_t ng = ngroups();
+			if (ng * lane_width == m_count) return;
+
+			T *p = ptr_group(ng - 1);
+			const index_t l0 = m_count - (ng - 1) * lane_width;
+
+			for (index_t j = 0; j < m_ncols; ++j)
+			{
+				for (index_t i = 0; i < m_nrows; ++i, p += lane_width)
+				{
+					for (index_t l = l0; l < lane_width; ++l)
+						p[l] = T(i == j ? 1 : 0);
+				}
+			}
+		}
+
+	private:
+		index_t m_nrows;
+		index_t m_ncols;
+		index_t m_count;
+		dblock<T, allocator_type> m_data;
+
+	}; // end class mat_batch
+
+
+	/********************************************
+	 *
+	 *  group kernels
+	 *
+	 *  Each kernel works on one group of W matrices,
+	 *  with one matrix per SIMD lane.
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		template<typename T, typename Kind>
+		struct batch_group
+		{
+			typedef simd_pack<T, Kind> pack_t;
+			static const index_t W = (index_t)simd_traits<T, Kind>::pack_width;
+
+			T *data;
+			index_t m;
+
+			LMAT_ENSURE_INLINE T* at(index_t i, index_t j) const
+			{
+				return data + (j * m + i) * W;
+			}
+
+			LMAT_ENSURE_INLINE pack_t ld(index_t i, index_t j) const
+			{
+				pack_t r;
+				r.load_a(at(i, j));
+				return r;
+			}
+
+			LMAT_ENSURE_INLINE void st(index_t i, index_t j, const pack_t& v) const
+			{
+				v.store_a(at(i, j));
+			}
+		};
+
+
+		// Cholesky (lower): A = L * L'
+
+		template<typename T, typename Kind>
+		inline void batch_chol_group(const batch_group<T, Kind>& a, index_t n)
+		{
+			typedef simd_pack<T, Kind> pack_t;
+
+			for (index_t j = 0; j < n; ++j)
+			{
+				pack_t d = a.ld(j, j);
+				for (index_t k = 0; k < j; ++k)
+				{
+					pack_t l = a.ld(j, k);
+					d -= l * l;
+				}
+
+				d = math::sqrt(d);
+				a.st(j, j, d);
+				pack_t r = pack_t::ones() / d;
+
+				for (index_t i = j + 1; i < n; ++i)
+				{
+					pack_t s = a.ld(i, j);
+					for (index_t k = 0; k < j; ++k)
+						s -= a.ld(i, k) * a.ld(j, k);
+					a.st(i, j, s * r);
+				}
+			}
+		}
+
+		template<typename T, typename Kind>
+		inline void batch_chol_solve_group(const batch_group<T, Kind>& l, index_t n,
+				const batch_group<T, Kind>& b, index_t nrhs)
+		{
+			typedef simd_pack<T, Kind> pack_t;
+
+			for (index_t c = 0; c < nrhs; ++c)
+			{
+				// L * y = b
+
+				for (index_t i = 0; i < n; ++i)
+				{
+					pack_t s = b.ld(i, c);
+					for (index_t k = 0; k < i; ++k)
+						s -= l.ld(i, k) * b.ld(k, c);
+					b.st(i, c, s / l.ld(i, i));
+				}
+
+				// L' * x = y
+
+				for (index_t i = n - 1; i >= 0; --i)
+				{
+					pack_t s = b.ld(i, c);
+					for (index_t k = i + 1; k < n; ++k)
+						s -= l.ld(k, i) * b.ld(k, c);
+					b.st(i, c, s / l.ld(i, i));
+				}
+			}
+		}
+
+
+		// LU with partial pivoting: P * A = L * U
+
+		template<typename T, typename Kind>
+		inline void batch_lu_group(const batch_group<T, Kind>& a, index_t n, index_t *piv, index_t nlanes)
+		{
+			typedef simd_pack<T, Kind> pack_t;
+
+			for (index_t j = 0; j < n; ++j)
+			{
+				// pivot selection and row swaps (per lane)
+
+				for (index_t l = 0; l < nlanes; ++l)
+				{
+					index_t p = j;
+					T vmax = math::abs(a.at(j, j)[l]);
+					for (index_t i = j + 1; i < n; ++i)
+					{
+						T v = math::abs(a.at(i, j)[l]);
+						if (v > vmax)
+						{
+							vmax = v;
+							p = i;
+						}
+					}
+
+					piv[l * n + j] = p;
+					if (p != j)
+					{
+						for (index_t c = 0; c < n; ++c)
+						{
+							T *r0 = a.at(j, c) + l;
+							T *r1 = a.at(p, c) + l;
+							T t = *r0; *r0 = *r1; *r1 = t;
+						}
+					}
+				}
+
+				// elimination
+
+				pack_t r = pack_t::ones() / a.ld(j, j);
+				for (index_t i = j + 1; i < n; ++i)
+					a.st(i, j, a.ld(i, j) * r);
+
+				for (index_t c = j + 1; c < n; ++c)
+				{
+					pack_t u = a.ld(j, c);
+					for (index_t i = j + 1; i < n; ++i)
+						a.st(i, c, a.ld(i, c) - a.ld(i, j) * u);
+				}
+			}
+		}
+
+		template<typename T, typename Kind>
+		inline void batch_lu_solve_group(const batch_group<T, Kind>& lu, index_t n, const index_t *piv, index_t nlanes,
+				const batch_group<T, Kind>& b, index_t nrhs)
+		{
+			typedef simd_pack<T, Kind> pack_t;
+
+			// apply row permutations (per lane)
+
+			for (index_t l = 0; l < nlanes; ++l)
+			{
+				for (index_t j = 0; j < n; ++j)
+				{
+					index_t p = piv[l * n + j];
+					if (p != j)
+					{
+						for (index_t c = 0; c < nrhs; ++c)
+						{
+							T *r0 = b.at(j, c) + l;
+							T *r1 = b.at(p, c) + l;
+							T t = *r0; *r0 = *r1; *r1 = t;
+						}
+					}
+				}
+			}
+
+			for (index_t c = 0; c < nrhs; ++c)
+			{
+				// L * y = P * b  (L is unit lower triangular)
+
+				for (index_t i = 1; i < n; ++i)
+				{
+					pack_t s = b.ld(i, c);
+					for (index_t k = 0; k < i; ++k)
+						s -= lu.ld(i, k) * b.ld(k, c);
+					b.st(i, c, s);
+				}
+
+				// U * x = y
+
+				for (index_t i = n - 1; i >= 0; --i)
+				{
+					pack_t s = b.ld(i, c);
+					for (index_t k = i + 1; k < n; ++k)
+						s -= lu.ld(i, k) * b.ld(k, c);
+					b.st(i, c, s / lu.ld(i, i));
+				}
+			}
+		}
+
+
+		// Householder QR: A = Q * R  (in the form of LAPACK's geqrf)
+
+		template<typename T, typename Kind>
+		inline void batch_qr_group(const batch_group<T, Kind>& a, index_t m, index_t n,
+				const batch_group<T, Kind>& tau)
+		{
+			typedef simd_pack<T, Kind> pack_t;
+			const pack_t zero = pack_t::zeros();
+			const pack_t one = pack_t::ones();
+
+			const index_t k = m < n ? m : n;
+			for (index_t j = 0; j < k; ++j)
+			{
+				// generate the reflector H_j = I - tau * v * v'
+
+				pack_t alpha = a.ld(j, j);
+				pack_t s2 = zero;
+				for (index_t i = j + 1; i < m; ++i)
+				{
+					pack_t v = a.ld(i, j);
+					s2 += v * v;
+				}
+
+				pack_t nrm = math::sqrt(alpha * alpha + s2);
+				pack_t beta = math::cond(math::signbit(alpha), nrm, -nrm);
+
+				// no reflection is needed if the sub-column is zero
+				simd_bpack<T, Kind> trivial = (s2 == zero);
+				beta = math::cond(trivial, alpha, beta);
+
+				pack_t t = math::cond(trivial, zero, (beta - alpha) / beta);
+				pack_t sc = math::cond(trivial, one, one / (alpha - beta));
+
+				a.st(j, j, beta);
+				for (index_t i = j + 1; i < m; ++i)
+					a.st(i, j, a.ld(i, j) * sc);
+				tau.st(j, 0, t);
+
+				// apply H_j to the trailing columns
+
+				for (index_t c = j + 1; c < n; ++c)
+				{
+					pack_t w = a.ld(j, c);
+					for (index_t i = j + 1; i < m; ++i)
+						w += a.ld(i, j) * a.ld(i, c);
+					w *= t;
+
+					a.st(j, c, a.ld(j, c) - w);
+					for (index_t i = j + 1; i < m; ++i)
+						a.st(i, c, a.ld(i, c) - a.ld(i, j) * w);
+				}
+			}
+		}
+
+		template<typename T, typename Kind>
+		inline void batch_qr_solve_group(const batch_group<T, Kind>& qr, index_t m, index_t n,
+				const batch_group<T, Kind>& tau, const batch_group<T, Kind>& b, index_t nrhs)
+		{
+			typedef simd_pack<T, Kind> pack_t;
+
+			for (index_t c = 0; c < nrhs; ++c)
+			{
+				// b <- Q' * b
+
+				for (index_t j = 0; j < n; ++j)
+				{
+					pack_t w = b.ld(j, c);
+					for (index_t i = j + 1; i < m; ++i)
+						w += qr.ld(i, j) * b.ld(i, c);
+					w *= tau.ld(j, 0);
+
+					b.st(j, c, b.ld(j, c) - w);
+					for (index_t i = j + 1; i < m; ++i)
+						b.st(i, c, b.ld(i, c) - qr.ld(i, j) * w);
+				}
+
+				// R * x = b(0:n)
+
+				for (index_t i = n - 1; i >= 0; --i)
+				{
+					pack_t s = b.ld(i, c);
+					for (index_t k = i + 1; k < n; ++k)
+						s -= qr.ld(i, k) * b.ld(k, c);
+					b.st(i, c, s / qr.ld(i, i));
+				}
+			}
+		}
+
+
+		template<typename T, typename Kind>
+		LMAT_ENSURE_INLINE
+		inline batch_group<T, Kind> get_group(mat_batch<T, Kind>& a, index_t g)
+		{
+			batch_group<T, Kind> r;
+			r.data = a.ptr_group(g);
+			r.m = a.nrows();
+			return r;
+		}
+
+		template<typename T, typename Kind>
+		LMAT_ENSURE_INLINE
+		inline batch_group<T, Kind> get_group(const mat_batch<T, Kind>& a, index_t g)
+		{
+			batch_group<T, Kind> r;
+			r.data = const_cast<T*>(a.ptr_group(g));
+			r.m = a.nrows();
+			return r;
+		}
+
+		template<typename T, typename Kind>
+		inline void check_batch_rhs(const mat_batch<T, Kind>& a, const mat_batch<T, Kind>& b)
+		{
+			if (a.count() != b.count() || a.nrows() != b.nrows())
+				throw invalid_argument("The right hand sides are inconsistent with the factorization.");
+		}
+	}
+
+
+	namespace internal
+	{
+		// calls f(g) for each group g, in parallel over blocks of groups
+
+		template<class Fun>
+		inline void for_each_group(index_t ng, const Fun& f)
+		{
+			exec::parallel_for(range(0, ng), LMAT_BATCH_PAR_GROUPS, [&](const range& r)
+			{
+				const index_t ge = r.end_index();
+				for (index_t g = r.begin_index(); g < ge; ++g) f(g);
+			});
+		}
+	}
+
+
+	/********************************************
+	 *
+	 *  batched factorization & solve
+	 *
+	 *  Factorizations are done in place. As in LAPACK,
+	 *  a failed factorization (e.g. non-positive-definite
+	 *  or singular) is signaled by non-finite entries in
+	 *  the factor of the corresponding matrix, which does
+	 *  not affect other matrices in the batch.
+	 *
+	 ********************************************/
+
+	// Cholesky
+
+	template<typename T, typename Kind>
+	inline void batch_chol(mat_batch<T, Kind>& a)
+	{
+		LMAT_CHECK_DIMS( a.nrows() == a.ncolumns() )
+
+		const index_t ng = a.ngroups();
+		const index_t n = a.nrows();
+
+		internal::for_each_group(ng, [&](index_t g)
+		{
+			internal::batch_chol_group(internal::get_group(a, g), n);
+		});
+	}
+
+	template<typename T, typename Kind>
+	inline void batch_chol_solve(const mat_batch<T, Kind>& l, mat_batch<T, Kind>& b)
+	{
+		LMAT_CHECK_DIMS( l.nrows() == l.ncolumns() )
+		internal::check_batch_rhs(l, b);
+
+		const index_t ng = l.ngroups();
+		const index_t n = l.nrows();
+		const index_t nrhs = b.ncolumns();
+
+		internal::for_each_group(ng, [&](index_t g)
+		{
+			internal::batch_chol_solve_group(
+					internal::get_group(l, g), n, internal::get_group(b, g), nrhs);
+		});
+	}
+
+
+	// LU
+
+	/**
+	 * piv is resized to n x count. Its k-th column records the
+	 * (zero-based) row interchanges of the k-th matrix.
+	 */
+	template<typename T, typename Kind>
+	inline void batch_lu(mat_batch<T, Kind>& a, dense_matrix<index_t>& piv)
+	{
+		LMAT_CHECK_DIMS( a.nrows() == a.ncolumns() )
+
+		const index_t W = mat_batch<T, Kind>::lane_width;
+		const index_t ng = a.ngroups();
+		const index_t n = a.nrows();
+		const index_t cnt = a.count();
+
+		piv.require_size(n, cnt);
+		index_t *pv = piv.ptr_data();
+
+		internal::for_each_group(ng, [&](index_t g)
+		{
+			index_t nl = cnt - g * W;
+			if (nl > W) nl = W;
+			internal::batch_lu_group(internal::get_group(a, g), n, pv + g * W * n, nl);
+		});
+	}
+
+	template<typename T, typename Kind>
+	inline void batch_lu_solve(const mat_batch<T, Kind>& lu, const dense_matrix<index_t>& piv,
+			mat_batch<T, Kind>& b)
+	{
+		LMAT_CHECK_DIMS( lu.nrows() == lu.ncolumns() )
+		LMAT_CHECK_DIMS( piv.nrows() == lu.nrows() && piv.ncolumns() == lu.count() )
+		internal::check_batch_rhs(lu, b);
+
+		const index_t W = mat_batch<T, Kind>::lane_width;
+		const index_t ng = lu.ngroups();
+		const index_t n = lu.nrows();
+		const index_t cnt = lu.count();
+		const index_t nrhs = b.ncolumns();
+		const index_t *pv = piv.ptr_data();
+
+		internal::for_each_group(ng, [&](index_t g)
+		{
+			index_t nl = cnt - g * W;
+			if (nl > W) nl = W;
+			internal::batch_lu_solve_group(internal::get_group(lu, g), n, pv + g * W * n, nl,
+					internal::get_group(b, g), nrhs);
+		});
+	}
+
+
+	// QR
+
+	/**
+	 * a (m x n, m >= n) is overwritten by R and the Householder
+	 * vectors as in LAPACK's geqrf, and tau is resized to an
+	 * n x 1 batch holding the scalar factors of the reflectors.
+	 */
+	template<typename T, typename Kind>
+	inline void batch_qr(mat_batch<T, Kind>& a, mat_batch<T, Kind>& tau)
+	{
+		LMAT_CHECK_DIMS( a.nrows() >= a.ncolumns() )
+
+		const index_t ng = a.ngroups();
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+
+		if (tau.nrows() != n || tau.ncolumns() != 1 || tau.count() != a.count())
+			tau.resize(n, 1, a.count());
+
+		internal::for_each_group(ng, [&](index_t g)
+		{
+			internal::batch_qr_group(internal::get_group(a, g), m, n, internal::get_group(tau, g));
+		});
+	}
+
+	/**
+	 * Solves the least square problems min ||A x - b||, where b
+	 * is an m x nrhs batch. Upon return, the first n rows of b
+	 * hold the solutions.
+	 */
+	template<typename T, typename Kind>
+	inline void batch_qr_solve(const mat_batch<T, Kind>& qr, const mat_batch<T, Kind>& tau,
+			mat_batch<T, Kind>& b)
+	{
+		LMAT_CHECK_DIMS( qr.nrows() >= qr.ncolumns() )
+		LMAT_CHECK_DIMS( tau.nrows() == qr.ncolumns() && tau.count() == qr.count() )
+		internal::check_batch_rhs(qr, b);
+
+		const index_t ng = qr.ngroups();
+		const index_t m = qr.nrows();
+		const index_t n = qr.ncolumns();
+		const index_t nrhs = b.ncolumns();
+
+		internal::for_each_group(ng, [&](index_t g)
+		{
+			internal::batch_qr_solve_group(internal::get_group(qr, g), m, n,
+					internal::get_group(tau, g), internal::get_group(b, g), nrhs);
+		});
+	}
+
+}
+
+#endif /* BATCHED_FAC_H_ */
@@ -49,6 +49,100 @@ namespace lmat { namespace lapack {
 		int m_errcode;
 	};
 
+
+	/********************************************
+	 *
+	 *  reusable workspace
+	 *
+	 *  Grows on demand and never shrinks, such that
+	 *  repeated calls of the same size do not allocate.
+	 *
+	 ********************************************/
+
+	template<typename T>
+	class lapack_workspace : private noncopyable
+	{
+	public:
+		lapack_workspace() { }
+
+		lapack_workspace(index_t lwork, index_t liwork)
+		{
+			reserve(lwork, liwork);
+		}
+
+		index_t work_size() const
+		{
+			return m_work.nelems();
+		}
+
+		index_t iwork_size() const
+		{
+			return m_iwork.nelems();
+		}
+
+		void reserve(index_t lwork, index_t liwork)
+		{
+			if (m_work.nelems() < lwork) m_work.require_size(lwork);
+			if (m_iwork.nelems() < liwork) m_iwork.require_size(liwork);
+		}
+
+		T* work(index_t lwork)
+		{
+			if (m_work.nelems() < lwork) m_work.require_size(lwork);
+			return m_work.ptr_data();
+		}
+
+		lapack_int* iwork(index_t liwork)
+		{
+			if (m_iwork.nelems() < liwork) m_iwork.require_size(liwork);
+			return m_iwork.ptr_data();
+		}
+
+		void release()
+		{
+			m_work.require_size(0);
+			m_iwork.require_size(0);
+		}
+
+	private:
+		dense_col<T> m_work;
+		dense_col<lapack_int> m_iwork;
+	};
+
+
+	namespace internal
+	{
+		// remembers the optimal workspace sizes for the last queried shape
+
+		struct lwork_cache
+		{
+			index_t m;
+			index_t n;
+			char job1;
+			char job2;
+			lapack_int lwork;
+			lapack_int liwork;
+
+			lwork_cache()
+			: m(-1), n(-1), job1(0), job2(0), lwork(0), liwork(0) { }
+
+			bool hit(index_t m_, index_t n_, char j1, char j2) const
+			{
+				return m == m_ && n == n_ && job1 == j1 && job2 == j2;
+			}
+
+			void set(index_t m_, index_t n_, char j1, char j2, lapack_int lw, lapack_int liw)
+			{
+				m = m_;
+				n = n_;
+				job1 = j1;
+				job2 = j2;
+				lwork = lw;
+				liwork = liw;
+			}
+		};
+	}
+
 } }
 
 #endif /* LAPACK_FWD_H_ */
@@ -243,6 +243,7 @@ namespace lmat { namespace lapack {
 
 			lwork = (lapack_int)lwork_opt;
 			dense_col<float> ws((index_t)lwork);
+			LMAT_INSTRUMENT_TEMP("lapack.sgetri", lwork * sizeof(float))
 
 			LMAT_CALL_LAPACK(sgetri, (&n, a.ptr_data(), &lda, ipiv.ptr_data(), ws.ptr_data(), &lwork, &info));
 		}
@@ -337,6 +338,7 @@ namespace lmat { namespace lapack {
 
 			lwork = (lapack_int)lwork_opt;
 			dense_col<double> ws((index_t)lwork);
+			LMAT_INSTRUMENT_TEMP("lapack.dgetri", lwork * sizeof(double))
 
 			LMAT_CALL_LAPACK(dgetri, (&n, a.ptr_data(), &lda, ipiv.ptr_data(), ws.ptr_data(), &lwork, &info));
 		}
@@ -461,6 +463,7 @@ namespace lmat
 		LMAT_CHECK_PERCOL_CONT(DMat)
 
 		typedef typename matrix_traits<Arg>::value_type T;
+		LMAT_INSTRUMENT_SCOPE("inv")
 		lapack::lu_fac<T>::inv(expr.arg(), dmat.derived());
 	}
 
@@ -71,6 +71,14 @@ namespace lmat { namespace lapack {
 	 *
 	 *  QR factorization classes
 	 *
+	 *  The workspace is kept across calls, and the
+	 *  optimal workspace size of each routine is
+	 *  queried only when the shape changes. Hence
+	 *  all methods that call LAPACK (getq, multq,
+	 *  solve) are non-const, and a factorization
+	 *  must not be used by multiple threads at the
+	 *  same time (copy it for each thread instead).
+	 *
 	 ********************************************/
 
 	template<typename T>
@@ -142,6 +150,15 @@ namespace lmat { namespace lapack {
 
 			index_t ltau = math::max(1, math::min(m_nrows, m_ncols));
 			m_tau.require_size(ltau);
+
+			m_orgqr_cache = internal::lwork_cache();
+			m_ormqr_cache = internal::lwork_cache();
+		}
+
+		T* work_buffer(index_t lwork)
+		{
+			if (m_work.nelems() < lwork) m_work.require_size(lwork);
+			return m_work.ptr_data();
 		}
 
 		index_t getq_nc(index_t nc) const
@@ -163,6 +180,11 @@ namespace lmat { namespace lapack {
 		index_t m_ncols;
 		dense_matrix<T> m_a;
 		dense_col<T> m_tau;
+
+		dense_col<T> m_work;
+		internal::lwork_cache m_geqrf_cache;
+		internal::lwork_cache m_orgqr_cache;  // for the current factorization
+		internal::lwork_cache m_ormqr_cache;
 	};
 
 
@@ -188,21 +210,27 @@ namespace lmat { namespace lapack {
 			lapack_int lda = (lapack_int)(this->m_a.col_stride());
 
 			lapack_int info = 0;
-			lapack_int lwork = -1;
-			float lwork_opt = 0;
 
-			LMAT_CALL_LAPACK(sgeqrf, (&m, &n, this->m_a.ptr_data(), &lda, this->m_tau.ptr_data(),
-					&lwork_opt, &lwork, &info));
+			if (!this->m_geqrf_cache.hit(m, n, 0, 0))
+			{
+				lapack_int lwork_q = -1;
+				float lwork_opt = 0;
+
+				LMAT_CALL_LAPACK(sgeqrf, (&m, &n, this->m_a.ptr_data(), &lda, this->m_tau.ptr_data(),
+						&lwork_opt, &lwork_q, &info));
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<float> ws((index_t)lwork);
+				this->m_geqrf_cache.set(m, n, 0, 0, (lapack_int)lwork_opt, 0);
+			}
+
+			lapack_int lwork = this->m_geqrf_cache.lwork;
+			float *ws = this->work_buffer((index_t)lwork);
 
 			LMAT_CALL_LAPACK(sgeqrf, (&m, &n, this->m_a.ptr_data(), &lda, this->m_tau.ptr_data(),
-					ws.ptr_data(), &lwork, &info));
+					ws, &lwork, &info));
 		}
 
 		template<class Q>
-		void getq(IRegularMatrix<Q, float>& q, index_t nc=-1) const  // q : m x nc
+		void getq(IRegularMatrix<Q, float>& q, index_t nc=-1)  // q : m x nc
 		{
 			LMAT_CHECK_PERCOL_CONT(Q)
 
@@ -214,23 +242,29 @@ namespace lmat { namespace lapack {
 			lapack_int k = (lapack_int)math::min(nc, this->m_ncols);
 			lapack_int ldq = (lapack_int)q.col_stride();
 
-			lapack_int lwork = -1;
-			float lwork_opt = 0;
 			lapack_int info = 0;
 
-			LMAT_CALL_LAPACK(sorgqr, (&m, &n, &k, q.ptr_data(), &ldq,
-					this->m_tau.ptr_data(), &lwork_opt, &lwork, &info));
+			if (!this->m_orgqr_cache.hit(m, n, 0, 0))
+			{
+				lapack_int lwork_q = -1;
+				float lwork_opt = 0;
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<float> ws((index_t)lwork);
+				LMAT_CALL_LAPACK(sorgqr, (&m, &n, &k, q.ptr_data(), &ldq,
+						this->m_tau.ptr_data(), &lwork_opt, &lwork_q, &info));
+
+				this->m_orgqr_cache.set(m, n, 0, 0, (lapack_int)lwork_opt, 0);
+			}
+
+			lapack_int lwork = this->m_orgqr_cache.lwork;
+			float *ws = this->work_buffer((index_t)lwork);
 
 			LMAT_CALL_LAPACK(sorgqr, (&m, &n, &k, q.ptr_data(), &ldq,
-					this->m_tau.ptr_data(), ws.ptr_data(), &lwork, &info));
+					this->m_tau.ptr_data(), ws, &lwork, &info));
 		}
 
 
 		template<class X>
-		void multq_inplace(IRegularMatrix<X, float>& x, char trans='N', char side='L') const
+		void multq_inplace(IRegularMatrix<X, float>& x, char trans='N', char side='L')
 		{
 			LMAT_CHECK_PERCOL_CONT(X)
 			LMAT_CHECK_DIMS( this->check_multq_dims(side, x.nrows(), x.ncolumns()) )
@@ -241,22 +275,28 @@ namespace lmat { namespace lapack {
 			lapack_int lda = (lapack_int)this->m_a.col_stride();
 			lapack_int ldx = (lapack_int)x.col_stride();
 
-			lapack_int lwork = -1;
-			float lwork_opt = 0;
 			lapack_int info = 0;
 
-			LMAT_CALL_LAPACK(sormqr, (&side, &trans, &m, &n, &k, this->m_a.ptr_data(), &lda,
-					this->m_tau.ptr_data(), x.ptr_data(), &ldx, &lwork_opt, &lwork, &info));
+			if (!this->m_ormqr_cache.hit(m, n, side, trans))
+			{
+				lapack_int lwork_q = -1;
+				float lwork_opt = 0;
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<float> ws((index_t)lwork);
+				LMAT_CALL_LAPACK(sormqr, (&side, &trans, &m, &n, &k, this->m_a.ptr_data(), &lda,
+						this->m_tau.ptr_data(), x.ptr_data(), &ldx, &lwork_opt, &lwork_q, &info));
+
+				this->m_ormqr_cache.set(m, n, side, trans, (lapack_int)lwork_opt, 0);
+			}
+
+			lapack_int lwork = this->m_ormqr_cache.lwork;
+			float *ws = this->work_buffer((index_t)lwork);
 
 			LMAT_CALL_LAPACK(sormqr, (&side, &trans, &m, &n, &k, this->m_a.ptr_data(), &lda,
-					this->m_tau.ptr_data(), x.ptr_data(), &ldx, ws.ptr_data(), &lwork, &info));
+					this->m_tau.ptr_data(), x.ptr_data(), &ldx, ws, &lwork, &info));
 		}
 
 		template<class X, class Y>
-		void multq(const IMatrixXpr<X, float>& x, IRegularMatrix<Y, float>& y, char trans='N', char side='L') const
+		void multq(const IMatrixXpr<X, float>& x, IRegularMatrix<Y, float>& y, char trans='N', char side='L')
 		{
 			LMAT_CHECK_PERCOL_CONT(Y)
 			y.derived() = x.derived();
@@ -264,7 +304,7 @@ namespace lmat { namespace lapack {
 		}
 
 		template<class X>
-		void solve_inplace(IRegularMatrix<X, float>& x) const // require: m >= n
+		void solve_inplace(IRegularMatrix<X, float>& x) // require: m >= n
 		{
 			LMAT_CHECK_PERCOL_CONT(X)
 
@@ -289,7 +329,7 @@ namespace lmat { namespace lapack {
 		}
 
 		template<class X, class B>
-		void solve(const IMatrixXpr<X, float>& x, IRegularMatrix<B, float>& b) const
+		void solve(const IMatrixXpr<X, float>& x, IRegularMatrix<B, float>& b)
 		{
 			LMAT_CHECK_PERCOL_CONT(B)
 			LMAT_CHECK_DIMS( x.nrows() == this->m_nrows );
@@ -324,21 +364,27 @@ namespace lmat { namespace lapack {
 			lapack_int lda = (lapack_int)(this->m_a.col_stride());
 
 			lapack_int info = 0;
-			lapack_int lwork = -1;
-			double lwork_opt = 0;
 
-			LMAT_CALL_LAPACK(dgeqrf, (&m, &n, this->m_a.ptr_data(), &lda, this->m_tau.ptr_data(),
-					&lwork_opt, &lwork, &info));
+			if (!this->m_geqrf_cache.hit(m, n, 0, 0))
+			{
+				lapack_int lwork_q = -1;
+				double lwork_opt = 0;
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<double> ws((index_t)lwork);
+				LMAT_CALL_LAPACK(dgeqrf, (&m, &n, this->m_a.ptr_data(), &lda, this->m_tau.ptr_data(),
+						&lwork_opt, &lwork_q, &info));
+
+				this->m_geqrf_cache.set(m, n, 0, 0, (lapack_int)lwork_opt, 0);
+			}
+
+			lapack_int lwork = this->m_geqrf_cache.lwork;
+			double *ws = this->work_buffer((index_t)lwork);
 
 			LMAT_CALL_LAPACK(dgeqrf, (&m, &n, this->m_a.ptr_data(), &lda, this->m_tau.ptr_data(),
-					ws.ptr_data(), &lwork, &info));
+					ws, &lwork, &info));
 		}
 
 		template<class Q>
-		void getq(IRegularMatrix<Q, double>& q, index_t nc=-1) const  // q: m x nc
+		void getq(IRegularMatrix<Q, double>& q, index_t nc=-1)  // q: m x nc
 		{
 			LMAT_CHECK_PERCOL_CONT(Q)
 
@@ -350,22 +396,28 @@ namespace lmat { namespace lapack {
 			lapack_int k = (lapack_int)math::min(nc, this->m_ncols);
 			lapack_int ldq = (lapack_int)q.col_stride();
 
-			lapack_int lwork = -1;
-			double lwork_opt = 0;
 			lapack_int info = 0;
 
-			LMAT_CALL_LAPACK(dorgqr, (&m, &n, &k, q.ptr_data(), &ldq,
-					this->m_tau.ptr_data(), &lwork_opt, &lwork, &info));
+			if (!this->m_orgqr_cache.hit(m, n, 0, 0))
+			{
+				lapack_int lwork_q = -1;
+				double lwork_opt = 0;
+
+				LMAT_CALL_LAPACK(dorgqr, (&m, &n, &k, q.ptr_data(), &ldq,
+						this->m_tau.ptr_data(), &lwork_opt, &lwork_q, &info));
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<double> ws((index_t)lwork);
+				this->m_orgqr_cache.set(m, n, 0, 0, (lapack_int)lwork_opt, 0);
+			}
+
+			lapack_int lwork = this->m_orgqr_cache.lwork;
+			double *ws = this->work_buffer((index_t)lwork);
 
 			LMAT_CALL_LAPACK(dorgqr, (&m, &n, &k, q.ptr_data(), &ldq,
-					this->m_tau.ptr_data(), ws.ptr_data(), &lwork, &info));
+					this->m_tau.ptr_data(), ws, &lwork, &info));
 		}
 
 		template<class X>
-		void multq_inplace(IRegularMatrix<X, double>& x, char trans='N', char side='L') const
+		void multq_inplace(IRegularMatrix<X, double>& x, char trans='N', char side='L')
 		{
 			LMAT_CHECK_PERCOL_CONT(X)
 			LMAT_CHECK_DIMS( this->check_multq_dims(side, x.nrows(), x.ncolumns()) )
@@ -376,22 +428,28 @@ namespace lmat { namespace lapack {
 			lapack_int lda = (lapack_int)this->m_a.col_stride();
 			lapack_int ldx = (lapack_int)x.col_stride();
 
-			lapack_int lwork = -1;
-			double lwork_opt = 0;
 			lapack_int info = 0;
 
-			LMAT_CALL_LAPACK(dormqr, (&side, &trans, &m, &n, &k, this->m_a.ptr_data(), &lda,
-					this->m_tau.ptr_data(), x.ptr_data(), &ldx, &lwork_opt, &lwork, &info));
+			if (!this->m_ormqr_cache.hit(m, n, side, trans))
+			{
+				lapack_int lwork_q = -1;
+				double lwork_opt = 0;
+
+				LMAT_CALL_LAPACK(dormqr, (&side, &trans, &m, &n, &k, this->m_a.ptr_data(), &lda,
+						this->m_tau.ptr_data(), x.ptr_data(), &ldx, &lwork_opt, &lwork_q, &info));
+
+				this->m_ormqr_cache.set(m, n, side, trans, (lapack_int)lwork_opt, 0);
+			}
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<double> ws((index_t)lwork);
+			lapack_int lwork = this->m_ormqr_cache.lwork;
+			double *ws = this->work_buffer((index_t)lwork);
 
 			LMAT_CALL_LAPACK(dormqr, (&side, &trans, &m, &n, &k, this->m_a.ptr_data(), &lda,
-					this->m_tau.ptr_data(), x.ptr_data(), &ldx, ws.ptr_data(), &lwork, &info));
+					this->m_tau.ptr_data(), x.ptr_data(), &ldx, ws, &lwork, &info));
 		}
 
 		template<class X, class Y>
-		void multq(const IMatrixXpr<X, double>& x, IRegularMatrix<Y, double>& y, char trans='N', char side='L') const
+		void multq(const IMatrixXpr<X, double>& x, IRegularMatrix<Y, double>& y, char trans='N', char side='L')
 		{
 			LMAT_CHECK_PERCOL_CONT(Y)
 			y.derived() = x.derived();
@@ -399,7 +457,7 @@ namespace lmat { namespace lapack {
 		}
 
 		template<class X>
-		void solve_inplace(IRegularMatrix<X, double>& x) const // require: m >= n
+		void solve_inplace(IRegularMatrix<X, double>& x) // require: m >= n
 		{
 			LMAT_CHECK_PERCOL_CONT(X)
 
@@ -424,7 +482,7 @@ namespace lmat { namespace lapack {
 		}
 
 		template<class X, class B>
-		void solve(const IMatrixXpr<X, double>& x, IRegularMatrix<B, double>& b) const
+		void solve(const IMatrixXpr<X, double>& x, IRegularMatrix<B, double>& b)
 		{
 			LMAT_CHECK_PERCOL_CONT(B)
 			LMAT_CHECK_DIMS( x.nrows() == this->m_nrows );
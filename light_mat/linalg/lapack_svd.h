@@ -52,6 +52,31 @@ namespace lmat { namespace lapack {
 			else
 				throw invalid_argument("Invalid character for SVD job.");
 		}
+
+		template<typename T, class S, class U, class VT>
+		inline void _svd_prepare(index_t m, index_t n, IRegularMatrix<S, T>& s,
+				IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt, char jobu, char jobvt)
+		{
+			index_t rk = math::min(m, n);
+
+			s.require_size(rk, 1);
+
+			if (jobu == 'A')
+				u.require_size(m, m);
+			else if (jobu == 'S')
+				u.require_size(m, rk);
+
+			if (jobvt == 'A')
+				vt.require_size(n, n);
+			else if (jobvt == 'S')
+				vt.require_size(rk, n);
+		}
+
+		LMAT_ENSURE_INLINE
+		inline index_t _gesdd_liwork(index_t m, index_t n)
+		{
+			return 8 * math::max(index_t(1), math::min(m, n));
+		}
 	}
 
 
@@ -63,10 +88,12 @@ namespace lmat { namespace lapack {
 
 	namespace internal
 	{
+		// calling with lwork = -1 performs a workspace query
+
 		template<class A, class S, class U, class VT>
 		inline void _gesvd(IRegularMatrix<A, float>& a, IRegularMatrix<S, float>& s,
 				IRegularMatrix<U, float>& u, IRegularMatrix<VT, float>& vt,
-				char jobu, char jobvt)
+				char jobu, char jobvt, float *work, lapack_int lwork)
 		{
 			lapack_int m = (lapack_int)a.nrows();
 			lapack_int n = (lapack_int)a.ncolumns();
@@ -78,26 +105,17 @@ namespace lmat { namespace lapack {
 			if (ldu <= 0) ldu = 1;
 			if (ldvt <= 0) ldvt = 1;
 
-			float lwork_opt = 0;
-			lapack_int lwork = -1;
 			lapack_int info = 0;
 
 			LMAT_CALL_LAPACK(sgesvd, (&jobu, &jobvt, &m, &n, a.ptr_data(), &lda,
 					s.ptr_data(), u.ptr_data(), &ldu, vt.ptr_data(), &ldvt,
-					&lwork_opt, &lwork, &info));
-
-			lwork = (lapack_int)lwork_opt;
-			dense_col<float> ws((index_t)lwork);
-
-			LMAT_CALL_LAPACK(sgesvd, (&jobu, &jobvt, &m, &n, a.ptr_data(), &lda,
-					s.ptr_data(), u.ptr_data(), &ldu, vt.ptr_data(), &ldvt,
-					ws.ptr_data(), &lwork, &info));
+					work, &lwork, &info));
 		}
 
 		template<class A, class S, class U, class VT>
 		inline void _gesvd(IRegularMatrix<A, double>& a, IRegularMatrix<S, double>& s,
 				IRegularMatrix<U, double>& u, IRegularMatrix<VT, double>& vt,
-				char jobu, char jobvt)
+				char jobu, char jobvt, double *work, lapack_int lwork)
 		{
 			lapack_int m = (lapack_int)a.nrows();
 			lapack_int n = (lapack_int)a.ncolumns();
@@ -109,20 +127,32 @@ namespace lmat { namespace lapack {
 			if (ldu <= 0) ldu = 1;
 			if (ldvt <= 0) ldvt = 1;
 
-			double lwork_opt = 0;
-			lapack_int lwork = -1;
 			lapack_int info = 0;
 
 			LMAT_CALL_LAPACK(dgesvd, (&jobu, &jobvt, &m, &n, a.ptr_data(), &lda,
 					s.ptr_data(), u.ptr_data(), &ldu, vt.ptr_data(), &ldvt,
-					&lwork_opt, &lwork, &info));
+					work, &lwork, &info));
+		}
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<double> ws((index_t)lwork);
+		template<typename T, class A, class S, class U, class VT>
+		inline lapack_int _gesvd_lwork(IRegularMatrix<A, T>& a, IRegularMatrix<S, T>& s,
+				IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt, char jobu, char jobvt)
+		{
+			T lwork_opt = 0;
+			_gesvd(a, s, u, vt, jobu, jobvt, &lwork_opt, lapack_int(-1));
+			return (lapack_int)lwork_opt;
+		}
 
-			LMAT_CALL_LAPACK(dgesvd, (&jobu, &jobvt, &m, &n, a.ptr_data(), &lda,
-					s.ptr_data(), u.ptr_data(), &ldu, vt.ptr_data(), &ldvt,
-					ws.ptr_data(), &lwork, &info));
+		template<typename T, class A, class S, class U, class VT>
+		inline void _gesvd(IRegularMatrix<A, T>& a, IRegularMatrix<S, T>& s,
+				IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt,
+				char jobu, char jobvt)
+		{
+			lapack_int lwork = _gesvd_lwork(a, s, u, vt, jobu, jobvt);
+			dense_col<T> ws((index_t)lwork);
+			LMAT_INSTRUMENT_TEMP("lapack.gesvd", lwork * sizeof(T))
+
+			_gesvd(a, s, u, vt, jobu, jobvt, ws.ptr_data(), lwork);
 		}
 
 
@@ -157,22 +187,7 @@ namespace lmat { namespace lapack {
 			jobvt = check_svd_jobc(jobvt);
 
 			dense_matrix<T> a_(a);
-
-			index_t m = a_.nrows();
-			index_t n = a_.ncolumns();
-			index_t rk = math::min(m, n);
-
-			s.require_size(rk, 1);
-
-			if (jobu == 'A')
-				u.require_size(m, m);
-			else if (jobu == 'S')
-				u.require_size(m, rk);
-
-			if (jobvt == 'A')
-				vt.require_size(n, n);
-			else if (jobvt == 'S')
-				vt.require_size(rk, n);
+			_svd_prepare(a_.nrows(), a_.ncolumns(), s, u, vt, jobu, jobvt);
 
 			_gesvd(a_, s, u, vt, jobu, jobvt);
 		}
@@ -215,9 +230,12 @@ namespace lmat { namespace lapack {
 
 	namespace internal
 	{
+		// calling with lwork = -1 performs a workspace query
+
 		template<class A, class S, class U, class VT>
 		inline void _gesdd(IRegularMatrix<A, float>& a, IRegularMatrix<S, float>& s,
-				IRegularMatrix<U, float>& u, IRegularMatrix<VT, float>& vt, char jobz)
+				IRegularMatrix<U, float>& u, IRegularMatrix<VT, float>& vt, char jobz,
+				float *work, lapack_int lwork, lapack_int *iwork)
 		{
 			lapack_int m = (lapack_int)a.nrows();
 			lapack_int n = (lapack_int)a.ncolumns();
@@ -229,27 +247,16 @@ namespace lmat { namespace lapack {
 			if (ldu <= 0) ldu = 1;
 			if (ldvt <= 0) ldvt = 1;
 
-			float lwork_opt = 0;
-			lapack_int lwork = -1;
 			lapack_int info = 0;
 
-			index_t iws_len = 8 * math::max(1, math::min(m, n));
-			dense_col<lapack_int> iws(iws_len);
-
 			LMAT_CALL_LAPACK(sgesdd, (&jobz, &m, &n, a.ptr_data(), &lda, s.ptr_data(), u.ptr_data(), &ldu,
-					vt.ptr_data(), &ldvt, &lwork_opt, &lwork, iws.ptr_data(), &info));
-
-			lwork = (lapack_int)lwork_opt;
-			dense_col<float> ws((index_t)lwork);
-
-			LMAT_CALL_LAPACK(sgesdd, (&jobz, &m, &n, a.ptr_data(), &lda, s.ptr_data(), u.ptr_data(), &ldu,
-					vt.ptr_data(), &ldvt, ws.ptr_data(), &lwork, iws.ptr_data(), &info));
+					vt.ptr_data(), &ldvt, work, &lwork, iwork, &info));
 		}
 
-
 		template<class A, class S, class U, class VT>
 		inline void _gesdd(IRegularMatrix<A, double>& a, IRegularMatrix<S, double>& s,
-				IRegularMatrix<U, double>& u, IRegularMatrix<VT, double>& vt, char jobz)
+				IRegularMatrix<U, double>& u, IRegularMatrix<VT, double>& vt, char jobz,
+				double *work, lapack_int lwork, lapack_int *iwork)
 		{
 			lapack_int m = (lapack_int)a.nrows();
 			lapack_int n = (lapack_int)a.ncolumns();
@@ -261,21 +268,32 @@ namespace lmat { namespace lapack {
 			if (ldu <= 0) ldu = 1;
 			if (ldvt <= 0) ldvt = 1;
 
-			double lwork_opt = 0;
-			lapack_int lwork = -1;
 			lapack_int info = 0;
 
-			index_t iws_len = 8 * math::max(1, math::min(m, n));
-			dense_col<lapack_int> iws(iws_len);
-
 			LMAT_CALL_LAPACK(dgesdd, (&jobz, &m, &n, a.ptr_data(), &lda, s.ptr_data(), u.ptr_data(), &ldu,
-					vt.ptr_data(), &ldvt, &lwork_opt, &lwork, iws.ptr_data(), &info));
+					vt.ptr_data(), &ldvt, work, &lwork, iwork, &info));
+		}
+
+		template<typename T, class A, class S, class U, class VT>
+		inline lapack_int _gesdd_lwork(IRegularMatrix<A, T>& a, IRegularMatrix<S, T>& s,
+				IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt, char jobz, lapack_int *iwork)
+		{
+			T lwork_opt = 0;
+			_gesdd(a, s, u, vt, jobz, &lwork_opt, lapack_int(-1), iwork);
+			return (lapack_int)lwork_opt;
+		}
 
-			lwork = (lapack_int)lwork_opt;
-			dense_col<double> ws((index_t)lwork);
+		template<typename T, class A, class S, class U, class VT>
+		inline void _gesdd(IRegularMatrix<A, T>& a, IRegularMatrix<S, T>& s,
+				IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt, char jobz)
+		{
+			dense_col<lapack_int> iws(_gesdd_liwork(a.nrows(), a.ncolumns()));
 
-			LMAT_CALL_LAPACK(dgesdd, (&jobz, &m, &n, a.ptr_data(), &lda, s.ptr_data(), u.ptr_data(), &ldu,
-					vt.ptr_data(), &ldvt, ws.ptr_data(), &lwork, iws.ptr_data(), &info));
+			lapack_int lwork = _gesdd_lwork(a, s, u, vt, jobz, iws.ptr_data());
+			dense_col<T> ws((index_t)lwork);
+			LMAT_INSTRUMENT_TEMP("lapack.gesdd", lwork * sizeof(T))
+
+			_gesdd(a, s, u, vt, jobz, ws.ptr_data(), lwork, iws.ptr_data());
 		}
 
 
@@ -308,23 +326,7 @@ namespace lmat { namespace lapack {
 			jobz = check_svd_jobc(jobz);
 
 			dense_matrix<T> a_(a);
-
-			index_t m = a_.nrows();
-			index_t n = a_.ncolumns();
-			index_t rk = math::min(m, n);
-
-			s.require_size(rk, 1);
-
-			if (jobz == 'A')
-			{
-				u.require_size(m, m);
-				vt.require_size(n, n);
-			}
-			else if (jobz == 'S')
-			{
-				u.require_size(m, rk);
-				vt.require_size(rk, n);
-			}
+			_svd_prepare(a_.nrows(), a_.ncolumns(), s, u, vt, jobz, jobz);
 
 			_gesdd(a_, s, u, vt, jobz);
 		}
@@ -359,6 +361,136 @@ namespace lmat { namespace lapack {
 	}
 
 
+	/********************************************
+	 *
+	 *  Reusable SVD solver
+	 *
+	 *  Keeps a copy buffer for the input, and the
+	 *  workspace of the last computation. The optimal
+	 *  workspace size is queried only when the shape
+	 *  or the job changes.
+	 *
+	 *  The workspace can be provided by the caller,
+	 *  e.g. to share it among several solvers.
+	 *
+	 ********************************************/
+
+	template<typename T>
+	class svd_solver : private noncopyable
+	{
+	public:
+		svd_solver()
+		: m_ws(&m_own_ws) { }
+
+		explicit svd_solver(lapack_workspace<T>& ws)
+		: m_ws(&ws) { }
+
+		lapack_workspace<T>& workspace()
+		{
+			return *m_ws;
+		}
+
+		template<class A, class S>
+		void gesvd(const IMatrixXpr<A, T>& a, IRegularMatrix<S, T>& s)
+		{
+			LMAT_CHECK_WHOLE_CONT(S)
+
+			m_a = a.derived();
+			s.require_size(math::min(m_a.nrows(), m_a.ncolumns()), 1);
+			run_gesvd(s, m_u, m_vt, 'N', 'N');
+		}
+
+		template<class A, class S, class U, class VT>
+		void gesvd(const IMatrixXpr<A, T>& a, IRegularMatrix<S, T>& s,
+				IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt, char jobu='A', char jobvt='A')
+		{
+			LMAT_CHECK_PERCOL_CONT(U)
+			LMAT_CHECK_PERCOL_CONT(VT)
+			LMAT_CHECK_WHOLE_CONT(S)
+
+			jobu = internal::check_svd_jobc(jobu);
+			jobvt = internal::check_svd_jobc(jobvt);
+
+			m_a = a.derived();
+			internal::_svd_prepare(m_a.nrows(), m_a.ncolumns(), s, u, vt, jobu, jobvt);
+			run_gesvd(s, u, vt, jobu, jobvt);
+		}
+
+		template<class A, class S>
+		void gesdd(const IMatrixXpr<A, T>& a, IRegularMatrix<S, T>& s)
+		{
+			LMAT_CHECK_WHOLE_CONT(S)
+
+			m_a = a.derived();
+			s.require_size(math::min(m_a.nrows(), m_a.ncolumns()), 1);
+			run_gesdd(s, m_u, m_vt, 'N');
+		}
+
+		template<class A, class S, class U, class VT>
+		void gesdd(const IMatrixXpr<A, T>& a, IRegularMatrix<S, T>& s,
+				IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt, char jobz='A')
+		{
+			LMAT_CHECK_PERCOL_CONT(U)
+			LMAT_CHECK_PERCOL_CONT(VT)
+			LMAT_CHECK_WHOLE_CONT(S)
+
+			jobz = internal::check_svd_jobc(jobz);
+
+			m_a = a.derived();
+			internal::_svd_prepare(m_a.nrows(), m_a.ncolumns(), s, u, vt, jobz, jobz);
+			run_gesdd(s, u, vt, jobz);
+		}
+
+	private:
+		template<class S, class U, class VT>
+		void run_gesvd(IRegularMatrix<S, T>& s, IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt,
+				char jobu, char jobvt)
+		{
+			const index_t m = m_a.nrows();
+			const index_t n = m_a.ncolumns();
+
+			if (!m_svd_cache.hit(m, n, jobu, jobvt))
+			{
+				lapack_int lw = internal::_gesvd_lwork(m_a, s, u, vt, jobu, jobvt);
+				m_svd_cache.set(m, n, jobu, jobvt, lw, 0);
+			}
+
+			lapack_int lwork = m_svd_cache.lwork;
+			internal::_gesvd(m_a, s, u, vt, jobu, jobvt, m_ws->work(lwork), lwork);
+		}
+
+		template<class S, class U, class VT>
+		void run_gesdd(IRegularMatrix<S, T>& s, IRegularMatrix<U, T>& u, IRegularMatrix<VT, T>& vt,
+				char jobz)
+		{
+			const index_t m = m_a.nrows();
+			const index_t n = m_a.ncolumns();
+
+			lapack_int liwork = (lapack_int)internal::_gesdd_liwork(m, n);
+			lapack_int *iwork = m_ws->iwork(liwork);
+
+			if (!m_sdd_cache.hit(m, n, jobz, jobz))
+			{
+				lapack_int lw = internal::_gesdd_lwork(m_a, s, u, vt, jobz, iwork);
+				m_sdd_cache.set(m, n, jobz, jobz, lw, liwork);
+			}
+
+			lapack_int lwork = m_sdd_cache.lwork;
+			internal::_gesdd(m_a, s, u, vt, jobz, m_ws->work(lwork), lwork, iwork);
+		}
+
+	private:
+		lapack_workspace<T> m_own_ws;
+		lapack_workspace<T> *m_ws;
+		internal::lwork_cache m_svd_cache;
+		internal::lwork_cache m_sdd_cache;
+
+		dense_matrix<T> m_a;
+		dense_matrix<T> m_u;   // empty place-holders when U/VT are not computed
+		dense_matrix<T> m_vt;
+	};
+
+
 } }
 
 
@@ -132,50 +132,55 @@ namespace lmat { namespace lapack {
 
 	namespace internal
 	{
+		// calling with lwork = -1 performs a workspace query
+
 		template<class A, class W>
-		inline void _syev(IRegularMatrix<A, float>& a, IRegularMatrix<W, float>& w, char jobz, char uplo)
+		inline void _syev(IRegularMatrix<A, float>& a, IRegularMatrix<W, float>& w, char jobz, char uplo,
+				float *work, lapack_int lwork)
 		{
 			LMAT_CHECK_WHOLE_CONT(W)
 			LMAT_CHECK_PERCOL_CONT(A)
 
 			lapack_int n = (lapack_int)a.nrows();
 			lapack_int lda = (lapack_int)a.col_stride();
-			float lwork_opt = 0;
-			lapack_int lwork = -1;
 			lapack_int info = 0;
 
 			LMAT_CALL_LAPACK(ssyev, (&jobz, &uplo, &n, a.ptr_data(), &lda,
-					w.ptr_data(), &lwork_opt, &lwork, &info));
-
-			lwork = (lapack_int)lwork_opt;
-
-			dense_col<float> ws((index_t)lwork);
-
-			LMAT_CALL_LAPACK(ssyev, (&jobz, &uplo, &n, a.ptr_data(), &lda,
-					w.ptr_data(), ws.ptr_data(), &lwork, &info));
+					w.ptr_data(), work, &lwork, &info));
 		}
 
 		template<class A, class W>
-		inline void _syev(IRegularMatrix<A, double>& a, IRegularMatrix<W, double>& w, char jobz, char uplo)
+		inline void _syev(IRegularMatrix<A, double>& a, IRegularMatrix<W, double>& w, char jobz, char uplo,
+				double *work, lapack_int lwork)
 		{
 			LMAT_CHECK_WHOLE_CONT(W)
 			LMAT_CHECK_PERCOL_CONT(A)
 
 			lapack_int n = (lapack_int)a.nrows();
 			lapack_int lda = (lapack_int)a.col_stride();
-			double lwork_opt = 0;
-			lapack_int lwork = -1;
 			lapack_int info = 0;
 
 			LMAT_CALL_LAPACK(dsyev, (&jobz, &uplo, &n, a.ptr_data(), &lda,
-					w.ptr_data(), &lwork_opt, &lwork, &info));
+					w.ptr_data(), work, &lwork, &info));
+		}
 
-			lwork = (lapack_int)lwork_opt;
+		template<typename T, class A, class W>
+		inline lapack_int _syev_lwork(IRegularMatrix<A, T>& a, IRegularMatrix<W, T>& w, char jobz, char uplo)
+		{
+			T lwork_opt = 0;
+			_syev(a, w, jobz, uplo, &lwork_opt, lapack_int(-1));
+			return (lapack_int)lwork_opt;
+		}
 
-			dense_col<double> ws((index_t)lwork);
+		template<typename T, class A, class W>
+		inline void _syev(IRegularMatrix<A, T>& a, IRegularMatrix<W, T>& w, char jobz, char uplo)
+		{
+			lapack_int lwork = _syev_lwork(a, w, jobz, uplo);
 
-			LMAT_CALL_LAPACK(dsyev, (&jobz, &uplo, &n, a.ptr_data(), &lda,
-					w.ptr_data(), ws.ptr_data(), &lwork, &info));
+			dense_col<T> ws((index_t)lwork);
+			LMAT_INSTRUMENT_TEMP("lapack.syev", lwork * sizeof(T))
+
+			_syev(a, w, jobz, uplo, ws.ptr_data(), lwork);
 		}
 	}
 
@@ -249,58 +254,61 @@ namespace lmat { namespace lapack {
 
 	namespace internal
 	{
+		// calling with lwork = liwork = -1 performs a workspace query
+
 		template<class A, class W>
-		inline void _syevd(IRegularMatrix<A, float>& a, IRegularMatrix<W, float>& w, char jobz, char uplo)
+		inline void _syevd(IRegularMatrix<A, float>& a, IRegularMatrix<W, float>& w, char jobz, char uplo,
+				float *work, lapack_int lwork, lapack_int *iwork, lapack_int liwork)
 		{
 			LMAT_CHECK_WHOLE_CONT(W)
 			LMAT_CHECK_PERCOL_CONT(A)
 
 			lapack_int n = (lapack_int)a.nrows();
 			lapack_int lda = (lapack_int)a.col_stride();
-			float lwork_opt = 0;
-			lapack_int lwork = -1;
-			lapack_int liwork_opt = 0;
-			lapack_int liwork = -1;
 			lapack_int info = 0;
 
 			LMAT_CALL_LAPACK(ssyevd, (&jobz, &uplo, &n, a.ptr_data(), &lda, w.ptr_data(),
-					&lwork_opt, &lwork, &liwork_opt, &liwork, &info));
-
-			lwork = (lapack_int)lwork_opt;
-			liwork = liwork_opt;
-
-			dense_col<float> ws((index_t)lwork);
-			dense_col<lapack_int> iws((index_t)liwork);
-
-			LMAT_CALL_LAPACK(ssyevd, (&jobz, &uplo, &n, a.ptr_data(), &lda, w.ptr_data(),
-					ws.ptr_data(), &lwork, iws.ptr_data(), &liwork, &info));
+					work, &lwork, iwork, &liwork, &info));
 		}
 
 		template<class A, class W>
-		inline void _syevd(IRegularMatrix<A, double>& a, IRegularMatrix<W, double>& w, char jobz, char uplo)
+		inline void _syevd(IRegularMatrix<A, double>& a, IRegularMatrix<W, double>& w, char jobz, char uplo,
+				double *work, lapack_int lwork, lapack_int *iwork, lapack_int liwork)
 		{
 			LMAT_CHECK_WHOLE_CONT(W)
 			LMAT_CHECK_PERCOL_CONT(A)
 
 			lapack_int n = (lapack_int)a.nrows();
 			lapack_int lda = (lapack_int)a.col_stride();
-			double lwork_opt = 0;
-			lapack_int lwork = -1;
-			lapack_int liwork_opt = 0;
-			lapack_int liwork = -1;
 			lapack_int info = 0;
 
 			LMAT_CALL_LAPACK(dsyevd, (&jobz, &uplo, &n, a.ptr_data(), &lda, w.ptr_data(),
-					&lwork_opt, &lwork, &liwork_opt, &liwork, &info));
+					work, &lwork, iwork, &liwork, &info));
+		}
+
+		template<typename T, class A, class W>
+		inline void _syevd_lwork(IRegularMatrix<A, T>& a, IRegularMatrix<W, T>& w, char jobz, char uplo,
+				lapack_int& lwork, lapack_int& liwork)
+		{
+			T lwork_opt = 0;
+			lapack_int liwork_opt = 0;
+			_syevd(a, w, jobz, uplo, &lwork_opt, lapack_int(-1), &liwork_opt, lapack_int(-1));
 
 			lwork = (lapack_int)lwork_opt;
 			liwork = liwork_opt;
+		}
 
-			dense_col<double> ws((index_t)lwork);
+		template<typename T, class A, class W>
+		inline void _syevd(IRegularMatrix<A, T>& a, IRegularMatrix<W, T>& w, char jobz, char uplo)
+		{
+			lapack_int lwork, liwork;
+			_syevd_lwork(a, w, jobz, uplo, lwork, liwork);
+
+			dense_col<T> ws((index_t)lwork);
+			LMAT_INSTRUMENT_TEMP("lapack.syevd", lwork * sizeof(T))
 			dense_col<lapack_int> iws((index_t)liwork);
 
-			LMAT_CALL_LAPACK(dsyevd, (&jobz, &uplo, &n, a.ptr_data(), &lda, w.ptr_data(),
-					ws.ptr_data(), &lwork, iws.ptr_data(), &liwork, &info));
+			_syevd(a, w, jobz, uplo, ws.ptr_data(), lwork, iws.ptr_data(), liwork);
 		}
 	}
 
@@ -413,9 +421,12 @@ namespace lmat { namespace lapack {
 		}
 
 
+		// calling with lwork = liwork = -1 performs a workspace query
+
 		template<class A, class W, class V, typename Range>
 		inline index_t _syevr(IRegularMatrix<A, float>& a, IRegularMatrix<W, float>& w, IRegularMatrix<V, float>& z,
-				char jobz, char uplo, float abstol, const Range& ergn)
+				char jobz, char uplo, float abstol, const Range& ergn, lapack_int *isuppz,
+				float *work, lapack_int lwork, lapack_int *iwork, lapack_int liwork)
 		{
 			LMAT_CHECK_WHOLE_CONT(W)
 			LMAT_CHECK_PERCOL_CONT(A)
@@ -427,42 +438,24 @@ namespace lmat { namespace lapack {
 			lapack_int ldz = (lapack_int)z.col_stride();
 			if (ldz == 0) ldz = 1;
 
-			float lwork_opt = 0;
-			lapack_int lwork = -1;
-			lapack_int liwork_opt = 0;
-			lapack_int liwork = -1;
 			lapack_int info = 0;
 
-			dense_col<lapack_int> isuppz;
-			if (jobz == 'V' || jobz == 'v')
-				isuppz.require_size(2 * n);
-
 			char range;
 			float vl, vu;
 			lapack_int il, iu;
 			_set_eigval_range(n, ergn, range, vl, vu, il, iu);
 
 			LMAT_CALL_LAPACK(ssyevr, (&jobz, &range, &uplo, &n, a.ptr_data(), &lda, &vl, &vu, &il, &iu, &abstol,
-					&m, w.ptr_data(), z.ptr_data(), &ldz, isuppz.ptr_data(),
-					&lwork_opt, &lwork, &liwork_opt, &liwork, &info));
-
-			lwork = (lapack_int)lwork_opt;
-			liwork = liwork_opt;
-
-			dense_col<float> ws((index_t)lwork);
-			dense_col<lapack_int> iws((index_t)liwork);
-
-			LMAT_CALL_LAPACK(ssyevr, (&jobz, &range, &uplo, &n, a.ptr_data(), &lda, &vl, &vu, &il, &iu, &abstol,
-					&m, w.ptr_data(), z.ptr_data(), &ldz, isuppz.ptr_data(),
-					ws.ptr_data(), &lwork, iws.ptr_data(), &liwork, &info));
+					&m, w.ptr_data(), z.ptr_data(), &ldz, isuppz,
+					work, &lwork, iwork, &liwork, &info));
 
 			return (index_t)m;
 		}
 
-
 		template<class A, class W, class V, typename Range>
 		inline index_t _syevr(IRegularMatrix<A, double>& a, IRegularMatrix<W, double>& w, IRegularMatrix<V, double>& z,
-				char jobz, char uplo, double abstol, const Range& ergn)
+				char jobz, char uplo, double abstol, const Range& ergn, lapack_int *isuppz,
+				double *work, lapack_int lwork, lapack_int *iwork, lapack_int liwork)
 		{
 			LMAT_CHECK_WHOLE_CONT(W)
 			LMAT_CHECK_PERCOL_CONT(A)
@@ -474,37 +467,55 @@ namespace lmat { namespace lapack {
 			lapack_int ldz = (lapack_int)z.col_stride();
 			if (ldz == 0) ldz = 1;
 
-			double lwork_opt = 0;
-			lapack_int lwork = -1;
-			lapack_int liwork_opt = 0;
-			lapack_int liwork = -1;
 			lapack_int info = 0;
 
-			dense_col<lapack_int> isuppz;
-			if (jobz == 'V' || jobz == 'v')
-				isuppz.require_size(2 * n);
-
 			char range;
 			double vl, vu;
 			lapack_int il, iu;
 			_set_eigval_range(n, ergn, range, vl, vu, il, iu);
 
 			LMAT_CALL_LAPACK(dsyevr, (&jobz, &range, &uplo, &n, a.ptr_data(), &lda, &vl, &vu, &il, &iu, &abstol,
-					&m, w.ptr_data(), z.ptr_data(), &ldz, isuppz.ptr_data(),
-					&lwork_opt, &lwork, &liwork_opt, &liwork, &info));
+					&m, w.ptr_data(), z.ptr_data(), &ldz, isuppz,
+					work, &lwork, iwork, &liwork, &info));
+
+			return (index_t)m;
+		}
+
+		LMAT_ENSURE_INLINE
+		inline index_t _syevr_isuppz_len(index_t n, char jobz)
+		{
+			return (jobz == 'V' || jobz == 'v') ? 2 * n : 0;
+		}
+
+		template<typename T, class A, class W, class V, typename Range>
+		inline void _syevr_lwork(IRegularMatrix<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& z,
+				char jobz, char uplo, T abstol, const Range& ergn, lapack_int *isuppz,
+				lapack_int& lwork, lapack_int& liwork)
+		{
+			T lwork_opt = 0;
+			lapack_int liwork_opt = 0;
+			_syevr(a, w, z, jobz, uplo, abstol, ergn, isuppz,
+					&lwork_opt, lapack_int(-1), &liwork_opt, lapack_int(-1));
 
 			lwork = (lapack_int)lwork_opt;
 			liwork = liwork_opt;
+		}
 
-			dense_col<double> ws((index_t)lwork);
-			dense_col<lapack_int> iws((index_t)liwork);
-			m = 0;
+		template<typename T, class A, class W, class V, typename Range>
+		inline index_t _syevr(IRegularMatrix<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& z,
+				char jobz, char uplo, T abstol, const Range& ergn)
+		{
+			dense_col<lapack_int> isuppz(_syevr_isuppz_len(a.nrows(), jobz));
 
-			LMAT_CALL_LAPACK(dsyevr, (&jobz, &range, &uplo, &n, a.ptr_data(), &lda, &vl, &vu, &il, &iu, &abstol,
-					&m, w.ptr_data(), z.ptr_data(), &ldz, isuppz.ptr_data(),
-					ws.ptr_data(), &lwork, iws.ptr_data(), &liwork, &info));
+			lapack_int lwork, liwork;
+			_syevr_lwork(a, w, z, jobz, uplo, abstol, ergn, isuppz.ptr_data(), lwork, liwork);
 
-			return (index_t)m;
+			dense_col<T> ws((index_t)lwork);
+			LMAT_INSTRUMENT_TEMP("lapack.syevr", lwork * sizeof(T))
+			dense_col<lapack_int> iws((index_t)liwork);
+
+			return _syevr(a, w, z, jobz, uplo, abstol, ergn, isuppz.ptr_data(),
+					ws.ptr_data(), lwork, iws.ptr_data(), liwork);
 		}
 
 		template<typename T, class A, class W, typename Range>
@@ -653,6 +664,278 @@ namespace lmat { namespace lapack {
 		return internal::_syevr_v(a, w, v, a.nrows(), ergn, abstol, uplo);
 	}
 
+
+	/********************************************
+	 *
+	 *  Reusable eigen-solver
+	 *
+	 *  Keeps a copy buffer for the input, and the
+	 *  workspace of the last computation. The optimal
+	 *  workspace size is queried only when the size
+	 *  or the job changes.
+	 *
+	 *  The workspace can be provided by the caller,
+	 *  e.g. to share it among several solvers.
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		LMAT_ENSURE_INLINE
+		inline index_t _eigval_count(index_t n, whole) { return n; }
+
+		LMAT_ENSURE_INLINE
+		inline index_t _eigval_count(index_t n, const eigval_irange& r) { return r.num(); }
+
+		template<typename T>
+		LMAT_ENSURE_INLINE
+		inline index_t _eigval_count(index_t n, const eigval_vrange<T>& ) { return n; }
+
+		LMAT_ENSURE_INLINE
+		inline char _eigval_range_code(whole) { return 'A'; }
+
+		LMAT_ENSURE_INLINE
+		inline char _eigval_range_code(const eigval_irange& ) { return 'I'; }
+
+		template<typename T>
+		LMAT_ENSURE_INLINE
+		inline char _eigval_range_code(const eigval_vrange<T>& ) { return 'V'; }
+	}
+
+
+	template<typename T>
+	class syev_solver : private noncopyable
+	{
+	public:
+		syev_solver()
+		: m_ws(&m_own_ws) { }
+
+		explicit syev_solver(lapack_workspace<T>& ws)
+		: m_ws(&ws) { }
+
+		lapack_workspace<T>& workspace()
+		{
+			return *m_ws;
+		}
+
+		// syev
+
+		template<class A, class W>
+		void syev(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, char uplo='L')
+		{
+			LMAT_CHECK_WHOLE_CONT(W)
+
+			set_input(a);
+			w.require_size(m_a.nrows(), 1);
+			run_syev(w, 'N', uplo);
+		}
+
+		template<class A, class W, class V>
+		void syev(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& v, char uplo='L')
+		{
+			LMAT_CHECK_WHOLE_CONT(W)
+			LMAT_CHECK_PERCOL_CONT(V)
+
+			set_input(a);
+			w.require_size(m_a.nrows(), 1);
+			run_syev(w, 'V', uplo);
+
+			v.derived() = m_a;
+		}
+
+		// syevd (divide and conquer)
+
+		template<class A, class W>
+		void syevd(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, char uplo='L')
+		{
+			LMAT_CHECK_WHOLE_CONT(W)
+
+			set_input(a);
+			w.require_size(m_a.nrows(), 1);
+			run_syevd(w, 'N', uplo);
+		}
+
+		template<class A, class W, class V>
+		void syevd(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& v, char uplo='L')
+		{
+			LMAT_CHECK_WHOLE_CONT(W)
+			LMAT_CHECK_PERCOL_CONT(V)
+
+			set_input(a);
+			w.require_size(m_a.nrows(), 1);
+			run_syevd(w, 'V', uplo);
+
+			v.derived() = m_a;
+		}
+
+		// syevr (relatively robust representations)
+
+		template<class A, class W>
+		index_t syevr(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, T abstol=T(0), char uplo='L')
+		{
+			return syevr_n(a, w, whole(), abstol, uplo);
+		}
+
+		template<class A, class W>
+		index_t syevr(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w,
+				const eigval_irange& ergn, T abstol=T(0), char uplo='L')
+		{
+			return syevr_n(a, w, ergn, abstol, uplo);
+		}
+
+		template<class A, class W>
+		index_t syevr(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w,
+				const eigval_vrange<T>& ergn, T abstol=T(0), char uplo='L')
+		{
+			return syevr_n(a, w, ergn, abstol, uplo);
+		}
+
+		template<class A, class W, class V>
+		index_t syevr(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& v,
+				T abstol=T(0), char uplo='L')
+		{
+			return syevr_v(a, w, v, whole(), abstol, uplo);
+		}
+
+		template<class A, class W, class V>
+		index_t syevr(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& v,
+				const eigval_irange& ergn, T abstol=T(0), char uplo='L')
+		{
+			return syevr_v(a, w, v, ergn, abstol, uplo);
+		}
+
+		template<class A, class W, class V>
+		index_t syevr(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& v,
+				const eigval_vrange<T>& ergn, T abstol=T(0), char uplo='L')
+		{
+			return syevr_v(a, w, v, ergn, abstol, uplo);
+		}
+
+	private:
+		template<class A>
+		void set_input(const IMatrixXpr<A, T>& a)
+		{
+			LMAT_CHECK_DIMS(a.ncolumns() == a.nrows())
+			m_a = a.derived();
+		}
+
+		template<class W>
+		void run_syev(IRegularMatrix<W, T>& w, char jobz, char uplo)
+		{
+			const index_t n = m_a.nrows();
+			if (!m_ev_cache.hit(n, n, jobz, uplo))
+			{
+				lapack_int lw = internal::_syev_lwork(m_a, w, jobz, uplo);
+				m_ev_cache.set(n, n, jobz, uplo, lw, 0);
+			}
+
+			lapack_int lwork = m_ev_cache.lwork;
+			internal::_syev(m_a, w, jobz, uplo, m_ws->work(lwork), lwork);
+		}
+
+		template<class W>
+		void run_syevd(IRegularMatrix<W, T>& w, char jobz, char uplo)
+		{
+			const index_t n = m_a.nrows();
+			if (!m_evd_cache.hit(n, n, jobz, uplo))
+			{
+				lapack_int lw, liw;
+				internal::_syevd_lwork(m_a, w, jobz, uplo, lw, liw);
+				m_evd_cache.set(n, n, jobz, uplo, lw, liw);
+			}
+
+			lapack_int lwork = m_evd_cache.lwork;
+			lapack_int liwork = m_evd_cache.liwork;
+			internal::_syevd(m_a, w, jobz, uplo,
+					m_ws->work(lwork), lwork, m_ws->iwork(liwork), liwork);
+		}
+
+		template<class W, class V, typename Range>
+		index_t run_syevr(IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& z,
+				char jobz, char uplo, T abstol, const Range& ergn)
+		{
+			const index_t n = m_a.nrows();
+
+			index_t lsupp = internal::_syevr_isuppz_len(n, jobz);
+			if (m_isuppz.nelems() != lsupp) m_isuppz.require_size(lsupp);
+
+			char rc = internal::_eigval_range_code(ergn);
+			if (!m_evr_cache.hit(n, n, jobz, rc))
+			{
+				lapack_int lw, liw;
+				internal::_syevr_lwork(m_a, w, z, jobz, uplo, abstol, ergn, m_isuppz.ptr_data(), lw, liw);
+				m_evr_cache.set(n, n, jobz, rc, lw, liw);
+			}
+
+			lapack_int lwork = m_evr_cache.lwork;
+			lapack_int liwork = m_evr_cache.liwork;
+			return internal::_syevr(m_a, w, z, jobz, uplo, abstol, ergn, m_isuppz.ptr_data(),
+					m_ws->work(lwork), lwork, m_ws->iwork(liwork), liwork);
+		}
+
+		template<class A, class W, typename Range>
+		index_t syevr_n(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w,
+				const Range& ergn, T abstol, char uplo)
+		{
+			LMAT_CHECK_WHOLE_CONT(W)
+
+			set_input(a);
+			const index_t n = m_a.nrows();
+			const index_t ns = internal::_eigval_count(n, ergn);
+			w.require_size(ns, 1);
+
+			if (ns == n)
+			{
+				return run_syevr(w, m_v, 'N', uplo, abstol, ergn);
+			}
+			else
+			{
+				m_w.require_size(n);
+				index_t ret = run_syevr(m_w, m_v, 'N', uplo, abstol, ergn);
+				copy_vec(ns, m_w.ptr_data(), w.ptr_data());
+				return ret;
+			}
+		}
+
+		template<class A, class W, class V, typename Range>
+		index_t syevr_v(const IMatrixXpr<A, T>& a, IRegularMatrix<W, T>& w, IRegularMatrix<V, T>& v,
+				const Range& ergn, T abstol, char uplo)
+		{
+			LMAT_CHECK_WHOLE_CONT(W)
+			LMAT_CHECK_PERCOL_CONT(V)
+
+			set_input(a);
+			const index_t n = m_a.nrows();
+			const index_t ns = internal::_eigval_count(n, ergn);
+			w.require_size(ns, 1);
+			v.require_size(n, ns);
+
+			if (ns == n)
+			{
+				return run_syevr(w, v, 'V', uplo, abstol, ergn);
+			}
+			else
+			{
+				m_w.require_size(n);
+				index_t ret = run_syevr(m_w, v, 'V', uplo, abstol, ergn);
+				copy_vec(ns, m_w.ptr_data(), w.ptr_data());
+				return ret;
+			}
+		}
+
+	private:
+		lapack_workspace<T> m_own_ws;
+		lapack_workspace<T> *m_ws;
+		internal::lwork_cache m_ev_cache;
+		internal::lwork_cache m_evd_cache;
+		internal::lwork_cache m_evr_cache;
+
+		dense_matrix<T> m_a;
+		dense_matrix<T> m_v;   // empty place-holder when vectors are not computed
+		dense_col<T> m_w;
+		dense_col<lapack_int> m_isuppz;
+	};
+
 } }
 
 
@@ -44,6 +44,12 @@ namespace lmat
 
 	LMAT_DEF_SIMD_SUPPORT( copy_kernel )
 
+	template<typename T>
+	struct kernel_cost<copy_kernel<T> >
+	{
+		static const int value = 0;
+	};
+
 	template<typename Fun>
 	struct map_kernel
 	{
@@ -46,6 +46,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		void eval(macc_<linear_, U>, index_t m, index_t n, const Wraps&... wraps) const
 		{
+			LMAT_INSTRUMENT_PATH("ewise.linear", use_simd(macc_<linear_, U>()))
 			dimension<0> dim(m * n);
 			internal::_linear_ewise_eval(dim, U(), m_kernel, make_vec_accessor(U(), wraps)...);
 		}
@@ -54,6 +55,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		void eval(macc_<linear_, U>, const matrix_shape<CM, CN>& shape, const Wraps&... wraps) const
 		{
+			LMAT_INSTRUMENT_PATH("ewise.linear", use_simd(macc_<linear_, U>()))
 			dimension<CM * CN> dim(shape.nelems());
 			internal::_linear_ewise_eval(dim, U(), m_kernel, make_vec_accessor(U(), wraps)...);
 		}
@@ -62,6 +64,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		void eval(macc_<percol_, U>, index_t m, index_t n, const Wraps&... wraps) const
 		{
+			LMAT_INSTRUMENT_PATH("ewise.percol", use_simd(macc_<percol_, U>()))
 			matrix_shape<0, 0> shape(m, n);
 			internal::_percol_ewise_eval(shape, U(), m_kernel, make_multicol_accessor(U(), wraps)...);
 		}
@@ -70,6 +73,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		void eval(macc_<percol_, U>, const matrix_shape<CM, CN>& shape, const Wraps&... wraps) const
 		{
+			LMAT_INSTRUMENT_PATH("ewise.percol", use_simd(macc_<percol_, U>()))
 			internal::_percol_ewise_eval(shape, U(), m_kernel, make_multicol_accessor(U(), wraps)...);
 		}
 
@@ -77,14 +81,57 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		void operator() (index_t m, index_t n, const Wraps&... wraps) const
 		{
-			eval(get_preferred_macc_policy(m, n, m_kernel, wraps...), m, n, wraps...);
+			typedef typename internal::avx_dispatchable<0, Kernel, Wraps...>::type dispatchable;
+
+			dispatch_eval(get_preferred_macc_policy(m, n, m_kernel, wraps...), dispatchable(),
+					m, n, wraps...);
 		}
 
 		template<index_t CM, index_t CN, typename... Wraps>
 		LMAT_ENSURE_INLINE
 		void operator() (const matrix_shape<CM, CN>& shape, const Wraps&... wraps) const
 		{
-			eval(get_preferred_macc_policy(shape, m_kernel, wraps...), shape, wraps...);
+			typedef preferred_macc_policy<matrix_shape<CM, CN>, Kernel, Wraps...> pmap;
+			typedef typename internal::avx_dispatchable<
+					(pmap::use_linear ? CM * CN : CM), Kernel, Wraps...>::type dispatchable;
+
+			dispatch_eval(typename pmap::type(), dispatchable(), shape, wraps...);
+		}
+
+	private:
+		// an evaluation planned with SSE packs goes through the
+		// run-time dispatch (see simd_dispatch.h)
+
+		template<typename Acc>
+		struct simd_eval_task
+		{
+			typedef void result_type;
+
+			const ewise_kernel& ek;
+
+			LMAT_ENSURE_INLINE
+			simd_eval_task(const ewise_kernel& ek_) : ek(ek_) { }
+
+			template<typename Kind, typename... Args>
+			LMAT_ENSURE_INLINE
+			void operator() (Kind, const Args&... args) const
+			{
+				ek.eval(macc_<Acc, simd_<Kind> >(), args...);
+			}
+		};
+
+		template<typename Acc, typename U, typename Dispatchable, typename... Args>
+		LMAT_ENSURE_INLINE
+		void dispatch_eval(macc_<Acc, U> policy, Dispatchable, const Args&... args) const
+		{
+			eval(policy, args...);
+		}
+
+		template<typename Acc, typename Dispatchable, typename... Args>
+		LMAT_ENSURE_INLINE
+		void dispatch_eval(macc_<Acc, simd_<sse_t> >, Dispatchable, const Args&... args) const
+		{
+			internal::simd_dispatch(Dispatchable(), simd_eval_task<Acc>(*this), args...);
 		}
 
 	private:
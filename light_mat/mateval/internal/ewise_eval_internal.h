@@ -14,19 +14,91 @@
 #define LIGHTMAT_EWISE_EVAL_INTERNAL_H_
 
 #include <light_mat/matrix/matrix_properties.h>
+#include <light_mat/mateval/macc_policy.h>
 #include <light_mat/mateval/vec_accessors.h>
 #include <light_mat/mateval/multicol_accessors.h>
 
 #include <light_mat/math/functor_base.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+// Outputs of at least LMAT_STREAM_MIN_BYTES (by default, the size of the
+// last-level cache, as detected at run-time) are evaluated in streaming
+// mode, where packs are written with non-temporal stores (avoiding the
+// read-for-ownership of the destination), and contiguous inputs are
+// prefetched LMAT_PREFETCH_DISTANCE bytes ahead. Define
+// LMAT_STREAM_MIN_BYTES as 0 to disable streaming.
+
+#ifndef LMAT_STREAM_MIN_BYTES
+#define LMAT_STREAM_MIN_BYTES (::lmat::internal::last_level_cache_size())
+#endif
+
+#ifndef LMAT_PREFETCH_DISTANCE
+#define LMAT_PREFETCH_DISTANCE 512
+#endif
+
 namespace lmat { namespace internal {
 
+	inline size_t _detect_last_level_cache_size()
+	{
+		long s = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+		s = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+		if (s <= 0) s = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+		return s > 0 ? static_cast<size_t>(s) : (static_cast<size_t>(1) << 23);
+	}
+
+	inline size_t last_level_cache_size()
+	{
+		static const size_t s = _detect_last_level_cache_size();
+		return s;
+	}
+
+
 	/********************************************
 	 *
 	 *  linear element-wise evaluation
 	 *
 	 ********************************************/
 
+	template<typename T>
+	LMAT_ENSURE_INLINE
+	inline bool _use_streaming(index_t len)
+	{
+		const size_t min_bytes = static_cast<size_t>(LMAT_STREAM_MIN_BYTES);
+		return min_bytes > 0 && static_cast<size_t>(len) * sizeof(T) >= min_bytes;
+	}
+
+	// evaluates the packs within [i0, maj_len), where maj_len - i0 is a
+	// multiple of 2 W, in streaming mode
+
+	template<typename T, unsigned int W, class PKernel, typename... Accessors>
+	inline void _linear_ewise_stream_packs(index_t i0, index_t maj_len,
+			const PKernel& pk_kernel, const Accessors&... accessors)
+	{
+		const index_t W_ = static_cast<index_t>(W);
+		const index_t W2_ = W_ * 2;
+		const index_t pf_dist = static_cast<index_t>(LMAT_PREFETCH_DISTANCE / sizeof(T));
+
+		for (index_t i = i0; i < maj_len; i += W2_)
+		{
+			pass(accessors.prefetch(i + pf_dist)...);
+
+			pk_kernel(accessors.pack(i)...);
+			pass(accessors.done_pack_nt(i)...);
+			pk_kernel(accessors.pack(i + W_)...);
+			pass(accessors.done_pack_nt(i + W_)...);
+		}
+
+		// make the non-temporal stores visible before proceeding
+		_mm_sfence();
+	}
+
 	template<index_t Len, class Kernel, typename... Accessors>
 	inline void _linear_ewise_eval(
 			const dimension<Len>& dim, scalar_,
@@ -42,26 +114,148 @@ namespace lmat { namespace internal {
 		pass(accessors.finalize()...);
 	}
 
+	// when all accessors support partial packs, the tail of len % W
+	// elements (or the whole range if len < W) is evaluated as one
+	// partial pack, with masked loads and stores, rather than by
+	// the scalar loop
+
+	template<class PKernel, class Kernel, typename... Accessors>
+	LMAT_ENSURE_INLINE
+	inline void _linear_ewise_tail(meta::true_, index_t i0, index_t len,
+			const PKernel& pk_kernel, const Kernel&, const Accessors&... accessors)
+	{
+		const index_t k = len - i0;
+		pk_kernel(accessors.pack_part(i0, k)...);
+		pass(accessors.done_pack_part(i0, k)...);
+	}
+
+	template<class PKernel, class Kernel, typename... Accessors>
+	LMAT_ENSURE_INLINE
+	inline void _linear_ewise_tail(meta::false_, index_t i0, index_t len,
+			const PKernel&, const Kernel& kernel, const Accessors&... accessors)
+	{
+		for (index_t i = i0; i < len; ++i)
+		{
+			kernel(accessors.scalar(i)...);
+			pass(accessors.done_scalar(i)...);
+		}
+	}
+
+	// evaluates [0, len) with aligned packs, after peeling off the
+	// leading i0 elements with scalars (see pack_align_policy)
+
+	template<typename T, unsigned int W, class PKernel, class Kernel, typename... Accessors>
+	inline void _linear_ewise_aligned(index_t i0, index_t len,
+			const PKernel& pk_kernel, const Kernel& kernel, const Accessors&... accessors)
+	{
+		const unsigned int W2 = W * 2;
+		const index_t W_ = static_cast<index_t>(W);
+		const index_t W2_ = static_cast<index_t>(W2);
+
+		typedef meta::bool_<supports_part_packs<Accessors...>::value> part_t;
+
+		_linear_ewise_tail(meta::false_(), 0, i0, pk_kernel, kernel, accessors...);
+
+		index_t i = i0 + static_cast<index_t>(int_div<W2>::maj(static_cast<size_t>(len - i0)));
+		pass(accessors.begin_packs()...);
+
+		if (_use_streaming<T>(len))
+		{
+			LMAT_INSTRUMENT_PATH("ewise.stream", true)
+			_linear_ewise_stream_packs<T, W>(i0, i, pk_kernel, accessors...);
+		}
+		else
+		{
+			for (index_t j = i0; j < i; j += W2_)
+			{
+				pk_kernel(accessors.pack_a(j)...);
+				pass(accessors.done_pack_a(j)...);
+				pk_kernel(accessors.pack_a(j + W_)...);
+				pass(accessors.done_pack_a(j + W_)...);
+			}
+		}
+
+		if (i + W_ <= len)
+		{
+			pk_kernel(accessors.pack_a(i)...);
+			pass(accessors.done_pack_a(i)...);
+			i += W_;
+		}
+
+		if (part_t::value)
+		{
+			if (i < len)
+				_linear_ewise_tail(part_t(), i, len, pk_kernel, kernel, accessors...);
+			pass(accessors.end_packs()...);
+		}
+		else
+		{
+			pass(accessors.end_packs()...);
+			_linear_ewise_tail(meta::false_(), i, len, pk_kernel, kernel, accessors...);
+		}
+	}
+
+	// returns whether [0, len) has been evaluated with aligned packs
+
+	template<typename T, typename SKind, class PKernel, class Kernel, typename... Accessors>
+	LMAT_ENSURE_INLINE
+	inline bool _linear_ewise_try_aligned(meta::false_, index_t,
+			const PKernel&, const Kernel&, const Accessors&... )
+	{
+		return false;
+	}
+
+	template<typename T, typename SKind, class PKernel, class Kernel, typename... Accessors>
+	inline bool _linear_ewise_try_aligned(meta::true_, index_t len,
+			const PKernel& pk_kernel, const Kernel& kernel, const Accessors&... accessors)
+	{
+		typedef pack_align_policy<T, SKind> apolicy;
+		const unsigned int W = simd_traits<T, SKind>::pack_width;
+
+		const index_t offset = common_pack_offset(accessors.pack_offset()...);
+
+		switch (apolicy::choose(offset, len))
+		{
+		case aligned_packs:
+			LMAT_INSTRUMENT_VARIANT("ewise.aligned")
+			_linear_ewise_aligned<T, W>(0, len, pk_kernel, kernel, accessors...);
+			return true;
+
+		case peeled_packs:
+			LMAT_INSTRUMENT_VARIANT("ewise.peeled")
+			_linear_ewise_aligned<T, W>(apolicy::npeel(offset), len, pk_kernel, kernel, accessors...);
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
 	template<index_t Len, typename SKind, class Kernel, typename... Accessors>
-	inline void _linear_ewise_eval(
+	inline void _linear_ewise_simd(meta::false_,
 			const dimension<Len>& dim, simd_<SKind>,
 			const Kernel& kernel, const Accessors&... accessors)
 	{
-		static_assert(is_simdizable<Kernel, SKind>::value, "kernel must be simdizable.");
-
 		typedef typename Kernel::value_type T;
 		const unsigned int W = simd_traits<T, SKind>::pack_width;
 		const index_t W_ = static_cast<index_t>(W);
 
+		typedef meta::bool_<supports_part_packs<Accessors...>::value> part_t;
+		typedef meta::bool_<supports_aligned_packs<Accessors...>::value> align_t;
+
 		const index_t len = dim.value();
+		auto pk_kernel = lmat::simdize_map<Kernel, SKind>::get(kernel);
 
-		if (len >= W_)
+		if (_linear_ewise_try_aligned<T, SKind>(align_t(), len, pk_kernel, kernel, accessors...))
+		{
+			// evaluated with aligned packs
+		}
+		else if (len >= W_)
 		{
 			const unsigned int W2 = W * 2;
 			const index_t W2_ = static_cast<index_t>(W2);
 
 			const size_t npacks = int_div<W>::quo(static_cast<size_t>(len));
-			auto pk_kernel = lmat::simdize_map<Kernel, SKind>::get(kernel);
 
 			index_t maj_len;
 
@@ -70,12 +264,20 @@ namespace lmat { namespace internal {
 				maj_len = static_cast<index_t>(int_div<W2>::maj(static_cast<size_t>(len)));
 				pass(accessors.begin_packs()...);
 
-				for (index_t i = 0; i < maj_len; i += W2_)
+				if (_use_streaming<T>(len))
+				{
+					LMAT_INSTRUMENT_PATH("ewise.stream", true)
+					_linear_ewise_stream_packs<T, W>(0, maj_len, pk_kernel, accessors...);
+				}
+				else
 				{
-					pk_kernel(accessors.pack(i)...);
-					pass(accessors.done_pack(i)...);
-					pk_kernel(accessors.pack(i + W_)...);
-					pass(accessors.done_pack(i + W_)...);
+					for (index_t i = 0; i < maj_len; i += W2_)
+					{
+						pk_kernel(accessors.pack(i)...);
+						pass(accessors.done_pack(i)...);
+						pk_kernel(accessors.pack(i + W_)...);
+						pass(accessors.done_pack(i + W_)...);
+					}
 				}
 
 				if (npacks & 1)
@@ -84,9 +286,6 @@ namespace lmat { namespace internal {
 					pass(accessors.done_pack(maj_len)...);
 					maj_len += W_;
 				}
-
-				pass(accessors.end_packs()...);
-
 			}
 			else // npacks == 1
 			{
@@ -94,27 +293,142 @@ namespace lmat { namespace internal {
 				pass(accessors.begin_packs()...);
 				pk_kernel(accessors.pack(0)...);
 				pass(accessors.done_pack(0)...);
-				pass(accessors.end_packs()...);
 			}
 
-			for (index_t i = maj_len; i < len; ++i)
+			if (part_t::value)
+			{
+				if (maj_len < len)
+					_linear_ewise_tail(part_t(), maj_len, len, pk_kernel, kernel, accessors...);
+				pass(accessors.end_packs()...);
+			}
+			else
 			{
-				kernel(accessors.scalar(i)...);
-				pass(accessors.done_scalar(i)...);
+				pass(accessors.end_packs()...);
+				_linear_ewise_tail(meta::false_(), maj_len, len, pk_kernel, kernel, accessors...);
 			}
 		}
+		else if (part_t::value && len > 0)
+		{
+			pass(accessors.begin_packs()...);
+			_linear_ewise_tail(part_t(), 0, len, pk_kernel, kernel, accessors...);
+			pass(accessors.end_packs()...);
+		}
 		else
 		{
-			for (index_t i = 0; i < len; ++i)
-			{
-				kernel(accessors.scalar(i)...);
-				pass(accessors.done_scalar(i)...);
-			}
+			_linear_ewise_tail(meta::false_(), 0, len, pk_kernel, kernel, accessors...);
 		}
 
 		pass(accessors.finalize()...);
 	}
 
+	// fully unrolled evaluation over a static length
+
+	template<index_t I, index_t N, index_t W, bool Done=(I >= N)>
+	struct _linear_ewise_unroller
+	{
+		template<class PKernel, typename... Accessors>
+		LMAT_ENSURE_INLINE
+		static void run(const PKernel& pk_kernel, const Accessors&... accessors)
+		{
+			pk_kernel(accessors.pack(I)...);
+			pass(accessors.done_pack(I)...);
+			_linear_ewise_unroller<I + W, N, W>::run(pk_kernel, accessors...);
+		}
+	};
+
+	template<index_t I, index_t N, index_t W>
+	struct _linear_ewise_unroller<I, N, W, true>
+	{
+		template<class PKernel, typename... Accessors>
+		LMAT_ENSURE_INLINE
+		static void run(const PKernel&, const Accessors&... ) { }
+	};
+
+	template<index_t Len, typename SKind, class Kernel, typename... Accessors>
+	LMAT_ENSURE_INLINE
+	inline void _linear_ewise_simd(meta::true_,
+			const dimension<Len>&, simd_<SKind>,
+			const Kernel& kernel, const Accessors&... accessors)
+	{
+		typedef typename Kernel::value_type T;
+		const index_t W = static_cast<index_t>(simd_traits<T, SKind>::pack_width);
+		const index_t maj_len = Len - Len % W;
+
+		auto pk_kernel = lmat::simdize_map<Kernel, SKind>::get(kernel);
+
+		pass(accessors.begin_packs()...);
+		_linear_ewise_unroller<0, maj_len, W>::run(pk_kernel, accessors...);
+		pass(accessors.end_packs()...);
+
+		// the tail has a static trip count (less than W), which the compiler
+		// unrolls as well, and which avoids the store-forwarding stalls
+		// of masked stores when small matrices are updated repeatedly
+
+		_linear_ewise_tail(meta::false_(), maj_len, Len, pk_kernel, kernel, accessors...);
+
+		pass(accessors.finalize()...);
+	}
+
+	template<index_t Len, typename SKind, class Kernel, typename... Accessors>
+	LMAT_ENSURE_INLINE
+	inline void _linear_ewise_eval(
+			const dimension<Len>& dim, simd_<SKind> u,
+			const Kernel& kernel, const Accessors&... accessors)
+	{
+		static_assert(is_simdizable<Kernel, SKind>::value, "kernel must be simdizable.");
+
+		_linear_ewise_simd(typename unroll_static_len<Len>::type(), dim, u, kernel, accessors...);
+	}
+
+
+	/********************************************
+	 *
+	 *  ranged element-wise evaluation
+	 *
+	 *  evaluates the indices within [i0, i1),
+	 *  with accessors that are stateless across
+	 *  indices (e.g. readers, writers and updaters)
+	 *
+	 ********************************************/
+
+	template<class Kernel, typename... Accessors>
+	inline void _ranged_ewise_eval(
+			index_t i0, index_t i1, scalar_,
+			const Kernel& kernel, const Accessors&... accessors)
+	{
+		for (index_t i = i0; i < i1; ++i)
+		{
+			kernel(accessors.scalar(i)...);
+			pass(accessors.done_scalar(i)...);
+		}
+	}
+
+	template<typename SKind, class Kernel, typename... Accessors>
+	inline void _ranged_ewise_eval(
+			index_t i0, index_t i1, simd_<SKind>,
+			const Kernel& kernel, const Accessors&... accessors)
+	{
+		static_assert(is_simdizable<Kernel, SKind>::value, "kernel must be simdizable.");
+
+		typedef typename Kernel::value_type T;
+		const index_t W = static_cast<index_t>(simd_traits<T, SKind>::pack_width);
+
+		auto pk_kernel = lmat::simdize_map<Kernel, SKind>::get(kernel);
+
+		index_t i = i0;
+		for (; i + W <= i1; i += W)
+		{
+			pk_kernel(accessors.pack(i)...);
+			pass(accessors.done_pack(i)...);
+		}
+
+		for (; i < i1; ++i)
+		{
+			kernel(accessors.scalar(i)...);
+			pass(accessors.done_scalar(i)...);
+		}
+	}
+
 
 	/********************************************
 	 *
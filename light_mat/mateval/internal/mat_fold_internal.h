@@ -15,6 +15,7 @@
 #define LIGHTMAT_MAT_FOLD_INTERNAL_H_
 
 #include <light_mat/mateval/macc_policy.h>
+#include <light_mat/mateval/vec_accessors.h>
 
 
 namespace lmat { namespace internal {
@@ -29,7 +30,8 @@ namespace lmat { namespace internal {
 
 		static const bool supp_simd =
 				is_simdizable<FoldKernel, skind>::value &&
-				meta::all_<supports_simd<Args, skind>...>::value;
+				meta::all_<supports_simd<Args, skind>...>::value &&
+				kernel_strided_simd_pays<FoldKernel, Args...>::value;
 
 		static const bool use_linear = supp_linear;
 
@@ -43,13 +45,44 @@ namespace lmat { namespace internal {
 		typedef typename std::conditional<use_linear,
 				linear_, percol_>::type access;
 
-		static const bool use_simd = supp_simd && ((unsigned int)_len % pack_width == 0);
+		// the tail of a length that is not a multiple of the pack width
+		// is folded in as an overlapping pack for idempotent kernels,
+		// and by a scalar loop otherwise
+
+		static const bool use_simd = supp_simd &&
+				((unsigned int)_len % pack_width == 0 || (unsigned int)_len > pack_width);
 
 		typedef typename std::conditional<use_simd, simd_<skind>, scalar_>::type unit;
 
 		typedef macc_<access, unit> type;
 	};
 
+	// a fold kernel is idempotent if folding in the same value more
+	// than once does not change the result (e.g. maximum)
+
+	template<class FoldKernel>
+	struct is_idempotent_fold : public meta::false_ { };
+
+	// constants of the same type as a (scalar or pack) value,
+	// which are useful in the initialization of statistics
+
+	template<typename T>
+	LMAT_ENSURE_INLINE
+	inline T zero_of(const T& ) { return T(0); }
+
+	template<typename T, typename Kind>
+	LMAT_ENSURE_INLINE
+	inline simd_pack<T, Kind> zero_of(const simd_pack<T, Kind>& ) { return simd_pack<T, Kind>::zeros(); }
+
+	template<typename T>
+	LMAT_ENSURE_INLINE
+	inline T one_of(const T& ) { return T(1); }
+
+	template<typename T, typename Kind>
+	LMAT_ENSURE_INLINE
+	inline simd_pack<T, Kind> one_of(const simd_pack<T, Kind>& ) { return simd_pack<T, Kind>::ones(); }
+
+
 	/********************************************
 	 *
 	 *  core implementation
@@ -70,7 +103,8 @@ namespace lmat { namespace internal {
 
 	template<index_t Len, typename SKind, class FoldKernel, typename... Reader>
 	inline typename FoldKernel::accumulated_type
-	linear_fold_impl(const dimension<Len>& dim, simd_<SKind>, const FoldKernel& fker, const Reader&... rd)
+	_linear_fold_simd(meta::false_, const dimension<Len>& dim, simd_<SKind>,
+			const FoldKernel& fker, const Reader&... rd)
 	{
 		typedef typename FoldKernel::accumulated_type RT;
 		typedef typename simdize_map<FoldKernel, SKind>::type simd_fker_t;
@@ -78,6 +112,13 @@ namespace lmat { namespace internal {
 
 		simd_fker_t pk_fker = simdize_map<FoldKernel, SKind>::get(fker);
 
+		// with an idempotent kernel, the tail is covered by the last
+		// (full) pack, which overlaps with the packs before it, provided
+		// that the readers access elements by index without side effects
+
+		typedef meta::and_<is_idempotent_fold<FoldKernel>,
+				supports_part_packs<Reader...> > overlap_t;
+
 		const index_t pw = (index_t)pack_t::pack_width;
 
 		const index_t len = dim.value();
@@ -146,6 +187,12 @@ namespace lmat { namespace internal {
 				i = pw;
 			}
 
+			if (overlap_t::value && i < len)
+			{
+				pk_fker(a0, rd.pack(len - pw)...);
+				i = len;
+			}
+
 			pass(rd.end_packs()...);
 
 			r = pk_fker.reduce(a0);
@@ -160,6 +207,85 @@ namespace lmat { namespace internal {
 		return r;
 	}
 
+	// fully unrolled folding over a static length, alternating
+	// between two accumulators
+
+	template<index_t I, index_t N, index_t W, bool Done=(I >= N)>
+	struct _linear_fold_unroller
+	{
+		template<class PFKer, typename Acc, typename... Reader>
+		LMAT_ENSURE_INLINE
+		static void run(const PFKer& pk_fker, Acc& a0, Acc& a1, const Reader&... rd)
+		{
+			pk_fker(a0, rd.pack(I)...);
+			_linear_fold_unroller<I + W, N, W>::run(pk_fker, a1, a0, rd...);
+		}
+	};
+
+	template<index_t I, index_t N, index_t W>
+	struct _linear_fold_unroller<I, N, W, true>
+	{
+		template<class PFKer, typename Acc, typename... Reader>
+		LMAT_ENSURE_INLINE
+		static void run(const PFKer&, Acc&, Acc&, const Reader&... ) { }
+	};
+
+	template<index_t Len, typename SKind, class FoldKernel, typename... Reader>
+	LMAT_ENSURE_INLINE
+	inline typename FoldKernel::accumulated_type
+	_linear_fold_simd(meta::true_, const dimension<Len>& dim, simd_<SKind> u,
+			const FoldKernel& fker, const Reader&... rd)
+	{
+		typedef typename FoldKernel::accumulated_type RT;
+		typedef typename simdize_map<FoldKernel, SKind>::type simd_fker_t;
+		typedef typename simd_fker_t::accumulated_type pack_t;
+
+		const index_t W = (index_t)pack_t::pack_width;
+		const index_t maj_len = Len - Len % W;
+
+		if (maj_len == 0)
+		{
+			return _linear_fold_simd(meta::false_(), dim, u, fker, rd...);
+		}
+
+		simd_fker_t pk_fker = simdize_map<FoldKernel, SKind>::get(fker);
+
+		typedef meta::and_<is_idempotent_fold<FoldKernel>,
+				supports_part_packs<Reader...> > overlap_t;
+
+		pass(rd.begin_packs()...);
+
+		pack_t a0 = pk_fker.init(rd.pack(0)...);
+
+		if (maj_len > W)
+		{
+			pack_t a1 = pk_fker.init(rd.pack(W)...);
+			_linear_fold_unroller<2 * W, maj_len, W>::run(pk_fker, a0, a1, rd...);
+			pk_fker(a0, a1);
+		}
+
+		index_t i = maj_len;
+		if (overlap_t::value && i < Len)
+		{
+			pk_fker(a0, rd.pack(Len - W)...);
+			i = Len;
+		}
+
+		pass(rd.end_packs()...);
+
+		RT r = pk_fker.reduce(a0);
+		for (; i < Len; ++i) fker(r, rd.scalar(i)...);
+		return r;
+	}
+
+	template<index_t Len, typename SKind, class FoldKernel, typename... Reader>
+	LMAT_ENSURE_INLINE
+	inline typename FoldKernel::accumulated_type
+	linear_fold_impl(const dimension<Len>& dim, simd_<SKind> u, const FoldKernel& fker, const Reader&... rd)
+	{
+		return _linear_fold_simd(typename unroll_static_len<Len>::type(), dim, u, fker, rd...);
+	}
+
 
 	template<index_t CM, index_t CN, typename U, class FoldKernel, typename... Reader>
 	inline typename FoldKernel::accumulated_type
@@ -0,0 +1,278 @@
+/**
+ * @file mat_histogram_internal.h
+ *
+ * Internal implementation of histograms and quantile sketches
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MAT_HISTOGRAM_INTERNAL_H_
+#define LIGHTMAT_MAT_HISTOGRAM_INTERNAL_H_
+
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/mateval/macc_policy.h>
+#include <light_mat/simd/simd_binning.h>
+#include <light_mat/common/exec.h>
+
+#include <algorithm>
+
+namespace lmat { namespace internal {
+
+	/********************************************
+	 *
+	 *  binners
+	 *
+	 *  A binner maps a value to the index of
+	 *  its bin in [0, nb), or to nb for values
+	 *  outside of all bins.
+	 *
+	 ********************************************/
+
+	template<typename TI>
+	struct index_binner
+	{
+		index_t nb;
+
+		LMAT_ENSURE_INLINE
+		index_t operator() (const TI& i) const
+		{
+			const int64_t k = static_cast<int64_t>(i);
+			return k >= 0 && k < nb ? static_cast<index_t>(k) : nb;
+		}
+	};
+
+	// bins [e[k], e[k+1]), except that the last one is closed
+
+	template<typename T>
+	struct edges_binner
+	{
+		const T *e;
+		index_t nb;
+
+		LMAT_ENSURE_INLINE
+		index_t operator() (const T& x) const
+		{
+			if (!(x >= e[0] && x <= e[nb])) return nb;
+			index_t k = static_cast<index_t>(std::upper_bound(e, e + (nb + 1), x) - e) - 1;
+			return k < nb ? k : nb - 1;
+		}
+	};
+
+	template<typename T>
+	struct uniform_binner
+	{
+		T lo;
+		T hi;
+		T scale;
+		index_t nb;
+
+		LMAT_ENSURE_INLINE
+		index_t operator() (const T& x) const
+		{
+			if (!(x >= lo && x <= hi)) return nb;
+			index_t k = static_cast<index_t>((x - lo) * scale);
+			return k < nb ? k : nb - 1;
+		}
+	};
+
+	template<class Binner, class A>
+	struct binning_unit
+	{
+		typedef scalar_ type;
+	};
+
+	template<typename T, class A>
+	struct binning_unit<uniform_binner<T>, A>
+	{
+		typedef typename std::conditional<
+				simd_uniform_binner<T, default_simd_kind>::available &&
+				supports_simd<A, default_simd_kind>::value &&
+				strided_simd_pays<LMAT_COST_ARITH, A>::value,
+				simd_<default_simd_kind>,
+				scalar_>::type type;
+	};
+
+
+	/********************************************
+	 *
+	 *  counting
+	 *
+	 ********************************************/
+
+	template<class Binner, class Rd>
+	inline void _bin_count(index_t i0, index_t i1, scalar_,
+			const Binner& binner, const Rd& rd, index_t *c)
+	{
+		for (index_t i = i0; i < i1; ++i)
+		{
+			++ c[binner(rd.scalar(i))];
+		}
+	}
+
+	// the bin indices of a pack are computed together, while
+	// the increments remain scalar (there is no scatter)
+
+	template<typename T, class Rd, typename Kind>
+	inline void _bin_count(index_t i0, index_t i1, simd_<Kind>,
+			const uniform_binner<T>& binner, const Rd& rd, index_t *c)
+	{
+		const index_t W = (index_t)simd_traits<T, Kind>::pack_width;
+		simd_uniform_binner<T, Kind> sb(binner.lo, binner.hi, binner.scale, binner.nb);
+
+		int32_t ks[W];
+
+		index_t i = i0;
+		for (; i + W <= i1; i += W)
+		{
+			sb.run(rd.pack(i), ks);
+			for (index_t u = 0; u < W; ++u) ++ c[ks[u]];
+		}
+
+		_bin_count(i, i1, scalar_(), binner, rd, c);
+	}
+
+	template<class Binner, typename U>
+	struct bin_counter
+	{
+		const Binner& binner;
+		index_t *c;
+
+		template<class Rd>
+		LMAT_ENSURE_INLINE
+		void operator() (const Rd& rd, index_t i0, index_t i1) const
+		{
+			_bin_count(i0, i1, U(), binner, rd, c);
+		}
+	};
+
+	template<class Sketch>
+	struct sketch_updater
+	{
+		Sketch& s;
+
+		template<class Rd>
+		LMAT_ENSURE_INLINE
+		void operator() (const Rd& rd, index_t i0, index_t i1) const
+		{
+			for (index_t i = i0; i < i1; ++i) s.update(rd.scalar(i));
+		}
+	};
+
+
+	/********************************************
+	 *
+	 *  block-wise visits
+	 *
+	 *  The elements [b0, b1) of a matrix (in
+	 *  column-major order) are visited as ranges
+	 *  of a vector reader, which is over the
+	 *  whole matrix if it supports linear access,
+	 *  or over each of its columns otherwise.
+	 *
+	 ********************************************/
+
+	template<typename U, class A, class Visitor>
+	inline void _visit_block(std::true_type, U, const A& a, index_t b0, index_t b1, const Visitor& vis)
+	{
+		vis(make_vec_accessor(U(), in_(a)), b0, b1);
+	}
+
+	template<typename U, class A, class Visitor>
+	inline void _visit_block(std::false_type, U, const A& a, index_t b0, index_t b1, const Visitor& vis)
+	{
+		auto rd = make_multicol_accessor(U(), in_(a));
+		const index_t m = a.nrows();
+
+		index_t j = b0 / m;
+		index_t i = b0 - j * m;
+
+		for (index_t k = b0; k < b1; ++j)
+		{
+			const index_t ie = b1 - k < m - i ? i + (b1 - k) : m;
+			vis(rd.col(j), i, ie);
+			k += ie - i;
+			i = 0;
+		}
+	}
+
+	template<typename U, class A, class Visitor>
+	LMAT_ENSURE_INLINE
+	inline void visit_block(U, const A& a, index_t b0, index_t b1, const Visitor& vis)
+	{
+		typedef std::integral_constant<bool, supports_linear_access<A>::value> linear_t;
+		_visit_block(linear_t(), U(), a, b0, b1, vis);
+	}
+
+	// the number of blocks for a parallel visit of len elements
+
+	inline index_t num_visit_blocks(const par_ *p, index_t len)
+	{
+		if (!p) return 1;
+		const index_t grain = p->grain > 0 ? p->grain : LMAT_PAR_MIN_TASK_ELEMS;
+		return exec::internal::num_par_blocks(len, grain, exec::current_executor().concurrency());
+	}
+
+
+	/********************************************
+	 *
+	 *  histogram implementation
+	 *
+	 *  In parallel, each block counts into its
+	 *  own sub-histogram, so the counts are never
+	 *  written by different threads. They are
+	 *  summed up at the end.
+	 *
+	 ********************************************/
+
+	template<class Binner, typename T, class A, class D, typename TD>
+	inline void bin_count_impl(const par_ *p, const Binner& binner,
+			const IEWiseMatrix<A, T>& a, IRegularMatrix<D, TD>& counts)
+	{
+		const index_t nb = binner.nb;
+		LMAT_CHECK_DIMS( counts.nelems() == nb )
+
+		typedef typename binning_unit<Binner, A>::type U;
+		LMAT_INSTRUMENT_PATH("histogram", use_simd(macc_<linear_, U>()))
+
+		const A& a_ = a.derived();
+		const index_t len = a.nelems();
+		const index_t nblk = num_visit_blocks(p, len);
+
+		// one more slot for the values outside of all bins
+		dense_matrix<index_t> sub(nb + 1, nblk, lmat::zero());
+
+		if (nblk == 1)
+		{
+			bin_counter<Binner, U> cnt = { binner, sub.ptr_data() };
+			visit_block(U(), a_, 0, len, cnt);
+		}
+		else
+		{
+			exec::parallel_for(range(0, nblk), 1, [&](const range& r)
+			{
+				for (index_t k = r.begin_index(); k < r.end_index(); ++k)
+				{
+					bin_counter<Binner, U> cnt = { binner, sub.ptr_col(k) };
+					visit_block(U(), a_,
+							exec::internal::par_block_begin(len, nblk, k),
+							exec::internal::par_block_begin(len, nblk, k + 1), cnt);
+				}
+			});
+		}
+
+		D& d_ = counts.derived();
+		for (index_t i = 0; i < nb; ++i)
+		{
+			index_t s = sub(i, 0);
+			for (index_t k = 1; k < nblk; ++k) s += sub(i, k);
+			d_[i] = static_cast<TD>(s);
+		}
+	}
+
+} }
+
+#endif
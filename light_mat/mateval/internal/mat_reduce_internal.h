@@ -17,6 +17,7 @@
 #include <light_mat/mateval/common_kernels.h>
 #include <light_mat/math/math_functors.h>
 #include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/common/exec.h>
 
 namespace lmat { namespace internal {
 
@@ -228,8 +229,37 @@ namespace lmat { namespace internal {
 		}
 	}
 
+	// each block of columns has its own getter, as the accessors of
+	// an expression may keep per-evaluation state
+
+	template<index_t CM, index_t CN, class FoldKernel, typename T, class DMat, class TExpr>
+	inline void colwise_fold_impl(const par_& p, const matrix_shape<CM, CN>& shape,
+			const FoldKernel& kernel, IRegularMatrix<DMat, T>& dmat, const IEWiseMatrix<TExpr, T>& texpr)
+	{
+		const index_t n = shape.ncolumns();
+		LMAT_CHECK_DIMS( n == dmat.nelems() )
+
+		DMat& d_ = dmat.derived();
+
+		exec::parallel_for(range(0, n), p.col_grain(shape.nrows()), [&](const range& cols)
+		{
+			auto g = make_colwise_fold_getter(kernel, shape, texpr);
+
+			for (index_t j = cols.begin_index(); j < cols.end_index(); ++j)
+			{
+				d_[j] = g[j];
+			}
+		});
+	}
+
 	// row wise reduction
 
+	template<typename T>
+	struct rowwise_block_len
+	{
+		static const index_t value = (index_t)(LMAT_ROWWISE_BLOCK_BYTES / sizeof(T));
+	};
+
 	template<index_t CM, index_t CN, class FoldKernel, typename T, class DMat, class TExpr>
 	inline void rowwise_fold_impl(const matrix_shape<CM, CN>& shape,
 			const FoldKernel& kernel, IRegularMatrix<DMat, T>& dmat, const IEWiseMatrix<TExpr, T>& texpr)
@@ -247,11 +277,34 @@ namespace lmat { namespace internal {
 		auto a = make_vec_accessor(U(), in_out_(dmat));
 		auto rd = make_multicol_accessor(U(), in_(texpr));
 
-		internal::_linear_ewise_eval(col_dim, U(), copy_kernel<T>(), rd.col(0), a);
+		const index_t m = col_dim.value();
+		const index_t blen = rowwise_block_len<T>::value;
 
-		for (index_t j = 1; j < n; ++j)
+		if (m <= blen || n == 1)
 		{
-			internal::_linear_ewise_eval(col_dim, U(), kernel, a, rd.col(j));
+			internal::_linear_ewise_eval(col_dim, U(), copy_kernel<T>(), rd.col(0), a);
+
+			for (index_t j = 1; j < n; ++j)
+			{
+				internal::_linear_ewise_eval(col_dim, U(), kernel, a, rd.col(j));
+			}
+		}
+		else
+		{
+			// tall matrix: go through all columns strip by strip,
+			// such that each strip of dmat is kept in cache
+
+			for (index_t i0 = 0; i0 < m; i0 += blen)
+			{
+				const index_t i1 = i0 + blen < m ? i0 + blen : m;
+
+				internal::_ranged_ewise_eval(i0, i1, U(), copy_kernel<T>(), rd.col(0), a);
+
+				for (index_t j = 1; j < n; ++j)
+				{
+					internal::_ranged_ewise_eval(i0, i1, U(), kernel, a, rd.col(j));
+				}
+			}
 		}
 	}
 
@@ -0,0 +1,495 @@
+/**
+ * @file mat_scan_internal.h
+ *
+ * Internal implementation of matrix scans
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MAT_SCAN_INTERNAL_H_
+#define LIGHTMAT_MAT_SCAN_INTERNAL_H_
+
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/simd/simd_scan.h>
+#include <light_mat/common/exec.h>
+#include "mat_reduce_internal.h"
+
+namespace lmat { namespace internal {
+
+	/********************************************
+	 *
+	 *  access unit
+	 *
+	 ********************************************/
+
+	template<class Kernel, class Arg, class DMat>
+	struct scan_unit
+	{
+		typedef typename matrix_traits<Arg>::value_type T;
+
+		static const bool use_simd =
+				is_simdizable<Kernel, default_simd_kind>::value &&
+				simd_prefix_scanner<T, default_simd_kind>::available &&
+				supports_simd<Arg, default_simd_kind>::value &&
+				supports_simd<DMat, default_simd_kind>::value &&
+				kernel_strided_simd_pays<Kernel, Arg, DMat>::value;
+
+		typedef typename std::conditional<use_simd,
+				simd_<default_simd_kind>,
+				scalar_>::type type;
+	};
+
+
+	/********************************************
+	 *
+	 *  scans over a range of a vector
+	 *
+	 *  c holds the accumulated value before i0
+	 *  on entry, and that at i1 - 1 on exit
+	 *
+	 ********************************************/
+
+	template<class Kernel, class Rd, class Wt, typename T>
+	inline void _scan_range(index_t i0, index_t i1, scalar_,
+			const Kernel& kernel, const Rd& rd, const Wt& wt, T& c)
+	{
+		for (index_t i = i0; i < i1; ++i)
+		{
+			kernel(c, rd.scalar(i));
+			wt.scalar(i) = c;
+			wt.done_scalar(i);
+		}
+	}
+
+	// each pack is scanned within the registers, and then combined
+	// with the carry broadcasted from the last element of its predecessor
+
+	template<class Kernel, class Rd, class Wt, typename T, typename Kind>
+	inline void _scan_range(index_t i0, index_t i1, simd_<Kind>,
+			const Kernel& kernel, const Rd& rd, const Wt& wt, T& c)
+	{
+		typedef simd_pack<T, Kind> pack_t;
+		typedef simdize_map<Kernel, Kind> smap;
+		const unsigned int W = simd_traits<T, Kind>::pack_width;
+
+		index_t i = i0;
+		if (i1 - i0 >= (index_t)W)
+		{
+			typename smap::type pkernel = smap::get(kernel);
+			const pack_t e = pkernel.identity();
+			pack_t cp(c);
+
+			for (; i + (index_t)W <= i1; i += W)
+			{
+				pack_t x = simd_prefix_scanner<T, Kind>::run(rd.pack(i), e, pkernel);
+				pkernel(x, cp);
+				wt.pack(i) = x;
+				wt.done_pack(i);
+				cp = x.broadcast(pos_<W-1>());
+			}
+
+			c = cp.to_scalar();
+		}
+
+		_scan_range(i, i1, scalar_(), kernel, rd, wt, c);
+	}
+
+	template<class Kernel, class Rd, typename T>
+	inline void _scan_fold_range(index_t i0, index_t i1, scalar_,
+			const Kernel& kernel, const Rd& rd, T& c)
+	{
+		for (index_t i = i0; i < i1; ++i)
+		{
+			kernel(c, rd.scalar(i));
+		}
+	}
+
+	template<class Kernel, class Rd, typename T, typename Kind>
+	inline void _scan_fold_range(index_t i0, index_t i1, simd_<Kind>,
+			const Kernel& kernel, const Rd& rd, T& c)
+	{
+		typedef simd_pack<T, Kind> pack_t;
+		typedef simdize_map<Kernel, Kind> smap;
+		const unsigned int W = simd_traits<T, Kind>::pack_width;
+
+		index_t i = i0;
+		if (i1 - i0 >= (index_t)W)
+		{
+			typename smap::type pkernel = smap::get(kernel);
+			const pack_t e = pkernel.identity();
+			pack_t a = e;
+
+			for (; i + (index_t)W <= i1; i += W)
+			{
+				pkernel(a, rd.pack(i));
+			}
+
+			// the last element of the scanned accumulator is its total
+			a = simd_prefix_scanner<T, Kind>::run(a, e, pkernel);
+			kernel(c, a.extract(pos_<W-1>()));
+		}
+
+		_scan_fold_range(i, i1, scalar_(), kernel, rd, c);
+	}
+
+
+	/********************************************
+	 *
+	 *  linear scans
+	 *
+	 *  A block is the range [b0, b1) of the
+	 *  elements in column-major order, which
+	 *  may span several columns. If first is
+	 *  set, the scan starts afresh at b0,
+	 *  otherwise it continues from c.
+	 *
+	 ********************************************/
+
+	template<typename U, class Kernel, class MRd, class MWt, typename T>
+	inline void _linear_scan_block(index_t m, index_t b0, index_t b1, U,
+			const Kernel& kernel, const MRd& rd, const MWt& wt, T& c, bool first)
+	{
+		index_t j = b0 / m;
+		index_t i = b0 - j * m;
+
+		for (index_t k = b0; k < b1; ++j)
+		{
+			const index_t ie = b1 - k < m - i ? i + (b1 - k) : m;
+			auto rdj = rd.col(j);
+			auto wtj = wt.col(j);
+
+			index_t s = i;
+			if (first)
+			{
+				c = rdj.scalar(s);
+				wtj.scalar(s) = c;
+				wtj.done_scalar(s);
+				++s;
+				first = false;
+			}
+			_scan_range(s, ie, U(), kernel, rdj, wtj, c);
+
+			k += ie - i;
+			i = 0;
+		}
+	}
+
+	template<typename U, class Kernel, class MRd, typename T>
+	inline void _linear_scan_fold_block(index_t m, index_t b0, index_t b1, U,
+			const Kernel& kernel, const MRd& rd, T& c)
+	{
+		index_t j = b0 / m;
+		index_t i = b0 - j * m;
+		bool first = true;
+
+		for (index_t k = b0; k < b1; ++j)
+		{
+			const index_t ie = b1 - k < m - i ? i + (b1 - k) : m;
+			auto rdj = rd.col(j);
+
+			index_t s = i;
+			if (first)
+			{
+				c = rdj.scalar(s++);
+				first = false;
+			}
+			_scan_fold_range(s, ie, U(), kernel, rdj, c);
+
+			k += ie - i;
+			i = 0;
+		}
+	}
+
+
+	// the accessors are made for each block, as those of an expression
+	// may keep per-evaluation state
+
+	template<typename U, class Kernel, class GetRd, class GetWt>
+	inline void _linear_scan(const par_ *p, index_t m, index_t N, U,
+			const Kernel& kernel, const GetRd& get_rd, const GetWt& get_wt)
+	{
+		typedef typename Kernel::value_type T;
+
+		if (p)
+		{
+			const index_t grain = p->grain > 0 ? p->grain : LMAT_PAR_MIN_TASK_ELEMS;
+			const index_t nb = exec::internal::num_par_blocks(N, grain,
+					exec::current_executor().concurrency());
+
+			if (nb > 1)
+			{
+				// pass 1: the total of each block (except the last one),
+				// turned into the carry into the next block
+
+				dense_col<T> carries(nb - 1);
+
+				exec::parallel_for(range(0, nb - 1), 1, [&](const range& r)
+				{
+					auto rd = get_rd();
+					for (index_t k = r.begin_index(); k < r.end_index(); ++k)
+					{
+						_linear_scan_fold_block(m,
+								exec::internal::par_block_begin(N, nb, k),
+								exec::internal::par_block_begin(N, nb, k + 1),
+								U(), kernel, rd, carries[k]);
+					}
+				});
+
+				for (index_t k = 1; k < nb - 1; ++k)
+				{
+					kernel(carries[k], carries[k-1]);
+				}
+
+				// pass 2: each block scanned from its carry
+
+				exec::parallel_for(range(0, nb), 1, [&](const range& r)
+				{
+					auto rd = get_rd();
+					auto wt = get_wt();
+					for (index_t k = r.begin_index(); k < r.end_index(); ++k)
+					{
+						T c = k > 0 ? carries[k-1] : T();
+						_linear_scan_block(m,
+								exec::internal::par_block_begin(N, nb, k),
+								exec::internal::par_block_begin(N, nb, k + 1),
+								U(), kernel, rd, wt, c, k == 0);
+					}
+				});
+
+				return;
+			}
+		}
+
+		T c;
+		_linear_scan_block(m, 0, N, U(), kernel, get_rd(), get_wt(), c, true);
+	}
+
+	// continuous operands are scanned as a single column
+
+	template<class Kernel, typename T, class Arg, class DMat>
+	inline typename std::enable_if<
+		supports_linear_access<Arg>::value && supports_linear_access<DMat>::value,
+	void>::type
+	linear_scan_impl(const par_ *p, const Kernel& kernel,
+			const IEWiseMatrix<Arg, T>& a, IRegularMatrix<DMat, T>& dmat)
+	{
+		LMAT_CHECK_DIMS( a.nrows() == dmat.nrows() && a.ncolumns() == dmat.ncolumns() )
+
+		const index_t N = a.nelems();
+		if (N == 0) return;
+
+		typedef typename scan_unit<Kernel, Arg, DMat>::type U;
+		LMAT_INSTRUMENT_PATH("scan.linear", use_simd(macc_<linear_, U>()))
+
+		const Arg& a_ = a.derived();
+		DMat& d_ = dmat.derived();
+
+		_linear_scan(p, N, N, U(), kernel,
+				[&]() { return as_single_col(make_vec_accessor(U(), in_(a_))); },
+				[&]() { return as_single_col(make_vec_accessor(U(), out_(d_))); });
+	}
+
+	template<class Kernel, typename T, class Arg, class DMat>
+	inline typename std::enable_if<
+		!(supports_linear_access<Arg>::value && supports_linear_access<DMat>::value),
+	void>::type
+	linear_scan_impl(const par_ *p, const Kernel& kernel,
+			const IEWiseMatrix<Arg, T>& a, IRegularMatrix<DMat, T>& dmat)
+	{
+		LMAT_CHECK_DIMS( a.nrows() == dmat.nrows() && a.ncolumns() == dmat.ncolumns() )
+
+		const index_t N = a.nelems();
+		if (N == 0) return;
+
+		typedef typename scan_unit<Kernel, Arg, DMat>::type U;
+		LMAT_INSTRUMENT_PATH("scan.percol", use_simd(macc_<percol_, U>()))
+
+		const Arg& a_ = a.derived();
+		DMat& d_ = dmat.derived();
+
+		_linear_scan(p, a.nrows(), N, U(), kernel,
+				[&]() { return make_multicol_accessor(U(), in_(a_)); },
+				[&]() { return make_multicol_accessor(U(), out_(d_)); });
+	}
+
+
+	/********************************************
+	 *
+	 *  column-wise scans
+	 *
+	 ********************************************/
+
+	template<typename U, class Kernel, class MRd, class MWt>
+	inline void _colwise_scan_cols(index_t m, index_t j0, index_t j1, U,
+			const Kernel& kernel, const MRd& rd, const MWt& wt)
+	{
+		for (index_t j = j0; j < j1; ++j)
+		{
+			typename Kernel::value_type c;
+			_linear_scan_block(m, j * m, (j + 1) * m, U(), kernel, rd, wt, c, true);
+		}
+	}
+
+	template<class Kernel, typename T, class Arg, class DMat>
+	inline void colwise_scan_impl(const par_ *p, const Kernel& kernel,
+			const IEWiseMatrix<Arg, T>& a, IRegularMatrix<DMat, T>& dmat)
+	{
+		LMAT_CHECK_DIMS( a.nrows() == dmat.nrows() && a.ncolumns() == dmat.ncolumns() )
+
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+		if (m == 0 || n == 0) return;
+
+		// a single column is scanned as a whole, in parallel if asked for
+		if (n == 1)
+		{
+			linear_scan_impl(p, kernel, a, dmat);
+			return;
+		}
+
+		typedef typename scan_unit<Kernel, Arg, DMat>::type U;
+		LMAT_INSTRUMENT_PATH("scan.colwise", use_simd(macc_<percol_, U>()))
+
+		const Arg& a_ = a.derived();
+		DMat& d_ = dmat.derived();
+
+		if (p)
+		{
+			exec::parallel_for(range(0, n), p->col_grain(m), [&](const range& cols)
+			{
+				_colwise_scan_cols(m, cols.begin_index(), cols.end_index(), U(), kernel,
+						make_multicol_accessor(U(), in_(a_)),
+						make_multicol_accessor(U(), out_(d_)));
+			});
+		}
+		else
+		{
+			_colwise_scan_cols(m, 0, n, U(), kernel,
+					make_multicol_accessor(U(), in_(a_)),
+					make_multicol_accessor(U(), out_(d_)));
+		}
+	}
+
+
+	/********************************************
+	 *
+	 *  row-wise scans
+	 *
+	 *  Each column of the result is combined
+	 *  from its predecessor, element-wise, so
+	 *  no shuffles are needed. Tall matrices
+	 *  are processed strip by strip, such that
+	 *  the preceding column is still in cache.
+	 *
+	 ********************************************/
+
+	template<class Kernel, class PRd, class Rd, class Wt>
+	inline void _rowwise_scan_step(index_t i0, index_t i1, scalar_,
+			const Kernel& kernel, const PRd& prev, const Rd& rd, const Wt& wt)
+	{
+		for (index_t i = i0; i < i1; ++i)
+		{
+			auto c = prev.scalar(i);
+			kernel(c, rd.scalar(i));
+			wt.scalar(i) = c;
+			wt.done_scalar(i);
+		}
+	}
+
+	template<class Kernel, class PRd, class Rd, class Wt, typename Kind>
+	inline void _rowwise_scan_step(index_t i0, index_t i1, simd_<Kind>,
+			const Kernel& kernel, const PRd& prev, const Rd& rd, const Wt& wt)
+	{
+		typedef typename Kernel::value_type T;
+		typedef simdize_map<Kernel, Kind> smap;
+		const index_t W = (index_t)simd_traits<T, Kind>::pack_width;
+
+		typename smap::type pkernel = smap::get(kernel);
+
+		index_t i = i0;
+		for (; i + W <= i1; i += W)
+		{
+			simd_pack<T, Kind> c = prev.pack(i);
+			pkernel(c, rd.pack(i));
+			wt.pack(i) = c;
+			wt.done_pack(i);
+		}
+
+		_rowwise_scan_step(i, i1, scalar_(), kernel, prev, rd, wt);
+	}
+
+	template<typename U, class Kernel, class MRd, class MPRd, class MWt>
+	inline void _rowwise_scan_rows(index_t i0, index_t i1, index_t n, U,
+			const Kernel& kernel, const MRd& rd, const MPRd& prev, const MWt& wt)
+	{
+		typedef typename Kernel::value_type T;
+		const index_t blen = rowwise_block_len<T>::value;
+
+		for (index_t s0 = i0; s0 < i1; s0 += blen)
+		{
+			const index_t s1 = s0 + blen < i1 ? s0 + blen : i1;
+
+			_ranged_ewise_eval(s0, s1, U(), copy_kernel<T>(), rd.col(0), wt.col(0));
+
+			for (index_t j = 1; j < n; ++j)
+			{
+				_rowwise_scan_step(s0, s1, U(), kernel, prev.col(j-1), rd.col(j), wt.col(j));
+			}
+		}
+	}
+
+	template<class Kernel, typename T, class Arg, class DMat>
+	inline void rowwise_scan_impl(const par_ *p, const Kernel& kernel,
+			const IEWiseMatrix<Arg, T>& a, IRegularMatrix<DMat, T>& dmat)
+	{
+		LMAT_CHECK_DIMS( a.nrows() == dmat.nrows() && a.ncolumns() == dmat.ncolumns() )
+
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+		if (m == 0 || n == 0) return;
+
+		// a single row is scanned as a whole, in parallel if asked for
+		if (m == 1)
+		{
+			linear_scan_impl(p, kernel, a, dmat);
+			return;
+		}
+
+		typedef typename std::conditional<
+				is_simdizable<Kernel, default_simd_kind>::value &&
+				supports_simd<Arg, default_simd_kind>::value &&
+				supports_simd<DMat, default_simd_kind>::value &&
+				kernel_strided_simd_pays<Kernel, Arg, DMat>::value,
+				simd_<default_simd_kind>,
+				scalar_>::type U;
+		LMAT_INSTRUMENT_PATH("scan.rowwise", use_simd(macc_<percol_, U>()))
+
+		const Arg& a_ = a.derived();
+		DMat& d_ = dmat.derived();
+
+		if (p)
+		{
+			exec::parallel_for(range(0, m), p->col_grain(n), [&](const range& rows)
+			{
+				_rowwise_scan_rows(rows.begin_index(), rows.end_index(), n, U(), kernel,
+						make_multicol_accessor(U(), in_(a_)),
+						make_multicol_accessor(U(), in_(d_)),
+						make_multicol_accessor(U(), out_(d_)));
+			});
+		}
+		else
+		{
+			_rowwise_scan_rows(0, m, n, U(), kernel,
+					make_multicol_accessor(U(), in_(a_)),
+					make_multicol_accessor(U(), in_(d_)),
+					make_multicol_accessor(U(), out_(d_)));
+		}
+	}
+
+} }
+
+#endif
@@ -15,6 +15,29 @@
 
 #include <light_mat/mateval/mateval_fwd.h>
 #include <light_mat/matrix/matrix_concepts.h>
+#include <light_mat/simd/simd_dispatch.h>
+
+// Vectors whose length is known at compile-time and does not exceed
+// LMAT_UNROLL_MAX_LEN elements are evaluated (and folded) as fully
+// unrolled sequences of packs, without a loop. Define it as 0 to
+// disable unrolling.
+
+#ifndef LMAT_UNROLL_MAX_LEN
+#define LMAT_UNROLL_MAX_LEN 32
+#endif
+
+// Work per element (in units of fun_cost) that an evaluation has to do
+// for each operand accessed with strided packs, in order to be evaluated
+// with SIMD (see strided_simd_pays below). Strided packs are assembled
+// element by element, or gathered with AVX2, which is a bit cheaper.
+
+#ifndef LMAT_STRIDED_SIMD_COST
+#ifdef LMAT_HAS_AVX2
+#define LMAT_STRIDED_SIMD_COST 1
+#else
+#define LMAT_STRIDED_SIMD_COST 2
+#endif
+#endif
 
 namespace lmat
 {
@@ -119,16 +142,33 @@ namespace lmat
 		template<typename Mat, bool IsRegular, typename Kind>
 		struct _matrix_supports_simd : public meta::false_ { };
 
+		// Contiguous columns are accessed with plain pack loads, while
+		// strided vectors, rows, and grids are accessed with strided
+		// (gathered) pack loads & stores. The latter is slower per pack
+		// than the former, and only pays off when there is enough work
+		// to be done on each pack (see strided_simd_pays).
+
 		template<typename Mat, typename Kind>
 		struct _matrix_supports_simd<Mat, true, Kind>
 		{
 			typedef typename meta::value_type_of<Mat>::type VT;
 
-			static const bool _bt = supports_simd<VT, Kind>::value;
+			static const bool value = supports_simd<VT, Kind>::value;
+		};
+
+		template<typename Mat, bool IsRegular>
+		struct _matrix_strided_operands
+		{
+			static const int value = 0;
+		};
+
+		template<typename Mat>
+		struct _matrix_strided_operands<Mat, true>
+		{
 			static const bool _bs = meta::is_contiguous<Mat>::value ||
 					(meta::is_percol_contiguous<Mat>::value && !meta::is_row<Mat>::value);
 
-			static const bool value = _bt && _bs;
+			static const int value = _bs ? 0 : 1;
 		};
 	}
 
@@ -153,6 +193,75 @@ namespace lmat
 	: public supports_simd<A, Kind> { };
 
 
+	/********************************************
+	 *
+	 *  SIMD cost model
+	 *
+	 ********************************************/
+
+	// the number of operands in A that are accessed with strided packs
+
+	template<typename A>
+	struct simd_strided_operands
+	: public internal::_matrix_strided_operands<A, meta::is_regular_mat<A>::value> { };
+
+	template<typename A, typename ATag>
+	struct simd_strided_operands<arg_wrap<A, ATag> >
+	: public simd_strided_operands<A> { };
+
+	// the work (in units of fun_cost) to compute an element of A,
+	// which is zero for a matrix in memory
+
+	template<typename A>
+	struct simd_work_cost
+	{
+		static const int value = 0;
+	};
+
+	template<typename A, typename ATag>
+	struct simd_work_cost<arg_wrap<A, ATag> >
+	: public simd_work_cost<A> { };
+
+	namespace internal
+	{
+		template<typename... Args> struct _strided_sum;
+
+		template<>
+		struct _strided_sum<>
+		{
+			static const int operands = 0;
+			static const int work = 0;
+		};
+
+		template<typename A, typename... R>
+		struct _strided_sum<A, R...>
+		{
+			static const int operands =
+					simd_strided_operands<A>::value + _strided_sum<R...>::operands;
+			static const int work =
+					simd_work_cost<A>::value + _strided_sum<R...>::work;
+		};
+
+		// Whether an evaluation doing a work of KCost per element, besides
+		// computing its arguments, pays for the strided packs of its
+		// operands, e.g. exp(row) does, while copying a row, or adding up
+		// rows does not, and is better done with scalars.
+
+		template<int KCost, typename... Args>
+		struct strided_simd_pays
+		{
+			typedef _strided_sum<Args...> s;
+
+			static const bool value = s::operands == 0 ||
+					KCost + s::work >= LMAT_STRIDED_SIMD_COST * s::operands;
+		};
+
+		template<class Kernel, typename... Args>
+		struct kernel_strided_simd_pays
+		: public strided_simd_pays<kernel_cost<Kernel>::value, Args...> { };
+	}
+
+
 	/********************************************
 	 *
 	 *  preferred policy
@@ -185,7 +294,8 @@ namespace lmat
 			static const bool ker_simdizable = is_simdizable<Kernel, skind>::value;
 
 			static const bool args_supp_simd =
-					meta::all_<supports_simd<Args, skind>...>::value;
+					meta::all_<supports_simd<Args, skind>...>::value &&
+					kernel_strided_simd_pays<Kernel, Args...>::value;
 
 			static const bool use_linear = supp_linear;
 
@@ -195,15 +305,104 @@ namespace lmat
 			static const unsigned int pack_width =
 					internal::_kernel_packwidth<Kernel, skind, ker_simdizable>::value;
 
+			// a length that is not a multiple of the pack width leaves a
+			// tail, evaluated as a masked partial pack when supported by
+			// the accessors; this does not pay off for a static length
+			// shorter than a pack
+
 			static const bool use_simd =
 					ker_simdizable &&
 					args_supp_simd &&
-					((unsigned int)len % pack_width == 0);
+					((unsigned int)len % pack_width == 0 || (unsigned int)len > pack_width);
+		};
+
+		// whether a vector of static length Len is to be unrolled
+
+		template<index_t Len>
+		struct unroll_static_len
+		{
+			static const bool value = Len > 0 && Len <= LMAT_UNROLL_MAX_LEN;
+			typedef meta::bool_<value> type;
+		};
+
+		// whether an evaluation planned with SSE packs may be carried
+		// out with AVX packs instead, when dispatched at run-time
+
+		template<index_t Len, class Kernel, typename... Args>
+		struct avx_dispatchable
+		{
+#ifdef LMAT_DISPATCH_AVX
+			static const bool ker_simdizable = is_simdizable<Kernel, avx_t>::value;
+
+			static const unsigned int pack_width =
+					_kernel_packwidth<Kernel, avx_t, ker_simdizable>::value;
+
+			static const bool value =
+					ker_simdizable &&
+					meta::all_<supports_simd<Args, avx_t>...>::value &&
+					kernel_strided_simd_pays<Kernel, Args...>::value &&
+					((unsigned int)Len % pack_width == 0 || (unsigned int)Len > pack_width);
+#else
+			static const bool value = false;
+#endif
+			typedef meta::bool_<value> type;
 		};
 	}
 
 
 
+	/********************************************
+	 *
+	 *  pack alignment
+	 *
+	 ********************************************/
+
+	// A linear SIMD evaluation whose operands are all contiguous accesses
+	// the packs with aligned loads & stores when the operands start at the
+	// same offset from a pack boundary, either directly (aligned_packs),
+	// or after peeling off the leading elements up to the next boundary
+	// with scalars (peeled_packs). Otherwise, or when the vector is too
+	// short for peeling to pay off, it accesses them with unaligned loads
+	// & stores (unaligned_packs). The variant depends on the addresses,
+	// and is hence chosen at run-time; with instrumentation, the first two
+	// are counted as variant_ under "ewise.aligned" and "ewise.peeled".
+
+	enum pack_align_variant
+	{
+		unaligned_packs,
+		aligned_packs,
+		peeled_packs
+	};
+
+	template<typename T, typename Kind>
+	struct pack_align_policy
+	{
+		static const index_t pack_width = static_cast<index_t>(simd_traits<T, Kind>::pack_width);
+		static const index_t pack_bytes = pack_width * static_cast<index_t>(sizeof(T));
+
+		// the number of leading elements to peel off, given the offset
+		// (in bytes) of the operands from the preceding pack boundary
+
+		LMAT_ENSURE_INLINE
+		static index_t npeel(index_t offset)
+		{
+			return offset > 0 ? (pack_bytes - offset) / static_cast<index_t>(sizeof(T)) : 0;
+		}
+
+		LMAT_ENSURE_INLINE
+		static pack_align_variant choose(index_t offset, index_t len)
+		{
+			if (offset == 0 || offset == internal::any_pack_offset)
+				return aligned_packs;
+			else if (offset > 0 && offset % static_cast<index_t>(sizeof(T)) == 0 &&
+					len >= npeel(offset) + 2 * pack_width)
+				return peeled_packs;
+			else
+				return unaligned_packs;
+		}
+	};
+
+
 	template<class Shape, class Kernel, typename... Args>
 	struct preferred_macc_policy
 	{
@@ -0,0 +1,478 @@
+/**
+ * @file mat_accsum.h
+ *
+ * @brief Accurate and reproducible summation
+ *
+ * The plain sum reduction accumulates with several SIMD
+ * accumulators, whose result depends on the pack width and
+ * whose error grows linearly with the length. This file
+ * provides alternative summation modes:
+ *
+ * - sumacc::compensated_ (aka accurate_):  Neumaier's compensated
+ *   summation (SIMD). The error is independent of the length.
+ *
+ * - sumacc::pairwise_: cascaded pairwise summation, i.e. blocks
+ *   are summed with SIMD accumulators and the block sums are
+ *   combined along a binary tree. The error grows as O(log n).
+ *
+ * - sumacc::reproducible_: the association of additions is fixed
+ *   regardless of the SIMD kind (or the absence of SIMD) and of the
+ *   memory layout: the elements, in column-major order, are processed
+ *   in fixed-size blocks combined pairwise. Hence the result depends
+ *   only on the values, and is bitwise identical across builds, for
+ *   a matrix and a strided view of the same values, and with
+ *   sum(par_(), a, sumacc::reproducible_()), which sums the blocks
+ *   in parallel.
+ *
+ * Note: none of these survives value-unsafe optimization of floating
+ * point arithmetic (e.g. -ffast-math).
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MAT_ACCSUM_H_
+#define LIGHTMAT_MAT_ACCSUM_H_
+
+#include <light_mat/mateval/mat_reduce.h>
+
+// block length of cascaded pairwise summation
+#ifndef LMAT_PAIRWISE_SUM_BLOCK
+#define LMAT_PAIRWISE_SUM_BLOCK 256
+#endif
+
+// block length of reproducible summation (part of the result's definition)
+#ifndef LMAT_REPRO_SUM_BLOCK
+#define LMAT_REPRO_SUM_BLOCK 1024
+#endif
+
+namespace lmat
+{
+
+	namespace sumacc
+	{
+		struct compensated_ { };
+		struct pairwise_ { };
+		struct reproducible_ { };
+
+		typedef compensated_ accurate_;
+	}
+
+
+	/********************************************
+	 *
+	 *  compensated sum statistics
+	 *
+	 ********************************************/
+
+	template<typename T>
+	struct csum_stat
+	{
+		T sum;
+		T comp;
+
+		csum_stat() { }
+
+		csum_stat(const T& x)
+		: sum(x), comp(internal::zero_of(x)) { }
+
+		void update(const T& x)
+		{
+			T t = sum + x;
+			comp += math::cond(math::abs(sum) >= math::abs(x), (sum - t) + x, (x - t) + sum);
+			sum = t;
+		}
+
+		void update(const csum_stat& s)
+		{
+			update(s.sum);
+			comp += s.comp;
+		}
+
+		T value() const
+		{
+			return sum + comp;
+		}
+	};
+
+	template<typename T, typename Kind>
+	inline csum_stat<T> reduce_impl(const csum_stat<simd_pack<T, Kind> >& s)
+	{
+		const unsigned int W = simd_traits<T, Kind>::pack_width;
+
+		csum_stat<T> r(s.sum[0]);
+		r.comp = s.comp[0];
+		for (unsigned int k = 1; k < W; ++k)
+		{
+			r.update(s.sum[k]);
+			r.comp += s.comp[k];
+		}
+		return r;
+	}
+
+	LMAT_DEFINE_AGGREG_SIMD_FOLDKERNEL(csum_stat, csum_kernel, 1)
+
+	LMAT_DEF_SIMD_SUPPORT( csum_kernel )
+
+
+	/********************************************
+	 *
+	 *  pairwise & reproducible summation
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		// cascade of partial sums, combined like a binary counter
+
+		template<typename T>
+		class sum_cascade
+		{
+		public:
+			sum_cascade() : m_n(0), m_cnt(0) { }
+
+			void push(T s)
+			{
+				index_t c = ++m_cnt;
+				while (!(c & 1))
+				{
+					s = m_parts[--m_n] + s;
+					c >>= 1;
+				}
+				m_parts[m_n++] = s;
+			}
+
+			T result() const
+			{
+				if (m_n == 0) return T(0);
+
+				T r = m_parts[m_n - 1];
+				for (int k = m_n - 2; k >= 0; --k) r = m_parts[k] + r;
+				return r;
+			}
+
+		private:
+			T m_parts[64];
+			int m_n;
+			index_t m_cnt;
+		};
+
+
+		// pairwise: block sums with two accumulators
+
+		template<typename T, class Reader>
+		inline T _accsum_block(index_t i0, index_t i1, scalar_, const Reader& rd)
+		{
+			T r = rd.scalar(i0);
+			for (index_t i = i0 + 1; i < i1; ++i) r += rd.scalar(i);
+			return r;
+		}
+
+		template<typename T, typename SKind, class Reader>
+		inline T _accsum_block(index_t i0, index_t i1, simd_<SKind>, const Reader& rd)
+		{
+			typedef simd_pack<T, SKind> pack_t;
+			const index_t W = (index_t)pack_t::pack_width;
+
+			index_t i = i0;
+			T r(0);
+
+			if (i1 - i0 >= W)
+			{
+				pass(rd.begin_packs());
+
+				pack_t a0 = pack_t::zeros();
+				pack_t a1 = pack_t::zeros();
+
+				for (; i + 2 * W <= i1; i += 2 * W)
+				{
+					a0 += rd.pack(i);
+					a1 += rd.pack(i + W);
+				}
+
+				if (i + W <= i1)
+				{
+					a0 += rd.pack(i);
+					i += W;
+				}
+
+				pass(rd.end_packs());
+				r = sum(a0 + a1);
+			}
+
+			for (; i < i1; ++i) r += rd.scalar(i);
+			return r;
+		}
+
+		template<typename T, typename U, class Reader>
+		inline void _accsum_push(sum_cascade<T>& c, index_t len, U, const Reader& rd)
+		{
+			const index_t B = LMAT_PAIRWISE_SUM_BLOCK;
+			for (index_t i0 = 0; i0 < len; i0 += B)
+			{
+				const index_t i1 = i0 + B < len ? i0 + B : len;
+				c.push(_accsum_block<T>(i0, i1, U(), rd));
+			}
+		}
+
+		template<typename T, typename U, class A>
+		inline T _accsum(macc_<linear_, U>, const IEWiseMatrix<A, T>& a, sumacc::pairwise_)
+		{
+			sum_cascade<T> c;
+			_accsum_push(c, a.nelems(), U(), make_vec_accessor(U(), in_(a)));
+			return c.result();
+		}
+
+		template<typename T, typename U, class A>
+		inline T _accsum(macc_<percol_, U>, const IEWiseMatrix<A, T>& a, sumacc::pairwise_)
+		{
+			auto rd = make_multicol_accessor(U(), in_(a));
+			const index_t m = a.nrows();
+			const index_t n = a.ncolumns();
+
+			sum_cascade<T> c;
+			for (index_t j = 0; j < n; ++j)
+			{
+				_accsum_push(c, m, U(), rd.col(j));
+			}
+			return c.result();
+		}
+
+
+		// reproducible: the elements are taken in column-major order,
+		// and cut into blocks of LMAT_REPRO_SUM_BLOCK elements, which
+		// may span columns. Within a block, 8 logical lanes are used,
+		// the k-th of which accumulates the elements at offsets k,
+		// k + 8, ... in order. A pack of width W covers W consecutive
+		// lanes, so the association depends on neither W nor the
+		// layout, but only on the number of elements.
+
+		const index_t repro_nlanes = 8;
+
+		template<typename T>
+		LMAT_ENSURE_INLINE
+		inline T _repro_combine(const T *a)
+		{
+			return ((a[0] + a[4]) + (a[2] + a[6])) + ((a[1] + a[5]) + (a[3] + a[7]));
+		}
+
+		// adds [i0, i1) of a column to the lanes, starting at lane k
+
+		template<typename T, class Reader>
+		inline void _repro_range(T *a, index_t k, index_t i0, index_t i1, scalar_, const Reader& rd)
+		{
+			index_t i = i0;
+			if (k > 0)
+			{
+				for (; k < repro_nlanes && i < i1; ++i, ++k) a[k] += rd.scalar(i);
+			}
+
+			for (; i + repro_nlanes <= i1; i += repro_nlanes)
+			{
+				for (index_t l = 0; l < repro_nlanes; ++l) a[l] += rd.scalar(i + l);
+			}
+
+			for (index_t l = 0; i < i1; ++i, ++l) a[l] += rd.scalar(i);
+		}
+
+		template<typename T, typename SKind, class Reader>
+		inline void _repro_range(T *a, index_t k, index_t i0, index_t i1, simd_<SKind>, const Reader& rd)
+		{
+			typedef simd_pack<T, SKind> pack_t;
+			const index_t W = (index_t)pack_t::pack_width;
+			const index_t NP = repro_nlanes / W;
+
+			static_assert(repro_nlanes % simd_traits<T, SKind>::pack_width == 0,
+					"The pack width must divide the number of lanes.");
+
+			index_t i = i0;
+			if (k > 0)
+			{
+				for (; k < repro_nlanes && i < i1; ++i, ++k) a[k] += rd.scalar(i);
+			}
+
+			if (i + repro_nlanes <= i1)
+			{
+				pack_t pa[NP];
+				for (index_t p = 0; p < NP; ++p) pa[p].load_u(a + p * W);
+
+				pass(rd.begin_packs());
+				for (; i + repro_nlanes <= i1; i += repro_nlanes)
+				{
+					for (index_t p = 0; p < NP; ++p) pa[p] += rd.pack(i + p * W);
+				}
+				pass(rd.end_packs());
+
+				for (index_t p = 0; p < NP; ++p) pa[p].store_u(a + p * W);
+			}
+
+			for (index_t l = 0; i < i1; ++i, ++l) a[l] += rd.scalar(i);
+		}
+
+		// the sum of elements [b0, b1) in column-major order, over columns of length m
+
+		template<typename T, typename U, class MRd>
+		inline T _repro_block(index_t m, index_t b0, index_t b1, U, const MRd& rd)
+		{
+			T a[repro_nlanes] = {T(0), T(0), T(0), T(0), T(0), T(0), T(0), T(0)};
+
+			index_t j = b0 / m;
+			index_t i = b0 - j * m;
+
+			for (index_t k = b0; k < b1; ++j)
+			{
+				const index_t ie = b1 - k < m - i ? i + (b1 - k) : m;
+				_repro_range(a, (k - b0) % repro_nlanes, i, ie, U(), rd.col(j));
+
+				k += ie - i;
+				i = 0;
+			}
+
+			return _repro_combine(a);
+		}
+
+		// the block sums are pushed to the cascade in order, so the
+		// result does not depend on which thread computes a block.
+		// The accessors are made for each task, as those of an
+		// expression may keep per-evaluation state.
+
+		template<typename T, typename U, class GetRd>
+		inline T _repro_sum(const par_ *p, index_t m, index_t N, U, const GetRd& get_rd)
+		{
+			const index_t B = LMAT_REPRO_SUM_BLOCK;
+			const index_t nb = (N + B - 1) / B;
+
+			sum_cascade<T> c;
+
+			if (p && nb > 1)
+			{
+				const index_t grain = (p->grain > 0 ? p->grain : LMAT_PAR_MIN_TASK_ELEMS) / B;
+
+				dense_col<T> bsums(nb);
+
+				exec::parallel_for(range(0, nb), grain, [&](const range& r)
+				{
+					auto rd = get_rd();
+					for (index_t k = r.begin_index(); k < r.end_index(); ++k)
+					{
+						const index_t b0 = k * B;
+						bsums[k] = _repro_block<T>(m, b0, b0 + B < N ? b0 + B : N, U(), rd);
+					}
+				});
+
+				for (index_t k = 0; k < nb; ++k) c.push(bsums[k]);
+			}
+			else
+			{
+				auto rd = get_rd();
+				for (index_t b0 = 0; b0 < N; b0 += B)
+				{
+					c.push(_repro_block<T>(m, b0, b0 + B < N ? b0 + B : N, U(), rd));
+				}
+			}
+
+			return c.result();
+		}
+
+		template<typename T, typename U, class A>
+		inline T _repro_accsum(const par_ *p, macc_<linear_, U>, const IEWiseMatrix<A, T>& a)
+		{
+			const A& a_ = a.derived();
+			const index_t N = a.nelems();
+
+			return _repro_sum<T>(p, N, N, U(),
+					[&]() { return as_single_col(make_vec_accessor(U(), in_(a_))); });
+		}
+
+		template<typename T, typename U, class A>
+		inline T _repro_accsum(const par_ *p, macc_<percol_, U>, const IEWiseMatrix<A, T>& a)
+		{
+			const A& a_ = a.derived();
+
+			return _repro_sum<T>(p, a.nrows(), a.nelems(), U(),
+					[&]() { return make_multicol_accessor(U(), in_(a_)); });
+		}
+
+		template<typename T, class Macc, class A>
+		LMAT_ENSURE_INLINE
+		inline T _accsum(Macc, const IEWiseMatrix<A, T>& a, sumacc::reproducible_)
+		{
+			return _repro_accsum(static_cast<const par_*>(0), Macc(), a);
+		}
+
+		template<class A>
+		struct accsum_policy
+		{
+			typedef typename matrix_traits<A>::value_type T;
+
+			typedef typename fold_policy<sum_kernel<T>,
+					typename meta::shape<A>::type, arg_wrap<A, atags::in> >::type type;
+		};
+
+		template<typename T, class Mode, class A>
+		LMAT_ENSURE_INLINE
+		inline T accsum(const IEWiseMatrix<A, T>& a, Mode)
+		{
+			return _accsum(typename accsum_policy<A>::type(), a, Mode());
+		}
+	}
+
+
+	/********************************************
+	 *
+	 *  summation functions
+	 *
+	 ********************************************/
+
+	template<typename T, class A>
+	LMAT_ENSURE_INLINE
+	inline T sum(const IEWiseMatrix<A, T>& a, sumacc::compensated_)
+	{
+		return a.nelems() > 0 ?
+				fold(csum_kernel<T>())(a.shape(), in_(a)).value() :
+				internal::empty_values<T>::sum();
+	}
+
+	template<typename T, class A>
+	LMAT_ENSURE_INLINE
+	inline T sum(const IEWiseMatrix<A, T>& a, sumacc::pairwise_)
+	{
+		return internal::accsum(a, sumacc::pairwise_());
+	}
+
+	template<typename T, class A>
+	LMAT_ENSURE_INLINE
+	inline T sum(const IEWiseMatrix<A, T>& a, sumacc::reproducible_)
+	{
+		return internal::accsum(a, sumacc::reproducible_());
+	}
+
+	template<typename T, class A>
+	LMAT_ENSURE_INLINE
+	inline T sum(const par_& p, const IEWiseMatrix<A, T>& a, sumacc::reproducible_)
+	{
+		typedef typename internal::accsum_policy<A>::type policy_t;
+		return internal::_repro_accsum(&p, policy_t(), a);
+	}
+
+	template<typename T, class A, class Mode>
+	LMAT_ENSURE_INLINE
+	inline T mean(const IEWiseMatrix<A, T>& a, Mode)
+	{
+		const index_t n = a.nelems();
+		return n > 0 ? sum(a, Mode()) / T(n) : internal::empty_values<T>::mean();
+	}
+
+	template<typename T, class A, class B, class Mode>
+	LMAT_ENSURE_INLINE
+	inline T dot(const IEWiseMatrix<A, T>& a, const IEWiseMatrix<B, T>& b, Mode)
+	{
+		return sum(a * b, Mode());
+	}
+
+}
+
+#endif /* MAT_ACCSUM_H_ */
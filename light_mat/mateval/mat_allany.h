@@ -94,7 +94,8 @@ namespace lmat
 			IRegularMatrix<DMat, bool>& dmat, bool val=true)
 	{
 		typedef default_simd_kind kind;
-		const bool use_simd = supports_simd<Mat, kind>::value;
+		const bool use_simd = supports_simd<Mat, kind>::value &&
+				internal::strided_simd_pays<LMAT_COST_ARITH, Mat>::value;
 		typedef typename std::conditional<use_simd, simd_<kind>, scalar_>::type U;
 
 		LMAT_CHECK_DIMS( dmat.nelems() == mat.ncolumns() )
@@ -114,7 +115,8 @@ namespace lmat
 			IRegularMatrix<DMat, bool>& dmat, bool val=true)
 	{
 		typedef default_simd_kind kind;
-		const bool use_simd = supports_simd<Mat, kind>::value;
+		const bool use_simd = supports_simd<Mat, kind>::value &&
+				internal::strided_simd_pays<LMAT_COST_ARITH, Mat>::value;
 		typedef typename std::conditional<use_simd, simd_<kind>, scalar_>::type U;
 
 		LMAT_CHECK_DIMS( dmat.nelems() == mat.ncolumns() )
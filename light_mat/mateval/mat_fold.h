@@ -122,6 +122,137 @@ namespace lmat
 
 	LMAT_DEFINE_SIMPLE_FOLD_KERNEL( minimum, x, a = math::min(a, x), minimum(a) )
 
+	namespace internal
+	{
+		template<typename T>
+		struct is_idempotent_fold<maximum_kernel<T> > : public meta::true_ { };
+
+		template<typename T>
+		struct is_idempotent_fold<minimum_kernel<T> > : public meta::true_ { };
+	}
+
+
+	/********************************************
+	 *
+	 *  fused folders
+	 *
+	 *  Two fold kernels over the same input
+	 *  evaluated in a single pass. The
+	 *  accumulated value is a pair.
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		template<typename T>
+		struct _fold_packwidth
+		{
+			static const unsigned int value = 1;
+		};
+
+		template<typename T, typename Kind>
+		struct _fold_packwidth<simd_pack<T, Kind> >
+		{
+			static const unsigned int value = simd_traits<T, Kind>::pack_width;
+		};
+	}
+
+	template<typename A1, typename A2, unsigned int W>
+	struct fused_stat : public std::pair<A1, A2>
+	{
+		static const unsigned int pack_width = W;
+
+		LMAT_ENSURE_INLINE
+		fused_stat() { }
+
+		LMAT_ENSURE_INLINE
+		fused_stat(const A1& a1, const A2& a2)
+		: std::pair<A1, A2>(a1, a2) { }
+	};
+
+	template<class Kernel1, class Kernel2>
+	struct fused_kernel
+	{
+		static_assert(std::is_same<typename Kernel1::value_type, typename Kernel2::value_type>::value,
+				"The kernels to be fused must have the same value_type.");
+
+		typedef typename Kernel1::value_type value_type;
+		typedef fused_stat<typename Kernel1::accumulated_type,
+				typename Kernel2::accumulated_type,
+				internal::_fold_packwidth<value_type>::value> accumulated_type;
+
+		Kernel1 first;
+		Kernel2 second;
+
+		LMAT_ENSURE_INLINE
+		fused_kernel(const Kernel1& k1, const Kernel2& k2)
+		: first(k1), second(k2) { }
+
+		LMAT_ENSURE_INLINE
+		accumulated_type init(const value_type& x) const
+		{
+			return accumulated_type(first.init(x), second.init(x));
+		}
+
+		LMAT_ENSURE_INLINE
+		void operator() (accumulated_type& a, const value_type& x) const
+		{
+			first(a.first, x);
+			second(a.second, x);
+		}
+
+		LMAT_ENSURE_INLINE
+		void operator() (accumulated_type& a, const accumulated_type& b) const
+		{
+			first(a.first, b.first);
+			second(a.second, b.second);
+		}
+
+		// only available on simdized kernels
+
+		template<class Acc, class K1=Kernel1, class K2=Kernel2>
+		LMAT_ENSURE_INLINE
+		auto reduce(const Acc& a) const
+		-> fused_stat<decltype(std::declval<const K1&>().reduce(a.first)),
+				decltype(std::declval<const K2&>().reduce(a.second)), 1>
+		{
+			typedef fused_stat<decltype(first.reduce(a.first)), decltype(second.reduce(a.second)), 1> rt;
+			return rt(first.reduce(a.first), second.reduce(a.second));
+		}
+	};
+
+	template<class Kernel1, class Kernel2, typename Kind>
+	struct is_simdizable<fused_kernel<Kernel1, Kernel2>, Kind>
+	: public meta::and_<is_simdizable<Kernel1, Kind>, is_simdizable<Kernel2, Kind> > { };
+
+	template<class Kernel1, class Kernel2, typename Kind>
+	struct simdize_map<fused_kernel<Kernel1, Kernel2>, Kind>
+	{
+		typedef simdize_map<Kernel1, Kind> map1;
+		typedef simdize_map<Kernel2, Kind> map2;
+		typedef fused_kernel<typename map1::type, typename map2::type> type;
+
+		LMAT_ENSURE_INLINE
+		static type get(const fused_kernel<Kernel1, Kernel2>& k)
+		{
+			return type(map1::get(k.first), map2::get(k.second));
+		}
+	};
+
+	namespace internal
+	{
+		template<class Kernel1, class Kernel2>
+		struct is_idempotent_fold<fused_kernel<Kernel1, Kernel2> >
+		: public meta::and_<is_idempotent_fold<Kernel1>, is_idempotent_fold<Kernel2> > { };
+	}
+
+	template<class Kernel1, class Kernel2>
+	LMAT_ENSURE_INLINE
+	inline fused_kernel<Kernel1, Kernel2> fuse(const Kernel1& k1, const Kernel2& k2)
+	{
+		return fused_kernel<Kernel1, Kernel2>(k1, k2);
+	}
+
 
 
 	/********************************************
@@ -144,6 +275,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		result_type eval(macc_<linear_, U>, const matrix_shape<CM, CN>& shape, const Wrap&... wrap) const
 		{
+			LMAT_INSTRUMENT_PATH("fold.linear", use_simd(macc_<linear_, U>()))
 			dimension<CM * CN> dim(shape.nelems());
 			return internal::linear_fold_impl(dim, U(), m_kernel, make_vec_accessor(U(), wrap)...);
 		}
@@ -152,6 +284,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		result_type eval(macc_<linear_, U>, index_t m, index_t n, const Wrap&... wrap) const
 		{
+			LMAT_INSTRUMENT_PATH("fold.linear", use_simd(macc_<linear_, U>()))
 			dimension<0> dim(m * n);
 			return internal::linear_fold_impl(dim, U(), m_kernel, make_vec_accessor(U(), wrap)...);
 		}
@@ -160,6 +293,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		result_type eval(macc_<percol_, U>, const matrix_shape<CM, CN>& shape, const Wrap&... wrap) const
 		{
+			LMAT_INSTRUMENT_PATH("fold.percol", use_simd(macc_<percol_, U>()))
 			return internal::percol_fold_impl(shape, U(), m_kernel, make_multicol_accessor(U(), wrap)...);
 		}
 
@@ -167,6 +301,7 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		result_type eval(macc_<percol_, U>, index_t m, index_t n, const Wrap&... wrap) const
 		{
+			LMAT_INSTRUMENT_PATH("fold.percol", use_simd(macc_<percol_, U>()))
 			matrix_shape<0,0> shape(m, n);
 			return internal::percol_fold_impl(shape, U(), m_kernel, make_multicol_accessor(U(), wrap)...);
 		}
@@ -175,8 +310,10 @@ namespace lmat
 		LMAT_ENSURE_INLINE
 		result_type operator() (const matrix_shape<CM, CN>& shape, const Wrap&... wrap) const
 		{
-			typedef typename internal::fold_policy<FoldKernel, matrix_shape<CM, CN>, Wrap...>::type policy_t;
-			return eval(policy_t(), shape, wrap...);
+			typedef internal::fold_policy<FoldKernel, matrix_shape<CM, CN>, Wrap...> pmap;
+			typedef typename internal::avx_dispatchable<pmap::_len, FoldKernel, Wrap...>::type dispatchable;
+
+			return dispatch_eval(typename pmap::type(), dispatchable(), shape, wrap...);
 		}
 
 		template<typename... Wrap>
@@ -184,7 +321,45 @@ namespace lmat
 		result_type operator() (index_t m, index_t n, const Wrap&... wrap) const
 		{
 			typedef typename internal::fold_policy<FoldKernel, matrix_shape<0, 0>, Wrap...>::type policy_t;
-			return eval(policy_t(), m, n, wrap...);
+			typedef typename internal::avx_dispatchable<0, FoldKernel, Wrap...>::type dispatchable;
+
+			return dispatch_eval(policy_t(), dispatchable(), m, n, wrap...);
+		}
+
+	private:
+		// a fold planned with SSE packs goes through the
+		// run-time dispatch (see simd_dispatch.h)
+
+		template<typename Acc>
+		struct simd_eval_task
+		{
+			typedef typename matrix_folder::result_type result_type;
+
+			const matrix_folder& folder;
+
+			LMAT_ENSURE_INLINE
+			simd_eval_task(const matrix_folder& folder_) : folder(folder_) { }
+
+			template<typename Kind, typename... Args>
+			LMAT_ENSURE_INLINE
+			result_type operator() (Kind, const Args&... args) const
+			{
+				return folder.eval(macc_<Acc, simd_<Kind> >(), args...);
+			}
+		};
+
+		template<typename Acc, typename U, typename Dispatchable, typename... Args>
+		LMAT_ENSURE_INLINE
+		result_type dispatch_eval(macc_<Acc, U> policy, Dispatchable, const Args&... args) const
+		{
+			return eval(policy, args...);
+		}
+
+		template<typename Acc, typename Dispatchable, typename... Args>
+		LMAT_ENSURE_INLINE
+		result_type dispatch_eval(macc_<Acc, simd_<sse_t> >, Dispatchable, const Args&... args) const
+		{
+			return internal::simd_dispatch(Dispatchable(), simd_eval_task<Acc>(*this), args...);
 		}
 
 	private:
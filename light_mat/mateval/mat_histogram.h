@@ -0,0 +1,463 @@
+/**
+ * @file mat_histogram.h
+ *
+ * @brief Bin counts, histograms and streaming quantile sketches
+ *
+ * - bincount(idx, n, c): c[k] is the number of elements of idx
+ *   that are equal to k, for k in [0, n).
+ *
+ * - histogram(a, edges, c): c[k] is the number of elements of a in
+ *   [edges[k], edges[k+1]), the last bin being closed. With
+ *   uniform_bins(lo, hi, n) instead of edges, the bin indices are
+ *   computed by multiplication and truncation (with SIMD).
+ *
+ *   Elements outside of all bins (including NaN) are not counted.
+ *   The parallel variants (with par_) count each block of elements
+ *   into its own sub-histogram, which are summed up at the end.
+ *
+ * - quantile_sketch<T>: a KLL sketch, which summarizes a stream of
+ *   values in O(k) memory, and answers quantile queries with a rank
+ *   error of about 1 / k. Sketches can be merged, and thus computed
+ *   as a fold (see quantile_sketch_kernel), or by blocks in parallel.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MAT_HISTOGRAM_H_
+#define LIGHTMAT_MAT_HISTOGRAM_H_
+
+#include <light_mat/mateval/mat_fold.h>
+#include "internal/mat_histogram_internal.h"
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include <cmath>
+
+// default capacity parameter of quantile sketches
+#ifndef LMAT_QSKETCH_K
+#define LMAT_QSKETCH_K 200
+#endif
+
+namespace lmat
+{
+	/********************************************
+	 *
+	 *  bin counts
+	 *
+	 ********************************************/
+
+	template<typename TI, class A, class D, typename TD>
+	inline void bincount(const IEWiseMatrix<A, TI>& idx, index_t n, IRegularMatrix<D, TD>& counts)
+	{
+		static_assert(std::is_integral<TI>::value, "bincount: the indices must be integers.");
+		check_arg(n >= 0, "bincount: n must be non-negative.");
+
+		internal::index_binner<TI> binner = { n };
+		internal::bin_count_impl(0, binner, idx, counts);
+	}
+
+	template<typename TI, class A, class D, typename TD>
+	inline void bincount(const par_& p, const IEWiseMatrix<A, TI>& idx, index_t n, IRegularMatrix<D, TD>& counts)
+	{
+		static_assert(std::is_integral<TI>::value, "bincount: the indices must be integers.");
+		check_arg(n >= 0, "bincount: n must be non-negative.");
+
+		internal::index_binner<TI> binner = { n };
+		internal::bin_count_impl(&p, binner, idx, counts);
+	}
+
+	template<typename TI, class A>
+	inline dense_col<index_t> bincount(const IEWiseMatrix<A, TI>& idx, index_t n)
+	{
+		dense_col<index_t> c(n);
+		bincount(idx, n, c);
+		return c;
+	}
+
+	template<typename TI, class A>
+	inline dense_col<index_t> bincount(const par_& p, const IEWiseMatrix<A, TI>& idx, index_t n)
+	{
+		dense_col<index_t> c(n);
+		bincount(p, idx, n, c);
+		return c;
+	}
+
+
+	/********************************************
+	 *
+	 *  histograms
+	 *
+	 ********************************************/
+
+	template<typename T>
+	struct uniform_bins
+	{
+		T lo;
+		T hi;
+		index_t n;
+
+		uniform_bins(T lo_, T hi_, index_t n_)
+		: lo(lo_), hi(hi_), n(n_)
+		{
+			check_arg(n > 0, "uniform_bins: n must be positive.");
+			check_arg(lo < hi, "uniform_bins: lo must be less than hi.");
+		}
+	};
+
+	namespace internal
+	{
+		template<typename T>
+		inline uniform_binner<T> make_binner(const uniform_bins<T>& bins)
+		{
+			uniform_binner<T> b = { bins.lo, bins.hi, T(bins.n) / (bins.hi - bins.lo), bins.n };
+			return b;
+		}
+
+		template<typename T, class E>
+		inline dense_matrix<T> histogram_edges(const IMatrixXpr<E, T>& edges)
+		{
+			dense_matrix<T> e(edges);
+
+			check_arg(e.nelems() >= 2, "histogram: there must be at least two edges.");
+			for (index_t i = 1; i < e.nelems(); ++i)
+			{
+				check_arg(e[i-1] < e[i], "histogram: the edges must be strictly increasing.");
+			}
+			return e;
+		}
+	}
+
+	template<typename T, class A, class E, class D, typename TD>
+	inline void histogram(const IEWiseMatrix<A, T>& a, const IMatrixXpr<E, T>& edges, IRegularMatrix<D, TD>& counts)
+	{
+		dense_matrix<T> e = internal::histogram_edges(edges);
+		internal::edges_binner<T> binner = { e.ptr_data(), e.nelems() - 1 };
+		internal::bin_count_impl(0, binner, a, counts);
+	}
+
+	template<typename T, class A, class E, class D, typename TD>
+	inline void histogram(const par_& p, const IEWiseMatrix<A, T>& a, const IMatrixXpr<E, T>& edges, IRegularMatrix<D, TD>& counts)
+	{
+		dense_matrix<T> e = internal::histogram_edges(edges);
+		internal::edges_binner<T> binner = { e.ptr_data(), e.nelems() - 1 };
+		internal::bin_count_impl(&p, binner, a, counts);
+	}
+
+	template<typename T, class A, class D, typename TD>
+	inline void histogram(const IEWiseMatrix<A, T>& a, const uniform_bins<T>& bins, IRegularMatrix<D, TD>& counts)
+	{
+		internal::bin_count_impl(0, internal::make_binner(bins), a, counts);
+	}
+
+	template<typename T, class A, class D, typename TD>
+	inline void histogram(const par_& p, const IEWiseMatrix<A, T>& a, const uniform_bins<T>& bins, IRegularMatrix<D, TD>& counts)
+	{
+		internal::bin_count_impl(&p, internal::make_binner(bins), a, counts);
+	}
+
+	template<typename T, class A, class E>
+	inline dense_col<index_t> histogram(const IEWiseMatrix<A, T>& a, const IMatrixXpr<E, T>& edges)
+	{
+		dense_col<index_t> c(edges.nelems() - 1);
+		histogram(a, edges, c);
+		return c;
+	}
+
+	template<typename T, class A, class E>
+	inline dense_col<index_t> histogram(const par_& p, const IEWiseMatrix<A, T>& a, const IMatrixXpr<E, T>& edges)
+	{
+		dense_col<index_t> c(edges.nelems() - 1);
+		histogram(p, a, edges, c);
+		return c;
+	}
+
+	template<typename T, class A>
+	inline dense_col<index_t> histogram(const IEWiseMatrix<A, T>& a, const uniform_bins<T>& bins)
+	{
+		dense_col<index_t> c(bins.n);
+		histogram(a, bins, c);
+		return c;
+	}
+
+	template<typename T, class A>
+	inline dense_col<index_t> histogram(const par_& p, const IEWiseMatrix<A, T>& a, const uniform_bins<T>& bins)
+	{
+		dense_col<index_t> c(bins.n);
+		histogram(p, a, bins, c);
+		return c;
+	}
+
+
+	/********************************************
+	 *
+	 *  quantile sketch
+	 *
+	 *  Level h holds items of weight 2^h. When a
+	 *  level reaches its capacity, it is sorted,
+	 *  and every other item (starting from a
+	 *  random offset) is promoted to the next
+	 *  level. The capacities decrease by 2/3 per
+	 *  level below the top one, which has k.
+	 *
+	 *  NaN values are ignored.
+	 *
+	 ********************************************/
+
+	template<typename T>
+	class quantile_sketch
+	{
+		static_assert(std::is_floating_point<T>::value || std::is_integral<T>::value,
+				"quantile_sketch: T must be an arithmetic type.");
+
+	public:
+		explicit quantile_sketch(index_t k = LMAT_QSKETCH_K)
+		: m_k(k), m_n(0), m_rng(0x9E3779B97F4A7C15ULL), m_levels(1)
+		{
+			check_arg(k >= 2, "quantile_sketch: k must be at least 2.");
+		}
+
+		index_t k() const
+		{
+			return m_k;
+		}
+
+		// the number of values that have been seen
+		int64_t count() const
+		{
+			return m_n;
+		}
+
+		bool empty() const
+		{
+			return m_n == 0;
+		}
+
+		// the number of retained items
+		index_t nretained() const
+		{
+			index_t s = 0;
+			for (size_t h = 0; h < m_levels.size(); ++h) s += (index_t)m_levels[h].size();
+			return s;
+		}
+
+		void update(const T& x)
+		{
+			if (x != x) return;
+
+			m_levels[0].push_back(x);
+			++ m_n;
+
+			if ((index_t)m_levels[0].size() >= capacity(0)) compress();
+		}
+
+		void update(const quantile_sketch& s)
+		{
+			if (&s == this)
+			{
+				// the levels are appended to, hence merged from a copy
+				quantile_sketch t(s);
+				update(t);
+				return;
+			}
+
+			if (m_levels.size() < s.m_levels.size()) m_levels.resize(s.m_levels.size());
+
+			for (size_t h = 0; h < s.m_levels.size(); ++h)
+			{
+				m_levels[h].insert(m_levels[h].end(), s.m_levels[h].begin(), s.m_levels[h].end());
+			}
+			m_n += s.m_n;
+
+			compress();
+		}
+
+		/**
+		 * The approximate q-th quantile (q in [0, 1]), i.e. the smallest
+		 * retained item whose rank reaches q * count(). An empty sketch
+		 * gives NaN for floating-point T, and throws invalid_argument
+		 * for integral T, which has no NaN.
+		 */
+		T quantile(double q) const
+		{
+			check_arg(q >= 0.0 && q <= 1.0, "quantile_sketch: q must be in [0, 1].");
+			check_arg(m_n > 0 || std::is_floating_point<T>::value,
+					"quantile_sketch: the sketch of integers is empty.");
+			if (m_n == 0) return std::numeric_limits<T>::quiet_NaN();
+
+			std::vector<std::pair<T, int64_t> > items = weighted_items();
+
+			const double target = q * double(m_n);
+			int64_t cw = 0;
+			for (size_t i = 0; i < items.size(); ++i)
+			{
+				cw += items[i].second;
+				if (double(cw) >= target) return items[i].first;
+			}
+			return items.back().first;
+		}
+
+		// the approximate fraction of values that are not greater than x
+		double rank(const T& x) const
+		{
+			if (m_n == 0) return std::numeric_limits<double>::quiet_NaN();
+
+			int64_t w = 0;
+			for (size_t h = 0; h < m_levels.size(); ++h)
+			{
+				const std::vector<T>& lv = m_levels[h];
+				for (size_t i = 0; i < lv.size(); ++i)
+				{
+					if (lv[i] <= x) w += int64_t(1) << h;
+				}
+			}
+			return double(w) / double(m_n);
+		}
+
+	private:
+		index_t capacity(size_t h) const
+		{
+			double c = double(m_k);
+			for (size_t l = h + 1; l < m_levels.size(); ++l) c *= (2.0 / 3.0);
+			index_t r = (index_t)std::ceil(c);
+			return r > 2 ? r : 2;
+		}
+
+		void compress()
+		{
+			bool changed = true;
+			while (changed)
+			{
+				changed = false;
+				for (size_t h = 0; h < m_levels.size(); ++h)
+				{
+					if ((index_t)m_levels[h].size() >= capacity(h))
+					{
+						compact(h);
+						changed = true;
+						break;
+					}
+				}
+			}
+		}
+
+		void compact(size_t h)
+		{
+			if (h + 1 == m_levels.size()) m_levels.resize(h + 2);
+
+			std::vector<T>& lv = m_levels[h];
+			std::vector<T>& up = m_levels[h + 1];
+			std::sort(lv.begin(), lv.end());
+
+			// an odd item out (the smallest one) stays at this level
+			const size_t s = lv.size() & 1;
+			const size_t off = s + (size_t)(next_random() & 1);
+
+			for (size_t i = off; i < lv.size(); i += 2) up.push_back(lv[i]);
+			lv.resize(s);
+		}
+
+		uint64_t next_random()
+		{
+			m_rng ^= m_rng << 13;
+			m_rng ^= m_rng >> 7;
+			m_rng ^= m_rng << 17;
+			return m_rng >> 32;
+		}
+
+		std::vector<std::pair<T, int64_t> > weighted_items() const
+		{
+			std::vector<std::pair<T, int64_t> > items;
+			items.reserve((size_t)nretained());
+			for (size_t h = 0; h < m_levels.size(); ++h)
+			{
+				const std::vector<T>& lv = m_levels[h];
+				for (size_t i = 0; i < lv.size(); ++i)
+				{
+					items.push_back(std::make_pair(lv[i], int64_t(1) << h));
+				}
+			}
+			std::sort(items.begin(), items.end());
+			return items;
+		}
+
+	private:
+		index_t m_k;
+		int64_t m_n;
+		uint64_t m_rng;
+		std::vector<std::vector<T> > m_levels;
+	};
+
+
+	// a fold kernel, e.g. fold(quantile_sketch_kernel<double>())(a.shape(), in_(a))
+
+	template<typename T>
+	struct quantile_sketch_kernel
+	{
+		typedef T value_type;
+		typedef quantile_sketch<T> accumulated_type;
+
+		index_t k;
+
+		explicit quantile_sketch_kernel(index_t k_ = LMAT_QSKETCH_K) : k(k_) { }
+
+		accumulated_type init(const T& x) const
+		{
+			accumulated_type s(k);
+			s.update(x);
+			return s;
+		}
+
+		void operator() (accumulated_type& s, const T& x) const
+		{
+			s.update(x);
+		}
+
+		void operator() (accumulated_type& s, const accumulated_type& t) const
+		{
+			s.update(t);
+		}
+	};
+
+
+	template<typename T, class A>
+	inline quantile_sketch<T> sketch_quantiles(const IEWiseMatrix<A, T>& a, index_t k = LMAT_QSKETCH_K)
+	{
+		return a.nelems() > 0 ?
+				fold(quantile_sketch_kernel<T>(k))(a.shape(), in_(a)) :
+				quantile_sketch<T>(k);
+	}
+
+	template<typename T, class A>
+	inline quantile_sketch<T> sketch_quantiles(const par_& p, const IEWiseMatrix<A, T>& a, index_t k = LMAT_QSKETCH_K)
+	{
+		const A& a_ = a.derived();
+		const index_t len = a.nelems();
+		const index_t nblk = internal::num_visit_blocks(&p, len);
+
+		if (nblk <= 1) return sketch_quantiles(a, k);
+
+		std::vector<quantile_sketch<T> > subs(nblk, quantile_sketch<T>(k));
+
+		exec::parallel_for(range(0, nblk), 1, [&](const range& r)
+		{
+			for (index_t b = r.begin_index(); b < r.end_index(); ++b)
+			{
+				internal::sketch_updater<quantile_sketch<T> > upd = { subs[b] };
+				internal::visit_block(scalar_(), a_,
+						exec::internal::par_block_begin(len, nblk, b),
+						exec::internal::par_block_begin(len, nblk, b + 1), upd);
+			}
+		});
+
+		for (index_t b = 1; b < nblk; ++b) subs[0].update(subs[b]);
+		return subs[0];
+	}
+
+}
+
+#endif
@@ -71,6 +71,12 @@ namespace lmat
 
 	LMAT_DEF_SIMD_SUPPORT( minmax_kernel )
 
+	namespace internal
+	{
+		template<typename T>
+		struct is_idempotent_fold<minmax_kernel<T> > : public meta::true_ { };
+	}
+
 
 	/********************************************
 	 *
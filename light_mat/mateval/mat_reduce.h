@@ -38,6 +38,12 @@
 		auto shape = a.shape(); \
 		if (shape.nrows() > 0) { \
 			internal::colwise_fold_impl(shape, Name##_kernel<T>(), dmat, a ); } \
+		else { fill(dmat, internal::empty_values<T>::Name()); } } \
+	template<typename T, class A, class DMat> \
+	inline void colwise_##Name(const par_& p, const IEWiseMatrix<A, T>& a, IRegularMatrix<DMat, T>& dmat) { \
+		auto shape = a.shape(); \
+		if (shape.nrows() > 0) { \
+			internal::colwise_fold_impl(p, shape, Name##_kernel<T>(), dmat, a ); } \
 		else { fill(dmat, internal::empty_values<T>::Name()); } }
 
 #define LMAT_DEFINE_BASIC_ROWWISE_REDUCTION( Name ) \
@@ -75,6 +81,15 @@
 		if (shape.nrows() > 0) { \
 			colwise_##Reduc(TExpr, dmat); \
 		} \
+		else { fill(dmat.derived(), EmptyVal); } } \
+	template<typename T, class A, class DMat> \
+	LMAT_ENSURE_INLINE \
+	inline void colwise_##Name(const par_& p, const IEWiseMatrix<A, T>& a, IRegularMatrix<DMat, T>& dmat) { \
+		typename meta::shape<A>::type shape = internal::reduc_get_shape(a); \
+		LMAT_CHECK_DIMS( dmat.nelems() == shape.ncolumns() ); \
+		if (shape.nrows() > 0) { \
+			colwise_##Reduc(p, TExpr, dmat); \
+		} \
 		else { fill(dmat.derived(), EmptyVal); } }
 
 #define LMAT_DEFINE_COLWISE_REDUCTION_2( Name, Reduc, TExpr, EmptyVal ) \
@@ -87,6 +102,16 @@
 		if (shape.nrows() > 0) { \
 			colwise_##Reduc(TExpr, dmat); \
 		} \
+		else { fill(dmat.derived(), EmptyVal); } } \
+	template<typename T, class A, class B, class DMat> \
+	LMAT_ENSURE_INLINE \
+	inline void colwise_##Name(const par_& p, const IEWiseMatrix<A, T>& a, const IEWiseMatrix<B, T>& b, \
+			IRegularMatrix<DMat, T>& dmat) { \
+		typename meta::common_shape<A, B>::type shape = internal::reduc_get_shape(a, b); \
+		LMAT_CHECK_DIMS( dmat.nelems() == shape.ncolumns() ); \
+		if (shape.nrows() > 0) { \
+			colwise_##Reduc(p, TExpr, dmat); \
+		} \
 		else { fill(dmat.derived(), EmptyVal); } }
 
 
@@ -164,6 +189,21 @@ namespace lmat
 		}
 	}
 
+	template<typename T, class A, class DMat>
+	inline void colwise_mean(const par_& p, const IEWiseMatrix<A, T>& a, IRegularMatrix<DMat, T>& dmat)
+	{
+		auto shape = internal::reduc_get_shape(a);
+		if (shape.nrows() > 0)
+		{
+			colwise_sum(p, a, dmat);
+			dmat *= math::rcp((T)shape.nrows());
+		}
+		else
+		{
+			fill(dmat, internal::empty_values<T>::mean());
+		}
+	}
+
 	// rowwise reduction
 
 	LMAT_DEFINE_BASIC_ROWWISE_REDUCTION( sum )
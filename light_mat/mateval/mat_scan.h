@@ -0,0 +1,186 @@
+/**
+ * @file mat_scan.h
+ *
+ * @brief Cumulative sums, products, maxima and minima
+ *
+ * cumsum(a), cumprod(a), cummax(a) and cummin(a) scan the elements of a
+ * in column-major order, while their colwise_ and rowwise_ versions scan
+ * along each column and each row respectively. They are expressions,
+ * which are evaluated into the destination directly, e.g.
+ *
+ *   dense_matrix<double> r = colwise_cumsum(a);
+ *   r = cumsum(par_(), a + b);   // parallel two-pass block scan
+ *
+ * Floating-point sums and products are combined in a different order
+ * than a sequential loop, and thus may differ in the last bits.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MAT_SCAN_H_
+#define LIGHTMAT_MAT_SCAN_H_
+
+#include "internal/mat_scan_internal.h"
+
+#include <limits>
+
+
+// the identity is only used by the SIMD paths, i.e. for real values
+
+#define LMAT_DEFINE_SCAN_KERNEL( Name, Identity, ScanExpr ) \
+	template<typename T> \
+	struct Name##_kernel { \
+		typedef T value_type; \
+		LMAT_ENSURE_INLINE \
+		static T identity() { return Identity; } \
+		LMAT_ENSURE_INLINE \
+		void operator()(T& a, const T& x) const { ScanExpr; } \
+	}; \
+	template<typename T, typename Kind> \
+	struct Name##_kernel<simd_pack<T, Kind> > { \
+		typedef simd_pack<T, Kind> value_type; \
+		LMAT_ENSURE_INLINE \
+		static value_type identity() { return value_type(Identity); } \
+		LMAT_ENSURE_INLINE \
+		void operator()(value_type& a, const value_type& x) const { ScanExpr; } \
+	}; \
+	LMAT_DECL_SIMDIZABLE_ON_REAL( Name##_kernel ) \
+	LMAT_DEF_TRIVIAL_SIMDIZE_MAP( Name##_kernel )
+
+#define LMAT_DEFINE_SCAN( Name ) \
+	template<typename T, class A> \
+	LMAT_ENSURE_INLINE \
+	inline scan_expr<A, Name##_kernel<T>, scandir::linear_> \
+	Name(const IEWiseMatrix<A, T>& a) { \
+		return scan_expr<A, Name##_kernel<T>, scandir::linear_>(a.derived()); } \
+	template<typename T, class A> \
+	LMAT_ENSURE_INLINE \
+	inline scan_expr<A, Name##_kernel<T>, scandir::linear_> \
+	Name(const par_& p, const IEWiseMatrix<A, T>& a) { \
+		return scan_expr<A, Name##_kernel<T>, scandir::linear_>(p, a.derived()); } \
+	template<typename T, class A> \
+	LMAT_ENSURE_INLINE \
+	inline scan_expr<A, Name##_kernel<T>, scandir::colwise_> \
+	colwise_##Name(const IEWiseMatrix<A, T>& a) { \
+		return scan_expr<A, Name##_kernel<T>, scandir::colwise_>(a.derived()); } \
+	template<typename T, class A> \
+	LMAT_ENSURE_INLINE \
+	inline scan_expr<A, Name##_kernel<T>, scandir::colwise_> \
+	colwise_##Name(const par_& p, const IEWiseMatrix<A, T>& a) { \
+		return scan_expr<A, Name##_kernel<T>, scandir::colwise_>(p, a.derived()); } \
+	template<typename T, class A> \
+	LMAT_ENSURE_INLINE \
+	inline scan_expr<A, Name##_kernel<T>, scandir::rowwise_> \
+	rowwise_##Name(const IEWiseMatrix<A, T>& a) { \
+		return scan_expr<A, Name##_kernel<T>, scandir::rowwise_>(a.derived()); } \
+	template<typename T, class A> \
+	LMAT_ENSURE_INLINE \
+	inline scan_expr<A, Name##_kernel<T>, scandir::rowwise_> \
+	rowwise_##Name(const par_& p, const IEWiseMatrix<A, T>& a) { \
+		return scan_expr<A, Name##_kernel<T>, scandir::rowwise_>(p, a.derived()); }
+
+
+namespace lmat
+{
+	/********************************************
+	 *
+	 *  scan kernels
+	 *
+	 ********************************************/
+
+	LMAT_DEFINE_SCAN_KERNEL( cumsum, T(0), a += x )
+
+	LMAT_DEFINE_SCAN_KERNEL( cumprod, T(1), a *= x )
+
+	LMAT_DEFINE_SCAN_KERNEL( cummax, - std::numeric_limits<T>::infinity(), a = math::max(a, x) )
+
+	LMAT_DEFINE_SCAN_KERNEL( cummin, std::numeric_limits<T>::infinity(), a = math::min(a, x) )
+
+
+	/********************************************
+	 *
+	 *  scan expression
+	 *
+	 ********************************************/
+
+	namespace scandir
+	{
+		struct linear_ { };
+		struct colwise_ { };
+		struct rowwise_ { };
+	}
+
+	template<class Arg, class Kernel, class Dir> class scan_expr;
+
+	template<class Arg, class Kernel, class Dir>
+	struct matrix_traits<scan_expr<Arg, Kernel, Dir> >
+	: public matrix_xpr_traits_base<
+	  typename meta::value_type_of<Arg>::type,
+	  meta::nrows<Arg>::value,
+	  meta::ncols<Arg>::value,
+	  typename meta::domain_of<Arg>::type > { };
+
+	template<class Arg, class Kernel, class Dir>
+	class scan_expr
+	: public sarg_matrix_xpr_base<scan_expr<Arg, Kernel, Dir>, Arg>
+	{
+		typedef sarg_matrix_xpr_base<scan_expr<Arg, Kernel, Dir>, Arg> base_t;
+
+	public:
+		scan_expr(const Arg& arg)
+		: base_t(arg), m_par(), m_parallel(false) { }
+
+		scan_expr(const par_& p, const Arg& arg)
+		: base_t(arg), m_par(p), m_parallel(true) { }
+
+		// the parallel policy, or null for a serial scan
+		LMAT_ENSURE_INLINE const par_* par() const
+		{
+			return m_parallel ? &m_par : 0;
+		}
+
+	private:
+		par_ m_par;
+		bool m_parallel;
+	};
+
+	template<class Arg, class Kernel, class DMat>
+	inline void evaluate(const scan_expr<Arg, Kernel, scandir::linear_>& expr,
+			IRegularMatrix<DMat, typename matrix_traits<Arg>::value_type>& dmat)
+	{
+		internal::linear_scan_impl(expr.par(), Kernel(), expr.arg(), dmat);
+	}
+
+	template<class Arg, class Kernel, class DMat>
+	inline void evaluate(const scan_expr<Arg, Kernel, scandir::colwise_>& expr,
+			IRegularMatrix<DMat, typename matrix_traits<Arg>::value_type>& dmat)
+	{
+		internal::colwise_scan_impl(expr.par(), Kernel(), expr.arg(), dmat);
+	}
+
+	template<class Arg, class Kernel, class DMat>
+	inline void evaluate(const scan_expr<Arg, Kernel, scandir::rowwise_>& expr,
+			IRegularMatrix<DMat, typename matrix_traits<Arg>::value_type>& dmat)
+	{
+		internal::rowwise_scan_impl(expr.par(), Kernel(), expr.arg(), dmat);
+	}
+
+
+	/********************************************
+	 *
+	 *  expression construction
+	 *
+	 ********************************************/
+
+	LMAT_DEFINE_SCAN( cumsum )
+	LMAT_DEFINE_SCAN( cumprod )
+	LMAT_DEFINE_SCAN( cummax )
+	LMAT_DEFINE_SCAN( cummin )
+
+}
+
+#endif
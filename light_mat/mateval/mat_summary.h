@@ -0,0 +1,415 @@
+/**
+ * @file mat_summary.h
+ *
+ * @brief Single-pass summary statistics of matrices
+ *
+ * summarize(a) computes the count, sum, mean, variance, min, max,
+ * argmin, argmax, L1-norm and L2-norm of a matrix in one pass,
+ * instead of one pass per statistic. Mean and variance are
+ * accumulated with Welford's update, and partial results are
+ * combined with Chan's formula, so that the variance does not
+ * suffer from the cancellation of sqsum - n * mean^2.
+ *
+ * The input is processed in blocks. The min/max of a block are
+ * obtained together with other statistics, and the block is
+ * scanned again (while still in cache) for argmin/argmax only
+ * when its min/max improves the running ones.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MAT_SUMMARY_H_
+#define LIGHTMAT_MAT_SUMMARY_H_
+
+#include <light_mat/mateval/mat_minmax.h>
+
+// number of elements in a block of summarize
+#ifndef LMAT_SUMMARY_BLOCK
+#define LMAT_SUMMARY_BLOCK 2048
+#endif
+
+namespace lmat
+{
+
+	/********************************************
+	 *
+	 *  summary statistics
+	 *
+	 ********************************************/
+
+	template<typename T>
+	struct summary_stat
+	{
+		T count;
+		T sum;
+		T mean;
+		T m2;		// sum of squared deviations from mean
+		T min_value;
+		T max_value;
+		T asum;
+		T sqsum;
+
+		summary_stat() { }
+
+		summary_stat(const T& x)
+		: count(internal::one_of(x)), sum(x), mean(x), m2(internal::zero_of(x))
+		, min_value(x), max_value(x), asum(math::abs(x)), sqsum(x * x) { }
+
+		void update(const T& x)
+		{
+			count += internal::one_of(x);
+			sum += x;
+
+			T d = x - mean;
+			mean += d / count;
+			m2 += d * (x - mean);
+
+			min_value = math::min(min_value, x);
+			max_value = math::max(max_value, x);
+			asum += math::abs(x);
+			sqsum += x * x;
+		}
+
+		void update(const summary_stat& s)
+		{
+			T n = count + s.count;
+			T d = s.mean - mean;
+			T r = s.count / n;
+
+			mean += d * r;
+			m2 += s.m2 + d * d * count * r;
+			count = n;
+			sum += s.sum;
+
+			min_value = math::min(min_value, s.min_value);
+			max_value = math::max(max_value, s.max_value);
+			asum += s.asum;
+			sqsum += s.sqsum;
+		}
+	};
+
+	template<typename T, typename Kind>
+	inline summary_stat<T> reduce_impl(const summary_stat<simd_pack<T, Kind> >& s)
+	{
+		const unsigned int W = simd_traits<T, Kind>::pack_width;
+
+		summary_stat<T> r;
+		for (unsigned int k = 0; k < W; ++k)
+		{
+			summary_stat<T> t;
+			t.count = s.count[k];
+			t.sum = s.sum[k];
+			t.mean = s.mean[k];
+			t.m2 = s.m2[k];
+			t.min_value = s.min_value[k];
+			t.max_value = s.max_value[k];
+			t.asum = s.asum[k];
+			t.sqsum = s.sqsum[k];
+
+			if (k == 0) r = t; else r.update(t);
+		}
+		return r;
+	}
+
+	LMAT_DEFINE_AGGREG_SIMD_FOLDKERNEL(summary_stat, summary_kernel, 1)
+
+	LMAT_DEF_SIMD_SUPPORT( summary_kernel )
+
+
+	template<typename T>
+	struct summary
+	{
+		index_t count;
+		T sum;
+		T mean;
+		T var;			// unbiased, i.e. normalized by count - 1
+		T min_value;
+		T max_value;
+		index_t argmin;
+		index_t argmax;
+		T l1norm;
+		T l2norm;
+	};
+
+
+	/********************************************
+	 *
+	 *  implementation
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		// a reader that views [offset, ...) of another reader
+
+		template<class Reader>
+		class offset_reader
+		{
+		public:
+			LMAT_ENSURE_INLINE
+			offset_reader(const Reader& rd, index_t o) : m_rd(rd), m_o(o) { }
+
+			LMAT_ENSURE_INLINE
+			auto scalar(index_t i) const -> decltype(std::declval<const Reader&>().scalar(i))
+			{
+				return m_rd.scalar(m_o + i);
+			}
+
+			template<class R=Reader>
+			LMAT_ENSURE_INLINE
+			auto pack(index_t i) const -> decltype(std::declval<const R&>().pack(i))
+			{
+				return m_rd.pack(m_o + i);
+			}
+
+			template<class R=Reader>
+			LMAT_ENSURE_INLINE
+			auto begin_packs() const -> decltype(std::declval<const R&>().begin_packs())
+			{
+				return m_rd.begin_packs();
+			}
+
+			template<class R=Reader>
+			LMAT_ENSURE_INLINE
+			auto end_packs() const -> decltype(std::declval<const R&>().end_packs())
+			{
+				return m_rd.end_packs();
+			}
+
+		private:
+			const Reader& m_rd;
+			index_t m_o;
+		};
+
+		template<typename T>
+		LMAT_ENSURE_INLINE
+		inline const summary_stat<T>& _summary_part(const summary_stat<T>& s)
+		{
+			return s;
+		}
+
+		template<typename A1, typename A2, unsigned int W>
+		LMAT_ENSURE_INLINE
+		inline const A1& _summary_part(const fused_stat<A1, A2, W>& s)
+		{
+			return s.first;
+		}
+
+		template<typename T>
+		struct summary_state
+		{
+			index_t argmin;
+			index_t argmax;
+			T min_value;
+			T max_value;
+			bool started;
+
+			summary_state() : argmin(-1), argmax(-1), started(false) { }
+		};
+
+		template<typename T, class Reader>
+		inline index_t _summary_find(const Reader& rd, index_t len, const T& v)
+		{
+			for (index_t i = 0; i < len; ++i)
+			{
+				if (rd.scalar(i) == v) return i;
+			}
+			return -1;
+		}
+
+		// folds a vector of length len block by block, the elements of which
+		// have linear indices base, base + 1, ...
+
+		template<typename T, typename U, class Kernel, class Reader>
+		void _summarize_vec(const Kernel& kernel, U, const Reader& rd, index_t len, index_t base,
+				typename Kernel::accumulated_type& r, summary_state<T>& st)
+		{
+			const index_t B = LMAT_SUMMARY_BLOCK;
+
+			for (index_t i0 = 0; i0 < len; i0 += B)
+			{
+				const index_t bl = i0 + B < len ? B : len - i0;
+
+				offset_reader<Reader> brd(rd, i0);
+				typename Kernel::accumulated_type br =
+						linear_fold_impl(dimension<0>(bl), U(), kernel, brd);
+
+				const summary_stat<T>& bs = _summary_part(br);
+
+				if (!st.started || bs.min_value < st.min_value)
+				{
+					index_t k = _summary_find(brd, bl, bs.min_value);
+					if (k >= 0)
+					{
+						st.argmin = base + i0 + k;
+						st.min_value = bs.min_value;
+					}
+				}
+
+				if (!st.started || bs.max_value > st.max_value)
+				{
+					index_t k = _summary_find(brd, bl, bs.max_value);
+					if (k >= 0)
+					{
+						st.argmax = base + i0 + k;
+						st.max_value = bs.max_value;
+					}
+				}
+
+				if (st.started) kernel(r, br); else r = br;
+				st.started = true;
+			}
+		}
+
+		template<typename T>
+		inline summary<T> make_summary(index_t n, const summary_stat<T>& s, const summary_state<T>& st)
+		{
+			summary<T> r;
+			r.count = n;
+
+			if (n > 0)
+			{
+				r.sum = s.sum;
+				r.mean = s.mean;
+				r.var = n > 1 ? s.m2 / T(n - 1) : T(0);
+				r.min_value = s.min_value;
+				r.max_value = s.max_value;
+				r.l1norm = s.asum;
+				r.l2norm = math::sqrt(s.sqsum);
+			}
+			else
+			{
+				minmax_stat<T> e = minmax_empty_value<T>();
+				r.sum = T(0);
+				r.mean = empty_values<T>::mean();
+				r.var = empty_values<T>::mean();
+				r.min_value = e.min_value;
+				r.max_value = e.max_value;
+				r.l1norm = T(0);
+				r.l2norm = T(0);
+			}
+
+			r.argmin = st.argmin;
+			r.argmax = st.argmax;
+			return r;
+		}
+
+		template<typename T, typename U, class Kernel, class A>
+		inline typename Kernel::accumulated_type
+		_summarize(macc_<linear_, U>, const Kernel& kernel, const IEWiseMatrix<A, T>& a, summary_state<T>& st)
+		{
+			typename Kernel::accumulated_type r;
+			_summarize_vec(kernel, U(), make_vec_accessor(U(), in_(a)), a.nelems(), 0, r, st);
+			return r;
+		}
+
+		template<typename T, typename U, class Kernel, class A>
+		inline typename Kernel::accumulated_type
+		_summarize(macc_<percol_, U>, const Kernel& kernel, const IEWiseMatrix<A, T>& a, summary_state<T>& st)
+		{
+			auto rd = make_multicol_accessor(U(), in_(a));
+			const index_t m = a.nrows();
+			const index_t n = a.ncolumns();
+
+			typename Kernel::accumulated_type r;
+			for (index_t j = 0; j < n; ++j)
+			{
+				_summarize_vec(kernel, U(), rd.col(j), m, j * m, r, st);
+			}
+			return r;
+		}
+
+		template<typename T, class Kernel, class A>
+		LMAT_ENSURE_INLINE
+		inline typename Kernel::accumulated_type
+		summarize(const Kernel& kernel, const IEWiseMatrix<A, T>& a, summary_state<T>& st)
+		{
+			typedef typename fold_policy<Kernel,
+					typename meta::shape<A>::type, arg_wrap<A, atags::in> >::type policy_t;
+			return _summarize(policy_t(), kernel, a, st);
+		}
+	}
+
+
+	/********************************************
+	 *
+	 *  summary functions
+	 *
+	 ********************************************/
+
+	template<typename T, class A>
+	inline summary<T> summarize(const IEWiseMatrix<A, T>& a)
+	{
+		internal::summary_state<T> st;
+		summary_stat<T> s;
+
+		const index_t n = a.nelems();
+		if (n > 0) s = internal::summarize(summary_kernel<T>(), a, st);
+
+		return internal::make_summary(n, s, st);
+	}
+
+	// summarize, together with a user fold kernel in the same pass,
+	// whose result is written to r (left unchanged if a is empty)
+
+	template<typename T, class A, class Kernel>
+	inline summary<T> summarize(const IEWiseMatrix<A, T>& a, const Kernel& kernel,
+			typename Kernel::accumulated_type& r)
+	{
+		internal::summary_state<T> st;
+		summary_stat<T> s;
+
+		const index_t n = a.nelems();
+		if (n > 0)
+		{
+			auto fr = internal::summarize(fuse(summary_kernel<T>(), kernel), a, st);
+			s = fr.first;
+			r = fr.second;
+		}
+
+		return internal::make_summary(n, s, st);
+	}
+
+	// the argmin & argmax of each column are row indices
+
+	template<typename T, class A, class DMat>
+	inline void colwise_summarize(const IEWiseMatrix<A, T>& a, IRegularMatrix<DMat, summary<T> >& dmat)
+	{
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+		LMAT_CHECK_DIMS( n == dmat.nelems() )
+
+		DMat& d_ = dmat.derived();
+
+		if (m > 0)
+		{
+			typedef summary_kernel<T> kernel_t;
+			typedef typename internal::fold_policy<kernel_t,
+					matrix_shape<meta::nrows<A>::value, 1>, A>::unit U;
+
+			auto rd = make_multicol_accessor(U(), in_(a));
+
+			for (index_t j = 0; j < n; ++j)
+			{
+				internal::summary_state<T> st;
+				summary_stat<T> s;
+				internal::_summarize_vec(kernel_t(), U(), rd.col(j), m, 0, s, st);
+				d_[j] = internal::make_summary(m, s, st);
+			}
+		}
+		else
+		{
+			internal::summary_state<T> st;
+			summary_stat<T> s;
+			summary<T> e = internal::make_summary(0, s, st);
+			for (index_t j = 0; j < n; ++j) d_[j] = e;
+		}
+	}
+
+}
+
+#endif /* MAT_SUMMARY_H_ */
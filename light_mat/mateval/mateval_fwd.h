@@ -16,6 +16,7 @@
 #include <light_mat/simd/simd.h>
 #include <light_mat/matrix/matrix_concepts.h>
 #include <light_mat/math/functor_base.h>
+#include <light_mat/math/fun_costs.h>
 
 #define _LMAT_DEFINE_READONLY_ARG_WRAPPER(TagName) \
 	template<class Arg> \
@@ -74,6 +75,26 @@ namespace lmat
 	template<typename Kind>
 	struct simd_ { };
 
+	// pack offsets (see vec_accessors.h) of accessors that do not
+	// access memory, and of accessors over operands starting at
+	// different offsets
+
+	namespace internal
+	{
+		const index_t any_pack_offset = -1;
+		const index_t mixed_pack_offset = -2;
+	}
+
+
+	// the work (in units of fun_cost) of a kernel on an element,
+	// beyond reading its operands
+
+	template<class Kernel>
+	struct kernel_cost
+	{
+		static const int value = LMAT_COST_ARITH;
+	};
+
 
 	// access tags
 
@@ -15,6 +15,7 @@
 
 #include <light_mat/matrix/matrix_classes.h>
 #include <light_mat/mateval/ewise_eval.h>
+#include <light_mat/common/exec.h>
 #include <utility>
 #include <algorithm>
 
@@ -292,6 +293,8 @@ namespace lmat
 		if ( k < 0 || k >= n )
 			throw invalid_argument("nth_element: the value of k is out of valid range.");
 
+		LMAT_INSTRUMENT_SCOPE("nth_element")
+		LMAT_INSTRUMENT_TEMP("nth_element", a.nelems() * sizeof(T))
 		dense_matrix<T, meta::nrows<A>::value, meta::ncols<A>::value> tmp(a);
 		return internal::_nth_elem(tmp, k);
 	}
@@ -307,6 +310,8 @@ namespace lmat
 		if ( k < 0 || k >= m )
 			throw invalid_argument("colwise_nth_element: the value of k is out of valid range.");
 
+		LMAT_INSTRUMENT_SCOPE("colwise_nth_element")
+		LMAT_INSTRUMENT_TEMP("colwise_nth_element", a.nelems() * sizeof(T))
 		dense_matrix<T, meta::nrows<A>::value, meta::ncols<A>::value> tmp(a);
 		D& r_ = r.derived();
 		for (index_t j = 0; j < n; ++j)
@@ -316,6 +321,31 @@ namespace lmat
 		}
 	}
 
+	template<class A, typename T, class D>
+	inline typename std::enable_if<meta::supports_linear_index<D>::value,
+	void>::type
+	colwise_nth_element(const par_& p, const IMatrixXpr<A, T>& a, index_t k, IRegularMatrix<D, T>& r)
+	{
+		index_t m = a.nrows();
+		index_t n = a.ncolumns();
+		if ( k < 0 || k >= m )
+			throw invalid_argument("colwise_nth_element: the value of k is out of valid range.");
+
+		LMAT_INSTRUMENT_SCOPE("colwise_nth_element")
+		LMAT_INSTRUMENT_TEMP("colwise_nth_element", a.nelems() * sizeof(T))
+		dense_matrix<T, meta::nrows<A>::value, meta::ncols<A>::value> tmp(a);
+		D& r_ = r.derived();
+
+		exec::parallel_for(range(0, n), p.col_grain(m), [&](const range& cols)
+		{
+			for (index_t j = cols.begin_index(); j < cols.end_index(); ++j)
+			{
+				auto cj = tmp.column(j);
+				r_[j] = internal::_nth_elem(cj, k);
+			}
+		});
+	}
+
 
 	template<class A, typename T>
 	inline T median(const IMatrixXpr<A, T>& a)
@@ -324,6 +354,8 @@ namespace lmat
 		if (n == 0)
 			throw invalid_argument("median: the input array a was emtpy.");
 
+		LMAT_INSTRUMENT_SCOPE("median")
+		LMAT_INSTRUMENT_TEMP("median", a.nelems() * sizeof(T))
 		dense_matrix<T, meta::nrows<A>::value, meta::ncols<A>::value> tmp(a);
 		return internal::_median(tmp);
 	}
@@ -339,6 +371,8 @@ namespace lmat
 		const index_t n = a.ncolumns();
 		LMAT_CHECK_DIMS( n == r.nelems() )
 
+		LMAT_INSTRUMENT_SCOPE("colwise_median")
+		LMAT_INSTRUMENT_TEMP("colwise_median", a.nelems() * sizeof(T))
 		dense_matrix<T, meta::nrows<A>::value, meta::ncols<A>::value> tmp(a);
 		D& r_ = r.derived();
 		for (index_t j = 0; j < n; ++j)
@@ -348,6 +382,301 @@ namespace lmat
 		}
 	}
 
+	template<class A, typename T, class D>
+	inline typename std::enable_if<meta::supports_linear_index<D>::value,
+	void>::type
+	colwise_median(const par_& p, const IMatrixXpr<A, T>& a, IRegularMatrix<D, T>& r)
+	{
+		if (is_empty(a))
+			throw invalid_argument("median: the input array a was emtpy.");
+
+		const index_t n = a.ncolumns();
+		LMAT_CHECK_DIMS( n == r.nelems() )
+
+		LMAT_INSTRUMENT_SCOPE("colwise_median")
+		LMAT_INSTRUMENT_TEMP("colwise_median", a.nelems() * sizeof(T))
+		dense_matrix<T, meta::nrows<A>::value, meta::ncols<A>::value> tmp(a);
+		D& r_ = r.derived();
+
+		exec::parallel_for(range(0, n), p.col_grain(a.nrows()), [&](const range& cols)
+		{
+			for (index_t j = cols.begin_index(); j < cols.end_index(); ++j)
+			{
+				auto cj = tmp.column(j);
+				r_[j] = internal::_median(cj);
+			}
+		});
+	}
+
+
+	/********************************************
+	 *
+	 *  top-k elements
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		// vs & is form a min-heap of size k (w.r.t. values),
+		// such that vs[0] is the smallest of the current top-k
+
+		template<typename T>
+		inline void _topk_sift_down(T *vs, index_t *is, index_t k, index_t p)
+		{
+			const T v = vs[p];
+			const index_t vi = is[p];
+
+			index_t c;
+			while ((c = (p << 1) + 1) < k)
+			{
+				if (c + 1 < k && vs[c + 1] < vs[c]) ++c;
+				if (!(vs[c] < v)) break;
+
+				vs[p] = vs[c];
+				is[p] = is[c];
+				p = c;
+			}
+
+			vs[p] = v;
+			is[p] = vi;
+		}
+
+		template<typename T>
+		LMAT_ENSURE_INLINE
+		inline void _topk_replace_top(T *vs, index_t *is, index_t k, const T& x, index_t i)
+		{
+			vs[0] = x;
+			is[0] = i;
+			_topk_sift_down(vs, is, k, 0);
+		}
+
+		template<class Rd, typename T>
+		inline void _topk_init(const Rd& rd, index_t k, T *vs, index_t *is)
+		{
+			for (index_t i = 0; i < k; ++i)
+			{
+				vs[i] = rd.scalar(i);
+				is[i] = i;
+			}
+
+			for (index_t p = (k >> 1) - 1; p >= 0; --p)
+				_topk_sift_down(vs, is, k, p);
+		}
+
+		// turns the heap into a descending sequence
+		template<typename T>
+		inline void _topk_finish(T *vs, index_t *is, index_t k)
+		{
+			for (index_t m = k - 1; m > 0; --m)
+			{
+				std::swap(vs[0], vs[m]);
+				std::swap(is[0], is[m]);
+				_topk_sift_down(vs, is, m, 0);
+			}
+		}
+
+		template<class Rd, typename T>
+		inline void _topk_scan(const Rd& rd, index_t n, index_t k, T *vs, index_t *is, scalar_)
+		{
+			_topk_init(rd, k, vs, is);
+
+			for (index_t i = k; i < n; ++i)
+			{
+				T x = rd.scalar(i);
+				if (x > vs[0])
+					_topk_replace_top(vs, is, k, x, i);
+			}
+
+			_topk_finish(vs, is, k);
+		}
+
+		template<class Rd, typename T, typename Kind>
+		inline void _topk_scan(const Rd& rd, index_t n, index_t k, T *vs, index_t *is, simd_<Kind>)
+		{
+			typedef simd_pack<T, Kind> pack_t;
+			const index_t W = (index_t)pack_t::pack_width;
+
+			_topk_init(rd, k, vs, is);
+
+			// a whole pack is skipped unless one of its elements beats the threshold,
+			// which is the common case once the heap is warmed up
+
+			index_t i = k;
+			for (; i + W <= n; i += W)
+			{
+				if (any_true(rd.pack(i) > pack_t(vs[0])))
+				{
+					for (index_t u = i; u < i + W; ++u)
+					{
+						T x = rd.scalar(u);
+						if (x > vs[0])
+							_topk_replace_top(vs, is, k, x, u);
+					}
+				}
+			}
+
+			for (; i < n; ++i)
+			{
+				T x = rd.scalar(i);
+				if (x > vs[0])
+					_topk_replace_top(vs, is, k, x, i);
+			}
+
+			_topk_finish(vs, is, k);
+		}
+
+		template<class A>
+		struct topk_unit
+		{
+			typedef typename std::conditional<
+					supports_simd<A, default_simd_kind>::value &&
+					strided_simd_pays<LMAT_COST_ARITH, A>::value,
+					simd_<default_simd_kind>,
+					scalar_>::type type;
+		};
+	}
+
+
+	template<class A, typename T, class DV, typename TI, class DI>
+	inline typename std::enable_if<supports_linear_access<A>::value,
+	void>::type
+	topk(const IEWiseMatrix<A, T>& a, index_t k,
+			IRegularMatrix<DV, T>& vals, IRegularMatrix<DI, TI>& idx)
+	{
+		const index_t n = a.nelems();
+		if ( k < 0 || k > n )
+			throw invalid_argument("topk: the value of k is out of valid range.");
+
+		LMAT_CHECK_DIMS( vals.nelems() == k && idx.nelems() == k )
+		if (k == 0) return;
+
+		typedef typename internal::topk_unit<A>::type U;
+
+		LMAT_INSTRUMENT_SCOPE("topk")
+		dense_col<T> hv(k);
+		dense_col<index_t> hi(k);
+		internal::_topk_scan(make_vec_accessor(U(), in_(a.derived())),
+				n, k, hv.ptr_data(), hi.ptr_data(), U());
+
+		DV& vals_ = vals.derived();
+		DI& idx_ = idx.derived();
+		for (index_t i = 0; i < k; ++i)
+		{
+			vals_[i] = hv[i];
+			idx_[i] = static_cast<TI>(hi[i]);
+		}
+	}
+
+	template<class A, typename T, class DV>
+	inline typename std::enable_if<supports_linear_access<A>::value,
+	void>::type
+	topk(const IEWiseMatrix<A, T>& a, index_t k, IRegularMatrix<DV, T>& vals)
+	{
+		dense_col<index_t> idx(k);
+		topk(a, k, vals, idx);
+	}
+
+	template<class A, typename T>
+	inline typename std::enable_if<supports_linear_access<A>::value,
+	dense_col<T> >::type
+	topk(const IEWiseMatrix<A, T>& a, index_t k)
+	{
+		dense_col<T> vals(k);
+		topk(a, k, vals);
+		return vals;
+	}
+
+
+	template<class A, typename T, class DV, typename TI, class DI>
+	inline void colwise_topk(const IEWiseMatrix<A, T>& a, index_t k,
+			IRegularMatrix<DV, T>& vals, IRegularMatrix<DI, TI>& idx)
+	{
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+		if ( k < 0 || k > m )
+			throw invalid_argument("colwise_topk: the value of k is out of valid range.");
+
+		LMAT_CHECK_DIMS( vals.nrows() == k && vals.ncolumns() == n )
+		LMAT_CHECK_DIMS( idx.nrows() == k && idx.ncolumns() == n )
+		if (k == 0) return;
+
+		typedef typename internal::topk_unit<A>::type U;
+		auto rd = make_multicol_accessor(U(), in_(a.derived()));
+
+		LMAT_INSTRUMENT_SCOPE("colwise_topk")
+		dense_col<T> hv(k);
+		dense_col<index_t> hi(k);
+
+		DV& vals_ = vals.derived();
+		DI& idx_ = idx.derived();
+
+		for (index_t j = 0; j < n; ++j)
+		{
+			internal::_topk_scan(rd.col(j), m, k, hv.ptr_data(), hi.ptr_data(), U());
+
+			for (index_t i = 0; i < k; ++i)
+			{
+				vals_(i, j) = hv[i];
+				idx_(i, j) = static_cast<TI>(hi[i]);
+			}
+		}
+	}
+
+	template<class A, typename T, class DV>
+	inline void colwise_topk(const IEWiseMatrix<A, T>& a, index_t k, IRegularMatrix<DV, T>& vals)
+	{
+		dense_matrix<index_t> idx(k, a.ncolumns());
+		colwise_topk(a, k, vals, idx);
+	}
+
+	// each block of columns has its own heap (and accessor)
+
+	template<class A, typename T, class DV, typename TI, class DI>
+	inline void colwise_topk(const par_& p, const IEWiseMatrix<A, T>& a, index_t k,
+			IRegularMatrix<DV, T>& vals, IRegularMatrix<DI, TI>& idx)
+	{
+		const index_t m = a.nrows();
+		const index_t n = a.ncolumns();
+		if ( k < 0 || k > m )
+			throw invalid_argument("colwise_topk: the value of k is out of valid range.");
+
+		LMAT_CHECK_DIMS( vals.nrows() == k && vals.ncolumns() == n )
+		LMAT_CHECK_DIMS( idx.nrows() == k && idx.ncolumns() == n )
+		if (k == 0) return;
+
+		typedef typename internal::topk_unit<A>::type U;
+
+		DV& vals_ = vals.derived();
+		DI& idx_ = idx.derived();
+
+		exec::parallel_for(range(0, n), p.col_grain(m), [&](const range& cols)
+		{
+			auto rd = make_multicol_accessor(U(), in_(a.derived()));
+
+			LMAT_INSTRUMENT_SCOPE("colwise_topk")
+			dense_col<T> hv(k);
+			dense_col<index_t> hi(k);
+
+			for (index_t j = cols.begin_index(); j < cols.end_index(); ++j)
+			{
+				internal::_topk_scan(rd.col(j), m, k, hv.ptr_data(), hi.ptr_data(), U());
+
+				for (index_t i = 0; i < k; ++i)
+				{
+					vals_(i, j) = hv[i];
+					idx_(i, j) = static_cast<TI>(hi[i]);
+				}
+			}
+		});
+	}
+
+	template<class A, typename T, class DV>
+	inline void colwise_topk(const par_& p, const IEWiseMatrix<A, T>& a, index_t k, IRegularMatrix<DV, T>& vals)
+	{
+		dense_matrix<index_t> idx(k, a.ncolumns());
+		colwise_topk(p, a, k, vals, idx);
+	}
+
 }
 
 #endif 
@@ -16,6 +16,7 @@
 #include <light_mat/matrix/matrix_classes.h>
 #include <light_mat/matexpr/subs_expr.h>
 #include <light_mat/matexpr/mat_zip.h>
+#include <light_mat/common/exec.h>
 
 #include <functional>
 #include <algorithm>
@@ -224,6 +225,43 @@ namespace lmat
 		colwise_gsort(a, default_sort_alg(), asc_());
 	}
 
+	// colwise (parallel)
+
+	template<class A, typename T, typename Alg, typename Compare>
+	inline void
+	colwise_gsort(const par_& p, IRegularMatrix<A, T>& a, const Alg& alg, const Compare& comp)
+	{
+		exec::parallel_for(range(0, a.ncolumns()), p.col_grain(a.nrows()), [&](const range& cols)
+		{
+			for (index_t j = cols.begin_index(); j < cols.end_index(); ++j)
+				alg.sort(a.col_begin(j), a.col_end(j), comp);
+		});
+	}
+
+	template<class A, typename T, typename Alg>
+	inline void colwise_gsort(const par_& p, IRegularMatrix<A, T>& a, const Alg& alg, asc_)
+	{
+		colwise_gsort(p, a, alg, std::less<T>());
+	}
+
+	template<class A, typename T, typename Alg>
+	inline void colwise_gsort(const par_& p, IRegularMatrix<A, T>& a, const Alg& alg, desc_)
+	{
+		colwise_gsort(p, a, alg, std::greater<T>());
+	}
+
+	template<class A, typename T, typename Spec>
+	inline void colwise_sort(const par_& p, IRegularMatrix<A, T>& a, const Spec& s)
+	{
+		colwise_gsort(p, a, default_sort_alg(), s);
+	}
+
+	template<class A, typename T>
+	inline void colwise_sort(const par_& p, IRegularMatrix<A, T>& a)
+	{
+		colwise_gsort(p, a, default_sort_alg(), asc_());
+	}
+
 
 	/********************************************
 	 *
@@ -307,6 +307,36 @@ namespace lmat
 		return type(wrap.arg());
 	}
 
+	namespace internal
+	{
+		// presents a vector accessor as the only column of a multi-column one
+
+		template<class Acc>
+		class single_col_accessor
+		{
+		public:
+			LMAT_ENSURE_INLINE
+			explicit single_col_accessor(const Acc& acc)
+			: m_acc(acc) { }
+
+			LMAT_ENSURE_INLINE
+			const Acc& col(index_t ) const
+			{
+				return m_acc;
+			}
+
+		private:
+			Acc m_acc;
+		};
+
+		template<class Acc>
+		LMAT_ENSURE_INLINE
+		inline single_col_accessor<Acc> as_single_col(const Acc& acc)
+		{
+			return single_col_accessor<Acc>(acc);
+		}
+	}
+
 
 	/********************************************
 	 *
@@ -65,8 +65,84 @@ namespace lmat
 
 		LMAT_ENSURE_INLINE
 		nil_t finalize() const { return nil_t(); }
+
+		// streaming mode (see _linear_ewise_eval): readers may prefetch
+		// ahead, and writers may commit packs with non-temporal stores
+
+		LMAT_ENSURE_INLINE
+		nil_t prefetch(index_t ) const { return nil_t(); }
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_nt(index_t ) const { return nil_t(); }
+
+		// partial packs (see _linear_ewise_eval): accessors with
+		// supports_part provide pack_part(i, k), which accesses only
+		// the first k elements of the pack at i, committed with
+		// done_pack_part(i, k)
+
+		static const bool supports_part = false;
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_part(index_t, index_t ) const { return nil_t(); }
+
+		// aligned packs (see _linear_ewise_eval): accessors with
+		// supports_align report pack_offset(), the offset in bytes of
+		// the first element from the preceding pack boundary (or
+		// any_pack_offset if they do not access memory), and provide
+		// pack_a(i), committed with done_pack_a(i), for packs at
+		// aligned addresses
+
+		static const bool supports_align = false;
+
+		LMAT_ENSURE_INLINE
+		index_t pack_offset() const { return internal::any_pack_offset; }
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_a(index_t ) const { return nil_t(); }
 	};
 
+	namespace internal
+	{
+		template<typename... Accessors>
+		struct supports_part_packs
+		{
+			static const bool value =
+					meta::all_<meta::bool_<Accessors::supports_part>...>::value;
+		};
+
+		template<typename... Accessors>
+		struct supports_aligned_packs
+		{
+			static const bool value =
+					meta::all_<meta::bool_<Accessors::supports_align>...>::value;
+		};
+
+		template<typename T, typename Kind>
+		LMAT_ENSURE_INLINE
+		inline index_t pack_offset_of(const T *p)
+		{
+			return static_cast<index_t>(
+					reinterpret_cast<size_t>(p) % sizeof(simd_pack<T, Kind>));
+		}
+
+		// the offset shared by all the accessors, or mixed_pack_offset
+
+		LMAT_ENSURE_INLINE
+		inline index_t common_pack_offset(index_t a)
+		{
+			return a;
+		}
+
+		template<typename... Rest>
+		LMAT_ENSURE_INLINE
+		inline index_t common_pack_offset(index_t a, index_t b, Rest... rest)
+		{
+			const index_t c = a == any_pack_offset ? b :
+					(b == any_pack_offset || b == a ? a : mixed_pack_offset);
+			return common_pack_offset(c, rest...);
+		}
+	}
+
 
 	/********************************************
 	 *
@@ -113,12 +189,45 @@ namespace lmat
 			return m_pdata[i];
 		}
 
+		static const bool supports_part = true;
+
 		LMAT_ENSURE_INLINE
 		pack_type pack(index_t i) const
 		{
 			return pack_type(m_pdata + i);
 		}
 
+		LMAT_ENSURE_INLINE
+		pack_type pack_part(index_t i, index_t k) const
+		{
+			pack_type pk;
+			pk.load_part(k, m_pdata + i);
+			return pk;
+		}
+
+		static const bool supports_align = true;
+
+		LMAT_ENSURE_INLINE
+		index_t pack_offset() const
+		{
+			return internal::pack_offset_of<T, Kind>(m_pdata);
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_type pack_a(index_t i) const
+		{
+			pack_type pk;
+			pk.load_a(m_pdata + i);
+			return pk;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t prefetch(index_t i) const
+		{
+			_mm_prefetch(reinterpret_cast<const char*>(m_pdata + i), _MM_HINT_T0);
+			return nil_t();
+		}
+
 	private:
 		const T* m_pdata;
 	};
@@ -148,6 +257,52 @@ namespace lmat
 	};
 
 
+	template<typename T, typename Kind>
+	class stepvec_reader<T, simd_<Kind> > : public simd_vec_accessor_base
+	{
+	public:
+		typedef T scalar_type;
+		typedef Kind simd_kind;
+		typedef simd_pack<T, Kind> pack_type;
+
+		LMAT_ENSURE_INLINE
+		explicit stepvec_reader(const T* p, index_t step)
+		: m_pdata(p), m_step(step) { }
+
+		LMAT_ENSURE_INLINE
+		T scalar(index_t i) const
+		{
+			return m_pdata[i * m_step];
+		}
+
+		static const bool supports_part = true;
+
+		LMAT_ENSURE_INLINE
+		pack_type pack(index_t i) const
+		{
+			pack_type pk;
+			pk.load_strided(m_pdata + i * m_step, m_step);
+			return pk;
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_type pack_part(index_t i, index_t k) const
+		{
+			T buf[pack_type::pack_width];
+			const T *p = m_pdata + i * m_step;
+			for (index_t j = 0; j < k; ++j) buf[j] = p[j * m_step];
+
+			pack_type pk;
+			pk.load_part(k, buf);
+			return pk;
+		}
+
+	private:
+		const T* m_pdata;
+		index_t m_step;
+	};
+
+
 	// single_reader
 
 	template<typename T>
@@ -189,12 +344,28 @@ namespace lmat
 			return m_val;
 		}
 
+		static const bool supports_part = true;
+
 		LMAT_ENSURE_INLINE
 		pack_type pack(index_t ) const
 		{
 			return m_pack;
 		}
 
+		LMAT_ENSURE_INLINE
+		pack_type pack_part(index_t, index_t ) const
+		{
+			return m_pack;
+		}
+
+		static const bool supports_align = true;
+
+		LMAT_ENSURE_INLINE
+		pack_type pack_a(index_t ) const
+		{
+			return m_pack;
+		}
+
 	private:
 		pack_type m_pack;
 		T m_val;
@@ -362,6 +533,55 @@ namespace lmat
 			return nil_t();
 		}
 
+		// the packs are aligned after peeling (see _linear_ewise_eval),
+		// even if the vector itself is not
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_nt(index_t i) const
+		{
+			if (internal::pack_offset_of<T, Kind>(m_pdata + i) == 0)
+				m_ptemp.store_nt(m_pdata + i);
+			else
+				m_ptemp.store_u(m_pdata + i);
+			return nil_t();
+		}
+
+		static const bool supports_part = true;
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack_part(index_t, index_t ) const
+		{
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_part(index_t i, index_t k) const
+		{
+			m_ptemp.store_part(k, m_pdata + i);
+			return nil_t();
+		}
+
+		static const bool supports_align = true;
+
+		LMAT_ENSURE_INLINE
+		index_t pack_offset() const
+		{
+			return internal::pack_offset_of<T, Kind>(m_pdata);
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack_a(index_t) const
+		{
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_a(index_t i) const
+		{
+			m_ptemp.store_a(m_pdata + i);
+			return nil_t();
+		}
+
 	private:
 		mutable pack_type m_ptemp;
 		mutable T m_stemp;
@@ -400,6 +620,77 @@ namespace lmat
 	};
 
 
+	template<typename T, typename Kind>
+	class stepvec_writer<T, simd_<Kind> > : public simd_vec_accessor_base
+	{
+	public:
+		typedef T scalar_type;
+		typedef Kind simd_kind;
+		typedef simd_pack<T, Kind> pack_type;
+
+		LMAT_ENSURE_INLINE
+		explicit stepvec_writer(T* p, index_t step)
+		: m_pdata(p), m_step(step) { }
+
+		LMAT_ENSURE_INLINE
+		T& scalar(index_t) const
+		{
+			return m_stemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack(index_t) const
+		{
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_scalar(index_t i) const
+		{
+			m_pdata[i * m_step] = m_stemp;
+			return nil_t();
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack(index_t i) const
+		{
+			m_ptemp.store_strided(m_pdata + i * m_step, m_step);
+			return nil_t();
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_nt(index_t i) const
+		{
+			return done_pack(i);
+		}
+
+		static const bool supports_part = true;
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack_part(index_t, index_t ) const
+		{
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_part(index_t i, index_t k) const
+		{
+			T buf[pack_type::pack_width];
+			m_ptemp.store_u(buf);
+
+			T *p = m_pdata + i * m_step;
+			for (index_t j = 0; j < k; ++j) p[j * m_step] = buf[j];
+			return nil_t();
+		}
+
+	private:
+		mutable pack_type m_ptemp;
+		mutable T m_stemp;
+		T* m_pdata;
+		index_t m_step;
+	};
+
+
 
 	/********************************************
 	 *
@@ -553,6 +844,60 @@ namespace lmat
 			return nil_t();
 		}
 
+		LMAT_ENSURE_INLINE
+		nil_t prefetch(index_t i) const
+		{
+			_mm_prefetch(reinterpret_cast<const char*>(m_pdata + i), _MM_HINT_T0);
+			return nil_t();
+		}
+
+		// the destination has been read into cache, so that
+		// a non-temporal store would not save any traffic
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_nt(index_t i) const
+		{
+			return done_pack(i);
+		}
+
+		static const bool supports_part = true;
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack_part(index_t i, index_t k) const
+		{
+			m_ptemp.load_part(k, m_pdata + i);
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_part(index_t i, index_t k) const
+		{
+			m_ptemp.store_part(k, m_pdata + i);
+			return nil_t();
+		}
+
+		static const bool supports_align = true;
+
+		LMAT_ENSURE_INLINE
+		index_t pack_offset() const
+		{
+			return internal::pack_offset_of<T, Kind>(m_pdata);
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack_a(index_t i) const
+		{
+			m_ptemp.load_a(m_pdata + i);
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_a(index_t i) const
+		{
+			m_ptemp.store_a(m_pdata + i);
+			return nil_t();
+		}
+
 	private:
 		mutable pack_type m_ptemp;
 		mutable T m_stemp;
@@ -591,6 +936,83 @@ namespace lmat
 	};
 
 
+	template<typename T, typename Kind>
+	class stepvec_updater<T, simd_<Kind> > : public simd_vec_accessor_base
+	{
+	public:
+		typedef T scalar_type;
+		typedef Kind simd_kind;
+		typedef simd_pack<T, Kind> pack_type;
+
+		LMAT_ENSURE_INLINE
+		explicit stepvec_updater(T* p, index_t step)
+		: m_pdata(p), m_step(step) { }
+
+		LMAT_ENSURE_INLINE
+		T& scalar(index_t i) const
+		{
+			return m_stemp = m_pdata[i * m_step];
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack(index_t i) const
+		{
+			m_ptemp.load_strided(m_pdata + i * m_step, m_step);
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_scalar(index_t i) const
+		{
+			m_pdata[i * m_step] = m_stemp;
+			return nil_t();
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack(index_t i) const
+		{
+			m_ptemp.store_strided(m_pdata + i * m_step, m_step);
+			return nil_t();
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_nt(index_t i) const
+		{
+			return done_pack(i);
+		}
+
+		static const bool supports_part = true;
+
+		LMAT_ENSURE_INLINE
+		pack_type& pack_part(index_t i, index_t k) const
+		{
+			T buf[pack_type::pack_width];
+			const T *p = m_pdata + i * m_step;
+			for (index_t j = 0; j < k; ++j) buf[j] = p[j * m_step];
+
+			m_ptemp.load_part(k, buf);
+			return m_ptemp;
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t done_pack_part(index_t i, index_t k) const
+		{
+			T buf[pack_type::pack_width];
+			m_ptemp.store_u(buf);
+
+			T *p = m_pdata + i * m_step;
+			for (index_t j = 0; j < k; ++j) p[j * m_step] = buf[j];
+			return nil_t();
+		}
+
+	private:
+		mutable pack_type m_ptemp;
+		mutable T m_stemp;
+		T* m_pdata;
+		index_t m_step;
+	};
+
+
 	/********************************************
 	 *
 	 *  updater maps
@@ -0,0 +1,456 @@
+/**
+ * @file bcast_tile_eval.h
+ *
+ * @brief Tiled evaluation of expressions over short broadcasts
+ *
+ * Expressions over repcol (or reprow) do not support linear access,
+ * and are thus evaluated column by column. For short columns (e.g.
+ * adding a bias to each of many 3-vectors), this leaves little work
+ * to the packs and pays the per-column overhead every few elements.
+ *
+ * When the other matrices in the expression and the destination are
+ * all contiguous, such an expression is instead evaluated in tiles of
+ * k columns, each as a single contiguous vector of k * m elements:
+ *
+ *  - repcol(v, n) reads a buffer holding v repeated k times, which is
+ *    filled once for the whole evaluation;
+ *
+ *  - reprow(w, m) reads a buffer holding each of k elements of w
+ *    repeated m times, which is refilled for each tile;
+ *
+ *  - the other matrices are read in place.
+ *
+ * A tile has at most LMAT_BCAST_TILE_LEN elements, such that the
+ * buffers stay in L1 and the repeated vectors are never expanded to
+ * the size of the result. Tiles are used when the columns are shorter
+ * than LMAT_BCAST_TILE_MAXROWS, and there is more than one of them.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_BCAST_TILE_EVAL_H_
+#define LIGHTMAT_BCAST_TILE_EVAL_H_
+
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/mateval/ewise_eval.h>
+
+// columns shorter than this are evaluated in tiles
+#ifndef LMAT_BCAST_TILE_MAXROWS
+#define LMAT_BCAST_TILE_MAXROWS 32
+#endif
+
+// the maximum number of elements in a tile
+#ifndef LMAT_BCAST_TILE_LEN
+#define LMAT_BCAST_TILE_LEN 512
+#endif
+
+namespace lmat
+{
+	// forward declarations
+
+	template<typename... Args> class map_expr;
+	template<class Arg, index_t CN> class repcol_expr;
+	template<class Arg, index_t CM> class reprow_expr;
+
+	namespace internal
+	{
+
+		/********************************************
+		 *
+		 *  tiling flags
+		 *
+		 ********************************************/
+
+		template<class Mat, bool IsRegular=meta::is_regular_mat<Mat>::value>
+		struct _bcast_tile_inplace : public meta::false_ { };
+
+		template<class Mat>
+		struct _bcast_tile_inplace<Mat, true> : public meta::is_contiguous<Mat> { };
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct bcast_tile_flags
+		{
+			static const bool ok = _bcast_tile_inplace<Expr>::value;
+			static const bool has_bcast = false;
+		};
+
+		template<typename T>
+		struct bcast_tile_flags<T, false>
+		{
+			static const bool ok = true;
+			static const bool has_bcast = false;
+		};
+
+		template<class Arg, index_t CN>
+		struct bcast_tile_flags<repcol_expr<Arg, CN>, true>
+		{
+			static const bool ok = true;
+			static const bool has_bcast = true;
+		};
+
+		template<class Arg, index_t CM>
+		struct bcast_tile_flags<reprow_expr<Arg, CM>, true>
+		{
+			static const bool ok = true;
+			static const bool has_bcast = true;
+		};
+
+		template<class Expr>
+		struct _bcast_tile_ok : public meta::bool_<bcast_tile_flags<Expr>::ok> { };
+
+		template<class Expr>
+		struct _bcast_tile_has : public meta::bool_<bcast_tile_flags<Expr>::has_bcast> { };
+
+		template<typename FTag, typename... Args>
+		struct bcast_tile_flags<map_expr<FTag, Args...>, true>
+		{
+			static const bool ok = meta::all_<_bcast_tile_ok<Args>...>::value;
+			static const bool has_bcast = meta::any_<_bcast_tile_has<Args>...>::value;
+		};
+
+		template<class Expr, class DMat>
+		struct bcast_tileable
+		{
+			typedef bcast_tile_flags<Expr> f;
+
+			static const bool value = f::ok && f::has_bcast &&
+					_bcast_tile_inplace<DMat>::value;
+		};
+
+		// the number of columns in a tile (0 if the columns are too
+		// long), chosen such that a tile is a multiple of 16 elements
+		// whenever possible, which keeps the tiles equally aligned
+
+		inline index_t bcast_tile_ncols(index_t m)
+		{
+			if (m <= 0 || m >= LMAT_BCAST_TILE_MAXROWS) return 0;
+
+			index_t a = m, b = 16;
+			while (b > 0)
+			{
+				index_t r = a % b;
+				a = b;
+				b = r;
+			}
+
+			index_t k0 = 16 / a;
+			if (k0 * m > LMAT_BCAST_TILE_LEN) k0 = 1;
+
+			return (LMAT_BCAST_TILE_LEN / (k0 * m)) * k0;
+		}
+
+
+		/********************************************
+		 *
+		 *  tile stores
+		 *
+		 *  the buffers kept across tiles
+		 *
+		 ********************************************/
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct bcast_tile_store : private noncopyable
+		{
+			LMAT_ENSURE_INLINE
+			bcast_tile_store(const Expr&, index_t) { }
+		};
+
+		template<class Arg, index_t CN>
+		struct bcast_tile_store<repcol_expr<Arg, CN>, true> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Arg>::type T;
+
+			bcast_tile_store(const repcol_expr<Arg, CN>& e, index_t k)
+			: buf(e.nrows() * k)
+			{
+				const Arg& a = e.arg();
+				const index_t m = a.nrows();
+
+				T *b = buf.ptr_data();
+				for (index_t i = 0; i < m; ++i) b[i] = a(i, 0);
+				for (index_t j = 1; j < k; ++j) copy_vec(m, b, b + j * m);
+			}
+
+			dense_col<T> buf;
+		};
+
+		template<class Arg, index_t CM>
+		struct bcast_tile_store<reprow_expr<Arg, CM>, true> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Arg>::type T;
+
+			bcast_tile_store(const reprow_expr<Arg, CM>& e, index_t k)
+			: buf(e.nrows() * k + 8) { }
+
+			dense_col<T> buf;
+		};
+
+		template<typename FTag, typename A1>
+		struct bcast_tile_store<map_expr<FTag, A1>, true> : private noncopyable
+		{
+			bcast_tile_store(const map_expr<FTag, A1>& e, index_t k)
+			: s1(e.arg1(), k) { }
+
+			bcast_tile_store<A1> s1;
+		};
+
+		template<typename FTag, typename A1, typename A2>
+		struct bcast_tile_store<map_expr<FTag, A1, A2>, true> : private noncopyable
+		{
+			bcast_tile_store(const map_expr<FTag, A1, A2>& e, index_t k)
+			: s1(e.arg1(), k), s2(e.arg2(), k) { }
+
+			bcast_tile_store<A1> s1;
+			bcast_tile_store<A2> s2;
+		};
+
+		template<typename FTag, typename A1, typename A2, typename A3>
+		struct bcast_tile_store<map_expr<FTag, A1, A2, A3>, true> : private noncopyable
+		{
+			bcast_tile_store(const map_expr<FTag, A1, A2, A3>& e, index_t k)
+			: s1(e.arg1(), k), s2(e.arg2(), k), s3(e.arg3(), k) { }
+
+			bcast_tile_store<A1> s1;
+			bcast_tile_store<A2> s2;
+			bcast_tile_store<A3> s3;
+		};
+
+
+		/********************************************
+		 *
+		 *  tile views
+		 *
+		 *  the expression on the k columns from j0,
+		 *  as a contiguous column of k * m elements
+		 *
+		 ********************************************/
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct bcast_tile_view : private noncopyable
+		{
+			typedef typename meta::value_type_of<Expr>::type T;
+			typedef cref_matrix<T, 0, 1> type;
+
+			LMAT_ENSURE_INLINE
+			bcast_tile_view(const Expr& a, bcast_tile_store<Expr>&, index_t j0, index_t k)
+			: m_e(a.ptr_data() + j0 * a.nrows(), a.nrows() * k, 1) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			type m_e;
+		};
+
+		template<typename T>
+		struct bcast_tile_view<T, false> : private noncopyable
+		{
+			typedef T type;
+
+			LMAT_ENSURE_INLINE
+			bcast_tile_view(const T& v, bcast_tile_store<T>&, index_t, index_t)
+			: m_v(v) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_v; }
+
+		private:
+			T m_v;
+		};
+
+		template<class Arg, index_t CN>
+		struct bcast_tile_view<repcol_expr<Arg, CN>, true> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Arg>::type T;
+			typedef cref_matrix<T, 0, 1> type;
+
+			LMAT_ENSURE_INLINE
+			bcast_tile_view(const repcol_expr<Arg, CN>& e,
+					bcast_tile_store<repcol_expr<Arg, CN> >& s, index_t, index_t k)
+			: m_e(s.buf.ptr_data(), e.nrows() * k, 1) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			type m_e;
+		};
+
+		template<class Arg, index_t CM>
+		struct bcast_tile_view<reprow_expr<Arg, CM>, true> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Arg>::type T;
+			typedef cref_matrix<T, 0, 1> type;
+
+			LMAT_ENSURE_INLINE
+			bcast_tile_view(const reprow_expr<Arg, CM>& e,
+					bcast_tile_store<reprow_expr<Arg, CM> >& s, index_t j0, index_t k)
+			: m_e(fill(e, s.buf.ptr_data(), j0, k), e.nrows() * k, 1) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			static const T* fill(const reprow_expr<Arg, CM>& e, T *buf, index_t j0, index_t k)
+			{
+				const Arg& a = e.arg();
+				const index_t m = e.nrows();
+
+				if (m == 1)
+				{
+					for (index_t j = 0; j < k; ++j) buf[j] = a(0, j0 + j);
+				}
+				else if (m <= 4)
+				{
+					// very short columns are written in steps of 4,
+					// spilling over to the next column
+
+					for (index_t j = 0; j < k; ++j)
+					{
+						const T v = a(0, j0 + j);
+						T *b = buf + j * m;
+						for (index_t u = 0; u < 4; ++u) b[u] = v;
+					}
+				}
+				else
+				{
+					// each column is written in whole steps of 8 (which
+					// are unrolled), spilling over to the next column
+					// (or to the spare elements at the end)
+
+					for (index_t j = 0; j < k; ++j)
+					{
+						const T v = a(0, j0 + j);
+						T *b = buf + j * m;
+						for (index_t i = 0; i < m; i += 8)
+						{
+							for (index_t u = 0; u < 8; ++u) b[i + u] = v;
+						}
+					}
+				}
+				return buf;
+			}
+
+			type m_e;
+		};
+
+		template<typename FTag, typename A1>
+		struct bcast_tile_view<map_expr<FTag, A1>, true> : private noncopyable
+		{
+			typedef bcast_tile_view<A1> v1_t;
+			typedef map_expr<FTag, typename v1_t::type> type;
+
+			bcast_tile_view(const map_expr<FTag, A1>& e,
+					bcast_tile_store<map_expr<FTag, A1> >& s, index_t j0, index_t k)
+			: m_v1(e.arg1(), s.s1, j0, k), m_e(FTag(), m_v1.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			v1_t m_v1;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2>
+		struct bcast_tile_view<map_expr<FTag, A1, A2>, true> : private noncopyable
+		{
+			typedef bcast_tile_view<A1> v1_t;
+			typedef bcast_tile_view<A2> v2_t;
+			typedef map_expr<FTag, typename v1_t::type, typename v2_t::type> type;
+
+			bcast_tile_view(const map_expr<FTag, A1, A2>& e,
+					bcast_tile_store<map_expr<FTag, A1, A2> >& s, index_t j0, index_t k)
+			: m_v1(e.arg1(), s.s1, j0, k), m_v2(e.arg2(), s.s2, j0, k)
+			, m_e(FTag(), m_v1.get(), m_v2.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			v1_t m_v1;
+			v2_t m_v2;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2, typename A3>
+		struct bcast_tile_view<map_expr<FTag, A1, A2, A3>, true> : private noncopyable
+		{
+			typedef bcast_tile_view<A1> v1_t;
+			typedef bcast_tile_view<A2> v2_t;
+			typedef bcast_tile_view<A3> v3_t;
+			typedef map_expr<FTag, typename v1_t::type, typename v2_t::type, typename v3_t::type> type;
+
+			bcast_tile_view(const map_expr<FTag, A1, A2, A3>& e,
+					bcast_tile_store<map_expr<FTag, A1, A2, A3> >& s, index_t j0, index_t k)
+			: m_v1(e.arg1(), s.s1, j0, k), m_v2(e.arg2(), s.s2, j0, k), m_v3(e.arg3(), s.s3, j0, k)
+			, m_e(FTag(), m_v1.get(), m_v2.get(), m_v3.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			v1_t m_v1;
+			v2_t m_v2;
+			v3_t m_v3;
+			type m_e;
+		};
+
+
+		/********************************************
+		 *
+		 *  tiled evaluation
+		 *
+		 ********************************************/
+
+		template<class Expr, class DMat>
+		inline void bcast_tile_evaluate(const Expr& e, DMat& d, index_t k)
+		{
+			typedef typename meta::value_type_of<DMat>::type T;
+
+			const index_t m = e.nrows();
+			const index_t n = e.ncolumns();
+
+			bcast_tile_store<Expr> s(e, k);
+			T *pd = d.ptr_data();
+
+			for (index_t j = 0; j < n; j += k)
+			{
+				const index_t kj = k < n - j ? k : n - j;
+
+				bcast_tile_view<Expr> v(e, s, j, kj);
+				ref_matrix<T, 0, 1> dj(pd + j * m, m * kj, 1);
+				macc_evaluate(v.get(), dj);
+			}
+		}
+
+		template<class Expr, class DMat>
+		LMAT_ENSURE_INLINE
+		inline bool _try_bcast_tiles(const Expr&, DMat&, meta::false_)
+		{
+			return false;
+		}
+
+		template<class Expr, class DMat>
+		inline bool _try_bcast_tiles(const Expr& e, DMat& d, meta::true_)
+		{
+			const index_t k = bcast_tile_ncols(e.nrows());
+
+			if (k > 0 && e.ncolumns() > 1)
+			{
+				LMAT_INSTRUMENT_VARIANT("ewise.bcast_tiles")
+				bcast_tile_evaluate(e, d, k);
+				return true;
+			}
+			return false;
+		}
+
+		// returns whether e has been evaluated to d in tiles
+
+		template<class Expr, class DMat>
+		LMAT_ENSURE_INLINE
+		inline bool try_bcast_tiles(const Expr& e, DMat& d)
+		{
+			return _try_bcast_tiles(e, d, meta::bool_<bcast_tileable<Expr, DMat>::value>());
+		}
+	}
+}
+
+#endif /* BCAST_TILE_EVAL_H_ */
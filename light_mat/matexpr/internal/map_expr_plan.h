@@ -0,0 +1,515 @@
+/**
+ * @file map_expr_plan.h
+ *
+ * @brief Evaluation planning of map expressions
+ *
+ * A map expression is evaluated in a single fused loop, which
+ * recomputes a sub-expression over broadcast arguments, such as
+ * exp(repcol(v, n)), for every repetition. The planner finds the
+ * maximal sub-expressions that depend on broadcast arguments only
+ * (all repcol or all reprow), and whose cost (the sum of fun_cost over
+ * their functions) is at least LMAT_MATERIALIZE_COST. Each of them is
+ * evaluated once on the underlying vector into a scratch buffer, and
+ * the fused loop then reads the buffer through repcol (or reprow), as
+ * exp(repcol(v, n)) * a is evaluated as repcol(exp(v), n) * a.
+ *
+ * The plan is applied only when the result actually repeats the
+ * vectors (i.e. it has more than one column for repcol, or more than
+ * one row for reprow). Expressions without such sub-expressions are
+ * evaluated as before without any overhead.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_MAP_EXPR_PLAN_H_
+#define LIGHTMAT_MAP_EXPR_PLAN_H_
+
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/math/fun_costs.h>
+
+#include "bcast_tile_eval.h"
+#include "shared_block_eval.h"
+
+// minimum cost of a broadcast sub-expression to be materialized
+#ifndef LMAT_MATERIALIZE_COST
+#define LMAT_MATERIALIZE_COST 8
+#endif
+
+namespace lmat
+{
+	// forward declarations
+
+	template<typename... Args> class map_expr;
+	template<class Arg, index_t CN> class repcol_expr;
+	template<class Arg, index_t CM> class reprow_expr;
+
+	namespace internal
+	{
+
+		/********************************************
+		 *
+		 *  broadcast kinds & costs
+		 *
+		 ********************************************/
+
+		struct bcast_none_ { };
+		struct bcast_any_ { };		// scalars, which go with any kind
+		struct bcast_col_ { };
+		struct bcast_row_ { };
+
+		template<typename K1, typename K2>
+		struct bcast_join { typedef bcast_none_ type; };
+
+		template<typename K>
+		struct bcast_join<K, K> { typedef K type; };
+
+		template<typename K>
+		struct bcast_join<bcast_any_, K> { typedef K type; };
+
+		template<typename K>
+		struct bcast_join<K, bcast_any_> { typedef K type; };
+
+		template<>
+		struct bcast_join<bcast_any_, bcast_any_> { typedef bcast_any_ type; };
+
+		template<typename... K> struct bcast_join_all;
+
+		template<typename K>
+		struct bcast_join_all<K> { typedef K type; };
+
+		template<typename K1, typename K2, typename... R>
+		struct bcast_join_all<K1, K2, R...>
+		{
+			typedef typename bcast_join_all<typename bcast_join<K1, K2>::type, R...>::type type;
+		};
+
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct expr_bcast { typedef bcast_none_ type; };
+
+		template<typename T>
+		struct expr_bcast<T, false> { typedef bcast_any_ type; };
+
+		template<class Arg, index_t CN>
+		struct expr_bcast<repcol_expr<Arg, CN>, true> { typedef bcast_col_ type; };
+
+		template<class Arg, index_t CM>
+		struct expr_bcast<reprow_expr<Arg, CM>, true> { typedef bcast_row_ type; };
+
+		template<typename FTag, typename... Args>
+		struct expr_bcast<map_expr<FTag, Args...>, true>
+		{
+			typedef typename bcast_join_all<typename expr_bcast<Args>::type...>::type type;
+		};
+
+
+		template<typename... Args> struct _cost_sum;
+
+		template<>
+		struct _cost_sum<> { static const int value = 0; };
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct expr_cost
+		{
+			static const int value = meta::is_regular_mat<Expr>::value ? 0 : LMAT_COST_ARITH;
+		};
+
+		template<typename T>
+		struct expr_cost<T, false> { static const int value = 0; };
+
+		template<class Arg, index_t CN>
+		struct expr_cost<repcol_expr<Arg, CN>, true> { static const int value = 0; };
+
+		template<class Arg, index_t CM>
+		struct expr_cost<reprow_expr<Arg, CM>, true> { static const int value = 0; };
+
+		template<typename FTag, typename... Args>
+		struct expr_cost<map_expr<FTag, Args...>, true>
+		{
+			static const int value = fun_cost<FTag>::value + _cost_sum<Args...>::value;
+		};
+
+		template<typename A, typename... R>
+		struct _cost_sum<A, R...>
+		{
+			static const int value = expr_cost<A>::value + _cost_sum<R...>::value;
+		};
+
+
+		/********************************************
+		 *
+		 *  plan kinds
+		 *
+		 ********************************************/
+
+		struct plan_keep_ { };
+		struct plan_rewrite_ { };
+		struct plan_repcol_ { };
+		struct plan_reprow_ { };
+
+		template<class Expr>
+		struct plan_flags
+		{
+			static const bool here_col = false;
+			static const bool here_row = false;
+			static const bool mat_col = false;
+			static const bool mat_row = false;
+		};
+
+		template<class Expr>
+		struct _plan_mat_col : public meta::bool_<plan_flags<Expr>::mat_col> { };
+
+		template<class Expr>
+		struct _plan_mat_row : public meta::bool_<plan_flags<Expr>::mat_row> { };
+
+		template<typename FTag, typename... Args>
+		struct plan_flags<map_expr<FTag, Args...> >
+		{
+			typedef map_expr<FTag, Args...> expr_t;
+			typedef typename expr_bcast<expr_t>::type bk;
+
+			static const bool heavy = expr_cost<expr_t>::value >= LMAT_MATERIALIZE_COST;
+			static const bool is_bcast = !std::is_same<bk, bcast_none_>::value;
+
+			static const bool here_col = heavy && std::is_same<bk, bcast_col_>::value;
+			static const bool here_row = heavy && std::is_same<bk, bcast_row_>::value;
+
+			static const bool mat_col = here_col ||
+					(!is_bcast && meta::any_<_plan_mat_col<Args>...>::value);
+			static const bool mat_row = here_row ||
+					(!is_bcast && meta::any_<_plan_mat_row<Args>...>::value);
+		};
+
+		template<class Expr>
+		struct plan_kind
+		{
+			typedef plan_flags<Expr> f;
+
+			typedef typename meta::select_<
+					meta::bool_<f::here_col>, plan_repcol_,
+					meta::bool_<f::here_row>, plan_reprow_,
+					meta::bool_<f::mat_col || f::mat_row>, plan_rewrite_,
+					meta::otherwise_, plan_keep_>::type type;
+		};
+
+
+		/********************************************
+		 *
+		 *  broadcast sources
+		 *
+		 *  the expression on the vectors being
+		 *  repeated (in place of the broadcasts)
+		 *
+		 ********************************************/
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct bcast_source;
+
+		template<typename T>
+		struct bcast_source<T, false> : private noncopyable
+		{
+			typedef T type;
+
+			LMAT_ENSURE_INLINE
+			explicit bcast_source(const T& v) : m_v(v) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_v; }
+
+		private:
+			T m_v;
+		};
+
+		template<class Arg, index_t CN>
+		struct bcast_source<repcol_expr<Arg, CN>, true> : private noncopyable
+		{
+			typedef Arg type;
+
+			LMAT_ENSURE_INLINE
+			explicit bcast_source(const repcol_expr<Arg, CN>& e) : m_a(e.arg()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_a; }
+
+		private:
+			const Arg& m_a;
+		};
+
+		template<class Arg, index_t CM>
+		struct bcast_source<reprow_expr<Arg, CM>, true> : private noncopyable
+		{
+			typedef Arg type;
+
+			LMAT_ENSURE_INLINE
+			explicit bcast_source(const reprow_expr<Arg, CM>& e) : m_a(e.arg()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_a; }
+
+		private:
+			const Arg& m_a;
+		};
+
+		template<typename FTag, typename A1>
+		struct bcast_source<map_expr<FTag, A1>, true> : private noncopyable
+		{
+			typedef bcast_source<A1> s1_t;
+			typedef map_expr<FTag, typename s1_t::type> type;
+
+			explicit bcast_source(const map_expr<FTag, A1>& e)
+			: m_s1(e.arg1()), m_e(FTag(), m_s1.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			s1_t m_s1;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2>
+		struct bcast_source<map_expr<FTag, A1, A2>, true> : private noncopyable
+		{
+			typedef bcast_source<A1> s1_t;
+			typedef bcast_source<A2> s2_t;
+			typedef map_expr<FTag, typename s1_t::type, typename s2_t::type> type;
+
+			explicit bcast_source(const map_expr<FTag, A1, A2>& e)
+			: m_s1(e.arg1()), m_s2(e.arg2()), m_e(FTag(), m_s1.get(), m_s2.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			s1_t m_s1;
+			s2_t m_s2;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2, typename A3>
+		struct bcast_source<map_expr<FTag, A1, A2, A3>, true> : private noncopyable
+		{
+			typedef bcast_source<A1> s1_t;
+			typedef bcast_source<A2> s2_t;
+			typedef bcast_source<A3> s3_t;
+			typedef map_expr<FTag, typename s1_t::type, typename s2_t::type, typename s3_t::type> type;
+
+			explicit bcast_source(const map_expr<FTag, A1, A2, A3>& e)
+			: m_s1(e.arg1()), m_s2(e.arg2()), m_s3(e.arg3())
+			, m_e(FTag(), m_s1.get(), m_s2.get(), m_s3.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			s1_t m_s1;
+			s2_t m_s2;
+			s3_t m_s3;
+			type m_e;
+		};
+
+
+		/********************************************
+		 *
+		 *  planned expressions
+		 *
+		 ********************************************/
+
+		template<class Expr, typename Kind=typename plan_kind<Expr>::type>
+		struct map_plan;
+
+		template<class Expr>
+		struct map_plan<Expr, plan_keep_> : private noncopyable
+		{
+			typedef Expr type;
+
+			LMAT_ENSURE_INLINE
+			explicit map_plan(const Expr& e) : m_e(e) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			const Expr& m_e;
+		};
+
+		template<class Expr>
+		struct map_plan<Expr, plan_repcol_> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Expr>::type T;
+			typedef dense_matrix<T, meta::nrows<Expr>::value, 1> buf_t;
+			typedef repcol_expr<buf_t, meta::ncols<Expr>::value> type;
+
+			explicit map_plan(const Expr& e)
+			: m_buf(e.nrows(), 1)
+			, m_e(fill(m_buf, e), e.ncolumns()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			static const buf_t& fill(buf_t& buf, const Expr& e)
+			{
+				bcast_source<Expr> s(e);
+				evaluate(s.get(), buf);
+				return buf;
+			}
+
+			buf_t m_buf;
+			type m_e;
+		};
+
+		template<class Expr>
+		struct map_plan<Expr, plan_reprow_> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Expr>::type T;
+			typedef dense_matrix<T, 1, meta::ncols<Expr>::value> buf_t;
+			typedef reprow_expr<buf_t, meta::nrows<Expr>::value> type;
+
+			explicit map_plan(const Expr& e)
+			: m_buf(1, e.ncolumns())
+			, m_e(fill(m_buf, e), e.nrows()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			static const buf_t& fill(buf_t& buf, const Expr& e)
+			{
+				bcast_source<Expr> s(e);
+				evaluate(s.get(), buf);
+				return buf;
+			}
+
+			buf_t m_buf;
+			type m_e;
+		};
+
+		// non-expression arguments
+
+		template<typename T>
+		struct map_arg_plan : private noncopyable
+		{
+			typedef T type;
+
+			LMAT_ENSURE_INLINE
+			explicit map_arg_plan(const T& v) : m_v(v) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_v; }
+
+		private:
+			T m_v;
+		};
+
+		template<class Arg>
+		struct arg_plan
+		{
+			typedef typename meta::if_<meta::is_mat_xpr<Arg>,
+					map_plan<Arg>, map_arg_plan<Arg> >::type type;
+		};
+
+		template<typename FTag, typename A1>
+		struct map_plan<map_expr<FTag, A1>, plan_rewrite_> : private noncopyable
+		{
+			typedef typename arg_plan<A1>::type p1_t;
+			typedef map_expr<FTag, typename p1_t::type> type;
+
+			explicit map_plan(const map_expr<FTag, A1>& e)
+			: m_p1(e.arg1()), m_e(FTag(), m_p1.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			p1_t m_p1;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2>
+		struct map_plan<map_expr<FTag, A1, A2>, plan_rewrite_> : private noncopyable
+		{
+			typedef typename arg_plan<A1>::type p1_t;
+			typedef typename arg_plan<A2>::type p2_t;
+			typedef map_expr<FTag, typename p1_t::type, typename p2_t::type> type;
+
+			explicit map_plan(const map_expr<FTag, A1, A2>& e)
+			: m_p1(e.arg1()), m_p2(e.arg2()), m_e(FTag(), m_p1.get(), m_p2.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			p1_t m_p1;
+			p2_t m_p2;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2, typename A3>
+		struct map_plan<map_expr<FTag, A1, A2, A3>, plan_rewrite_> : private noncopyable
+		{
+			typedef typename arg_plan<A1>::type p1_t;
+			typedef typename arg_plan<A2>::type p2_t;
+			typedef typename arg_plan<A3>::type p3_t;
+			typedef map_expr<FTag, typename p1_t::type, typename p2_t::type, typename p3_t::type> type;
+
+			explicit map_plan(const map_expr<FTag, A1, A2, A3>& e)
+			: m_p1(e.arg1()), m_p2(e.arg2()), m_p3(e.arg3())
+			, m_e(FTag(), m_p1.get(), m_p2.get(), m_p3.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			p1_t m_p1;
+			p2_t m_p2;
+			p3_t m_p3;
+			type m_e;
+		};
+
+
+		/********************************************
+		 *
+		 *  planned evaluation
+		 *
+		 ********************************************/
+
+		// short columns over broadcasts are evaluated in tiles
+		// (see bcast_tile_eval.h), and expressions with shared
+		// sub-expressions in blocks (see shared_block_eval.h)
+
+		template<class Expr, class DMat>
+		LMAT_ENSURE_INLINE
+		inline void _bcast_evaluate(const Expr& e, DMat& d)
+		{
+			if (!try_shared_blocks(e, d) && !try_bcast_tiles(e, d))
+			{
+				macc_evaluate(e, d);
+			}
+		}
+
+		template<class Expr, class DMat>
+		LMAT_ENSURE_INLINE
+		inline void _plan_evaluate(const Expr& e, DMat& d, meta::false_)
+		{
+			_bcast_evaluate(e, d);
+		}
+
+		template<class Expr, class DMat>
+		inline void _plan_evaluate(const Expr& e, DMat& d, meta::true_)
+		{
+			typedef plan_flags<Expr> f;
+
+			if ((f::mat_col && e.ncolumns() > 1) || (f::mat_row && e.nrows() > 1))
+			{
+				map_plan<Expr> p(e);
+				_bcast_evaluate(p.get(), d);
+			}
+			else
+			{
+				_bcast_evaluate(e, d);
+			}
+		}
+
+		template<class Expr, class DMat>
+		LMAT_ENSURE_INLINE
+		inline void plan_evaluate(const Expr& e, DMat& d)
+		{
+			typedef plan_flags<Expr> f;
+			_plan_evaluate(e, d, meta::bool_<f::mat_col || f::mat_row>());
+		}
+	}
+}
+
+#endif /* MAP_EXPR_PLAN_H_ */
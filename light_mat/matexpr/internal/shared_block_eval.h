@@ -0,0 +1,411 @@
+/**
+ * @file shared_block_eval.h
+ *
+ * @brief Blocked evaluation of expressions with shared sub-expressions
+ *
+ * An expression that contains shared_(e) is evaluated in blocks of at
+ * most LMAT_SHARED_BLOCK_LEN elements (within a column, or over the
+ * whole matrix when everything is contiguous). For each block:
+ *
+ *  - each distinct shared sub-expression (identified by its address)
+ *    is evaluated once into a buffer on the stack, which stays in L1;
+ *
+ *  - all of its occurrences then read that buffer, and the other
+ *    matrices are read in place, in a single fused pass.
+ *
+ * The buffers belong to the evaluation, so nothing is cached in the
+ * expression, and an expression may be evaluated from multiple threads
+ * at the same time. This applies when the other matrices in the
+ * expression and the destination are all percol-contiguous, otherwise
+ * shared_(e) simply reads e.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_SHARED_BLOCK_EVAL_H_
+#define LIGHTMAT_SHARED_BLOCK_EVAL_H_
+
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/mateval/ewise_eval.h>
+
+// the maximum number of elements in a block
+#ifndef LMAT_SHARED_BLOCK_LEN
+#define LMAT_SHARED_BLOCK_LEN 256
+#endif
+
+namespace lmat
+{
+	// forward declarations
+
+	template<typename... Args> class map_expr;
+	template<class Arg> class shared_expr;
+
+	namespace internal
+	{
+
+		/********************************************
+		 *
+		 *  blocking flags
+		 *
+		 ********************************************/
+
+		template<class Mat, bool IsRegular=meta::is_regular_mat<Mat>::value>
+		struct _shared_block_inplace
+		{
+			static const bool percol = false;
+			static const bool linear = false;
+		};
+
+		template<class Mat>
+		struct _shared_block_inplace<Mat, true>
+		{
+			static const bool percol = meta::is_percol_contiguous<Mat>::value;
+			static const bool linear = meta::is_contiguous<Mat>::value;
+		};
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct shared_block_flags
+		{
+			static const bool ok = _shared_block_inplace<Expr>::percol;
+			static const bool linear = _shared_block_inplace<Expr>::linear;
+			static const bool has_shared = false;
+		};
+
+		template<typename T>
+		struct shared_block_flags<T, false>
+		{
+			static const bool ok = true;
+			static const bool linear = true;
+			static const bool has_shared = false;
+		};
+
+		template<class Arg>
+		struct shared_block_flags<shared_expr<Arg>, true>
+		{
+			static const bool ok = shared_block_flags<Arg>::ok;
+			static const bool linear = shared_block_flags<Arg>::linear;
+			static const bool has_shared = true;
+		};
+
+		template<class Expr>
+		struct _shared_block_ok : public meta::bool_<shared_block_flags<Expr>::ok> { };
+
+		template<class Expr>
+		struct _shared_block_linear : public meta::bool_<shared_block_flags<Expr>::linear> { };
+
+		template<class Expr>
+		struct _shared_block_has : public meta::bool_<shared_block_flags<Expr>::has_shared> { };
+
+		template<typename FTag, typename... Args>
+		struct shared_block_flags<map_expr<FTag, Args...>, true>
+		{
+			static const bool ok = meta::all_<_shared_block_ok<Args>...>::value;
+			static const bool linear = meta::all_<_shared_block_linear<Args>...>::value;
+			static const bool has_shared = meta::any_<_shared_block_has<Args>...>::value;
+		};
+
+		template<class Expr, class DMat>
+		struct shared_blockable
+		{
+			typedef shared_block_flags<Expr> f;
+
+			static const bool value = f::ok && f::has_shared &&
+					_shared_block_inplace<DMat>::percol;
+
+			static const bool linear = f::linear &&
+					_shared_block_inplace<DMat>::linear;
+		};
+
+
+		/********************************************
+		 *
+		 *  block stores
+		 *
+		 *  the buffers kept across blocks, one for
+		 *  each distinct shared sub-expression
+		 *
+		 ********************************************/
+
+		struct shared_block_link
+		{
+			const void *key;
+			const void *buf;
+			const shared_block_link *next;
+		};
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct shared_block_store : private noncopyable
+		{
+			LMAT_ENSURE_INLINE
+			shared_block_store(const Expr&, const shared_block_link*&) { }
+		};
+
+		template<class Arg>
+		struct shared_block_store<shared_expr<Arg>, true> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Arg>::type T;
+
+			// the argument is registered before the expression itself,
+			// such that nested shared sub-expressions are filled first
+
+			shared_block_store(const shared_expr<Arg>& e, const shared_block_link*& head)
+			: s(e.arg(), head), owner(true)
+			{
+				link.key = &e;
+				link.buf = buf;
+				link.next = head;
+
+				for (const shared_block_link *p = head; p; p = p->next)
+				{
+					if (p->key == &e)
+					{
+						link.buf = p->buf;
+						owner = false;
+						break;
+					}
+				}
+
+				if (owner) head = &link;
+			}
+
+			LMAT_ENSURE_INLINE T *data()
+			{
+				return static_cast<T*>(const_cast<void*>(link.buf));
+			}
+
+			shared_block_store<Arg> s;
+			shared_block_link link;
+			bool owner;
+			LMAT_ALIGN_AVX T buf[LMAT_SHARED_BLOCK_LEN];
+		};
+
+		template<typename FTag, typename A1>
+		struct shared_block_store<map_expr<FTag, A1>, true> : private noncopyable
+		{
+			shared_block_store(const map_expr<FTag, A1>& e, const shared_block_link*& head)
+			: s1(e.arg1(), head) { }
+
+			shared_block_store<A1> s1;
+		};
+
+		template<typename FTag, typename A1, typename A2>
+		struct shared_block_store<map_expr<FTag, A1, A2>, true> : private noncopyable
+		{
+			shared_block_store(const map_expr<FTag, A1, A2>& e, const shared_block_link*& head)
+			: s1(e.arg1(), head), s2(e.arg2(), head) { }
+
+			shared_block_store<A1> s1;
+			shared_block_store<A2> s2;
+		};
+
+		template<typename FTag, typename A1, typename A2, typename A3>
+		struct shared_block_store<map_expr<FTag, A1, A2, A3>, true> : private noncopyable
+		{
+			shared_block_store(const map_expr<FTag, A1, A2, A3>& e, const shared_block_link*& head)
+			: s1(e.arg1(), head), s2(e.arg2(), head), s3(e.arg3(), head) { }
+
+			shared_block_store<A1> s1;
+			shared_block_store<A2> s2;
+			shared_block_store<A3> s3;
+		};
+
+
+		/********************************************
+		 *
+		 *  block views
+		 *
+		 *  the expression on the len elements from
+		 *  i0 in column j, as a contiguous column
+		 *
+		 ********************************************/
+
+		template<class Expr, bool IsXpr=meta::is_mat_xpr<Expr>::value>
+		struct shared_block_view : private noncopyable
+		{
+			typedef typename meta::value_type_of<Expr>::type T;
+			typedef cref_matrix<T, 0, 1> type;
+
+			LMAT_ENSURE_INLINE
+			shared_block_view(const Expr& a, shared_block_store<Expr>&,
+					index_t j, index_t i0, index_t len)
+			: m_e(a.ptr_data() + j * a.col_stride() + i0, len, 1) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			type m_e;
+		};
+
+		template<typename T>
+		struct shared_block_view<T, false> : private noncopyable
+		{
+			typedef T type;
+
+			LMAT_ENSURE_INLINE
+			shared_block_view(const T& v, shared_block_store<T>&, index_t, index_t, index_t)
+			: m_v(v) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_v; }
+
+		private:
+			T m_v;
+		};
+
+		// the first occurrence fills the buffer of the block,
+		// which is then read by all occurrences
+
+		template<class Arg>
+		struct shared_block_view<shared_expr<Arg>, true> : private noncopyable
+		{
+			typedef typename meta::value_type_of<Arg>::type T;
+			typedef cref_matrix<T, 0, 1> type;
+
+			shared_block_view(const shared_expr<Arg>& e,
+					shared_block_store<shared_expr<Arg> >& s, index_t j, index_t i0, index_t len)
+			: m_e(fill(e, s, j, i0, len), len, 1) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			static const T* fill(const shared_expr<Arg>& e,
+					shared_block_store<shared_expr<Arg> >& s, index_t j, index_t i0, index_t len)
+			{
+				if (s.owner)
+				{
+					shared_block_view<Arg> v(e.arg(), s.s, j, i0, len);
+					ref_matrix<T, 0, 1> b(s.data(), len, 1);
+					macc_evaluate(v.get(), b);
+				}
+				return s.data();
+			}
+
+			type m_e;
+		};
+
+		template<typename FTag, typename A1>
+		struct shared_block_view<map_expr<FTag, A1>, true> : private noncopyable
+		{
+			typedef shared_block_view<A1> v1_t;
+			typedef map_expr<FTag, typename v1_t::type> type;
+
+			shared_block_view(const map_expr<FTag, A1>& e,
+					shared_block_store<map_expr<FTag, A1> >& s, index_t j, index_t i0, index_t len)
+			: m_v1(e.arg1(), s.s1, j, i0, len), m_e(FTag(), m_v1.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			v1_t m_v1;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2>
+		struct shared_block_view<map_expr<FTag, A1, A2>, true> : private noncopyable
+		{
+			typedef shared_block_view<A1> v1_t;
+			typedef shared_block_view<A2> v2_t;
+			typedef map_expr<FTag, typename v1_t::type, typename v2_t::type> type;
+
+			shared_block_view(const map_expr<FTag, A1, A2>& e,
+					shared_block_store<map_expr<FTag, A1, A2> >& s, index_t j, index_t i0, index_t len)
+			: m_v1(e.arg1(), s.s1, j, i0, len), m_v2(e.arg2(), s.s2, j, i0, len)
+			, m_e(FTag(), m_v1.get(), m_v2.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			v1_t m_v1;
+			v2_t m_v2;
+			type m_e;
+		};
+
+		template<typename FTag, typename A1, typename A2, typename A3>
+		struct shared_block_view<map_expr<FTag, A1, A2, A3>, true> : private noncopyable
+		{
+			typedef shared_block_view<A1> v1_t;
+			typedef shared_block_view<A2> v2_t;
+			typedef shared_block_view<A3> v3_t;
+			typedef map_expr<FTag, typename v1_t::type, typename v2_t::type, typename v3_t::type> type;
+
+			shared_block_view(const map_expr<FTag, A1, A2, A3>& e,
+					shared_block_store<map_expr<FTag, A1, A2, A3> >& s, index_t j, index_t i0, index_t len)
+			: m_v1(e.arg1(), s.s1, j, i0, len), m_v2(e.arg2(), s.s2, j, i0, len)
+			, m_v3(e.arg3(), s.s3, j, i0, len)
+			, m_e(FTag(), m_v1.get(), m_v2.get(), m_v3.get()) { }
+
+			LMAT_ENSURE_INLINE const type& get() const { return m_e; }
+
+		private:
+			v1_t m_v1;
+			v2_t m_v2;
+			v3_t m_v3;
+			type m_e;
+		};
+
+
+		/********************************************
+		 *
+		 *  blocked evaluation
+		 *
+		 ********************************************/
+
+		template<class Expr, class DMat>
+		inline void shared_block_evaluate(const Expr& e, DMat& d, index_t m, index_t n)
+		{
+			typedef typename meta::value_type_of<DMat>::type T;
+
+			const shared_block_link *head = 0;
+			shared_block_store<Expr> s(e, head);
+
+			T *pd = d.ptr_data();
+			const index_t ds = d.col_stride();
+
+			for (index_t j = 0; j < n; ++j)
+			{
+				for (index_t i = 0; i < m; i += LMAT_SHARED_BLOCK_LEN)
+				{
+					const index_t len = LMAT_SHARED_BLOCK_LEN < m - i ? LMAT_SHARED_BLOCK_LEN : m - i;
+
+					shared_block_view<Expr> v(e, s, j, i, len);
+					ref_matrix<T, 0, 1> dj(pd + j * ds + i, len, 1);
+					macc_evaluate(v.get(), dj);
+				}
+			}
+		}
+
+		template<class Expr, class DMat>
+		LMAT_ENSURE_INLINE
+		inline bool _try_shared_blocks(const Expr&, DMat&, meta::false_)
+		{
+			return false;
+		}
+
+		template<class Expr, class DMat>
+		inline bool _try_shared_blocks(const Expr& e, DMat& d, meta::true_)
+		{
+			LMAT_INSTRUMENT_VARIANT("ewise.shared_blocks")
+
+			if (shared_blockable<Expr, DMat>::linear)
+				shared_block_evaluate(e, d, e.nelems(), 1);
+			else
+				shared_block_evaluate(e, d, e.nrows(), e.ncolumns());
+
+			return true;
+		}
+
+		// returns whether e has been evaluated to d in blocks
+
+		template<class Expr, class DMat>
+		LMAT_ENSURE_INLINE
+		inline bool try_shared_blocks(const Expr& e, DMat& d)
+		{
+			return _try_shared_blocks(e, d, meta::bool_<shared_blockable<Expr, DMat>::value>());
+		}
+	}
+}
+
+#endif /* SHARED_BLOCK_EVAL_H_ */
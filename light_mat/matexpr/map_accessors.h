@@ -76,12 +76,41 @@ namespace lmat
 			return m_fun(m_rd1.scalar(i));
 		}
 
+		static const bool supports_part = Rd1::supports_part;
+
 		LMAT_ENSURE_INLINE
 		pack_t pack(index_t i) const
 		{
 			return m_pkfun(m_rd1.pack(i));
 		}
 
+		LMAT_ENSURE_INLINE
+		pack_t pack_part(index_t i, index_t k) const
+		{
+			return m_pkfun(m_rd1.pack_part(i, k));
+		}
+
+		static const bool supports_align = Rd1::supports_align;
+
+		LMAT_ENSURE_INLINE
+		index_t pack_offset() const
+		{
+			return m_rd1.pack_offset();
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_t pack_a(index_t i) const
+		{
+			return m_pkfun(m_rd1.pack_a(i));
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t prefetch(index_t i) const
+		{
+			m_rd1.prefetch(i);
+			return nil_t();
+		}
+
 	private:
 		Fun m_fun;
 		simd_fun_t m_pkfun;
@@ -136,12 +165,42 @@ namespace lmat
 			return m_fun(m_rd1.scalar(i), m_rd2.scalar(i));
 		}
 
+		static const bool supports_part = Rd1::supports_part && Rd2::supports_part;
+
 		LMAT_ENSURE_INLINE
 		pack_t pack(index_t i) const
 		{
 			return m_pkfun(m_rd1.pack(i), m_rd2.pack(i));
 		}
 
+		LMAT_ENSURE_INLINE
+		pack_t pack_part(index_t i, index_t k) const
+		{
+			return m_pkfun(m_rd1.pack_part(i, k), m_rd2.pack_part(i, k));
+		}
+
+		static const bool supports_align = Rd1::supports_align && Rd2::supports_align;
+
+		LMAT_ENSURE_INLINE
+		index_t pack_offset() const
+		{
+			return internal::common_pack_offset(m_rd1.pack_offset(), m_rd2.pack_offset());
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_t pack_a(index_t i) const
+		{
+			return m_pkfun(m_rd1.pack_a(i), m_rd2.pack_a(i));
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t prefetch(index_t i) const
+		{
+			m_rd1.prefetch(i);
+			m_rd2.prefetch(i);
+			return nil_t();
+		}
+
 	private:
 		Fun m_fun;
 		simd_fun_t m_pkfun;
@@ -200,12 +259,46 @@ namespace lmat
 			return m_fun(m_rd1.scalar(i), m_rd2.scalar(i), m_rd3.scalar(i));
 		}
 
+		static const bool supports_part =
+				Rd1::supports_part && Rd2::supports_part && Rd3::supports_part;
+
 		LMAT_ENSURE_INLINE
 		pack_t pack(index_t i) const
 		{
 			return m_pkfun(m_rd1.pack(i), m_rd2.pack(i), m_rd3.pack(i));
 		}
 
+		LMAT_ENSURE_INLINE
+		pack_t pack_part(index_t i, index_t k) const
+		{
+			return m_pkfun(m_rd1.pack_part(i, k), m_rd2.pack_part(i, k), m_rd3.pack_part(i, k));
+		}
+
+		static const bool supports_align =
+				Rd1::supports_align && Rd2::supports_align && Rd3::supports_align;
+
+		LMAT_ENSURE_INLINE
+		index_t pack_offset() const
+		{
+			return internal::common_pack_offset(
+					m_rd1.pack_offset(), m_rd2.pack_offset(), m_rd3.pack_offset());
+		}
+
+		LMAT_ENSURE_INLINE
+		pack_t pack_a(index_t i) const
+		{
+			return m_pkfun(m_rd1.pack_a(i), m_rd2.pack_a(i), m_rd3.pack_a(i));
+		}
+
+		LMAT_ENSURE_INLINE
+		nil_t prefetch(index_t i) const
+		{
+			m_rd1.prefetch(i);
+			m_rd2.prefetch(i);
+			m_rd3.prefetch(i);
+			return nil_t();
+		}
+
 	private:
 		Fun m_fun;
 		simd_fun_t m_pkfun;
@@ -17,6 +17,7 @@
 #include <light_mat/simd/simd.h>
 
 #include "internal/map_expr_internal.h"
+#include "internal/map_expr_plan.h"
 
 namespace lmat
 {
@@ -462,12 +463,24 @@ namespace lmat
 				meta::all_<supports_simd<Args, Kind>...>::value;
 	};
 
+	template<typename FTag, typename... Args>
+	struct simd_strided_operands<map_expr<FTag, Args...> >
+	{
+		static const int value = internal::_strided_sum<Args...>::operands;
+	};
+
+	template<typename FTag, typename... Args>
+	struct simd_work_cost<map_expr<FTag, Args...> >
+	{
+		static const int value = fun_cost<FTag>::value + internal::_strided_sum<Args...>::work;
+	};
+
 	template<typename FTag, typename... Args, class DMat>
 	LMAT_ENSURE_INLINE
 	inline void evaluate(const map_expr<FTag, Args...>& sexpr,
 			IRegularMatrix<DMat, typename internal::map_expr_value<FTag, Args...>::type>& dmat)
 	{
-		macc_evaluate(sexpr, dmat);
+		internal::plan_evaluate(sexpr, dmat.derived());
 	}
 
 
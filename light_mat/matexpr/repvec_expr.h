@@ -14,6 +14,7 @@
 #define LIGHTMAT_REPVEC_EXPR_H_
 
 #include <light_mat/mateval/ewise_eval.h>
+#include "internal/bcast_tile_eval.h"
 
 namespace lmat
 {
@@ -201,6 +202,14 @@ namespace lmat
 	struct supports_simd<reprow_expr<Arg, CM>, Kind>
 	: public supports_simd<typename matrix_traits<Arg>::value_type, Kind> { };
 
+	template<typename Arg, index_t CN>
+	struct simd_strided_operands<repcol_expr<Arg, CN> >
+	: public simd_strided_operands<Arg> { };
+
+	template<typename Arg, index_t CN>
+	struct simd_work_cost<repcol_expr<Arg, CN> >
+	: public simd_work_cost<Arg> { };
+
 
 	template<typename Arg, index_t CN, class DMat>
 	inline void evaluate(const repcol_expr<Arg, CN>& sexpr,
@@ -219,6 +228,10 @@ namespace lmat
 		{
 			fill(dmat, *(a.ptr_data()));
 		}
+		else if (internal::try_bcast_tiles(sexpr, dmat.derived()))
+		{
+			// short columns, copied from a tile of repeated columns
+		}
 		else
 		{
 			for (index_t j = 0; j < n; ++j)
@@ -249,6 +262,10 @@ namespace lmat
 		{
 			fill(dmat, *(a.ptr_data()));
 		}
+		else if (internal::try_bcast_tiles(sexpr, dmat.derived()))
+		{
+			// short columns, copied from tiles of repeated elements
+		}
 		else
 		{
 			for (index_t j = 0; j < n; ++j)
@@ -0,0 +1,163 @@
+/**
+ * @file shared_expr.h
+ *
+ * @brief Shared sub-expressions
+ *
+ * A map expression is a tree, so a sub-expression that appears more
+ * than once, as exp(x) in exp(x) * y + exp(x) * z, is computed once
+ * per occurrence. shared_(e) wraps e such that all occurrences of the
+ * wrapper compute e only once per element:
+ *
+ *   auto ex = shared_(exp(x));
+ *   a = ex * y + ex * z;
+ *
+ * When such an expression is evaluated into a matrix, it is evaluated
+ * in blocks of a few hundred elements, and e is computed once per block
+ * into a buffer local to the evaluation, which all occurrences then
+ * read (see internal/shared_block_eval.h). No temporary of the size of
+ * the result is created, and as nothing is cached in the expression, it
+ * can be evaluated from multiple threads at once (e.g. under par_).
+ * Elsewhere (e.g. in reductions, or over non-contiguous matrices),
+ * shared_(e) simply reads e.
+ *
+ * The wrapper holds a copy of e, which (like any map expression) refers
+ * to its own arguments, so e itself should only refer to named matrices
+ * or expressions.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_SHARED_EXPR_H_
+#define LIGHTMAT_SHARED_EXPR_H_
+
+#include <light_mat/matexpr/map_expr.h>
+
+namespace lmat
+{
+	// forward declarations
+
+	template<class Arg> class shared_expr;
+
+
+	/********************************************
+	 *
+	 *  expression class
+	 *
+	 ********************************************/
+
+	template<class Arg>
+	struct matrix_traits<shared_expr<Arg> >
+	: public matrix_xpr_traits_base<
+	  typename meta::value_type_of<Arg>::type,
+	  meta::nrows<Arg>::value,
+	  meta::ncols<Arg>::value,
+	  typename meta::domain_of<Arg>::type> { };
+
+
+	template<class Arg>
+	class shared_expr
+	: public ewise_matrix_base<shared_expr<Arg> >
+	{
+		static_assert( !meta::is_regular_mat<Arg>::value,
+				"Arg should be an expression rather than a regular matrix" );
+
+		typedef ewise_matrix_base<shared_expr<Arg> > base_t;
+
+	public:
+		LMAT_ENSURE_INLINE
+		explicit shared_expr(const Arg& a)
+		: base_t(a.shape()), m_arg(a) { }
+
+		LMAT_ENSURE_INLINE const Arg& arg() const
+		{
+			return m_arg;
+		}
+
+	private:
+		Arg m_arg;
+	};
+
+
+	template<typename T, class Arg>
+	LMAT_ENSURE_INLINE
+	inline shared_expr<Arg> shared_(const IEWiseMatrix<Arg, T>& a)
+	{
+		return shared_expr<Arg>(a.derived());
+	}
+
+
+	/********************************************
+	 *
+	 *  Accessor maps
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		// outside of blocked evaluation, the argument is read as is
+
+		template<class Arg, typename U>
+		struct vec_reader_map<shared_expr<Arg>, U>
+		{
+			typedef shared_expr<Arg> expr_type;
+			typedef typename vec_reader_map<Arg, U>::type type;
+
+			LMAT_ENSURE_INLINE
+			static type get(const expr_type& expr)
+			{
+				return vec_reader_map<Arg, U>::get(expr.arg());
+			}
+		};
+
+		template<class Arg, typename U>
+		struct multicol_reader_map<shared_expr<Arg>, U>
+		{
+			typedef shared_expr<Arg> expr_type;
+			typedef typename multicol_reader_map<Arg, U>::type type;
+
+			LMAT_ENSURE_INLINE
+			static type get(const expr_type& expr)
+			{
+				return multicol_reader_map<Arg, U>::get(expr.arg());
+			}
+		};
+	}
+
+
+	/********************************************
+	 *
+	 *  Evaluation
+	 *
+	 ********************************************/
+
+	template<class Arg>
+	struct supports_linear_access<shared_expr<Arg> >
+	: public supports_linear_access<Arg> { };
+
+	template<class Arg, typename Kind>
+	struct supports_simd<shared_expr<Arg>, Kind>
+	: public supports_simd<Arg, Kind> { };
+
+	template<class Arg>
+	struct simd_strided_operands<shared_expr<Arg> >
+	: public simd_strided_operands<Arg> { };
+
+	template<class Arg>
+	struct simd_work_cost<shared_expr<Arg> >
+	: public simd_work_cost<Arg> { };
+
+	template<class Arg, class DMat>
+	LMAT_ENSURE_INLINE
+	inline void evaluate(const shared_expr<Arg>& sexpr,
+			IRegularMatrix<DMat, typename meta::value_type_of<Arg>::type>& dmat)
+	{
+		evaluate(sexpr.arg(), dmat);
+	}
+
+}
+
+#endif /* SHARED_EXPR_H_ */
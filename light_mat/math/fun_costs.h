@@ -0,0 +1,98 @@
+/**
+ * @file fun_costs.h
+ *
+ * @brief Relative costs of functions
+ *
+ * fun_cost<FTag>::value is a rough estimate of the cost of evaluating
+ * a function on one element (or pack), in units of a simple arithmetic
+ * operation. Expression planners use it to decide whether it pays to
+ * materialize a sub-expression instead of recomputing it.
+ *
+ * A function that is not listed has the cost of simple arithmetic.
+ * User-defined function tags may be given a cost with LMAT_DEF_FUN_COST.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_FUN_COSTS_H_
+#define LIGHTMAT_FUN_COSTS_H_
+
+#include <light_mat/math/fun_tags.h>
+
+// cost classes
+
+#define LMAT_COST_ARITH 1
+#define LMAT_COST_DIV 4
+#define LMAT_COST_TRANSCEND 20
+#define LMAT_COST_SPECIAL 40
+
+#define LMAT_DEF_FUN_COST(FTag, C) \
+	template<> struct fun_cost<FTag> { static const int value = C; };
+
+namespace lmat
+{
+	template<typename FTag>
+	struct fun_cost
+	{
+		static const int value = LMAT_COST_ARITH;
+	};
+
+	// division & roots
+
+	LMAT_DEF_FUN_COST( ftags::div_,   LMAT_COST_DIV )
+	LMAT_DEF_FUN_COST( ftags::rcp_,   LMAT_COST_DIV )
+	LMAT_DEF_FUN_COST( ftags::sqrt_,  LMAT_COST_DIV )
+	LMAT_DEF_FUN_COST( ftags::rsqrt_, LMAT_COST_DIV )
+
+	// power, exp & log
+
+	LMAT_DEF_FUN_COST( ftags::pow_,   LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::cbrt_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::hypot_, LMAT_COST_TRANSCEND )
+
+	LMAT_DEF_FUN_COST( ftags::exp_,   LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::log_,   LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::log10_, LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::xlogx_, LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::xlogy_, LMAT_COST_TRANSCEND )
+
+	LMAT_DEF_FUN_COST( ftags::exp2_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::log2_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::exp10_, LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::expm1_, LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::log1p_, LMAT_COST_TRANSCEND )
+
+	// trigonometric & hyperbolic
+
+	LMAT_DEF_FUN_COST( ftags::sin_,   LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::cos_,   LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::tan_,   LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::asin_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::acos_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::atan_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::atan2_, LMAT_COST_TRANSCEND )
+
+	LMAT_DEF_FUN_COST( ftags::sinh_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::cosh_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::tanh_,  LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::asinh_, LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::acosh_, LMAT_COST_TRANSCEND )
+	LMAT_DEF_FUN_COST( ftags::atanh_, LMAT_COST_TRANSCEND )
+
+	// special functions
+
+	LMAT_DEF_FUN_COST( ftags::erf_,     LMAT_COST_SPECIAL )
+	LMAT_DEF_FUN_COST( ftags::erfc_,    LMAT_COST_SPECIAL )
+	LMAT_DEF_FUN_COST( ftags::erfinv_,  LMAT_COST_SPECIAL )
+	LMAT_DEF_FUN_COST( ftags::erfcinv_, LMAT_COST_SPECIAL )
+	LMAT_DEF_FUN_COST( ftags::norminv_, LMAT_COST_SPECIAL )
+	LMAT_DEF_FUN_COST( ftags::lgamma_,  LMAT_COST_SPECIAL )
+	LMAT_DEF_FUN_COST( ftags::tgamma_,  LMAT_COST_SPECIAL )
+	LMAT_DEF_FUN_COST( ftags::psi_,     LMAT_COST_SPECIAL )
+}
+
+#endif /* FUN_COSTS_H_ */
@@ -27,8 +27,8 @@ namespace lmat
 	 *
 	 ********************************************/
 
-	template<typename T, index_t CM, index_t CN>
-	struct matrix_traits<dense_matrix<T, CM, CN> >
+	template<typename T, index_t CM, index_t CN, class Allocator>
+	struct matrix_traits<dense_matrix<T, CM, CN, Allocator> >
 	: public regular_matrix_traits_base<T, CM, CN, cpu_domain>
 	{
 		typedef cont_layout_cm<CM, CN> layout_type;
@@ -43,7 +43,9 @@ namespace lmat
 
 	namespace internal
 	{
-		template<typename T, int CTSize>
+		// static storage lives in place, and thus ignores the allocator
+
+		template<typename T, int CTSize, class Allocator>
 		class dense_mat_storage
 		{
 #ifdef LMAT_USE_STATIC_ASSERT
@@ -79,8 +81,8 @@ namespace lmat
 		};
 
 
-		template<typename T>
-		class dense_mat_storage<T, 0>
+		template<typename T, class Allocator>
+		class dense_mat_storage<T, 0, Allocator>
 		{
 		public:
 			LMAT_ENSURE_INLINE
@@ -136,7 +138,7 @@ namespace lmat
 			}
 
 		private:
-			dblock<T> m_block;
+			dblock<T, Allocator> m_block;
 		};
 	}
 
@@ -146,12 +148,13 @@ namespace lmat
 	 *
 	 ********************************************/
 
-	template<typename T, index_t CM, index_t CN>
-	class dense_matrix : public regular_mat_base<dense_matrix<T, CM, CN> >
+	template<typename T, index_t CM, index_t CN, class Allocator>
+	class dense_matrix : public regular_mat_base<dense_matrix<T, CM, CN, Allocator> >
 	{
 	public:
 		LMAT_DEFINE_REGMAT_TYPES(T)
 		typedef cont_layout_cm<CM, CN> layout_type;
+		typedef Allocator allocator_type;
 
 	public:
 		LMAT_ENSURE_INLINE dense_matrix()
@@ -284,16 +287,16 @@ namespace lmat
 		}
 
 	private:
-		typedef internal::dense_mat_storage<T, CM * CN> storage_t;
+		typedef internal::dense_mat_storage<T, CM * CN, Allocator> storage_t;
 
 		layout_type m_layout;
 		storage_t m_store;
 	};
 
 
-	template<typename T, index_t CM, index_t CN>
+	template<typename T, index_t CM, index_t CN, class Allocator>
 	LMAT_ENSURE_INLINE
-	inline void swap(dense_matrix<T, CM, CN>& a, dense_matrix<T, CM, CN>& b)
+	inline void swap(dense_matrix<T, CM, CN, Allocator>& a, dense_matrix<T, CM, CN, Allocator>& b)
 	{
 		a.swap(b);
 	}
@@ -305,10 +308,10 @@ namespace lmat
 	 *
 	 ********************************************/
 
-	template<typename T, index_t CM>
-	class dense_col : public dense_matrix<T, CM, 1>
+	template<typename T, index_t CM, class Allocator>
+	class dense_col : public dense_matrix<T, CM, 1, Allocator>
 	{
-		typedef dense_matrix<T, CM, 1> base_mat_t;
+		typedef dense_matrix<T, CM, 1, Allocator> base_mat_t;
 
 	public:
 		LMAT_ENSURE_INLINE dense_col() : base_mat_t(CM, 1) { }
@@ -352,10 +355,10 @@ namespace lmat
 	};
 
 
-	template<typename T, index_t CN>
-	class dense_row : public dense_matrix<T, 1, CN>
+	template<typename T, index_t CN, class Allocator>
+	class dense_row : public dense_matrix<T, 1, CN, Allocator>
 	{
-		typedef dense_matrix<T, 1, CN> base_mat_t;
+		typedef dense_matrix<T, 1, CN, Allocator> base_mat_t;
 
 	public:
 		LMAT_ENSURE_INLINE dense_row() : base_mat_t(1, CN) { }
@@ -409,6 +412,7 @@ namespace lmat
 	inline dense_matrix<T, meta::nrows<Expr>::value, meta::ncols<Expr>::value>
 	eval(const IMatrixXpr<Expr, T>& expr)
 	{
+		LMAT_INSTRUMENT_TEMP("eval", expr.nelems() * sizeof(T))
 		return dense_matrix<T, meta::nrows<Expr>::value, meta::ncols<Expr>::value>(
 				expr.derived());
 	}
@@ -14,6 +14,7 @@
 #define LIGHTMAT_MATRIX_FILL_INTERNAL_H_
 
 #include <light_mat/matrix/matrix_properties.h>
+#include <light_mat/simd/simd_dispatch.h>
 
 namespace lmat { namespace internal {
 
@@ -59,11 +60,53 @@ namespace lmat { namespace internal {
 	 *
 	 ********************************************/
 
+	// filling of contiguous vectors, which is done with SIMD packs
+	// (dispatched at run-time) for float and double
+
+	struct fill_contvec_task
+	{
+		typedef void result_type;
+
+		template<typename Kind, typename T>
+		LMAT_ENSURE_INLINE
+		void operator() (Kind, index_t len, T *pd, const T& v) const
+		{
+			typedef simd_pack<T, Kind> pack_t;
+			const index_t W = static_cast<index_t>(pack_t::pack_width);
+
+			const pack_t pv(v);
+
+			index_t i = 0;
+			for (; i + W <= len; i += W) pv.store_u(pd + i);
+			for (; i < len; ++i) pd[i] = v;
+		}
+	};
+
+	template<typename T>
+	LMAT_ENSURE_INLINE
+	inline void _fill_contvec(index_t len, T *pd, const T& v)
+	{
+		fill_vec(len, pd, v);
+	}
+
+	LMAT_ENSURE_INLINE
+	inline void _fill_contvec(index_t len, float *pd, const float& v)
+	{
+		simd_dispatch(meta::true_(), fill_contvec_task(), len, pd, v);
+	}
+
+	LMAT_ENSURE_INLINE
+	inline void _fill_contvec(index_t len, double *pd, const double& v)
+	{
+		simd_dispatch(meta::true_(), fill_contvec_task(), len, pd, v);
+	}
+
+
 	template<typename T>
 	LMAT_ENSURE_INLINE
 	inline void _fill_singlevec(index_t len, const T& v, T *pd, index_t d_step)
 	{
-		if (d_step == 1) fill_vec(len, pd, v);
+		if (d_step == 1) _fill_contvec(len, pd, v);
 		else fill_vec(len, step_ptr(pd, d_step), v);
 	}
 
@@ -75,7 +118,7 @@ namespace lmat { namespace internal {
 	{
 		for (index_t j = 0; j < n; ++j)
 		{
-			fill_vec(m, pd + j * dst_cs, v);
+			_fill_contvec(m, pd + j * dst_cs, v);
 		}
 	}
 
@@ -147,7 +190,7 @@ namespace lmat { namespace internal {
 	LMAT_ENSURE_INLINE
 	inline void fill(const T& v, IRegularMatrix<DMat, T>& dmat, const matrix_fill_scheme<M, N, cont_level::whole>& sch)
 	{
-		fill_vec(sch.nelems(), dmat.ptr_data(), v);
+		_fill_contvec(sch.nelems(), dmat.ptr_data(), v);
 	}
 
 	template<typename T, class DMat, index_t M, index_t N>
@@ -164,7 +207,7 @@ namespace lmat { namespace internal {
 			if (m == 1)
 				*pd = v;
 			else
-				fill_vec(m, pd, v);
+				_fill_contvec(m, pd, v);
 		}
 		else
 		{
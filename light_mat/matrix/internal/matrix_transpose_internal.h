@@ -15,6 +15,8 @@
 
 #include <light_mat/common/memory.h>
 #include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/simd/simd_transpose.h>
+#include <light_mat/simd/simd_dispatch.h>
 
 namespace lmat { namespace internal {
 
@@ -106,16 +108,87 @@ namespace lmat { namespace internal {
 	}
 
 
+	// tiled transposition of matrices with contiguous columns,
+	// where each W x W tile is transposed within SIMD registers
+
+	template<typename Kind, typename T>
+	inline void tiled_transpose(index_t m, index_t n,
+			const T* src, index_t src_cs, T *dst, index_t dst_cs)
+	{
+		typedef simd_tile_transposer<T, Kind> tr_t;
+		const index_t W = tr_t::size;
+
+		const index_t mt = m - m % W;
+		const index_t nt = n - n % W;
+
+		for (index_t j = 0; j < nt; j += W)
+		{
+			for (index_t i = 0; i < mt; i += W)
+				tr_t::run(src + i + j * src_cs, src_cs, dst + j + i * dst_cs, dst_cs);
+
+			for (index_t i = mt; i < m; ++i)
+			{
+				for (index_t k = j; k < j + W; ++k)
+					dst[k + i * dst_cs] = src[i + k * src_cs];
+			}
+		}
+
+		for (index_t j = nt; j < n; ++j)
+		{
+			for (index_t i = 0; i < m; ++i)
+				dst[j + i * dst_cs] = src[i + j * src_cs];
+		}
+	}
+
+	struct tiled_transpose_task
+	{
+		typedef void result_type;
+
+		template<typename Kind, typename T>
+		LMAT_ENSURE_INLINE
+		void operator() (Kind, index_t m, index_t n,
+				const T* src, index_t src_cs, T *dst, index_t dst_cs) const
+		{
+			const index_t W = simd_tile_transposer<T, Kind>::size;
+
+			if (m >= W && n >= W)
+				tiled_transpose<Kind>(m, n, src, src_cs, dst, dst_cs);
+			else
+				naive_transpose(m, n, src, src_cs, dst, dst_cs);
+		}
+	};
+
+	template<typename T, bool Tiled=simd_tile_transposer<T, default_simd_kind>::available>
+	struct percol_transposer
+	{
+		inline static void run(index_t m, index_t n,
+				const T* src, index_t src_cs, T *dst, index_t dst_cs)
+		{
+			naive_transpose(m, n, src, src_cs, dst, dst_cs);
+		}
+	};
+
+	template<typename T>
+	struct percol_transposer<T, true>
+	{
+		inline static void run(index_t m, index_t n,
+				const T* src, index_t src_cs, T *dst, index_t dst_cs)
+		{
+			simd_dispatch(meta::true_(), tiled_transpose_task(), m, n, src, src_cs, dst, dst_cs);
+		}
+	};
+
+
 	template<typename T, class SMat, class DMat>
 	inline void direct_transpose(index_t m, index_t n, const IRegularMatrix<SMat, T>& smat, IRegularMatrix<DMat, T>& dmat)
 	{
 		if (meta::is_contiguous<SMat>::value && meta::is_contiguous<DMat>::value)
 		{
-			naive_transpose(m, n, smat.ptr_data(), dmat.ptr_data());
+			percol_transposer<T>::run(m, n, smat.ptr_data(), m, dmat.ptr_data(), n);
 		}
 		else if (meta::is_percol_contiguous<SMat>::value && meta::is_percol_contiguous<DMat>::value)
 		{
-			naive_transpose(m, n, smat.ptr_data(), smat.col_stride(), dmat.ptr_data(), dmat.col_stride());
+			percol_transposer<T>::run(m, n, smat.ptr_data(), smat.col_stride(), dmat.ptr_data(), dmat.col_stride());
 		}
 		else
 		{
@@ -16,6 +16,7 @@
 #include <light_mat/common/basic_defs.h>
 #include <light_mat/common/range.h>
 #include <light_mat/common/memory.h>
+#include <light_mat/common/memalloc.h>
 
 #include <light_mat/matrix/matrix_shape.h>
 
@@ -86,9 +87,9 @@ namespace lmat
 
 	// forward declaration of some important types
 
-	template<typename T, index_t CM=0, index_t CN=0> class dense_matrix;
-	template<typename T, index_t CM=0> class dense_col;
-	template<typename T, index_t CN=0> class dense_row;
+	template<typename T, index_t CM=0, index_t CN=0, class Allocator=aligned_allocator<T> > class dense_matrix;
+	template<typename T, index_t CM=0, class Allocator=aligned_allocator<T> > class dense_col;
+	template<typename T, index_t CN=0, class Allocator=aligned_allocator<T> > class dense_row;
 
 	template<typename T, index_t CM=0, index_t CN=0> class cref_matrix;
 	template<typename T, index_t CM=0, index_t CN=0> class ref_matrix;
@@ -60,6 +60,16 @@ namespace lmat { namespace random {
 	template<typename T=double, typename Method=basic_> class gamma_distr;
 
 
+	// whether simdize_map<Distr, sse_t> gives a generator of batches
+	// (which fills memory directly, as opposed to returning packs)
+
+	template<class Distr>
+	struct is_batch_simdizable
+	{
+		static const bool value = false;
+	};
+
+
 } }
 
 #endif
@@ -256,12 +256,69 @@ namespace lmat
 		static const bool value = is_simdizable<Distr, Kind>::value;
 	};
 
+	// drawing a sample takes at least a few arithmetic operations
+
+	template<class Distr, class RStream, index_t CM, index_t CN>
+	struct simd_work_cost<rand_expr<Distr, RStream, CM, CN> >
+	{
+		static const int value = LMAT_COST_DIV;
+	};
+
+	namespace internal
+	{
+		template<class Distr, class RStream, typename T>
+		inline void rand_fill_batches(const Distr& distr, RStream& rs, index_t len, T *p)
+		{
+			typedef simdize_map<Distr, sse_t> smap;
+			typedef typename smap::type batch_gen_t;
+			const index_t B = batch_gen_t::batch_size;
+
+			batch_gen_t gen = smap::get(distr);
+
+			index_t i = 0;
+			for (; i + B <= len; i += B) gen(rs, p + i);
+			for (; i < len; ++i) p[i] = distr(rs);
+		}
+
+		template<class Distr, class RStream, index_t CM, index_t CN, class DMat, typename T>
+		LMAT_ENSURE_INLINE
+		inline void rand_evaluate(std::false_type, const rand_expr<Distr, RStream, CM, CN>& sexpr,
+				IRegularMatrix<DMat, T>& dmat)
+		{
+			macc_evaluate(sexpr, dmat);
+		}
+
+		template<class Distr, class RStream, index_t CM, index_t CN, class DMat, typename T>
+		inline void rand_evaluate(std::true_type, const rand_expr<Distr, RStream, CM, CN>& sexpr,
+				IRegularMatrix<DMat, T>& dmat)
+		{
+			if (dmat.is_contiguous())
+			{
+				rand_fill_batches(sexpr.distr(), sexpr.stream(), dmat.nelems(), dmat.ptr_data());
+			}
+			else if (dmat.is_percol_contiguous())
+			{
+				const index_t m = dmat.nrows();
+				const index_t n = dmat.ncolumns();
+				for (index_t j = 0; j < n; ++j)
+				{
+					rand_fill_batches(sexpr.distr(), sexpr.stream(), m, dmat.ptr_col(j));
+				}
+			}
+			else
+			{
+				macc_evaluate(sexpr, dmat);
+			}
+		}
+	}
+
 	template<class Distr, class RStream, index_t CM, index_t CN, class DMat>
 	LMAT_ENSURE_INLINE
 	inline void evaluate(const rand_expr<Distr, RStream, CM, CN>& sexpr,
 			IRegularMatrix<DMat, typename Distr::result_type>& dmat)
 	{
-		macc_evaluate(sexpr, dmat);
+		typedef std::integral_constant<bool, random::is_batch_simdizable<Distr>::value> use_batch_t;
+		internal::rand_evaluate(use_batch_t(), sexpr, dmat);
 	}
 
 
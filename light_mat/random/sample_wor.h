@@ -63,8 +63,7 @@ namespace lmat { namespace random {
 		LMAT_ENSURE_INLINE
 		TI next()
 		{
-			std_uniform_int_distr<index_t> d(remain() - 1);
-			index_t i = m_i + d(m_rstream);
+			index_t i = m_i + internal::get_rand_int(m_rstream, remain());
 
 			TI t = m_seq[i];
 			m_seq[i] = m_seq[m_i];
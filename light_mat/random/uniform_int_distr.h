@@ -3,6 +3,12 @@
  *
  * @brief Uniform integer distribution
  *
+ * Draws are reduced to a range by Lemire's multiply-shift method,
+ * which is unbiased and (almost always) free of divisions. For
+ * 32-bit integers, simdize_map<Distr, sse_t> gives a generator of
+ * batches of draws, with which random expressions fill contiguous
+ * memory.
+ *
  * @author Dahua Lin
  */
 
@@ -14,6 +20,8 @@
 #define LIGHTMAT_UNIFORM_INT_DISTR_H_
 
 #include <light_mat/random/distr_fwd.h>
+#include <cmath>
+#include <limits>
 
 namespace lmat { namespace random {
 
@@ -82,70 +90,213 @@ namespace lmat { namespace random {
 			}
 		};
 
-		template<typename T, bool IsSigned>
-		struct rand_int_mod;
+		template<class RStream, typename T>
+		LMAT_ENSURE_INLINE
+		inline T get_rand_int(RStream& rs)
+		{
+			return rand_int_helper<RStream, T, (unsigned int)sizeof(T)>::get(rs);
+		}
+
 
-		template<typename T>
-		struct rand_int_mod<T, false>
+		/********************************************
+		 *
+		 *  bounded draws
+		 *
+		 *  Lemire's multiply-shift method: the high
+		 *  half of x * s is uniform over [0, s) once
+		 *  the draws whose low half falls below
+		 *  2^w mod s are rejected. The modulo is only
+		 *  computed when the low half is below s,
+		 *  i.e. with probability s / 2^w.
+		 *
+		 ********************************************/
+
+#if defined(_MSC_VER) && defined(_M_X64)
+		LMAT_ENSURE_INLINE
+		inline uint64_t mul_u64(uint64_t a, uint64_t b, uint64_t& lo)
 		{
-			LMAT_ENSURE_INLINE
-			static T eval(const T& x, const T& u)
+			uint64_t hi;
+			lo = _umul128(a, b, &hi);
+			return hi;
+		}
+#else
+		__extension__ typedef unsigned __int128 uint128_t;
+
+		LMAT_ENSURE_INLINE
+		inline uint64_t mul_u64(uint64_t a, uint64_t b, uint64_t& lo)
+		{
+			uint128_t p = static_cast<uint128_t>(a) * b;
+			lo = static_cast<uint64_t>(p);
+			return static_cast<uint64_t>(p >> 64);
+		}
+#endif
+
+		// uniform over [0, s), s > 0
+
+		template<class RStream>
+		inline uint32_t rand_u32_below(RStream& rs, uint32_t s)
+		{
+			uint64_t m = static_cast<uint64_t>(rs.rand_u32()) * s;
+			uint32_t l = static_cast<uint32_t>(m);
+
+			if (l < s)
 			{
-				return x % u;
+				const uint32_t t = (0u - s) % s;
+				while (l < t)
+				{
+					m = static_cast<uint64_t>(rs.rand_u32()) * s;
+					l = static_cast<uint32_t>(m);
+				}
 			}
-		};
+			return static_cast<uint32_t>(m >> 32);
+		}
 
-		template<typename T>
-		struct rand_int_mod<T, true>
+		template<class RStream>
+		inline uint64_t rand_u64_below(RStream& rs, uint64_t s)
 		{
-			typedef typename std::make_unsigned<T>::type UT;
+			uint64_t l;
+			uint64_t h = mul_u64(rs.rand_u64(), s, l);
 
+			if (l < s)
+			{
+				const uint64_t t = (uint64_t(0) - s) % s;
+				while (l < t)
+				{
+					h = mul_u64(rs.rand_u64(), s, l);
+				}
+			}
+			return h;
+		}
+
+		template<class RStream, typename T, bool Wide>
+		struct rand_int_below_helper;
+
+		template<class RStream, typename T>
+		struct rand_int_below_helper<RStream, T, false>
+		{
 			LMAT_ENSURE_INLINE
-			static T eval(const T& x, const T& u)
+			static T get(RStream& rs, uint32_t s)
 			{
-				return static_cast<T>(static_cast<UT>(x) % static_cast<UT>(u));
+				return static_cast<T>(rand_u32_below(rs, s));
 			}
 		};
 
 		template<class RStream, typename T>
-		LMAT_ENSURE_INLINE
-		inline T get_rand_int(RStream& rs)
+		struct rand_int_below_helper<RStream, T, true>
 		{
-			return rand_int_helper<RStream, T, (unsigned int)sizeof(T)>::get(rs);
-		}
+			LMAT_ENSURE_INLINE
+			static T get(RStream& rs, uint64_t s)
+			{
+				return static_cast<T>(rand_u64_below(rs, s));
+			}
+		};
+
+		// uniform over [0, m), where m == 0 stands for the whole range of T
 
 		template<class RStream, typename T>
 		LMAT_ENSURE_INLINE
 		inline T get_rand_int(RStream& rs, const T& m)
 		{
-			T x = get_rand_int<RStream, T>(rs);
-			return rand_int_mod<T, std::is_signed<T>::value>::eval(x, m);
+			typedef typename std::make_unsigned<T>::type UT;
+			const UT s = static_cast<UT>(m);
+
+			if (s == 0) return get_rand_int<RStream, T>(rs);
+			return rand_int_below_helper<RStream, T, (sizeof(T) > 4)>::get(rs, s);
+		}
+
+
+		/********************************************
+		 *
+		 *  batch draws
+		 *
+		 *  Four 32-bit draws are multiplied at once
+		 *  (SSE2 has no 32-bit high multiply, hence
+		 *  lanes 0, 2 and 1, 3 are done separately),
+		 *  and a lane is redrawn in the (rare) case
+		 *  that it is rejected.
+		 *
+		 ********************************************/
+
+		template<class RStream>
+		inline void rand_u32_below_x4(RStream& rs, uint32_t s, uint32_t offset, uint32_t *dst)
+		{
+			const __m128i x = rs.rand_pack(sse_t());
+			const __m128i vs = _mm_set1_epi32((int32_t)s);
+			const __m128i mhi = _mm_set_epi32(-1, 0, -1, 0);
+
+			const __m128i p02 = _mm_mul_epu32(x, vs);
+			const __m128i p13 = _mm_mul_epu32(_mm_srli_epi64(x, 32), vs);
+
+			const __m128i hi = _mm_or_si128(_mm_srli_epi64(p02, 32), _mm_and_si128(p13, mhi));
+			const __m128i lo = _mm_or_si128(_mm_andnot_si128(mhi, p02), _mm_slli_epi64(p13, 32));
+
+			// lo < s, as unsigned integers
+			const __m128i sgn = _mm_set1_epi32((int32_t)0x80000000);
+			const int rej = _mm_movemask_ps(_mm_castsi128_ps(
+					_mm_cmplt_epi32(_mm_xor_si128(lo, sgn), _mm_xor_si128(vs, sgn))));
+
+			_mm_storeu_si128((__m128i*)dst, _mm_add_epi32(hi, _mm_set1_epi32((int32_t)offset)));
+
+			if (rej)
+			{
+				LMAT_ALIGN_SSE uint32_t ls[4];
+				_mm_store_si128((__m128i*)ls, lo);
+
+				const uint32_t t = (0u - s) % s;
+				for (int k = 0; k < 4; ++k)
+				{
+					if ((rej & (1 << k)) && ls[k] < t)
+					{
+						dst[k] = rand_u32_below(rs, s) + offset;
+					}
+				}
+			}
 		}
 	}
 
 
+	/********************************************
+	 *
+	 *  distribution classes
+	 *
+	 *  The span (b - a + 1) is kept unsigned, where
+	 *  0 stands for the whole range of TI (2^w).
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		template<typename UT>
+		LMAT_ENSURE_INLINE
+		inline double int_span_value(UT s)
+		{
+			return s > 0 ? double(s) : std::ldexp(1.0, std::numeric_limits<UT>::digits);
+		}
+	}
+
 	template<typename TI>
 	class std_uniform_int_distr  // Uniform over [0, b]
 	{
 	public:
 		typedef TI result_type;
+		typedef typename std::make_unsigned<TI>::type span_type;
 
 		explicit std_uniform_int_distr(const TI& b)
-		: m_span(b+1) { }
+		: m_span(static_cast<span_type>(static_cast<span_type>(b) + 1u)) { }
 
 		LMAT_ENSURE_INLINE
 		TI a() const { return 0; }
 
 		LMAT_ENSURE_INLINE
-		TI b() const { return m_span - 1; }
+		TI b() const { return static_cast<TI>(static_cast<span_type>(m_span - 1u)); }
 
 		LMAT_ENSURE_INLINE
-		TI span() const { return m_span; }
+		span_type span() const { return m_span; }
 
 		LMAT_ENSURE_INLINE
 		double p(TI x) const
 		{
-			return is_nonneg_int(x) && x < m_span ? 1.0 / double(m_span) : 0.0;
+			return is_nonneg_int(x) && x <= b() ? 1.0 / internal::int_span_value(m_span) : 0.0;
 		}
 
 		LMAT_ENSURE_INLINE
@@ -157,18 +308,18 @@ namespace lmat { namespace random {
 		LMAT_ENSURE_INLINE
 		double var() const
 		{
-			return (math::sqr(double(m_span)) - 1.0) * (1.0/12);
+			return (math::sqr(internal::int_span_value(m_span)) - 1.0) * (1.0/12);
 		}
 
 		template<class RStream>
 		LMAT_ENSURE_INLINE
 		TI operator() (RStream& rs) const
 		{
-			return internal::get_rand_int(rs, m_span);
+			return static_cast<TI>(internal::get_rand_int(rs, m_span));
 		}
 
 	private:
-		TI m_span;
+		span_type m_span;
 	};
 
 
@@ -177,9 +328,11 @@ namespace lmat { namespace random {
 	{
 	public:
 		typedef TI result_type;
+		typedef typename std::make_unsigned<TI>::type span_type;
 
 		uniform_int_distr(const TI& a, const TI& b)
-		: m_a(a), m_b(b), m_span(b-a+1) { }
+		: m_a(a), m_b(b)
+		, m_span(static_cast<span_type>(static_cast<span_type>(b) - static_cast<span_type>(a) + 1u)) { }
 
 		LMAT_ENSURE_INLINE
 		TI a() const { return m_a; }
@@ -190,7 +343,7 @@ namespace lmat { namespace random {
 		LMAT_ENSURE_INLINE
 		double p(TI x) const
 		{
-			return x >= m_a && x <= m_b ? 1.0 / double(m_span) : 0.0;
+			return x >= m_a && x <= m_b ? 1.0 / internal::int_span_value(m_span) : 0.0;
 		}
 
 		LMAT_ENSURE_INLINE
@@ -202,26 +355,101 @@ namespace lmat { namespace random {
 		LMAT_ENSURE_INLINE
 		double var() const
 		{
-			return (math::sqr(double(m_span)) - 1.0) * (1.0/12);
+			return (math::sqr(internal::int_span_value(m_span)) - 1.0) * (1.0/12);
 		}
 
 		LMAT_ENSURE_INLINE
-		TI span() const { return m_span; }
+		span_type span() const { return m_span; }
 
 		template<class RStream>
 		LMAT_ENSURE_INLINE
 		TI operator() (RStream& rs) const
 		{
-			return (internal::get_rand_int(rs, m_span)) + m_a;
+			return static_cast<TI>(static_cast<span_type>(
+					internal::get_rand_int(rs, m_span) + static_cast<span_type>(m_a)));
 		}
 
 	private:
 		TI m_a;
 		TI m_b;
-		TI m_span;
+		span_type m_span;
 	};
 
 
+	// SIMD generator of batches (there are no integer packs)
+
+	template<typename TI>
+	class uniform_int_batch
+	{
+		static_assert(sizeof(TI) == 4, "uniform_int_batch: TI must be a 32-bit integer type.");
+
+	public:
+		typedef TI result_type;
+		static const index_t batch_size = 4;
+
+		LMAT_ENSURE_INLINE
+		uniform_int_batch(TI a, typename std::make_unsigned<TI>::type span)
+		: m_a(static_cast<uint32_t>(a)), m_span(static_cast<uint32_t>(span)) { }
+
+		template<class RStream>
+		LMAT_ENSURE_INLINE
+		void operator() (RStream& rs, TI *dst) const
+		{
+			if (m_span > 0)
+			{
+				internal::rand_u32_below_x4(rs, m_span, m_a, (uint32_t*)dst);
+			}
+			else
+			{
+				_mm_storeu_si128((__m128i*)dst, rs.rand_pack(sse_t()));
+			}
+		}
+
+	private:
+		uint32_t m_a;
+		uint32_t m_span;
+	};
+
+	template<typename TI>
+	struct is_batch_simdizable<std_uniform_int_distr<TI> >
+	{
+		static const bool value = sizeof(TI) == 4;
+	};
+
+	template<typename TI>
+	struct is_batch_simdizable<uniform_int_distr<TI> >
+	{
+		static const bool value = sizeof(TI) == 4;
+	};
+
 } }
 
+
+namespace lmat
+{
+	template<typename TI>
+	struct simdize_map< random::std_uniform_int_distr<TI>, sse_t >
+	{
+		typedef random::uniform_int_batch<TI> type;
+
+		LMAT_ENSURE_INLINE
+		static type get(const random::std_uniform_int_distr<TI>& s)
+		{
+			return type(TI(0), s.span());
+		}
+	};
+
+	template<typename TI>
+	struct simdize_map< random::uniform_int_distr<TI>, sse_t >
+	{
+		typedef random::uniform_int_batch<TI> type;
+
+		LMAT_ENSURE_INLINE
+		static type get(const random::uniform_int_distr<TI>& s)
+		{
+			return type(s.a(), s.span());
+		}
+	};
+}
+
 #endif
@@ -16,6 +16,8 @@
 #include <light_mat/simd/avx_packs.h>
 #include <light_mat/simd/avx_bpacks.h>
 
+#include "internal/avx_target_begin.h"
+
 namespace lmat { namespace meta {
 
 	// arithmetics
@@ -407,4 +409,6 @@ namespace lmat {  namespace math {
 
 } }
 
+#include "internal/avx_target_end.h"
+
 #endif
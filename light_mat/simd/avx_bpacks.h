@@ -16,6 +16,8 @@
 #include <light_mat/simd/simd_base.h>
 #include "internal/avx_helpers.h"
 
+#include "internal/avx_target_begin.h"
+
 namespace lmat
 {
 
@@ -302,4 +304,6 @@ namespace lmat
 }
 
 
+#include "internal/avx_target_end.h"
+
 #endif 
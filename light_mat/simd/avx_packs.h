@@ -16,10 +16,12 @@
 #include <light_mat/simd/simd_base.h>
 #include "internal/avx_helpers.h"
 
-#ifndef LMAT_HAS_AVX
+#ifndef LMAT_HAS_AVX_PACKS
 #error Only include avx_packs.h when AVX is enabled.
 #endif
 
+#include "internal/avx_target_begin.h"
+
 namespace lmat
 {
 
@@ -164,6 +166,12 @@ namespace lmat
 	    	v = _mm256_maskload_ps(p, internal::avx_part_mask_32(n));
 	    }
 
+	    // n must be in [0, 8] (n known at run-time)
+	    LMAT_ENSURE_INLINE void load_part(index_t n, const float *p)
+	    {
+	    	v = _mm256_maskload_ps(p, internal::avx_part_mask_32(n));
+	    }
+
 	    // store
 
 	    LMAT_ENSURE_INLINE void store_u(float *p) const
@@ -176,12 +184,54 @@ namespace lmat
 	    	_mm256_store_ps(p, v);
 	    }
 
+	    // non-temporal store (p must be aligned), which bypasses the cache
+	    LMAT_ENSURE_INLINE void store_nt(float *p) const
+	    {
+	    	_mm256_stream_ps(p, v);
+	    }
+
 	    template<unsigned int N>
 	    LMAT_ENSURE_INLINE void store_part(siz_<N> n, float *p) const
 	    {
 	    	_mm256_maskstore_ps(p, internal::avx_part_mask_32(n), v);
 	    }
 
+	    // n must be in [0, 8] (n known at run-time)
+	    LMAT_ENSURE_INLINE void store_part(index_t n, float *p) const
+	    {
+	    	_mm256_maskstore_ps(p, internal::avx_part_mask_32(n), v);
+	    }
+
+
+	    // strided load & store
+
+	    LMAT_ENSURE_INLINE void load_strided(const float *p, index_t step)
+	    {
+#ifdef LMAT_HAS_AVX2
+	    	const int s = (int)step;
+	    	v = _mm256_i32gather_ps(p,
+	    			_mm256_setr_epi32(0, s, 2*s, 3*s, 4*s, 5*s, 6*s, 7*s), 4);
+#else
+	    	v = _mm256_setr_ps(
+	    			p[0],        p[step],     p[2 * step], p[3 * step],
+	    			p[4 * step], p[5 * step], p[6 * step], p[7 * step]);
+#endif
+	    }
+
+	    LMAT_ENSURE_INLINE void store_strided(float *p, index_t step) const
+	    {
+	    	__m128 lo = _mm256_castps256_ps128(v);
+	    	__m128 hi = _mm256_extractf128_ps(v, 1);
+
+	    	_mm_store_ss(p, lo);
+	    	_mm_store_ss(p + step,     _mm_shuffle_ps(lo, lo, 1));
+	    	_mm_store_ss(p + 2 * step, _mm_movehl_ps(lo, lo));
+	    	_mm_store_ss(p + 3 * step, _mm_shuffle_ps(lo, lo, 3));
+	    	_mm_store_ss(p + 4 * step, hi);
+	    	_mm_store_ss(p + 5 * step, _mm_shuffle_ps(hi, hi, 1));
+	    	_mm_store_ss(p + 6 * step, _mm_movehl_ps(hi, hi));
+	    	_mm_store_ss(p + 7 * step, _mm_shuffle_ps(hi, hi, 3));
+	    }
 
 	    // extract
 
@@ -344,6 +394,12 @@ namespace lmat
 	    	v = _mm256_maskload_pd(p, internal::avx_part_mask_64(n));
 	    }
 
+	    // n must be in [0, 4] (n known at run-time)
+	    LMAT_ENSURE_INLINE void load_part(index_t n, const double *p)
+	    {
+	    	v = _mm256_maskload_pd(p, internal::avx_part_mask_64(n));
+	    }
+
 	    // store
 
 	    LMAT_ENSURE_INLINE void store_u(double *p) const
@@ -356,12 +412,49 @@ namespace lmat
 	    	_mm256_store_pd(p, v);
 	    }
 
+	    // non-temporal store (p must be aligned), which bypasses the cache
+	    LMAT_ENSURE_INLINE void store_nt(double *p) const
+	    {
+	    	_mm256_stream_pd(p, v);
+	    }
+
 	    template<unsigned int N>
 	    LMAT_ENSURE_INLINE void store_part(siz_<N> n, double *p) const
 	    {
 	    	_mm256_maskstore_pd(p, internal::avx_part_mask_64(n), v);
 	    }
 
+	    // n must be in [0, 4] (n known at run-time)
+	    LMAT_ENSURE_INLINE void store_part(index_t n, double *p) const
+	    {
+	    	_mm256_maskstore_pd(p, internal::avx_part_mask_64(n), v);
+	    }
+
+	    // strided load & store
+
+	    LMAT_ENSURE_INLINE void load_strided(const double *p, index_t step)
+	    {
+#ifdef LMAT_HAS_AVX2
+	    	v = _mm256_i64gather_pd(p,
+	    			_mm256_setr_epi64x(0, step, 2 * step, 3 * step), 8);
+#else
+	    	__m128d lo = _mm_loadh_pd(_mm_load_sd(p), p + step);
+	    	__m128d hi = _mm_loadh_pd(_mm_load_sd(p + 2 * step), p + 3 * step);
+	    	v = _mm256_insertf128_pd(_mm256_castpd128_pd256(lo), hi, 1);
+#endif
+	    }
+
+	    LMAT_ENSURE_INLINE void store_strided(double *p, index_t step) const
+	    {
+	    	__m128d lo = _mm256_castpd256_pd128(v);
+	    	__m128d hi = _mm256_extractf128_pd(v, 1);
+
+	    	_mm_store_sd(p, lo);
+	    	_mm_storeh_pd(p + step, lo);
+	    	_mm_store_sd(p + 2 * step, hi);
+	    	_mm_storeh_pd(p + 3 * step, hi);
+	    }
+
 	    // extract
 
 	    LMAT_ENSURE_INLINE __m128d get_low() const
@@ -404,4 +497,6 @@ namespace lmat
 }
 
 
+#include "internal/avx_target_end.h"
+
 #endif
@@ -17,6 +17,8 @@
 #include <light_mat/simd/avx_bpacks.h>
 #include "internal/sse_fpclass_impl.h"
 
+#include "internal/avx_target_begin.h"
+
 namespace lmat { namespace meta {
 
 	// comparison
@@ -301,4 +303,6 @@ namespace lmat { namespace math {
 
 } }
 
+#include "internal/avx_target_end.h"
+
 #endif
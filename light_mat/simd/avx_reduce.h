@@ -17,6 +17,8 @@
 #include <light_mat/simd/avx_bpacks.h>
 #include <light_mat/simd/sse_reduce.h>
 
+#include "internal/avx_target_begin.h"
+
 namespace lmat
 {
 
@@ -118,4 +120,6 @@ namespace lmat
 
 }
 
+#include "internal/avx_target_end.h"
+
 #endif 
@@ -15,6 +15,8 @@
 
 #include "sse_helpers.h"
 
+#include "avx_target_begin.h"
+
 namespace lmat { namespace internal {
 
 	LMAT_ENSURE_INLINE
@@ -118,6 +120,32 @@ namespace lmat { namespace internal {
 	}
 
 
+	// part mask for 0 <= n <= W (n known at run-time), taken
+	// from a sliding window over a table of 8 ones and 8 zeros
+
+	inline const int* _avx_part_mask_table()
+	{
+		static const int tab[16] = {
+			-1, -1, -1, -1, -1, -1, -1, -1,
+			 0,  0,  0,  0,  0,  0,  0,  0 };
+		return tab;
+	}
+
+	LMAT_ENSURE_INLINE
+	inline __m256i avx_part_mask_32(index_t n)
+	{
+		return _mm256_loadu_si256(
+				(const __m256i*)(_avx_part_mask_table() + (8 - n)));
+	}
+
+	LMAT_ENSURE_INLINE
+	inline __m256i avx_part_mask_64(index_t n)
+	{
+		return _mm256_loadu_si256(
+				(const __m256i*)(_avx_part_mask_table() + (8 - 2 * n)));
+	}
+
+
 	// AVX extraction
 
 	LMAT_ENSURE_INLINE
@@ -285,4 +313,6 @@ namespace lmat { namespace internal {
 
 } }
 
+#include "avx_target_end.h"
+
 #endif /* AVX_HELPERS_H_ */
@@ -0,0 +1,25 @@
+/**
+ * @file avx_target_begin.h
+ *
+ * @brief Opens a region of code compiled for the AVX target
+ *
+ * This is only effective with run-time dispatch (LMAT_DISPATCH_AVX),
+ * where the AVX headers are compiled without global AVX support.
+ * Within the region, LMAT_ENSURE_INLINE is relaxed to a hint, as GCC
+ * refuses to force-inline AVX functions into callers of the default
+ * target. The dispatched entry points (see simd_dispatch.h) flatten
+ * their bodies, which inlines these functions anyway.
+ *
+ * This header has no include guard, and each inclusion must be paired
+ * with an inclusion of avx_target_end.h.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef LMAT_DISPATCH_AVX
+#pragma GCC push_options
+#pragma GCC target("avx")
+#pragma push_macro("LMAT_ENSURE_INLINE")
+#undef LMAT_ENSURE_INLINE
+#define LMAT_ENSURE_INLINE
+#endif
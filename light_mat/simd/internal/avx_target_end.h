@@ -0,0 +1,12 @@
+/**
+ * @file avx_target_end.h
+ *
+ * @brief Closes a region opened by avx_target_begin.h
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef LMAT_DISPATCH_AVX
+#pragma pop_macro("LMAT_ENSURE_INLINE")
+#pragma GCC pop_options
+#endif
@@ -38,14 +38,14 @@ namespace lmat { namespace internal {
 	LMAT_ENSURE_INLINE
 	inline __m128 sse_loadpart_f32(siz_<2>, const float *p)
 	{
-		return _mm_castpd_ps(_mm_load_sd((double*)p));
+		return _mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)p));
 	}
 
 	LMAT_ENSURE_INLINE
 	inline __m128 sse_loadpart_f32(siz_<3>, const float *p)
 	{
 		return _mm_movelh_ps(
-				_mm_castpd_ps(_mm_load_sd((double*)p)), _mm_load_ss(p + 2));
+				_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)p)), _mm_load_ss(p + 2));
 	}
 
 	LMAT_ENSURE_INLINE
@@ -69,6 +69,27 @@ namespace lmat { namespace internal {
 	}
 
 
+	// partial load of 0 < n <= 4 elements (n known at run-time)
+
+	LMAT_ENSURE_INLINE
+	inline __m128 sse_loadpart_f32(index_t n, const float *p)
+	{
+		switch (n)
+		{
+		case 1: return sse_loadpart_f32(siz_<1>(), p);
+		case 2: return sse_loadpart_f32(siz_<2>(), p);
+		case 3: return sse_loadpart_f32(siz_<3>(), p);
+		}
+		return _mm_loadu_ps(p);
+	}
+
+	LMAT_ENSURE_INLINE
+	inline __m128d sse_loadpart_f64(index_t n, const double *p)
+	{
+		return n == 1 ? _mm_load_sd(p) : _mm_loadu_pd(p);
+	}
+
+
 	// partial store
 
 	LMAT_ENSURE_INLINE
@@ -80,13 +101,13 @@ namespace lmat { namespace internal {
 	LMAT_ENSURE_INLINE
 	inline void sse_storepart_f32(siz_<2>, float *p, const __m128& v)
 	{
-		_mm_store_sd((double*)p, _mm_castps_pd(v));
+		_mm_storel_epi64((__m128i*)p, _mm_castps_si128(v));
 	}
 
 	LMAT_ENSURE_INLINE
 	inline void sse_storepart_f32(siz_<3>, float *p, const __m128& v)
 	{
-		_mm_store_sd((double*)p, _mm_castps_pd(v));
+		_mm_storel_epi64((__m128i*)p, _mm_castps_si128(v));
 		_mm_store_ss(p + 2, _mm_movehl_ps(v, v));
 	}
 
@@ -109,6 +130,30 @@ namespace lmat { namespace internal {
 	}
 
 
+	// partial store of 0 < n <= 4 elements (n known at run-time)
+
+	LMAT_ENSURE_INLINE
+	inline void sse_storepart_f32(index_t n, float *p, const __m128& v)
+	{
+		switch (n)
+		{
+		case 1: sse_storepart_f32(siz_<1>(), p, v); break;
+		case 2: sse_storepart_f32(siz_<2>(), p, v); break;
+		case 3: sse_storepart_f32(siz_<3>(), p, v); break;
+		default: _mm_storeu_ps(p, v);
+		}
+	}
+
+	LMAT_ENSURE_INLINE
+	inline void sse_storepart_f64(index_t n, double *p, const __m128d& v)
+	{
+		if (n == 1)
+			_mm_store_sd(p, v);
+		else
+			_mm_storeu_pd(p, v);
+	}
+
+
 	// extract scalar
 
 	LMAT_ENSURE_INLINE
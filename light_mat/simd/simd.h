@@ -17,7 +17,7 @@
 
 #include <light_mat/simd/sse.h>
 
-#ifdef LMAT_HAS_AVX
+#ifdef LMAT_HAS_AVX_PACKS
 #include <light_mat/simd/avx.h>
 #endif
 
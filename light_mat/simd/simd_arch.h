@@ -77,4 +77,23 @@
 #endif
 
 
+// Run-time dispatch
+//
+// When LMAT_ENABLE_SIMD_DISPATCH is defined and AVX is not enabled at
+// compile-time, the AVX packs are still compiled (for the AVX target),
+// and the hot evaluation routines choose between SSE and AVX code paths
+// at run-time (see simd_dispatch.h). This relies on GCC's function-level
+// target options.
+
+#if defined(LMAT_ENABLE_SIMD_DISPATCH) && !defined(LMAT_HAS_AVX)
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define LMAT_DISPATCH_AVX
+#endif
+#endif
+
+#if defined(LMAT_HAS_AVX) || defined(LMAT_DISPATCH_AVX)
+#define LMAT_HAS_AVX_PACKS
+#endif
+
+
 #endif /* SIMD_ARCH_H_ */
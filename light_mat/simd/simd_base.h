@@ -20,7 +20,7 @@
 
 // system headers for SIMD intrinsics
 
-#if (defined(LMAT_HAS_AVX2))
+#if (defined(LMAT_HAS_AVX2) || defined(LMAT_DISPATCH_AVX))
 #ifdef __GNUC__
 #include <x86intrin.h>
 #else
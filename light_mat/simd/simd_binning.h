@@ -0,0 +1,153 @@
+/**
+ * @file simd_binning.h
+ *
+ * @brief Bin indices of packs over uniform bins
+ *
+ * simd_uniform_binner<T, Kind> maps each element x of a pack to the
+ * index of its bin among nb uniform bins over [lo, hi], that is,
+ * floor((x - lo) * scale) with scale = nb / (hi - lo), hi itself
+ * belonging to the last bin. Elements outside [lo, hi] (including
+ * NaN) are mapped to nb. The indices are computed by multiplication
+ * and truncation, and written as W 32-bit integers.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_SIMD_BINNING_H_
+#define LIGHTMAT_SIMD_BINNING_H_
+
+#include <light_mat/simd/simd_base.h>
+
+namespace lmat { namespace internal {
+
+	template<typename T, typename Kind>
+	struct simd_uniform_binner
+	{
+		static const bool available = false;
+	};
+
+
+	/********************************************
+	 *
+	 *  SSE
+	 *
+	 ********************************************/
+
+	template<>
+	struct simd_uniform_binner<float, sse_t>
+	{
+		static const bool available = true;
+
+		LMAT_ENSURE_INLINE
+		simd_uniform_binner(float lo, float hi, float scale, index_t nb)
+		: m_lo(_mm_set1_ps(lo)), m_hi(_mm_set1_ps(hi)), m_scale(_mm_set1_ps(scale))
+		, m_tmax(_mm_set1_ps(float(nb - 1))), m_nb(_mm_set1_ps(float(nb))) { }
+
+		LMAT_ENSURE_INLINE
+		void run(const simd_pack<float, sse_t>& x, int32_t *dst) const
+		{
+			__m128 in = _mm_and_ps(_mm_cmpge_ps(x, m_lo), _mm_cmple_ps(x, m_hi));
+			__m128 t = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(x, m_lo), m_scale), m_tmax);
+			t = _mm_or_ps(_mm_and_ps(in, t), _mm_andnot_ps(in, m_nb));
+			_mm_storeu_si128((__m128i*)dst, _mm_cvttps_epi32(t));
+		}
+
+	private:
+		__m128 m_lo, m_hi, m_scale, m_tmax, m_nb;
+	};
+
+	template<>
+	struct simd_uniform_binner<double, sse_t>
+	{
+		static const bool available = true;
+
+		LMAT_ENSURE_INLINE
+		simd_uniform_binner(double lo, double hi, double scale, index_t nb)
+		: m_lo(_mm_set1_pd(lo)), m_hi(_mm_set1_pd(hi)), m_scale(_mm_set1_pd(scale))
+		, m_tmax(_mm_set1_pd(double(nb - 1))), m_nb(_mm_set1_pd(double(nb))) { }
+
+		LMAT_ENSURE_INLINE
+		void run(const simd_pack<double, sse_t>& x, int32_t *dst) const
+		{
+			__m128d in = _mm_and_pd(_mm_cmpge_pd(x, m_lo), _mm_cmple_pd(x, m_hi));
+			__m128d t = _mm_min_pd(_mm_mul_pd(_mm_sub_pd(x, m_lo), m_scale), m_tmax);
+			t = _mm_or_pd(_mm_and_pd(in, t), _mm_andnot_pd(in, m_nb));
+			_mm_storel_epi64((__m128i*)dst, _mm_cvttpd_epi32(t));
+		}
+
+	private:
+		__m128d m_lo, m_hi, m_scale, m_tmax, m_nb;
+	};
+
+
+	/********************************************
+	 *
+	 *  AVX
+	 *
+	 ********************************************/
+
+#ifdef LMAT_HAS_AVX_PACKS
+
+#include "internal/avx_target_begin.h"
+
+	template<>
+	struct simd_uniform_binner<float, avx_t>
+	{
+		static const bool available = true;
+
+		LMAT_ENSURE_INLINE
+		simd_uniform_binner(float lo, float hi, float scale, index_t nb)
+		: m_lo(_mm256_set1_ps(lo)), m_hi(_mm256_set1_ps(hi)), m_scale(_mm256_set1_ps(scale))
+		, m_tmax(_mm256_set1_ps(float(nb - 1))), m_nb(_mm256_set1_ps(float(nb))) { }
+
+		LMAT_ENSURE_INLINE
+		void run(const simd_pack<float, avx_t>& x, int32_t *dst) const
+		{
+			__m256 in = _mm256_and_ps(
+					_mm256_cmp_ps(x, m_lo, _CMP_GE_OQ),
+					_mm256_cmp_ps(x, m_hi, _CMP_LE_OQ));
+			__m256 t = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(x, m_lo), m_scale), m_tmax);
+			t = _mm256_or_ps(_mm256_and_ps(in, t), _mm256_andnot_ps(in, m_nb));
+			_mm256_storeu_si256((__m256i*)dst, _mm256_cvttps_epi32(t));
+		}
+
+	private:
+		__m256 m_lo, m_hi, m_scale, m_tmax, m_nb;
+	};
+
+	template<>
+	struct simd_uniform_binner<double, avx_t>
+	{
+		static const bool available = true;
+
+		LMAT_ENSURE_INLINE
+		simd_uniform_binner(double lo, double hi, double scale, index_t nb)
+		: m_lo(_mm256_set1_pd(lo)), m_hi(_mm256_set1_pd(hi)), m_scale(_mm256_set1_pd(scale))
+		, m_tmax(_mm256_set1_pd(double(nb - 1))), m_nb(_mm256_set1_pd(double(nb))) { }
+
+		LMAT_ENSURE_INLINE
+		void run(const simd_pack<double, avx_t>& x, int32_t *dst) const
+		{
+			__m256d in = _mm256_and_pd(
+					_mm256_cmp_pd(x, m_lo, _CMP_GE_OQ),
+					_mm256_cmp_pd(x, m_hi, _CMP_LE_OQ));
+			__m256d t = _mm256_min_pd(_mm256_mul_pd(_mm256_sub_pd(x, m_lo), m_scale), m_tmax);
+			t = _mm256_or_pd(_mm256_and_pd(in, t), _mm256_andnot_pd(in, m_nb));
+			_mm_storeu_si128((__m128i*)dst, _mm256_cvttpd_epi32(t));
+		}
+
+	private:
+		__m256d m_lo, m_hi, m_scale, m_tmax, m_nb;
+	};
+
+#include "internal/avx_target_end.h"
+
+#endif
+
+} }
+
+#endif /* SIMD_BINNING_H_ */
@@ -0,0 +1,181 @@
+/**
+ * @file simd_dispatch.h
+ *
+ * @brief Run-time selection of SIMD code paths
+ *
+ * runtime_simd_level() reports the instruction set level of the host
+ * (numbered as LMAT_SIMD_LEVEL, with 9 for AVX-512F), detected via
+ * CPUID once per process. The environment variable LMAT_SIMD (e.g.
+ * "sse2", "avx", "avx2", or a number) may lower the level for testing;
+ * a level above the one detected is ignored.
+ *
+ * simd_dispatch(eligible, task, args...) runs task(kind, args...) with
+ * the widest pack kind that is both supported by the host and compiled
+ * into the binary. Without run-time dispatch (see LMAT_DISPATCH_AVX in
+ * simd_arch.h), or when eligible is false_, it simply uses the default
+ * kind. With run-time dispatch, the AVX version is compiled as a
+ * separate entry point for the AVX target, with the whole call tree
+ * inlined into it, which all hosts with AVX or above take. The packs
+ * have no code specific to later levels that could be selected at
+ * run-time (AVX2 gathers are only used when compiled in, see
+ * LMAT_HAS_AVX2), and there are no 512-bit packs. Calls through the
+ * entry point are counted as simd_path_ under the tag "dispatch.avx"
+ * (see instrument.h).
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_SIMD_DISPATCH_H_
+#define LIGHTMAT_SIMD_DISPATCH_H_
+
+#include <light_mat/simd/simd.h>
+#include <light_mat/common/instrument.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#define LMAT_SIMD_LEVEL_AVX512 9
+
+namespace lmat
+{
+
+	/********************************************
+	 *
+	 *  instruction set levels
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		inline int _detect_simd_level()
+		{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+			__builtin_cpu_init();
+
+			if (__builtin_cpu_supports("avx512f")) return LMAT_SIMD_LEVEL_AVX512;
+			if (__builtin_cpu_supports("avx2")) return 8;
+			if (__builtin_cpu_supports("avx")) return 7;
+			if (__builtin_cpu_supports("sse4.2")) return 6;
+			if (__builtin_cpu_supports("sse4.1")) return 5;
+			if (__builtin_cpu_supports("ssse3")) return 4;
+			if (__builtin_cpu_supports("sse3")) return 3;
+			return 2;
+#else
+			return LMAT_SIMD_LEVEL;
+#endif
+		}
+
+		// returns -1 if the name is not recognized
+
+		inline int _parse_simd_level(const char *s)
+		{
+			static const char *names[] = {
+				"", "sse", "sse2", "sse3", "ssse3", "sse4.1", "sse4.2",
+				"avx", "avx2", "avx512" };
+
+			for (int i = 1; i <= LMAT_SIMD_LEVEL_AVX512; ++i)
+			{
+				if (std::strcmp(s, names[i]) == 0) return i;
+			}
+
+			if (s[0] >= '0' && s[0] <= '9' && s[1] == '\0') return s[0] - '0';
+
+			return -1;
+		}
+
+		inline int _init_simd_level()
+		{
+			int lv = _detect_simd_level();
+
+			const char *s = std::getenv("LMAT_SIMD");
+			if (s)
+			{
+				int r = _parse_simd_level(s);
+				if (r >= 0 && r < lv) lv = r;
+			}
+			return lv;
+		}
+	}
+
+	inline int runtime_simd_level()
+	{
+		static const int lv = internal::_init_simd_level();
+		return lv;
+	}
+
+	inline const char* simd_level_name(int lv)
+	{
+		switch (lv)
+		{
+		case 1: return "sse";
+		case 2: return "sse2";
+		case 3: return "sse3";
+		case 4: return "ssse3";
+		case 5: return "sse4.1";
+		case 6: return "sse4.2";
+		case 7: return "avx";
+		case 8: return "avx2";
+		case LMAT_SIMD_LEVEL_AVX512: return "avx512";
+		}
+		return "none";
+	}
+
+
+	/********************************************
+	 *
+	 *  dispatch
+	 *
+	 ********************************************/
+
+	namespace internal
+	{
+		template<class Task, typename... Args>
+		LMAT_ENSURE_INLINE
+		inline typename Task::result_type
+		simd_dispatch(meta::false_, const Task& task, const Args&... args)
+		{
+			return task(default_simd_kind(), args...);
+		}
+
+#ifdef LMAT_DISPATCH_AVX
+
+		template<class Task, typename... Args>
+		__attribute__((target("avx"), flatten))
+		typename Task::result_type
+		_simd_dispatch_avx(const Task& task, const Args&... args)
+		{
+			LMAT_INSTRUMENT_PATH("dispatch.avx", true)
+			return task(avx_t(), args...);
+		}
+
+		template<class Task, typename... Args>
+		inline typename Task::result_type
+		simd_dispatch(meta::true_, const Task& task, const Args&... args)
+		{
+			if (runtime_simd_level() >= 7)
+				return _simd_dispatch_avx(task, args...);
+			else
+				return task(sse_t(), args...);
+		}
+
+#else
+
+		template<class Task, typename... Args>
+		LMAT_ENSURE_INLINE
+		inline typename Task::result_type
+		simd_dispatch(meta::true_, const Task& task, const Args&... args)
+		{
+			return task(default_simd_kind(), args...);
+		}
+
+#endif
+
+	}
+
+}
+
+#endif /* SIMD_DISPATCH_H_ */
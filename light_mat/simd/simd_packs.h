@@ -19,7 +19,7 @@
 #include <light_mat/simd/sse_bpacks.h>
 #include <light_mat/simd/sse_reduce.h>
 
-#ifdef LMAT_HAS_AVX
+#ifdef LMAT_HAS_AVX_PACKS
 #include <light_mat/simd/avx_packs.h>
 #include <light_mat/simd/avx_bpacks.h>
 #include <light_mat/simd/avx_reduce.h>
@@ -0,0 +1,186 @@
+/**
+ * @file simd_scan.h
+ *
+ * @brief In-register inclusive scans of packs
+ *
+ * simd_prefix_scanner<T, Kind>::run(x, e, op) computes the inclusive
+ * scan of the elements of a pack x under an associative and commutative
+ * operation op (invoked as op(a, b) to set a to a (+) b), whose identity
+ * is broadcasted in e. It takes log2(W) shift-and-combine steps, the
+ * shifts being done with shuffles that fill the vacated lower positions
+ * with the identity.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_SIMD_SCAN_H_
+#define LIGHTMAT_SIMD_SCAN_H_
+
+#include <light_mat/simd/simd_base.h>
+
+namespace lmat { namespace internal {
+
+	template<typename T, typename Kind>
+	struct simd_prefix_scanner
+	{
+		static const bool available = false;
+	};
+
+
+	/********************************************
+	 *
+	 *  SSE
+	 *
+	 ********************************************/
+
+	template<>
+	struct simd_prefix_scanner<float, sse_t>
+	{
+		static const bool available = true;
+		typedef simd_pack<float, sse_t> pack_t;
+
+		// [e, x0, x1, x2]
+		LMAT_ENSURE_INLINE
+		static pack_t shift1(const pack_t& x, const pack_t& e)
+		{
+			__m128 u = _mm_shuffle_ps(e, x, _MM_SHUFFLE(0, 0, 3, 3));
+			return _mm_shuffle_ps(u, x, _MM_SHUFFLE(2, 1, 2, 0));
+		}
+
+		// [e, e, x0, x1]
+		LMAT_ENSURE_INLINE
+		static pack_t shift2(const pack_t& x, const pack_t& e)
+		{
+			return _mm_shuffle_ps(e, x, _MM_SHUFFLE(1, 0, 3, 2));
+		}
+
+		template<class Op>
+		LMAT_ENSURE_INLINE
+		static pack_t run(pack_t x, const pack_t& e, const Op& op)
+		{
+			op(x, shift1(x, e));
+			op(x, shift2(x, e));
+			return x;
+		}
+	};
+
+	template<>
+	struct simd_prefix_scanner<double, sse_t>
+	{
+		static const bool available = true;
+		typedef simd_pack<double, sse_t> pack_t;
+
+		// [e, x0]
+		LMAT_ENSURE_INLINE
+		static pack_t shift1(const pack_t& x, const pack_t& e)
+		{
+			return _mm_shuffle_pd(e, x, 0);
+		}
+
+		template<class Op>
+		LMAT_ENSURE_INLINE
+		static pack_t run(pack_t x, const pack_t& e, const Op& op)
+		{
+			op(x, shift1(x, e));
+			return x;
+		}
+	};
+
+
+	/********************************************
+	 *
+	 *  AVX
+	 *
+	 *  Only AVX1 shuffles are used, so an
+	 *  element crosses the 128-bit lanes
+	 *  through permute2f128.
+	 *
+	 ********************************************/
+
+#ifdef LMAT_HAS_AVX_PACKS
+
+#include "internal/avx_target_begin.h"
+
+	template<>
+	struct simd_prefix_scanner<float, avx_t>
+	{
+		static const bool available = true;
+		typedef simd_pack<float, avx_t> pack_t;
+
+		// [e, x0, ..., x6]
+		LMAT_ENSURE_INLINE
+		static pack_t shift1(const pack_t& x, const pack_t& e)
+		{
+			__m256 t = _mm256_permute2f128_ps(x, e, 0x02);
+			__m256 u = _mm256_shuffle_ps(t, x, _MM_SHUFFLE(0, 0, 3, 3));
+			return _mm256_shuffle_ps(u, x, _MM_SHUFFLE(2, 1, 2, 0));
+		}
+
+		// [e, e, x0, ..., x5]
+		LMAT_ENSURE_INLINE
+		static pack_t shift2(const pack_t& x, const pack_t& e)
+		{
+			__m256 t = _mm256_permute2f128_ps(x, e, 0x02);
+			return _mm256_shuffle_ps(t, x, _MM_SHUFFLE(1, 0, 3, 2));
+		}
+
+		// [e, e, e, e, x0, ..., x3]
+		LMAT_ENSURE_INLINE
+		static pack_t shift4(const pack_t& x, const pack_t& e)
+		{
+			return _mm256_permute2f128_ps(x, e, 0x02);
+		}
+
+		template<class Op>
+		LMAT_ENSURE_INLINE
+		static pack_t run(pack_t x, const pack_t& e, const Op& op)
+		{
+			op(x, shift1(x, e));
+			op(x, shift2(x, e));
+			op(x, shift4(x, e));
+			return x;
+		}
+	};
+
+	template<>
+	struct simd_prefix_scanner<double, avx_t>
+	{
+		static const bool available = true;
+		typedef simd_pack<double, avx_t> pack_t;
+
+		// [e, x0, x1, x2]
+		LMAT_ENSURE_INLINE
+		static pack_t shift1(const pack_t& x, const pack_t& e)
+		{
+			__m256d t = _mm256_permute2f128_pd(x, e, 0x02);
+			return _mm256_shuffle_pd(t, x, 0x4);
+		}
+
+		// [e, e, x0, x1]
+		LMAT_ENSURE_INLINE
+		static pack_t shift2(const pack_t& x, const pack_t& e)
+		{
+			return _mm256_permute2f128_pd(x, e, 0x02);
+		}
+
+		template<class Op>
+		LMAT_ENSURE_INLINE
+		static pack_t run(pack_t x, const pack_t& e, const Op& op)
+		{
+			op(x, shift1(x, e));
+			op(x, shift2(x, e));
+			return x;
+		}
+	};
+
+#include "internal/avx_target_end.h"
+
+#endif
+
+} }
+
+#endif /* SIMD_SCAN_H_ */
@@ -0,0 +1,175 @@
+/**
+ * @file simd_transpose.h
+ *
+ * @brief In-register transposition of small square tiles
+ *
+ * simd_tile_transposer<T, Kind>::run transposes a W x W tile (W being
+ * the pack width) of a column-major matrix: W columns are loaded into
+ * W packs, transposed within the registers, and written as W columns
+ * of the destination. Both source and destination columns must be
+ * contiguous.
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_SIMD_TRANSPOSE_H_
+#define LIGHTMAT_SIMD_TRANSPOSE_H_
+
+#include <light_mat/simd/simd_base.h>
+
+namespace lmat { namespace internal {
+
+	template<typename T, typename Kind>
+	struct simd_tile_transposer
+	{
+		static const bool available = false;
+	};
+
+
+	/********************************************
+	 *
+	 *  SSE
+	 *
+	 ********************************************/
+
+	template<>
+	struct simd_tile_transposer<float, sse_t>
+	{
+		static const bool available = true;
+		static const index_t size = 4;
+
+		LMAT_ENSURE_INLINE
+		static void run(const float *s, index_t scs, float *d, index_t dcs)
+		{
+			__m128 r0 = _mm_loadu_ps(s);
+			__m128 r1 = _mm_loadu_ps(s + scs);
+			__m128 r2 = _mm_loadu_ps(s + 2 * scs);
+			__m128 r3 = _mm_loadu_ps(s + 3 * scs);
+
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+			_mm_storeu_ps(d, r0);
+			_mm_storeu_ps(d + dcs, r1);
+			_mm_storeu_ps(d + 2 * dcs, r2);
+			_mm_storeu_ps(d + 3 * dcs, r3);
+		}
+	};
+
+	template<>
+	struct simd_tile_transposer<double, sse_t>
+	{
+		static const bool available = true;
+		static const index_t size = 2;
+
+		LMAT_ENSURE_INLINE
+		static void run(const double *s, index_t scs, double *d, index_t dcs)
+		{
+			__m128d r0 = _mm_loadu_pd(s);
+			__m128d r1 = _mm_loadu_pd(s + scs);
+
+			_mm_storeu_pd(d,       _mm_unpacklo_pd(r0, r1));
+			_mm_storeu_pd(d + dcs, _mm_unpackhi_pd(r0, r1));
+		}
+	};
+
+
+	/********************************************
+	 *
+	 *  AVX
+	 *
+	 ********************************************/
+
+#ifdef LMAT_HAS_AVX_PACKS
+
+#include "internal/avx_target_begin.h"
+
+	template<>
+	struct simd_tile_transposer<float, avx_t>
+	{
+		static const bool available = true;
+		static const index_t size = 8;
+
+		LMAT_ENSURE_INLINE
+		static void run(const float *s, index_t scs, float *d, index_t dcs)
+		{
+			__m256 r0 = _mm256_loadu_ps(s);
+			__m256 r1 = _mm256_loadu_ps(s + scs);
+			__m256 r2 = _mm256_loadu_ps(s + 2 * scs);
+			__m256 r3 = _mm256_loadu_ps(s + 3 * scs);
+			__m256 r4 = _mm256_loadu_ps(s + 4 * scs);
+			__m256 r5 = _mm256_loadu_ps(s + 5 * scs);
+			__m256 r6 = _mm256_loadu_ps(s + 6 * scs);
+			__m256 r7 = _mm256_loadu_ps(s + 7 * scs);
+
+			// interleave pairs within each 128-bit lane
+
+			__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+			__m256 t1 = _mm256_unpackhi_ps(r0, r1);
+			__m256 t2 = _mm256_unpacklo_ps(r2, r3);
+			__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+			__m256 t4 = _mm256_unpacklo_ps(r4, r5);
+			__m256 t5 = _mm256_unpackhi_ps(r4, r5);
+			__m256 t6 = _mm256_unpacklo_ps(r6, r7);
+			__m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+			// 4 x 4 transposes within each 128-bit lane
+
+			r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+			r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+			r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+			r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+			r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+			// exchange the lanes
+
+			_mm256_storeu_ps(d,           _mm256_permute2f128_ps(r0, r4, 0x20));
+			_mm256_storeu_ps(d + dcs,     _mm256_permute2f128_ps(r1, r5, 0x20));
+			_mm256_storeu_ps(d + 2 * dcs, _mm256_permute2f128_ps(r2, r6, 0x20));
+			_mm256_storeu_ps(d + 3 * dcs, _mm256_permute2f128_ps(r3, r7, 0x20));
+			_mm256_storeu_ps(d + 4 * dcs, _mm256_permute2f128_ps(r0, r4, 0x31));
+			_mm256_storeu_ps(d + 5 * dcs, _mm256_permute2f128_ps(r1, r5, 0x31));
+			_mm256_storeu_ps(d + 6 * dcs, _mm256_permute2f128_ps(r2, r6, 0x31));
+			_mm256_storeu_ps(d + 7 * dcs, _mm256_permute2f128_ps(r3, r7, 0x31));
+		}
+	};
+
+	template<>
+	struct simd_tile_transposer<double, avx_t>
+	{
+		static const bool available = true;
+		static const index_t size = 4;
+
+		LMAT_ENSURE_INLINE
+		static void run(const double *s, index_t scs, double *d, index_t dcs)
+		{
+			__m256d r0 = _mm256_loadu_pd(s);
+			__m256d r1 = _mm256_loadu_pd(s + scs);
+			__m256d r2 = _mm256_loadu_pd(s + 2 * scs);
+			__m256d r3 = _mm256_loadu_pd(s + 3 * scs);
+
+			__m256d t0 = _mm256_unpacklo_pd(r0, r1);
+			__m256d t1 = _mm256_unpackhi_pd(r0, r1);
+			__m256d t2 = _mm256_unpacklo_pd(r2, r3);
+			__m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+			_mm256_storeu_pd(d,           _mm256_permute2f128_pd(t0, t2, 0x20));
+			_mm256_storeu_pd(d + dcs,     _mm256_permute2f128_pd(t1, t3, 0x20));
+			_mm256_storeu_pd(d + 2 * dcs, _mm256_permute2f128_pd(t0, t2, 0x31));
+			_mm256_storeu_pd(d + 3 * dcs, _mm256_permute2f128_pd(t1, t3, 0x31));
+		}
+	};
+
+#include "internal/avx_target_end.h"
+
+#endif
+
+} }
+
+#endif /* SIMD_TRANSPOSE_H_ */
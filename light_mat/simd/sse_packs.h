@@ -158,6 +158,12 @@ namespace lmat {
 	    	v = internal::sse_loadpart_f32(n, p);
 	    }
 
+	    // n must be in [1, 4] (n known at run-time)
+	    LMAT_ENSURE_INLINE void load_part(index_t n, float const * p)
+	    {
+	    	v = internal::sse_loadpart_f32(n, p);
+	    }
+
 
 	    // store
 
@@ -171,12 +177,39 @@ namespace lmat {
 	    	_mm_store_ps(p, v);
 	    }
 
+	    // non-temporal store (p must be aligned), which bypasses the cache
+	    LMAT_ENSURE_INLINE void store_nt(float *p) const
+	    {
+	    	_mm_stream_ps(p, v);
+	    }
+
 	    template<unsigned int N>
 	    LMAT_ENSURE_INLINE void store_part(siz_<N> n, float *p) const
 	    {
 	    	internal::sse_storepart_f32(n, p, v);
 	    }
 
+	    // n must be in [1, 4] (n known at run-time)
+	    LMAT_ENSURE_INLINE void store_part(index_t n, float *p) const
+	    {
+	    	internal::sse_storepart_f32(n, p, v);
+	    }
+
+
+	    // strided load & store
+
+	    LMAT_ENSURE_INLINE void load_strided(const float *p, index_t step)
+	    {
+	    	v = _mm_setr_ps(p[0], p[step], p[2 * step], p[3 * step]);
+	    }
+
+	    LMAT_ENSURE_INLINE void store_strided(float *p, index_t step) const
+	    {
+	    	_mm_store_ss(p, v);
+	    	_mm_store_ss(p + step,     _mm_shuffle_ps(v, v, 1));
+	    	_mm_store_ss(p + 2 * step, _mm_movehl_ps(v, v));
+	    	_mm_store_ss(p + 3 * step, _mm_shuffle_ps(v, v, 3));
+	    }
 
 	    // extract
 
@@ -325,6 +358,12 @@ namespace lmat {
 	    	v = internal::sse_loadpart_f64(n, p);
 	    }
 
+	    // n must be in [1, 2] (n known at run-time)
+	    LMAT_ENSURE_INLINE void load_part(index_t n, double const * p)
+	    {
+	    	v = internal::sse_loadpart_f64(n, p);
+	    }
+
 	    // store
 
 	    LMAT_ENSURE_INLINE void store_u(double *p) const
@@ -337,12 +376,37 @@ namespace lmat {
 	    	_mm_store_pd(p, v);
 	    }
 
+	    // non-temporal store (p must be aligned), which bypasses the cache
+	    LMAT_ENSURE_INLINE void store_nt(double *p) const
+	    {
+	    	_mm_stream_pd(p, v);
+	    }
+
 	    template<unsigned int N>
 	    LMAT_ENSURE_INLINE void store_part(siz_<N> n, double *p) const
 	    {
 	    	internal::sse_storepart_f64(n, p, v);
 	    }
 
+	    // n must be in [1, 2] (n known at run-time)
+	    LMAT_ENSURE_INLINE void store_part(index_t n, double *p) const
+	    {
+	    	internal::sse_storepart_f64(n, p, v);
+	    }
+
+
+	    // strided load & store
+
+	    LMAT_ENSURE_INLINE void load_strided(const double *p, index_t step)
+	    {
+	    	v = _mm_loadh_pd(_mm_load_sd(p), p + step);
+	    }
+
+	    LMAT_ENSURE_INLINE void store_strided(double *p, index_t step) const
+	    {
+	    	_mm_store_sd(p, v);
+	    	_mm_storeh_pd(p + step, v);
+	    }
 
 	    // extract
 
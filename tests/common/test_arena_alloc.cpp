@@ -0,0 +1,259 @@
+/**
+ * @file test_arena_alloc.cpp
+ *
+ * Unit testing for arena and pool allocation
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+
+#include <light_mat/common/arena_alloc.h>
+#include <light_mat/common/block.h>
+#include <cstring>
+
+using namespace lmat;
+using namespace lmat::test;
+
+// explicit instantiation
+
+template class lmat::arena_allocator<double>;
+template class lmat::pool_allocator<double>;
+template class lmat::dblock<double, arena_allocator<double> >;
+template class lmat::dblock<double, pool_allocator<double> >;
+
+inline bool is_aligned_to(const void *p, size_t a)
+{
+	return (reinterpret_cast<size_t>(p) & (a - 1)) == 0;
+}
+
+
+SIMPLE_CASE( arena_bump )
+{
+	memory_arena arena(1024);
+
+	ASSERT_EQ( arena.num_chunks(), 0 );
+	ASSERT_EQ( arena.used_bytes(), 0 );
+
+	char *p1 = (char*)arena.allocate(100, 16);
+	char *p2 = (char*)arena.allocate(50, 32);
+	char *p3 = (char*)arena.allocate(8, 16);
+
+	ASSERT_EQ( arena.num_chunks(), 1 );
+	ASSERT_TRUE( is_aligned_to(p1, 16) );
+	ASSERT_TRUE( is_aligned_to(p2, 32) );
+	ASSERT_TRUE( is_aligned_to(p3, 16) );
+
+	ASSERT_EQ( p2 - p1, 128 );
+	ASSERT_EQ( p3 - p2, 64 );
+	ASSERT_EQ( arena.used_bytes(), 200 );
+
+	// only the top allocation is rewound
+
+	arena.deallocate(p2, 50);
+	ASSERT_EQ( arena.used_bytes(), 200 );
+	arena.deallocate(p3, 8);
+	ASSERT_EQ( arena.used_bytes(), 192 );
+
+	// spill to a new chunk
+
+	char *p4 = (char*)arena.allocate(1000, 16);
+	ASSERT_EQ( arena.num_chunks(), 2 );
+	ASSERT_EQ( arena.used_bytes(), 1024 + 1000 );
+
+	// oversized request
+
+	char *p5 = (char*)arena.allocate(3000, 16);
+	ASSERT_EQ( arena.num_chunks(), 3 );
+	ASSERT_TRUE( is_aligned_to(p5, 16) );
+	ASSERT_NE( p4, p5 );
+
+	size_t cap = arena.capacity();
+	ASSERT_EQ( cap, 1024 + 1024 + 3000 );
+
+	// reset retains the chunks
+
+	arena.reset();
+	ASSERT_EQ( arena.used_bytes(), 0 );
+	ASSERT_EQ( arena.capacity(), cap );
+
+	char *q1 = (char*)arena.allocate(100, 16);
+	ASSERT_EQ( q1, p1 );
+}
+
+
+SIMPLE_CASE( arena_regrow_after_rewind )
+{
+	memory_arena arena(1024);
+
+	arena_marker mk = arena.mark();
+	arena.allocate(1000, 16);
+	arena.allocate(1000, 16);
+	arena.allocate(1000, 16);
+	ASSERT_EQ( arena.num_chunks(), 3 );
+
+	// the retained chunks after the first are all too small
+
+	arena.rewind(mk);
+	arena.allocate(1000, 16);
+
+	char *p = (char*)arena.allocate(4096, 32);
+	ASSERT_TRUE( is_aligned_to(p, 32) );
+	ASSERT_EQ( arena.num_chunks(), 2 );
+	ASSERT_EQ( arena.capacity(), 1024 + 4096 );
+	std::memset(p, 0, 4096);
+
+	// a stricter alignment than the retained chunks provide
+
+	arena.reset();
+	char *q = (char*)arena.allocate(256, 256);
+	ASSERT_TRUE( is_aligned_to(q, 256) );
+	std::memset(q, 0, 256);
+
+	char *q2 = (char*)arena.allocate(100, 256);
+	ASSERT_TRUE( is_aligned_to(q2, 256) );
+}
+
+
+SIMPLE_CASE( arena_scoped_use )
+{
+	memory_arena arena(1024);
+	ASSERT_TRUE( memory_arena::current() == 0 );
+
+	arena.allocate(64, 16);
+	ASSERT_EQ( arena.used_bytes(), 64 );
+
+	{
+		arena_scope s(arena);
+		ASSERT_TRUE( memory_arena::current() == &arena );
+
+		arena_allocator<double> alloc;
+		ASSERT_TRUE( alloc.arena() == &arena );
+
+		double *p = alloc.allocate(10);
+		ASSERT_TRUE( is_aligned_to(p, 16) );
+		ASSERT_EQ( arena.used_bytes(), 64 + 80 );
+
+		memory_arena inner(256);
+		{
+			arena_scope s2(inner);
+			ASSERT_TRUE( memory_arena::current() == &inner );
+		}
+		ASSERT_TRUE( memory_arena::current() == &arena );
+	}
+
+	ASSERT_TRUE( memory_arena::current() == 0 );
+	ASSERT_EQ( arena.used_bytes(), 64 );
+
+	// falls back to heap without a current arena
+
+	arena_allocator<double> halloc;
+	ASSERT_TRUE( halloc.arena() == 0 );
+
+	double *h = halloc.allocate(10);
+	ASSERT_TRUE( is_aligned_to(h, LMAT_DEFAULT_ALIGNMENT) );
+	halloc.deallocate(h, 10);
+}
+
+
+SIMPLE_CASE( pool_reuse )
+{
+	ASSERT_EQ( memory_pool::class_of(1), 0 );
+	ASSERT_EQ( memory_pool::class_of(64), 0 );
+	ASSERT_EQ( memory_pool::class_of(65), 1 );
+	ASSERT_EQ( memory_pool::class_of(4096), 6 );
+
+	memory_pool pool;
+
+	void *p1 = pool.allocate(100);
+	void *p2 = pool.allocate(120);
+	ASSERT_TRUE( is_aligned_to(p1, memory_pool::alignment) );
+	ASSERT_TRUE( is_aligned_to(p2, memory_pool::alignment) );
+	ASSERT_NE( p1, p2 );
+
+	pool.deallocate(p1, 100);
+	pool.deallocate(p2, 120);
+	ASSERT_EQ( pool.num_cached(1), 2 );
+
+	// same size class: recycled in LIFO order
+
+	void *q1 = pool.allocate(128);
+	void *q2 = pool.allocate(65);
+	ASSERT_EQ( q1, p2 );
+	ASSERT_EQ( q2, p1 );
+	ASSERT_EQ( pool.num_cached(1), 0 );
+
+	pool.deallocate(q1, 128);
+	pool.deallocate(q2, 65);
+
+	// large blocks bypass the pool
+
+	size_t big = memory_pool::max_class_size() + 1;
+	void *b = pool.allocate(big);
+	pool.deallocate(b, big);
+
+	pool.trim();
+	ASSERT_EQ( pool.num_cached(1), 0 );
+}
+
+
+SIMPLE_CASE( pool_scoped_use )
+{
+	memory_pool pool;
+	ASSERT_TRUE( memory_pool::current() == 0 );
+
+	{
+		pool_scope s(pool);
+		ASSERT_TRUE( memory_pool::current() == &pool );
+
+		const double *p0 = 0;
+		{
+			dblock<double, pool_allocator<double> > a(20, fill(1.5));
+			ASSERT_TRUE( a.get_allocator().pool() == &pool );
+			p0 = a.ptr_data();
+		}
+
+		dblock<double, pool_allocator<double> > b(20, fill(2.5));
+		ASSERT_EQ( b.ptr_data(), p0 );
+		ASSERT_EQ( b[19], 2.5 );
+	}
+
+	ASSERT_TRUE( memory_pool::current() == 0 );
+}
+
+
+SIMPLE_CASE( arena_dblock )
+{
+	typedef dblock<double, arena_allocator<double> > blk_t;
+
+	memory_arena arena;
+	const index_t n = 7;
+
+	arena_scope s(arena);
+
+	blk_t a(n, fill(3.0));
+	ASSERT_TRUE( a.get_allocator().arena() == &arena );
+
+	blk_t b(a);
+	ASSERT_NE( b.ptr_data(), a.ptr_data() );
+	ASSERT_VEC_EQ( n, a, b );
+
+	blk_t c(std::move(b));
+	ASSERT_EQ( b.ptr_data(), 0 );
+	ASSERT_TRUE( c.get_allocator().arena() == &arena );
+	ASSERT_VEC_EQ( n, a, c );
+}
+
+
+AUTO_TPACK( arena_alloc )
+{
+	ADD_SIMPLE_CASE( arena_bump )
+	ADD_SIMPLE_CASE( arena_scoped_use )
+	ADD_SIMPLE_CASE( arena_dblock )
+}
+
+AUTO_TPACK( pool_alloc )
+{
+	ADD_SIMPLE_CASE( pool_reuse )
+	ADD_SIMPLE_CASE( pool_scoped_use )
+}
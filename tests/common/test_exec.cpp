@@ -0,0 +1,250 @@
+/**
+ * @file test_exec.cpp
+ *
+ * Unit testing for executors and parallel_for
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+
+#include <light_mat/common/exec.h>
+#include <stdexcept>
+
+using namespace lmat;
+using namespace lmat::test;
+using namespace lmat::exec;
+
+
+// an injected executor, which runs tasks on the caller and counts them
+
+class counting_executor : public executor
+{
+public:
+	counting_executor(unsigned int c) : m_conc(c), m_nruns(0), m_ntasks(0) { }
+
+	unsigned int concurrency() const { return m_conc; }
+
+	void bulk_run(index_t n, const task_fun& f)
+	{
+		++ m_nruns;
+		m_ntasks += n;
+		for (index_t i = 0; i < n; ++i) f(i);
+	}
+
+	index_t nruns() const { return m_nruns; }
+	index_t ntasks() const { return m_ntasks; }
+
+private:
+	unsigned int m_conc;
+	index_t m_nruns;
+	index_t m_ntasks;
+};
+
+
+// checks that each index of [0, n) is visited once, by blocks of at least grain
+
+inline bool test_coverage(executor& ex, index_t n, index_t grain)
+{
+	std::vector<std::atomic<int> > hits(static_cast<size_t>(n));
+	for (index_t i = 0; i < n; ++i) hits[static_cast<size_t>(i)].store(0);
+
+	std::atomic<bool> short_block(false);
+
+	parallel_for(ex, range(0, n), grain, [&](const range& r)
+	{
+		if (r.num() < grain && r.num() < n) short_block.store(true);
+		for (index_t i = r.begin_index(); i < r.end_index(); ++i)
+			hits[static_cast<size_t>(i)].fetch_add(1);
+	});
+
+	if (short_block.load()) return false;
+	for (index_t i = 0; i < n; ++i)
+	{
+		if (hits[static_cast<size_t>(i)].load() != 1) return false;
+	}
+	return true;
+}
+
+
+SIMPLE_CASE( work_deque_ops )
+{
+	exec::internal::bulk_job *job = 0;
+	exec::internal::pool_task t[3] = { {job, 0}, {job, 1}, {job, 2} };
+
+	work_deque dq;
+	ASSERT_EQ( dq.size(), 0 );
+	ASSERT_TRUE( dq.pop() == 0 );
+	ASSERT_TRUE( dq.steal() == 0 );
+
+	ASSERT_TRUE( dq.push(t) );
+	ASSERT_TRUE( dq.push(t + 1) );
+	ASSERT_TRUE( dq.push(t + 2) );
+	ASSERT_EQ( dq.size(), 3 );
+
+	// the owner pops the newest, the thieves steal the oldest
+
+	ASSERT_TRUE( dq.pop() == t + 2 );
+	ASSERT_TRUE( dq.steal() == t );
+	ASSERT_TRUE( dq.pop() == t + 1 );
+	ASSERT_TRUE( dq.pop() == 0 );
+	ASSERT_TRUE( dq.steal() == 0 );
+	ASSERT_EQ( dq.size(), 0 );
+
+	// it does not grow
+
+	for (int64_t i = 0; i < work_deque::capacity; ++i) ASSERT_TRUE( dq.push(t) );
+	ASSERT_FALSE( dq.push(t) );
+}
+
+
+SIMPLE_CASE( par_blocks )
+{
+	ASSERT_EQ( exec::internal::num_par_blocks(100, 10, 1), 1 );
+	ASSERT_EQ( exec::internal::num_par_blocks(100, 10, 4), 10 );
+	ASSERT_EQ( exec::internal::num_par_blocks(100, 1, 4), 4 * LMAT_PAR_BLOCKS_PER_THREAD );
+	ASSERT_EQ( exec::internal::num_par_blocks(100, 0, 4), 4 * LMAT_PAR_BLOCKS_PER_THREAD );
+	ASSERT_EQ( exec::internal::num_par_blocks(8, 10, 4), 1 );
+	ASSERT_EQ( exec::internal::num_par_blocks(25, 10, 4), 2 );
+
+	ASSERT_EQ( exec::internal::par_block_begin(25, 2, 0), 0 );
+	ASSERT_EQ( exec::internal::par_block_begin(25, 2, 1), 12 );
+	ASSERT_EQ( exec::internal::par_block_begin(25, 2, 2), 25 );
+}
+
+
+SIMPLE_CASE( serial_parallel_for )
+{
+	serial_executor ex;
+
+	ASSERT_TRUE( test_coverage(ex, 0, 1) );
+	ASSERT_TRUE( test_coverage(ex, 1, 1) );
+	ASSERT_TRUE( test_coverage(ex, 100, 7) );
+}
+
+
+SIMPLE_CASE( pool_parallel_for )
+{
+	thread_pool pool(4);
+	ASSERT_EQ( pool.num_workers(), 3 );
+	ASSERT_EQ( pool.concurrency(), 4 );
+
+	const index_t ns[] = {0, 1, 5, 16, 17, 100, 1000, 12345};
+	const index_t gs[] = {1, 3, 16, 100};
+
+	for (int i = 0; i < 8; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			ASSERT_TRUE( test_coverage(pool, ns[i], gs[j]) );
+		}
+	}
+
+	// repeated submissions (the workers go to sleep in between)
+
+	for (int k = 0; k < 200; ++k)
+	{
+		ASSERT_TRUE( test_coverage(pool, 64, 1) );
+	}
+}
+
+
+SIMPLE_CASE( pool_nested )
+{
+	thread_pool pool(3);
+
+	const index_t m = 37;
+	const index_t n = 53;
+	std::vector<std::atomic<int> > hits(static_cast<size_t>(m * n));
+	for (size_t i = 0; i < hits.size(); ++i) hits[i].store(0);
+
+	parallel_for(pool, range(0, n), 1, [&](const range& cols)
+	{
+		// nested ones go to the same pool
+
+		ASSERT_TRUE( &current_executor() == &pool );
+
+		for (index_t j = cols.begin_index(); j < cols.end_index(); ++j)
+		{
+			parallel_for(range(0, m), 4, [&](const range& rows)
+			{
+				for (index_t i = rows.begin_index(); i < rows.end_index(); ++i)
+					hits[static_cast<size_t>(i + j * m)].fetch_add(1);
+			});
+		}
+	});
+
+	for (size_t i = 0; i < hits.size(); ++i)
+	{
+		ASSERT_EQ( hits[i].load(), 1 );
+	}
+}
+
+
+SIMPLE_CASE( pool_exceptions )
+{
+	thread_pool pool(4);
+
+	bool caught = false;
+	try
+	{
+		pool.bulk_run(50, [](index_t i)
+		{
+			if (i == 17) throw std::runtime_error("task failure");
+		});
+	}
+	catch (std::runtime_error& )
+	{
+		caught = true;
+	}
+	ASSERT_TRUE( caught );
+
+	// still usable afterwards
+	ASSERT_TRUE( test_coverage(pool, 1000, 10) );
+}
+
+
+SIMPLE_CASE( injected_executor )
+{
+	counting_executor ex(8);
+
+	// scoped
+
+	{
+		executor_scope s(ex);
+		ASSERT_TRUE( &current_executor() == &ex );
+
+		index_t total = 0;
+		parallel_for(100, 10, [&](const range& r) { total += r.num(); });
+
+		ASSERT_EQ( total, 100 );
+		ASSERT_EQ( ex.nruns(), 1 );
+		ASSERT_EQ( ex.ntasks(), 10 );
+	}
+	ASSERT_TRUE( &current_executor() == &global_thread_pool() );
+
+	// as the default
+
+	set_default_executor(&ex);
+	ASSERT_TRUE( &current_executor() == &ex );
+
+	index_t total = 0;
+	parallel_for(range(5, 50), 100, [&](const range& r) { total += r.num(); });
+	ASSERT_EQ( total, 50 );
+	ASSERT_EQ( ex.nruns(), 1 );  // shorter than the grain: run on the caller
+
+	set_default_executor(0);
+	ASSERT_TRUE( &current_executor() == &global_thread_pool() );
+}
+
+
+AUTO_TPACK( exec )
+{
+	ADD_SIMPLE_CASE( work_deque_ops )
+	ADD_SIMPLE_CASE( par_blocks )
+	ADD_SIMPLE_CASE( serial_parallel_for )
+	ADD_SIMPLE_CASE( pool_parallel_for )
+	ADD_SIMPLE_CASE( pool_nested )
+	ADD_SIMPLE_CASE( pool_exceptions )
+	ADD_SIMPLE_CASE( injected_executor )
+}
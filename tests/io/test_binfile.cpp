@@ -0,0 +1,213 @@
+/**
+ * @file test_binfile.cpp
+ *
+ * Unit testing of binary matrix files
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+#include <light_mat/io/matrix_binfile.h>
+#include <cstdio>
+
+using namespace lmat;
+using namespace lmat::test;
+
+const char *binmat_path = "test_binfile.tmp";
+
+template<typename T>
+void fill_seq(dense_matrix<T>& a)
+{
+	for (index_t i = 0; i < a.nelems(); ++i) a[i] = T(i + 1);
+}
+
+template<class Fun>
+bool throws_io_error(Fun f)
+{
+	try
+	{
+		f();
+	}
+	catch (io_error& )
+	{
+		return true;
+	}
+	return false;
+}
+
+
+T_CASE( binmat_write_read )
+{
+	const index_t m = 13;
+	const index_t n = 7;
+
+	dense_matrix<T> a(m, n);
+	fill_seq(a);
+
+	write_binmat(binmat_path, a);
+
+	binmat_header h = read_binmat_header(binmat_path);
+	ASSERT_EQ( h.dtype, (uint32_t)type_to_binmat_dtype<T>::value );
+	ASSERT_EQ( h.nrows, m );
+	ASSERT_EQ( h.ncols, n );
+	ASSERT_EQ( h.data_offset % LMAT_BINMAT_ALIGN, 0 );
+
+	dense_matrix<T> b;
+	read_binmat(binmat_path, b);
+	ASSERT_EQ( b.nrows(), m );
+	ASSERT_EQ( b.ncolumns(), n );
+	ASSERT_MAT_EQ( m, n, a, b );
+
+	std::remove(binmat_path);
+}
+
+
+T_CASE( binmat_write_view )
+{
+	const index_t m = 9;
+	const index_t n = 5;
+
+	dense_matrix<T> a0(m + 3, n + 1);
+	fill_seq(a0);
+
+	auto a = a0(range(1, m), range(1, n));
+	write_binmat(binmat_path, a, 4096);
+
+	dense_matrix<T> b;
+	read_binmat(binmat_path, b);
+	ASSERT_EQ( b.nrows(), m );
+	ASSERT_EQ( b.ncolumns(), n );
+	ASSERT_MAT_EQ( m, n, a, b );
+
+	ASSERT_EQ( read_binmat_header(binmat_path).data_offset, 4096u );
+
+	std::remove(binmat_path);
+}
+
+
+T_CASE( binmat_mapped )
+{
+	const index_t m = 100;
+	const index_t n = 30;
+
+	dense_matrix<T> a(m, n);
+	fill_seq(a);
+	write_binmat(binmat_path, a);
+
+	{
+		mapped_binmat f(binmat_path);
+		ASSERT_EQ( f.nrows(), m );
+		ASSERT_EQ( f.ncolumns(), n );
+		ASSERT_TRUE( f.template is_type<T>() );
+		ASSERT_FALSE( f.is_writable() );
+
+		cref_matrix<T> v = f.template cview<T>();
+		ASSERT_EQ( (size_t)v.ptr_data() % LMAT_BINMAT_ALIGN, 0 );
+		ASSERT_MAT_EQ( m, n, v, a );
+	}
+
+	{
+		mapped_binmat f(binmat_path, true);
+		ref_matrix<T> v = f.template view<T>();
+		v(2, 3) = T(-1);
+	}
+
+	dense_matrix<T> b;
+	read_binmat(binmat_path, b);
+	a(2, 3) = T(-1);
+	ASSERT_MAT_EQ( m, n, a, b );
+
+	std::remove(binmat_path);
+}
+
+
+// overwrites the header of the file at binmat_path
+
+void rewrite_binmat_header(const binmat_header& h)
+{
+	std::FILE *fp = std::fopen(binmat_path, "r+b");
+	std::fwrite(&h, sizeof(h), 1, fp);
+	std::fclose(fp);
+}
+
+
+SIMPLE_CASE( binmat_errors )
+{
+	dense_matrix<double> a(4, 3, zero());
+	write_binmat(binmat_path, a);
+
+	{
+		mapped_binmat f(binmat_path);
+		bool caught = false;
+		try
+		{
+			f.cview<float>();
+		}
+		catch (invalid_argument& )
+		{
+			caught = true;
+		}
+		ASSERT_TRUE( caught );
+	}
+
+	binmat_header h0 = read_binmat_header(binmat_path);
+
+	// truncated payload
+
+	binmat_header h = h0;
+	h.nrows = 100;
+	rewrite_binmat_header(h);
+
+	ASSERT_TRUE( throws_io_error([](){ mapped_binmat f(binmat_path); }) );
+	ASSERT_TRUE( throws_io_error([](){ read_binmat_header(binmat_path); }) );
+
+	// sizes that overflow in the size checks
+
+	h = h0;
+	h.nrows = h.ncols = int64_t(1) << 32;
+	h.data_bytes = 0;
+	rewrite_binmat_header(h);
+	ASSERT_TRUE( throws_io_error([](){ read_binmat_header(binmat_path); }) );
+
+	h = h0;
+	h.data_offset = ~uint64_t(0) - 8;
+	rewrite_binmat_header(h);
+	ASSERT_TRUE( throws_io_error([](){ read_binmat_header(binmat_path); }) );
+
+	// more rows than index_t can count
+
+	h = h0;
+	h.nrows = int64_t(1) << 40;
+	h.ncols = 0;
+	h.data_bytes = 0;
+	rewrite_binmat_header(h);
+	ASSERT_TRUE( throws_io_error([](){ read_binmat_header(binmat_path); }) );
+
+	// a payload misaligned for the element type
+
+	h = h0;
+	h.nrows = 3;
+	h.data_offset += 4;
+	h.data_bytes = 3 * 3 * sizeof(double);
+	rewrite_binmat_header(h);
+	{
+		mapped_binmat f(binmat_path);
+		ASSERT_TRUE( throws_io_error([&](){ f.cview<double>(); }) );
+	}
+
+	std::remove(binmat_path);
+
+	ASSERT_TRUE( throws_io_error([](){ mapped_binmat f(binmat_path); }) );
+}
+
+
+AUTO_TPACK( binmat )
+{
+	ADD_T_CASE( binmat_write_read, float )
+	ADD_T_CASE( binmat_write_read, double )
+	ADD_T_CASE( binmat_write_read, int32_t )
+	ADD_T_CASE( binmat_write_view, double )
+	ADD_T_CASE( binmat_mapped, float )
+	ADD_T_CASE( binmat_mapped, double )
+	ADD_SIMPLE_CASE( binmat_errors )
+}
@@ -0,0 +1,257 @@
+/**
+ * @file test_matfile.cpp
+ *
+ * Unit testing of MAT-file reading & writing
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+#include <light_mat/io/matfile.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace lmat;
+using namespace lmat::test;
+
+const char *matfile_path = "test_matfile.mat";
+
+#ifdef LMAT_USE_ZLIB
+const bool matfile_zlib = true;
+#else
+const bool matfile_zlib = false;
+#endif
+
+template<typename T>
+void fill_seq(dense_matrix<T>& a)
+{
+	for (index_t i = 0; i < a.nelems(); ++i) a[i] = T(i + 1);
+}
+
+
+template<class Fun>
+bool throws_io_error(Fun f)
+{
+	try
+	{
+		f();
+	}
+	catch (io_error& )
+	{
+		return true;
+	}
+	return false;
+}
+
+// writes a MAT-file header followed by the given words
+
+void write_raw_matfile(const uint32_t *words, size_t n)
+{
+	char h[128];
+	std::memset(h, ' ', 124);
+	h[124] = 0; h[125] = 1;
+	h[126] = 'I'; h[127] = 'M';
+
+	std::FILE *fp = std::fopen(matfile_path, "wb");
+	std::fwrite(h, 1, 128, fp);
+	std::fwrite(words, 4, n, fp);
+	std::fclose(fp);
+}
+
+
+void test_matfile_rw(bool compress)
+{
+	dense_matrix<double> a(5, 7);
+	dense_matrix<float> b(1, 1);
+	dense_matrix<int32_t> c(3, 4);
+	dense_matrix<bool> d(2, 3);
+	dense_matrix<double> e(0, 3);
+
+	fill_seq(a);
+	fill_seq(b);
+	fill_seq(c);
+	for (index_t i = 0; i < d.nelems(); ++i) d[i] = (i % 2 == 0);
+
+	{
+		matfile_writer w(matfile_path, compress);
+		w.write("a", a);
+		w.write("b_float", b);
+		w.write("c", c);
+		w.write("dmask", d);
+		w.write("empty", e);
+		w.close();
+	}
+
+	matfile_reader rd(matfile_path);
+	matvar_info info;
+
+	ASSERT_TRUE( rd.next(info) );
+	ASSERT_EQ( info.name, "a" );
+	ASSERT_EQ( info.class_id, mat_double_class );
+	ASSERT_TRUE( info.is_type<double>() );
+	ASSERT_FALSE( info.is_complex );
+	ASSERT_EQ( info.nrows, 5 );
+	ASSERT_EQ( info.ncols, 7 );
+
+	dense_matrix<double> a2;
+	rd.read(a2);
+	ASSERT_MAT_EQ( 5, 7, a2, a );
+
+	// skip b_float without reading
+
+	ASSERT_TRUE( rd.next(info) );
+	ASSERT_EQ( info.name, "b_float" );
+	ASSERT_TRUE( info.is_type<float>() );
+
+	ASSERT_TRUE( rd.next(info) );
+	ASSERT_EQ( info.name, "c" );
+	ASSERT_TRUE( info.is_type<int32_t>() );
+
+	// streaming into a preallocated view
+
+	dense_matrix<int32_t> cbuf(4, 8, zero());
+	ref_matrix<int32_t> cv(cbuf.ptr_data() + 4, 3, 4);
+	rd.read(cv);
+	ASSERT_MAT_EQ( 3, 4, cv, c );
+
+	ASSERT_TRUE( rd.next(info) );
+	ASSERT_EQ( info.name, "dmask" );
+	ASSERT_EQ( info.class_id, mat_uint8_class );
+	ASSERT_TRUE( info.is_logical );
+	ASSERT_TRUE( info.is_type<bool>() );
+
+	dense_matrix<bool> d2;
+	rd.read(d2);
+	ASSERT_MAT_EQ( 2, 3, d2, d );
+
+	ASSERT_TRUE( rd.next(info) );
+	ASSERT_EQ( info.name, "empty" );
+	ASSERT_EQ( info.nrows, 0 );
+	ASSERT_EQ( info.ncols, 3 );
+
+	ASSERT_FALSE( rd.next(info) );
+
+	// find & convenient functions
+
+	matfile_reader rd2(matfile_path);
+	ASSERT_TRUE( rd2.find("c", info) );
+	ASSERT_FALSE( rd2.find("a", info) );
+
+	dense_matrix<float> b2;
+	ASSERT_TRUE( load_matvar(matfile_path, "b_float", b2) );
+	ASSERT_MAT_EQ( 1, 1, b2, b );
+	ASSERT_FALSE( load_matvar(matfile_path, "none", b2) );
+
+	std::remove(matfile_path);
+}
+
+
+SIMPLE_CASE( matfile_uncompressed )
+{
+	test_matfile_rw(false);
+}
+
+
+SIMPLE_CASE( matfile_compressed )
+{
+	if (matfile_zlib) test_matfile_rw(true);
+}
+
+
+// MATLAB stores integer-valued doubles in narrower types, and
+// data of no more than 4 bytes in the small element format
+
+SIMPLE_CASE( matfile_narrow_storage )
+{
+	const uint32_t words[] = {
+		14, 56,							// miMATRIX
+		6, 8, 6, 0,						// flags: double
+		5, 8, 2, 3,						// dims: 2 x 3
+		(1 << 16) | 1, 'x',				// name (small)
+		2, 6, 0x04030201, 0x00000605,	// miUINT8 data
+		14, 48,							// miMATRIX
+		6, 8, 6, 0,						// flags: double
+		5, 8, 1, 3,						// dims: 1 x 3
+		(1 << 16) | 1, 'y',				// name (small)
+		(3 << 16) | 2, 0x00090807		// miUINT8 data (small)
+	};
+
+	write_raw_matfile(words, sizeof(words) / 4);
+
+	matfile_reader rd(matfile_path);
+	matvar_info info;
+
+	ASSERT_TRUE( rd.next(info) );
+	ASSERT_EQ( info.name, "x" );
+
+	dense_matrix<double> x;
+	rd.read(x);
+	ASSERT_EQ( x.nrows(), 2 );
+	ASSERT_EQ( x.ncolumns(), 3 );
+	for (index_t i = 0; i < 6; ++i) ASSERT_EQ( x[i], double(i + 1) );
+
+	ASSERT_TRUE( rd.next(info) );
+	ASSERT_EQ( info.name, "y" );
+
+	dense_matrix<double> y;
+	rd.read(y);
+	ASSERT_EQ( y.nelems(), 3 );
+	for (index_t i = 0; i < 3; ++i) ASSERT_EQ( y[i], double(i + 7) );
+
+	ASSERT_FALSE( rd.next(info) );
+
+	std::remove(matfile_path);
+}
+
+
+SIMPLE_CASE( matfile_corrupted_header )
+{
+	matvar_info info;
+
+	// a small name element longer than 4 bytes
+
+	const uint32_t w_name[] = {
+		14, 40,
+		6, 8, 6, 0,
+		5, 8, 1, 1,
+		(0xffffu << 16) | 1, 'x',
+		(8 << 16) | 9, 0
+	};
+	write_raw_matfile(w_name, sizeof(w_name) / 4);
+	ASSERT_TRUE( throws_io_error([&](){ matfile_reader rd(matfile_path); rd.next(info); }) );
+
+	// negative dimensions
+
+	const uint32_t w_neg[] = {
+		14, 40,
+		6, 8, 6, 0,
+		5, 8, 2, (uint32_t)(-3),
+		(1 << 16) | 1, 'x',
+		(8 << 16) | 9, 0
+	};
+	write_raw_matfile(w_neg, sizeof(w_neg) / 4);
+	ASSERT_TRUE( throws_io_error([&](){ matfile_reader rd(matfile_path); rd.next(info); }) );
+
+	// more elements than index_t can count
+
+	const uint32_t w_big[] = {
+		14, 48,
+		6, 8, 6, 0,
+		5, 16, 65536, 256, 256, 0,
+		(1 << 16) | 1, 'x',
+		(8 << 16) | 9, 0
+	};
+	write_raw_matfile(w_big, sizeof(w_big) / 4);
+	ASSERT_TRUE( throws_io_error([&](){ matfile_reader rd(matfile_path); rd.next(info); }) );
+
+	std::remove(matfile_path);
+}
+
+
+AUTO_TPACK( matfile )
+{
+	ADD_SIMPLE_CASE( matfile_uncompressed )
+	ADD_SIMPLE_CASE( matfile_compressed )
+	ADD_SIMPLE_CASE( matfile_narrow_storage )
+	ADD_SIMPLE_CASE( matfile_corrupted_header )
+}
@@ -0,0 +1,249 @@
+/**
+ * @file test_matrix_text.cpp
+ *
+ * Unit testing of text matrix reading & writing
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+#include <light_mat/io/matrix_text.h>
+#include <cstdio>
+#include <cmath>
+#include <string>
+
+using namespace lmat;
+using namespace lmat::test;
+
+const char *textmat_path = "test_matrix_text.tmp";
+
+void write_text(const char *s)
+{
+	std::FILE *fp = std::fopen(textmat_path, "wb");
+	std::fputs(s, fp);
+	std::fclose(fp);
+}
+
+template<class Fun>
+bool throws_io_error(Fun f)
+{
+	try
+	{
+		f();
+	}
+	catch (io_error& )
+	{
+		return true;
+	}
+	return false;
+}
+
+double parse_real_str(const char *s)
+{
+	double v = 0;
+	internal::parse_real(s, v);
+	return v;
+}
+
+
+SIMPLE_CASE( textmat_parse_real )
+{
+	const char *strs[] = {
+		"0", "-0", "1", "-17", "+3.25", "0.1", ".5", "5.", "1e10", "1E-5",
+		"123456789012345678", "1234567890123456789012345",
+		"0.000000000000000000000000123", "3.141592653589793238462643",
+		"2.2250738585072014e-308", "1.7976931348623157e308", "4.9e-324",
+		"9007199254740993", "1e23", "8.98846567431158e307" };
+
+	for (size_t k = 0; k < sizeof(strs) / sizeof(const char*); ++k)
+	{
+		ASSERT_EQ( parse_real_str(strs[k]), std::strtod(strs[k], 0) );
+	}
+
+	ASSERT_TRUE( std::signbit(parse_real_str("-0")) );
+	ASSERT_TRUE( parse_real_str("nan") != parse_real_str("nan") );
+	ASSERT_EQ( parse_real_str("-inf"), -std::numeric_limits<double>::infinity() );
+
+	double v;
+	const char *s = "x1";
+	ASSERT_TRUE( internal::parse_real(s, v) == s );
+
+	s = "2.5e,";
+	ASSERT_TRUE( internal::parse_real(s, v) == s + 3 );
+	ASSERT_EQ( v, 2.5 );
+}
+
+
+SIMPLE_CASE( textmat_format_real )
+{
+	char buf[32];
+
+	internal::format_real(buf, 0.1);
+	ASSERT_EQ( std::string(buf), "0.1" );
+
+	internal::format_real(buf, 1.0 / 3.0);
+	ASSERT_EQ( std::strtod(buf, 0), 1.0 / 3.0 );
+
+	internal::format_real(buf, 0.1f);
+	ASSERT_EQ( std::string(buf), "0.1" );
+
+	internal::format_real(buf, 1.0f / 3.0f);
+	ASSERT_EQ( std::strtof(buf, 0), 1.0f / 3.0f );
+
+	internal::format_real(buf, int32_t(-42));
+	ASSERT_EQ( std::string(buf), "-42" );
+}
+
+
+SIMPLE_CASE( textmat_read_csv )
+{
+	write_text(
+			"a, b, c\r\n"
+			"1, 2.5, -3\r\n"
+			"\r\n"
+			"4e2,5 ,  .25\r\n"
+			"7,8,9");
+
+	dense_matrix<double> a;
+	read_textmat(textmat_path, a, csv_format(true));
+
+	ASSERT_EQ( a.nrows(), 3 );
+	ASSERT_EQ( a.ncolumns(), 3 );
+
+	const double r[9] = {1, 400, 7, 2.5, 5, 8, -3, 0.25, 9};
+	ASSERT_MAT_EQ( 3, 3, a, cref_matrix<double>(r, 3, 3) );
+
+	std::remove(textmat_path);
+}
+
+
+SIMPLE_CASE( textmat_read_tsv )
+{
+	write_text("1\t2\n3\t4\n5\t6\n");
+
+	dense_matrix<float> a;
+	read_textmat(textmat_path, a, tsv_format());
+
+	const float r_[6] = {1, 3, 5, 2, 4, 6};
+	cref_matrix<float> r(r_, 3, 2);
+	ASSERT_EQ( a.nrows(), 3 );
+	ASSERT_EQ( a.ncolumns(), 2 );
+	ASSERT_MAT_EQ( 3, 2, a, r );
+
+	// to a preallocated view
+
+	dense_matrix<float> buf(5, 4, zero());
+	ref_block<float> v(buf.ptr_data() + 1, 3, 2, 5);
+	read_textmat(textmat_path, v, tsv_format());
+	ASSERT_MAT_EQ( 3, 2, v, r );
+	ASSERT_EQ( buf(0, 0), 0.f );
+	ASSERT_EQ( buf(4, 1), 0.f );
+
+	std::remove(textmat_path);
+}
+
+
+T_CASE( textmat_roundtrip )
+{
+	const index_t m = 3000;
+	const index_t n = 7;
+
+	dense_matrix<T> a(m, n);
+	for (index_t i = 0; i < a.nelems(); ++i)
+	{
+		a[i] = T(std::sin(double(i) * 0.37) * std::pow(10.0, double(i % 13) - 6));
+	}
+
+	write_textmat(textmat_path, a);
+
+	dense_matrix<T> b;
+	read_textmat(textmat_path, b);
+	ASSERT_EQ( b.nrows(), m );
+	ASSERT_EQ( b.ncolumns(), n );
+	ASSERT_MAT_EQ( m, n, a, b );
+
+	// a non-contiguous view
+
+	write_textmat(textmat_path, a(range(0, 5), whole()), tsv_format());
+
+	dense_matrix<T> c;
+	read_textmat(textmat_path, c, tsv_format());
+	ASSERT_MAT_EQ( 5, n, a(range(0, 5), whole()), c );
+
+	std::remove(textmat_path);
+}
+
+
+SIMPLE_CASE( textmat_errors )
+{
+	dense_matrix<double> a;
+
+	write_text("1,2\n3\n");
+	ASSERT_TRUE( throws_io_error([&](){ read_textmat(textmat_path, a); }) );
+
+	write_text("1,2\n3,x\n");
+	ASSERT_TRUE( throws_io_error([&](){ read_textmat(textmat_path, a); }) );
+
+	write_text("1,2\n3,4\n");
+	dense_matrix<double> b(3, 2);
+	ref_matrix<double> bv(b.ptr_data(), 3, 2);
+	ASSERT_TRUE( throws_io_error([&](){ read_textmat(textmat_path, bv); }) );
+
+	ref_matrix<double> cv(b.ptr_data(), 2, 2);
+	read_textmat(textmat_path, cv);
+	ASSERT_EQ( cv(1, 1), 4.0 );
+
+	write_text("");
+	read_textmat(textmat_path, a);
+	ASSERT_EQ( a.nelems(), 0 );
+
+	std::remove(textmat_path);
+	ASSERT_TRUE( throws_io_error([&](){ read_textmat(textmat_path, a); }) );
+}
+
+
+SIMPLE_CASE( textmat_parallel_read )
+{
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	const index_t m = 10 * LMAT_TEXTMAT_PAR_LINES + 3;
+	const index_t n = 3;
+
+	dense_matrix<double> a(m, n);
+	for (index_t i = 0; i < a.nelems(); ++i) a[i] = double(i) * 0.25 - 100.0;
+
+	write_textmat(textmat_path, a);
+
+	// a destination with a static number of columns
+
+	dense_matrix<double, 0, 3> b;
+	read_textmat(textmat_path, b);
+	ASSERT_EQ( b.nrows(), m );
+	ASSERT_MAT_EQ( m, n, a, b );
+
+	// a malformed row far from the first block
+
+	std::FILE *fp = std::fopen(textmat_path, "ab");
+	std::fputs("1,2\n", fp);
+	std::fclose(fp);
+
+	dense_matrix<double> c;
+	ASSERT_TRUE( throws_io_error([&](){ read_textmat(textmat_path, c); }) );
+
+	std::remove(textmat_path);
+}
+
+
+AUTO_TPACK( textmat )
+{
+	ADD_SIMPLE_CASE( textmat_parse_real )
+	ADD_SIMPLE_CASE( textmat_format_real )
+	ADD_SIMPLE_CASE( textmat_read_csv )
+	ADD_SIMPLE_CASE( textmat_read_tsv )
+	ADD_T_CASE( textmat_roundtrip, float )
+	ADD_T_CASE( textmat_roundtrip, double )
+	ADD_T_CASE( textmat_roundtrip, int32_t )
+	ADD_SIMPLE_CASE( textmat_errors )
+	ADD_SIMPLE_CASE( textmat_parallel_read )
+}
@@ -0,0 +1,275 @@
+/**
+ * @file test_batched_fac.cpp
+ *
+ * @brief Unit testing of batched factorization
+ *
+ * @author Dahua Lin
+ */
+
+#include "linalg_test_base.h"
+#include <light_mat/linalg/batched_fac.h>
+
+
+using namespace lmat;
+using namespace lmat::test;
+
+const index_t BN = 6;
+const index_t BCNT = 11;	// not a multiple of the pack width
+
+template<typename T>
+void fill_pdm_stack(dense_matrix<T>& s, index_t n, index_t cnt)
+{
+	s.require_size(n, n * cnt);
+	dense_matrix<T> a(n, n);
+	for (index_t k = 0; k < cnt; ++k)
+	{
+		fill_rand_pdm(a);
+		for (index_t j = 0; j < n; ++j)
+			for (index_t i = 0; i < n; ++i) s(i, k * n + j) = a(i, j);
+	}
+}
+
+template<typename T>
+void fill_rand_stack(dense_matrix<T>& s, index_t m, index_t n, index_t cnt)
+{
+	s.require_size(m, n * cnt);
+	for (index_t j = 0; j < n * cnt; ++j)
+		for (index_t i = 0; i < m; ++i) s(i, j) = randunif<T>(T(-1), T(1));
+}
+
+// max_k || A_k * X_k - B_k ||_inf
+
+template<typename T>
+T stack_residual(const dense_matrix<T>& a, index_t n, const dense_matrix<T>& x, const dense_matrix<T>& b,
+		index_t cnt)
+{
+	const index_t m = a.nrows();
+	const index_t nrhs = b.ncolumns() / cnt;
+
+	T r(0);
+	for (index_t k = 0; k < cnt; ++k)
+	{
+		for (index_t c = 0; c < nrhs; ++c)
+		{
+			for (index_t i = 0; i < m; ++i)
+			{
+				T s = -b(i, k * nrhs + c);
+				for (index_t j = 0; j < n; ++j)
+					s += a(i, k * n + j) * x(j, k * nrhs + c);
+				if (math::abs(s) > r) r = math::abs(s);
+			}
+		}
+	}
+	return r;
+}
+
+
+T_CASE( mat_batch_layout )
+{
+	const index_t m = 3, n = 2;
+	dense_matrix<T> s;
+	fill_rand_stack(s, m, n, BCNT);
+
+	mat_batch<T> a(s, n);
+	ASSERT_EQ( a.nrows(), m );
+	ASSERT_EQ( a.ncolumns(), n );
+	ASSERT_EQ( a.count(), BCNT );
+
+	const index_t W = mat_batch<T>::lane_width;
+	ASSERT_EQ( a.ngroups(), (BCNT + W - 1) / W );
+
+	for (index_t k = 0; k < BCNT; ++k)
+	{
+		for (index_t j = 0; j < n; ++j)
+			for (index_t i = 0; i < m; ++i)
+			{
+				ASSERT_EQ( a(k, i, j), s(i, k * n + j) );
+				ASSERT_EQ( &a(k, i, j), a.ptr_group(k / W) + (j * m + i) * W + k % W );
+			}
+	}
+
+	dense_matrix<T> s2;
+	a.scatter(s2);
+	ASSERT_EQ( s2.nrows(), m );
+	ASSERT_EQ( s2.ncolumns(), n * BCNT );
+	ASSERT_MAT_EQ( m, n * BCNT, s2, s );
+}
+
+
+T_CASE( mat_batch_chol )
+{
+	const index_t n = BN;
+	const index_t nrhs = 2;
+
+	dense_matrix<T> as, bs;
+	fill_pdm_stack(as, n, BCNT);
+	fill_rand_stack(bs, n, nrhs, BCNT);
+
+	mat_batch<T> l(as, n);
+	batch_chol(l);
+
+	T tol = (T)(sizeof(T) == 4 ? 1.0e-4 : 1.0e-10);
+
+	// L * L' = A
+
+	for (index_t k = 0; k < BCNT; ++k)
+	{
+		for (index_t j = 0; j < n; ++j)
+			for (index_t i = j; i < n; ++i)
+			{
+				T s(0);
+				for (index_t t = 0; t <= j; ++t) s += l(k, i, t) * l(k, j, t);
+				ASSERT_APPROX( s, as(i, k * n + j), tol );
+			}
+	}
+
+	mat_batch<T> b(bs, nrhs);
+	batch_chol_solve(l, b);
+
+	dense_matrix<T> xs;
+	b.scatter(xs);
+	ASSERT_TRUE( stack_residual(as, n, xs, bs, BCNT) < tol );
+}
+
+
+T_CASE( mat_batch_lu )
+{
+	const index_t n = BN;
+	const index_t nrhs = 3;
+
+	dense_matrix<T> as, bs;
+	fill_rand_stack(as, n, n, BCNT);
+	fill_rand_stack(bs, n, nrhs, BCNT);
+
+	mat_batch<T> lu(as, n);
+	dense_matrix<index_t> piv;
+	batch_lu(lu, piv);
+
+	ASSERT_EQ( piv.nrows(), n );
+	ASSERT_EQ( piv.ncolumns(), BCNT );
+	for (index_t k = 0; k < BCNT; ++k)
+		for (index_t j = 0; j < n; ++j)
+			ASSERT_TRUE( piv(j, k) >= j && piv(j, k) < n );
+
+	T tol = (T)(sizeof(T) == 4 ? 1.0e-3 : 1.0e-9);
+
+	mat_batch<T> b(bs, nrhs);
+	batch_lu_solve(lu, piv, b);
+
+	dense_matrix<T> xs;
+	b.scatter(xs);
+	ASSERT_TRUE( stack_residual(as, n, xs, bs, BCNT) < tol );
+}
+
+
+T_CASE( mat_batch_qr )
+{
+	const index_t m = BN + 2;
+	const index_t n = BN;
+	const index_t nrhs = 2;
+
+	dense_matrix<T> as, bs;
+	fill_rand_stack(as, m, n, BCNT);
+	fill_rand_stack(bs, m, nrhs, BCNT);
+
+	mat_batch<T> qr(as, n);
+	mat_batch<T> tau;
+	batch_qr(qr, tau);
+
+	ASSERT_EQ( tau.nrows(), n );
+	ASSERT_EQ( tau.ncolumns(), 1 );
+	ASSERT_EQ( tau.count(), BCNT );
+
+	T tol = (T)(sizeof(T) == 4 ? 1.0e-3 : 1.0e-9);
+
+	// R' * R = A' * A
+
+	for (index_t k = 0; k < BCNT; ++k)
+	{
+		for (index_t j = 0; j < n; ++j)
+			for (index_t i = 0; i < n; ++i)
+			{
+				T s0(0), s1(0);
+				for (index_t t = 0; t < m; ++t) s0 += as(t, k * n + i) * as(t, k * n + j);
+				for (index_t t = 0; t <= math::min(i, j); ++t) s1 += qr(k, t, i) * qr(k, t, j);
+				ASSERT_APPROX( s1, s0, tol );
+			}
+	}
+
+	// least squares: A' * (A * x - b) = 0
+
+	mat_batch<T> b(bs, nrhs);
+	batch_qr_solve(qr, tau, b);
+
+	for (index_t k = 0; k < BCNT; ++k)
+	{
+		for (index_t c = 0; c < nrhs; ++c)
+		{
+			for (index_t j = 0; j < n; ++j)
+			{
+				T g(0);
+				for (index_t i = 0; i < m; ++i)
+				{
+					T r = -bs(i, k * nrhs + c);
+					for (index_t t = 0; t < n; ++t) r += as(i, k * n + t) * b(k, t, c);
+					g += as(i, k * n + j) * r;
+				}
+				ASSERT_APPROX( g, T(0), tol );
+			}
+		}
+	}
+}
+
+
+// groups are distributed over the executor in scope, and the
+// results do not depend on how they are divided
+
+T_CASE( mat_batch_parallel )
+{
+	const index_t n = 3;
+	const index_t W = mat_batch<T>::lane_width;
+	const index_t cnt = 4 * LMAT_BATCH_PAR_GROUPS * W + 3;
+
+	dense_matrix<T> as, bs;
+	fill_rand_stack(as, n, n, cnt);
+	fill_rand_stack(bs, n, 1, cnt);
+
+	mat_batch<T> lu0(as, n), b0(bs, 1);
+	dense_matrix<index_t> piv0;
+	{
+		exec::serial_executor sx;
+		exec::executor_scope xs(sx);
+		batch_lu(lu0, piv0);
+		batch_lu_solve(lu0, piv0, b0);
+	}
+
+	exec::thread_pool pool(4);
+	exec::executor_scope ps(pool);
+
+	mat_batch<T> lu(as, n), b(bs, 1);
+	dense_matrix<index_t> piv;
+	batch_lu(lu, piv);
+	batch_lu_solve(lu, piv, b);
+
+	ASSERT_MAT_EQ( n, cnt, piv, piv0 );
+
+	dense_matrix<T> xs, xs0;
+	b.scatter(xs);
+	b0.scatter(xs0);
+	ASSERT_MAT_EQ( n, cnt, xs, xs0 );
+}
+
+
+AUTO_TPACK( mat_batch )
+{
+	ADD_T_CASE( mat_batch_layout, float )
+	ADD_T_CASE( mat_batch_layout, double )
+	ADD_T_CASE( mat_batch_chol, float )
+	ADD_T_CASE( mat_batch_chol, double )
+	ADD_T_CASE( mat_batch_lu, float )
+	ADD_T_CASE( mat_batch_lu, double )
+	ADD_T_CASE( mat_batch_qr, float )
+	ADD_T_CASE( mat_batch_qr, double )
+	ADD_T_CASE( mat_batch_parallel, float )
+	ADD_T_CASE( mat_batch_parallel, double )
+}
@@ -202,6 +202,47 @@ void test_qr_solve(index_t m, index_t n )
 }
 
 
+// a factorization reused across shapes, whose cached workspace
+// sizes must follow the shapes
+
+template<typename T>
+void test_qr_reuse_on(qr_fac<T>& qr, index_t m, index_t n, index_t nx)
+{
+	dense_matrix<T> a(m, n), x(m, nx);
+	for (index_t i = 0; i < m * n; ++i) a[i] = randunif(T(-2.0), T(2.0));
+	for (index_t i = 0; i < m * nx; ++i) x[i] = randunif(T(-2.0), T(2.0));
+
+	qr.set(a);
+	qr_fac<T> qr0(a);
+
+	dense_matrix<T> q, q0;
+	qr.getq(q);
+	qr0.getq(q0);
+	ASSERT_MAT_EQ( m, m, q, q0 );
+
+	dense_matrix<T> y, y0;
+	qr.multq(x, y, 'T', 'L');
+	qr0.multq(x, y0, 'T', 'L');
+	ASSERT_MAT_EQ( m, nx, y, y0 );
+
+	qr_fac<T> qr1(qr);
+	dense_matrix<T> y1;
+	qr1.multq(x, y1, 'T', 'L');
+	ASSERT_MAT_EQ( m, nx, y1, y0 );
+}
+
+T_CASE( mat_qr_reuse )
+{
+	randunif(T(0), T(1));
+
+	qr_fac<T> qr;
+	test_qr_reuse_on(qr, 8, 5, 9);
+	test_qr_reuse_on(qr, 8, 5, 2);
+	test_qr_reuse_on(qr, 40, 12, 30);
+	test_qr_reuse_on(qr, 6, 6, 1);
+}
+
+
 T_CASE( mat_qr_fac_eq )
 {
 	test_qr_fac<T>(5, 5);
@@ -263,6 +304,8 @@ AUTO_TPACK( mat_qr_fac )
 	ADD_T_CASE( mat_qr_fac_eq, double )
 	ADD_T_CASE( mat_qr_fac_gt, double )
 	ADD_T_CASE( mat_qr_fac_lt, double )
+	ADD_T_CASE( mat_qr_reuse, float )
+	ADD_T_CASE( mat_qr_reuse, double )
 }
 
 
@@ -16,6 +16,8 @@ using namespace lmat::test;
 
 using lmat::lapack::gesvd;
 using lmat::lapack::gesdd;
+using lmat::lapack::svd_solver;
+using lmat::lapack::lapack_workspace;
 
 
 #define DISP(a) std::printf("\n" #a "=\n"); printf_mat("%10.4g ", a); std::printf("\n")
@@ -286,6 +288,64 @@ void test_sdd( index_t m, index_t n )
 }
 
 
+template<typename T>
+void test_svd_solver( index_t m, index_t n )
+{
+	dense_matrix<T> a(m, n);
+	dense_matrix<T> b(m, n);
+	do_fill_rand(a.ptr_data(), m * n);
+	do_fill_rand(b.ptr_data(), m * n);
+
+	index_t k = math::min(m, n);
+	T tol = (T)(sizeof(T) == 4 ? 2.0e-5 : 1.0e-10);
+
+	dense_col<T> sa0, sb0;
+	gesvd(a, sa0);
+	gesvd(b, sb0);
+
+	svd_solver<T> solver;
+
+	dense_col<T> s;
+	solver.gesvd(a, s);
+	ASSERT_VEC_APPROX(k, s, sa0, tol);
+
+	index_t lw = solver.workspace().work_size();
+	ASSERT_TRUE( lw > 0 );
+	const T *pw = solver.workspace().work(lw);
+
+	// same shape: the workspace is reused
+
+	solver.gesvd(b, s);
+	ASSERT_VEC_APPROX(k, s, sb0, tol);
+	ASSERT_EQ( solver.workspace().work_size(), lw );
+	ASSERT_EQ( solver.workspace().work(lw), pw );
+
+	dense_matrix<T> u, vt;
+	solver.gesvd(a, s, u, vt, 'S', 'S');
+	ASSERT_VEC_APPROX(k, s, sa0, tol);
+	ASSERT_TRUE( check_svd(a, s, u, vt, tol) );
+
+	solver.gesdd(b, s, u, vt, 'A');
+	ASSERT_VEC_APPROX(k, s, sb0, tol);
+	ASSERT_TRUE( is_orth(u, 'N', tol) );
+	ASSERT_TRUE( is_orth(vt, 'T', tol) );
+	ASSERT_TRUE( check_svd(b, s, u, vt, tol) );
+
+	solver.gesdd(a, s);
+	ASSERT_VEC_APPROX(k, s, sa0, tol);
+
+	// caller-provided workspace
+
+	lapack_workspace<T> ws;
+	svd_solver<T> solver2(ws);
+
+	solver2.gesdd(a, s, u, vt, 'S');
+	ASSERT_VEC_APPROX(k, s, sa0, tol);
+	ASSERT_TRUE( check_svd(a, s, u, vt, tol) );
+	ASSERT_TRUE( ws.work_size() > 0 );
+	ASSERT_TRUE( ws.iwork_size() >= 8 * k );
+}
+
 
 T_CASE( mat_svd_eq )
 {
@@ -319,6 +379,17 @@ T_CASE( mat_sdd_lt )
 }
 
 
+T_CASE( mat_svd_solver_gt )
+{
+	test_svd_solver<T>(8, 5);
+}
+
+T_CASE( mat_svd_solver_lt )
+{
+	test_svd_solver<T>(5, 8);
+}
+
+
 AUTO_TPACK( mat_svd )
 {
 	ADD_T_CASE( mat_svd_eq, float )
@@ -339,6 +410,10 @@ AUTO_TPACK( mat_sdd )
 	ADD_T_CASE( mat_sdd_lt, double )
 }
 
-
-
-
+AUTO_TPACK( mat_svd_solver )
+{
+	ADD_T_CASE( mat_svd_solver_gt, float )
+	ADD_T_CASE( mat_svd_solver_lt, float )
+	ADD_T_CASE( mat_svd_solver_gt, double )
+	ADD_T_CASE( mat_svd_solver_lt, double )
+}
@@ -16,6 +16,7 @@ using namespace lmat::test;
 using lmat::lapack::syev;
 using lmat::lapack::syevd;
 using lmat::lapack::syevr;
+using lmat::lapack::syev_solver;
 
 using lmat::lapack::evr_I;
 using lmat::lapack::evr_V;
@@ -217,6 +218,63 @@ T_CASE( mat_syevr )
 	ASSERT_MAT_APPROX( m, m-2, VV, V0I, tol0 );
 }
 
+T_CASE( mat_syev_solver )
+{
+	typedef mat_host<bloc, T, 0, 0> host_t;
+	typedef typename host_t::mat_t mat_t;
+
+	index_t m = DM;
+	host_t a_host(m, m);
+	mat_t a = a_host.get_mat();
+	fill_rand_pdm(a);
+
+	T tol0 = (T)(sizeof(T) == 4 ? 1.0e-4 : 1.0e-12);
+	T tol = (T)(sizeof(T) == 4 ? 1.0e-4 : 1.0e-10);
+
+	dense_col<T> w0;
+	syevr(a, w0);
+
+	syev_solver<T> solver;
+
+	dense_col<T> w;
+	dense_matrix<T> V;
+
+	solver.syev(a, w, V);
+	test_syev(a, w0, w, V, tol0, tol);
+
+	index_t lw = solver.workspace().work_size();
+	ASSERT_TRUE( lw > 0 );
+
+	solver.syev(a, w, V);
+	test_syev(a, w0, w, V, tol0, tol);
+	ASSERT_EQ( solver.workspace().work_size(), lw );
+
+	solver.syevd(a, w, V);
+	test_syev(a, w0, w, V, tol0, tol);
+
+	dense_col<T> w1;
+	solver.syevd(a, w1);
+	ASSERT_VEC_APPROX( m, w1, w0, tol0 );
+
+	index_t ret = solver.syevr(a, w, V);
+	ASSERT_EQ( ret, m );
+	test_syev(a, w0, w, V, tol0, tol);
+
+	dense_col<T> wI;
+	dense_matrix<T> VI;
+	ret = solver.syevr(a, wI, VI, evr_I(1, m-1));
+	ASSERT_EQ( ret, m-2 );
+	ASSERT_EQ( wI.nrows(), m-2 );
+	ASSERT_EQ( VI.ncolumns(), m-2 );
+
+	auto w0I = w0(range(1, m-2));
+	ASSERT_VEC_APPROX( m-2, wI, w0I, tol0 );
+
+	ret = solver.syevr(a, wI, evr_I(1, m-1));
+	ASSERT_EQ( ret, m-2 );
+	ASSERT_VEC_APPROX( m-2, wI, w0I, tol0 );
+}
+
 
 AUTO_TPACK( mat_syev )
 {
@@ -236,5 +294,8 @@ AUTO_TPACK( mat_syevr )
 	ADD_T_CASE( mat_syevr, double )
 }
 
-
-
+AUTO_TPACK( mat_syev_solver )
+{
+	ADD_T_CASE( mat_syev_solver, float )
+	ADD_T_CASE( mat_syev_solver, double )
+}
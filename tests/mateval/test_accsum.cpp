@@ -0,0 +1,212 @@
+/**
+ * @file test_accsum.cpp
+ *
+ * Test of accurate and reproducible summation
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/mateval/mat_accsum.h>
+#include <light_mat/common/exec.h>
+#include <cstdlib>
+
+using namespace lmat;
+using namespace lmat::test;
+
+inline double randunif()
+{
+	double u = (double)std::rand() / double(RAND_MAX);
+	return u * 2.0 - 1.0;
+}
+
+template<class Mat, typename T>
+void fill_rand(IRegularMatrix<Mat, T>& mat)
+{
+	for (index_t j = 0; j < mat.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < mat.nrows(); ++i)
+		{
+			mat(i, j) = T(randunif());
+		}
+	}
+}
+
+template<class Mat>
+double safe_sum(const IRegularMatrix<Mat, float>& a)
+{
+	double s = 0;
+	for (index_t j = 0; j < a.ncolumns(); ++j)
+		for (index_t i = 0; i < a.nrows(); ++i) s += a(i, j);
+	return s;
+}
+
+const index_t long_len = 1000003;
+
+
+SIMPLE_CASE( accsum_empty )
+{
+	dense_col<float> a(0);
+
+	ASSERT_EQ( sum(a, sumacc::accurate_()), 0.f );
+	ASSERT_EQ( sum(a, sumacc::pairwise_()), 0.f );
+	ASSERT_EQ( sum(a, sumacc::reproducible_()), 0.f );
+}
+
+
+SIMPLE_CASE( accsum_cancel )
+{
+	const index_t n = 1001;
+	dense_col<float> a(n, fill(1.0f));
+	a[0] = 1.0e8f;
+	a[n-1] = -1.0e8f;
+
+	ASSERT_EQ( sum(a, sumacc::accurate_()), float(n - 2) );
+}
+
+
+SIMPLE_CASE( accsum_long )
+{
+	dense_col<float> a(long_len);
+	for (index_t i = 0; i < long_len; ++i) a[i] = 0.1f + float(randunif()) * 1.0e-3f;
+
+	double r0 = safe_sum(a);
+
+	double e_acc = math::abs(sum(a, sumacc::accurate_()) - r0) / r0;
+	double e_pw = math::abs(sum(a, sumacc::pairwise_()) - r0) / r0;
+	double e_rp = math::abs(sum(a, sumacc::reproducible_()) - r0) / r0;
+
+	ASSERT_TRUE( e_acc < 1.0e-7 );
+	ASSERT_TRUE( e_pw < 1.0e-6 );
+	ASSERT_TRUE( e_rp < 1.0e-6 );
+
+	double r0_mean = r0 / double(long_len);
+	ASSERT_APPROX( mean(a, sumacc::accurate_()), r0_mean, 1.0e-7 );
+	ASSERT_APPROX( mean(a, sumacc::pairwise_()), r0_mean, 1.0e-6 );
+}
+
+
+SIMPLE_CASE( accsum_views )
+{
+	const index_t m = 1537;
+	const index_t n = 5;
+
+	dense_matrix<float> a0(m + 2, n);
+	fill_rand(a0);
+	auto a = a0(range(1, m), whole());
+
+	double r0 = safe_sum(a);
+	const double tol = 1.0e-4;
+
+	ASSERT_APPROX( sum(a, sumacc::accurate_()), r0, tol );
+	ASSERT_APPROX( sum(a, sumacc::pairwise_()), r0, tol );
+	ASSERT_APPROX( sum(a, sumacc::reproducible_()), r0, tol );
+
+	dense_matrix<float> b(m + 2, n);
+	fill_rand(b);
+	auto bv = b(range(1, m), whole());
+
+	double d0 = 0;
+	for (index_t j = 0; j < n; ++j)
+		for (index_t i = 0; i < m; ++i) d0 += a(i, j) * bv(i, j);
+
+	ASSERT_APPROX( dot(a, bv, sumacc::accurate_()), d0, tol );
+	ASSERT_APPROX( dot(a, bv, sumacc::pairwise_()), d0, tol );
+}
+
+
+template<typename T, typename U>
+T repro_sum(U, const dense_col<T>& a)
+{
+	return internal::_accsum(macc_<linear_, U>(), a, sumacc::reproducible_());
+}
+
+SIMPLE_CASE( accsum_reproducible )
+{
+	const index_t lens[] = {1, 7, 8, 13, 1024, 1029, 5000, 100003};
+
+	for (size_t t = 0; t < sizeof(lens) / sizeof(index_t); ++t)
+	{
+		index_t n = lens[t];
+
+		dense_col<float> af(n);
+		dense_col<double> ad(n);
+		fill_rand(af);
+		fill_rand(ad);
+
+		float sf = repro_sum(scalar_(), af);
+		double sd = repro_sum(scalar_(), ad);
+
+		ASSERT_EQ( repro_sum(simd_<sse_t>(), af), sf );
+		ASSERT_EQ( repro_sum(simd_<sse_t>(), ad), sd );
+#ifdef LMAT_HAS_AVX
+		ASSERT_EQ( repro_sum(simd_<avx_t>(), af), sf );
+		ASSERT_EQ( repro_sum(simd_<avx_t>(), ad), sd );
+#endif
+		ASSERT_EQ( sum(af, sumacc::reproducible_()), sf );
+		ASSERT_EQ( sum(ad, sumacc::reproducible_()), sd );
+	}
+}
+
+
+SIMPLE_CASE( accsum_repro_layout )
+{
+	const index_t ms[] = {1, 7, 13, 1023, 1029};
+	const index_t n = 11;
+
+	for (size_t t = 0; t < sizeof(ms) / sizeof(index_t); ++t)
+	{
+		const index_t m = ms[t];
+
+		dense_matrix<double> a(m, n);
+		fill_rand(a);
+
+		dense_matrix<double> b0(m + 3, n * 2, zero());
+		auto b = b0(range(2, m), step_range(1, n, 2));
+		copy(a, b);
+
+		dense_col<double> c(m * n);
+		copy(a.ptr_data(), c);
+
+		double s = sum(a, sumacc::reproducible_());
+
+		ASSERT_EQ( sum(b, sumacc::reproducible_()), s );
+		ASSERT_EQ( sum(c, sumacc::reproducible_()), s );
+	}
+}
+
+
+SIMPLE_CASE( accsum_repro_par )
+{
+	const index_t m = 1029;
+	const index_t n = 97;
+
+	dense_matrix<float> a(m, n);
+	fill_rand(a);
+	dense_matrix<float> b0(m + 1, n);
+	auto b = b0(range(1, m), whole());
+	copy(a, b);
+
+	float s = sum(a, sumacc::reproducible_());
+
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	ASSERT_EQ( sum(par_(), a, sumacc::reproducible_()), s );
+	ASSERT_EQ( sum(par_(1024), a, sumacc::reproducible_()), s );
+	ASSERT_EQ( sum(par_(1024), b, sumacc::reproducible_()), s );
+	ASSERT_EQ( sum(par_(), a * 2.0f, sumacc::reproducible_()), sum(a * 2.0f, sumacc::reproducible_()) );
+}
+
+
+AUTO_TPACK( accsum )
+{
+	ADD_SIMPLE_CASE( accsum_empty )
+	ADD_SIMPLE_CASE( accsum_cancel )
+	ADD_SIMPLE_CASE( accsum_long )
+	ADD_SIMPLE_CASE( accsum_views )
+	ADD_SIMPLE_CASE( accsum_reproducible )
+	ADD_SIMPLE_CASE( accsum_repro_layout )
+	ADD_SIMPLE_CASE( accsum_repro_par )
+}
@@ -9,6 +9,7 @@
 #include "../test_base.h"
 #include <light_mat/matrix/matrix_classes.h>
 #include <light_mat/mateval/mat_reduce.h>
+#include <light_mat/common/exec.h>
 #include <cstdlib>
 
 using namespace lmat;
@@ -53,6 +54,23 @@ const unsigned int ntest_nrows = sizeof(test_nrows) / sizeof(index_t);
 			colwise_##Name(s1, drow1); \
 			ASSERT_APPROX( drow1[0], rrow[0], 1.0e-12 ); \
 			colwise_##Name(sn, drow); \
+			ASSERT_MAT_APPROX( 1, n, drow, rrow, 1.0e-12 ); } } \
+	SIMPLE_CASE( tcolwise_par_##Name ) { \
+		const index_t n = 37; \
+		exec::thread_pool pool(4); \
+		exec::executor_scope xs(pool); \
+		dense_matrix<double> src(max_nrows, n); \
+		fill_rand(src); \
+		dense_row<double> rrow(n); \
+		dense_row<double> drow(n, zero()); \
+		for (unsigned k = 0; k < ntest_nrows; ++k) { \
+			index_t cl = test_nrows[k]; \
+			ref_block<double> sn = src(range(0, cl), whole()); \
+			colwise_##Name(sn, rrow); \
+			colwise_##Name(par_(1), sn, drow); \
+			ASSERT_MAT_APPROX( 1, n, drow, rrow, 1.0e-12 ); \
+			fill(drow, 0.0); \
+			colwise_##Name(par_(), sn, drow); \
 			ASSERT_MAT_APPROX( 1, n, drow, rrow, 1.0e-12 ); } }
 
 #define DEFINE_COLWISE_REDUCE_CASE_2( Name ) \
@@ -75,6 +93,23 @@ const unsigned int ntest_nrows = sizeof(test_nrows) / sizeof(index_t);
 			colwise_##Name(s11, s12, drow1); \
 			ASSERT_APPROX( drow1[0], rrow[0], 1.0e-12 ); \
 			colwise_##Name(sn1, sn2, drow); \
+			ASSERT_MAT_APPROX( 1, n, drow, rrow, 1.0e-12 ); } } \
+	SIMPLE_CASE( tcolwise_par_##Name ) { \
+		const index_t n = 37; \
+		exec::thread_pool pool(4); \
+		exec::executor_scope xs(pool); \
+		dense_matrix<double> src1(max_nrows, n); \
+		dense_matrix<double> src2(max_nrows, n); \
+		fill_rand(src1); \
+		fill_rand(src2); \
+		dense_row<double> rrow(n); \
+		dense_row<double> drow(n, zero()); \
+		for (unsigned k = 0; k < ntest_nrows; ++k) { \
+			index_t cl = test_nrows[k]; \
+			ref_block<double> sn1 = src1(range(0, cl), whole()); \
+			ref_block<double> sn2 = src2(range(0, cl), whole()); \
+			colwise_##Name(sn1, sn2, rrow); \
+			colwise_##Name(par_(1), sn1, sn2, drow); \
 			ASSERT_MAT_APPROX( 1, n, drow, rrow, 1.0e-12 ); } }
 
 
@@ -116,5 +151,24 @@ AUTO_TPACK( colwise_reduce )
 	ADD_SIMPLE_CASE( tcolwise_dot )
 }
 
+AUTO_TPACK( colwise_par_reduce )
+{
+	ADD_SIMPLE_CASE( tcolwise_par_sum )
+	ADD_SIMPLE_CASE( tcolwise_par_mean )
+	ADD_SIMPLE_CASE( tcolwise_par_maximum )
+	ADD_SIMPLE_CASE( tcolwise_par_minimum )
+
+	ADD_SIMPLE_CASE( tcolwise_par_asum )
+	ADD_SIMPLE_CASE( tcolwise_par_amean )
+	ADD_SIMPLE_CASE( tcolwise_par_amax )
+	ADD_SIMPLE_CASE( tcolwise_par_sqsum )
+
+	ADD_SIMPLE_CASE( tcolwise_par_diff_asum )
+	ADD_SIMPLE_CASE( tcolwise_par_diff_amean )
+	ADD_SIMPLE_CASE( tcolwise_par_diff_amax )
+	ADD_SIMPLE_CASE( tcolwise_par_diff_sqsum )
+
+	ADD_SIMPLE_CASE( tcolwise_par_dot )
+}
 
 
@@ -0,0 +1,174 @@
+/**
+ * @file test_instrument.cpp
+ *
+ * @brief Unit testing for instrumentation counters
+ *
+ * @author Dahua Lin
+ */
+
+#define LMAT_ENABLE_INSTRUMENTATION
+
+// a small threshold, such that moderate sizes are evaluated in streaming mode
+#define LMAT_STREAM_MIN_BYTES (1 << 16)
+
+#include "../test_base.h"
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/mateval/mat_reduce.h>
+#include <light_mat/mateval/matrix_ordstats.h>
+
+using namespace lmat;
+using namespace lmat::test;
+
+using lmat::instrument::site_stats;
+
+
+SIMPLE_CASE( count_allocations )
+{
+	instrument::reset();
+	ASSERT_TRUE( instrument::enabled );
+	ASSERT_EQ( instrument::total(instrument::allocation_).count, 0 );
+
+	dense_col<double> a(10);
+	site_stats s0 = instrument::query(instrument::allocation_, "untagged");
+	ASSERT_EQ( s0.count, 1 );
+	ASSERT_EQ( s0.bytes, 10 * sizeof(double) );
+
+	{
+		LMAT_INSTRUMENT_SCOPE("test_scope")
+		dense_col<float> b(5);
+		dense_col<float> c(3);
+	}
+
+	site_stats s1 = instrument::query(instrument::allocation_, "test_scope");
+	ASSERT_EQ( s1.count, 2 );
+	ASSERT_EQ( s1.bytes, 8 * sizeof(float) );
+
+	// back to untagged after the scope exits
+
+	dense_col<double> d(2);
+	ASSERT_EQ( instrument::query(instrument::allocation_, "untagged").count, 2 );
+	ASSERT_EQ( instrument::total(instrument::allocation_).count, 4 );
+
+	instrument::reset();
+	ASSERT_EQ( instrument::total(instrument::allocation_).count, 0 );
+	ASSERT_EQ( instrument::total(instrument::allocation_).bytes, 0 );
+}
+
+
+SIMPLE_CASE( count_temporaries )
+{
+	const index_t n = 10;
+	dense_col<double> a(n);
+	for (index_t i = 0; i < n; ++i) a[i] = double(n - i);
+
+	instrument::reset();
+
+	double v = nth_element(a, 3);
+	ASSERT_EQ( v, 4.0 );
+
+	site_stats st = instrument::query(instrument::temporary_, "nth_element");
+	ASSERT_EQ( st.count, 1 );
+	ASSERT_EQ( st.bytes, n * sizeof(double) );
+
+	site_stats sa = instrument::query(instrument::allocation_, "nth_element");
+	ASSERT_EQ( sa.count, 1 );
+	ASSERT_EQ( instrument::query(instrument::allocation_, "untagged").count, 0 );
+
+	dense_col<double> r = eval(a + a);
+	ASSERT_EQ( instrument::query(instrument::temporary_, "eval").count, 1 );
+	ASSERT_EQ( r[0], 2.0 * n );
+}
+
+
+SIMPLE_CASE( count_paths )
+{
+	dense_col<double> a(16, fill(1.0));
+	dense_col<double> b(16);
+	dense_col<double, 1> c(1, fill(1.0));   // shorter than a pack: scalar path
+	dense_col<double, 1> d(1);
+
+	instrument::reset();
+
+	b = a + a;
+	ASSERT_EQ( instrument::total(instrument::simd_path_).count, 1 );
+	ASSERT_EQ( instrument::total(instrument::scalar_path_).count, 0 );
+
+	d = c + c;
+	ASSERT_EQ( instrument::total(instrument::simd_path_).count, 1 );
+	ASSERT_EQ( instrument::total(instrument::scalar_path_).count, 1 );
+
+	double s = sum(a);
+	ASSERT_EQ( s, 16.0 );
+	ASSERT_EQ( instrument::total(instrument::simd_path_).count, 2 );
+
+	std::ostringstream out;
+	instrument::report(out);
+	ASSERT_TRUE( out.str().find("simd_path") != std::string::npos );
+}
+
+
+SIMPLE_CASE( count_stream_path )
+{
+	const index_t big = LMAT_STREAM_MIN_BYTES / sizeof(double) + 5;
+
+	dense_col<double> a(64, fill(1.0));
+	dense_col<double> b(64);
+	dense_col<double> x(big, fill(2.0));
+	dense_col<double> y(big);
+
+	instrument::reset();
+
+	b = a + a;
+	ASSERT_EQ( instrument::query(instrument::simd_path_, "ewise.stream").count, 0 );
+
+	y = x + x;
+	ASSERT_EQ( instrument::query(instrument::simd_path_, "ewise.stream").count, 1 );
+	ASSERT_EQ( y[0], 4.0 );
+	ASSERT_EQ( y[big - 1], 4.0 );
+}
+
+
+SIMPLE_CASE( count_align_paths )
+{
+	typedef pack_align_policy<double, default_simd_kind> apolicy;
+
+	dense_col<double> a(72, fill(1.0));
+	dense_col<double> b(72, zero());
+
+	// the first pack-aligned elements
+
+	const index_t ka = apolicy::npeel(internal::pack_offset_of<double, default_simd_kind>(a.ptr_data()));
+	const index_t kb = apolicy::npeel(internal::pack_offset_of<double, default_simd_kind>(b.ptr_data()));
+
+	ref_col<double> b0(b.ptr_data() + kb, 64);
+	cref_col<double> a0(a.ptr_data() + ka, 64);
+
+	instrument::reset();
+
+	b0 = a0 + a0;
+	ASSERT_EQ( instrument::query(instrument::variant_, "ewise.aligned").count, 1 );
+
+	ref_col<double> b1(b.ptr_data() + kb + 1, 60);
+	cref_col<double> a1(a.ptr_data() + ka + 1, 60);
+	cref_col<double> a2(a.ptr_data() + ka + 2, 60);
+
+	b1 = a1 + a1;
+	ASSERT_EQ( instrument::query(instrument::variant_, "ewise.peeled").count, 1 );
+
+	b1 = a1 + a2;
+	ASSERT_EQ( instrument::query(instrument::variant_, "ewise.aligned").count, 1 );
+	ASSERT_EQ( instrument::query(instrument::variant_, "ewise.peeled").count, 1 );
+	ASSERT_EQ( b[kb], 2.0 );
+	ASSERT_EQ( b[kb + 60], 2.0 );
+}
+
+
+AUTO_TPACK( instrument )
+{
+	ADD_SIMPLE_CASE( count_allocations )
+	ADD_SIMPLE_CASE( count_temporaries )
+	ADD_SIMPLE_CASE( count_paths )
+	ADD_SIMPLE_CASE( count_stream_path )
+	ADD_SIMPLE_CASE( count_align_paths )
+}
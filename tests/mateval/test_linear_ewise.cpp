@@ -7,6 +7,9 @@
  */
 
 
+// a small threshold, such that moderate sizes are evaluated in streaming mode
+#define LMAT_STREAM_MIN_BYTES (1 << 16)
+
 #include "../test_base.h"
 
 #define DEFAULT_M_VALUE 13
@@ -171,13 +174,194 @@ void test_linear_ewise_varysize()
 			r[i] = math::sqr(s[i]);
 
 		ewise(kernel).eval(macc_<linear_, U>(), len, 1, out_(d), in_(s));
-		ASSERT_VEC_EQ( len, d, r );
+
+		// the elements beyond len must remain untouched by the tail
+		ASSERT_VEC_EQ( max_len, d, r );
+	}
+}
+
+template<typename U>
+void test_linear_ewise_varysize_step()
+{
+	const index_t max_len = 32;
+	const index_t step = 3;
+
+	dense_matrix<double> s(step, max_len);
+	dense_matrix<double> d(step, max_len);
+	dense_matrix<double> r(step, max_len);
+
+	for (index_t i = 0; i < step * max_len; ++i)
+	{
+		s[i] = double(i + 1);
+	}
+
+	accum_kernel<double> kernel;
+
+	for (index_t len = 0; len <= max_len; ++len)
+	{
+		for (index_t i = 0; i < step * max_len; ++i) d[i] = r[i] = double(i % 5);
+		for (index_t j = 0; j < len; ++j) r(0, j) += s(0, j);
+
+		ref_block<double, 1, 0> dv(d.ptr_data(), 1, len, step);
+		cref_block<double, 1, 0> sv(s.ptr_data(), 1, len, step);
+
+		ewise(kernel).eval(macc_<linear_, U>(), 1, len, in_out_(dv), in_(sv));
+		ASSERT_MAT_EQ( step, max_len, d, r );
+	}
+}
+
+// static lengths, which are fully unrolled up to LMAT_UNROLL_MAX_LEN
+// (32 by default)
+
+template<typename U, int L>
+void test_linear_ewise_static_len()
+{
+	dense_col<double> s(L + 1);
+	dense_col<double> d(L + 1, zero());
+	dense_col<double> r(L + 1, zero());
+
+	for (index_t i = 0; i < L + 1; ++i)
+	{
+		s[i] = double(2 * i + 3);
+	}
+	for (index_t i = 0; i < L; ++i)
+	{
+		r[i] = math::sqr(s[i]);
+	}
+
+	cref_col<double, L> sv(s.ptr_data(), L);
+	ref_col<double, L> dv(d.ptr_data(), L);
+
+	map_kernel<sqr_fun<double> > kernel = sqr_fun<double>();
+	ewise(kernel).eval(macc_<linear_, U>(), sv.shape(), out_(dv), in_(sv));
+
+	ASSERT_VEC_EQ( L + 1, d, r );
+}
+
+template<typename U>
+void test_linear_ewise_static()
+{
+	test_linear_ewise_static_len<U, 1>();
+	test_linear_ewise_static_len<U, 3>();
+	test_linear_ewise_static_len<U, 4>();
+	test_linear_ewise_static_len<U, 7>();
+	test_linear_ewise_static_len<U, 16>();
+	test_linear_ewise_static_len<U, 19>();
+	test_linear_ewise_static_len<U, 32>();
+	test_linear_ewise_static_len<U, 35>();
+}
+
+template<typename U>
+void test_linear_ewise_streaming()
+{
+	// large enough to be evaluated in streaming mode, with an odd
+	// number of elements, and an unaligned destination
+
+	const index_t len = LMAT_STREAM_MIN_BYTES / sizeof(double) + 7;
+
+	dense_col<double> s(len);
+	dense_col<double> d(len + 1, zero());
+	dense_col<double> r(len);
+
+	for (index_t i = 0; i < len; ++i)
+	{
+		s[i] = double(i % 101);
+		r[i] = math::sqr(s[i]);
+	}
+
+	map_kernel<sqr_fun<double> > kernel = sqr_fun<double>();
+
+	ref_col<double> da(d.ptr_data(), len);
+	ewise(kernel).eval(macc_<linear_, U>(), len, 1, out_(da), in_(s));
+	ASSERT_VEC_EQ( len, da, r );
+
+	ref_col<double> du(d.ptr_data() + 1, len);
+	ewise(kernel).eval(macc_<linear_, U>(), len, 1, out_(du), in_(s));
+	ASSERT_VEC_EQ( len, du, r );
+
+	// updater
+
+	for (index_t i = 0; i < len; ++i) r[i] += s[i];
+	ewise(accum_kernel<double>()).eval(macc_<linear_, U>(), len, 1, in_out_(du), in_(s));
+	ASSERT_VEC_EQ( len, du, r );
+}
+
+template<typename U>
+void test_linear_ewise_offsets()
+{
+	// contiguous operands starting at the same offset from a pack
+	// boundary are evaluated with aligned packs, after peeling off the
+	// leading elements, while those at different offsets are not
+
+	const index_t max_len = 40;
+	const index_t max_off = 4;
+	const index_t n = max_len + max_off;
+
+	dense_col<double> s(n);
+	dense_col<double> d(n);
+	dense_col<double> r(n);
+
+	for (index_t i = 0; i < n; ++i)
+	{
+		s[i] = double(i + 1);
+	}
+
+	map_kernel<sqr_fun<double> > wkernel = sqr_fun<double>();
+	accum_kernel<double> ukernel;
+
+	for (index_t os = 0; os < max_off; ++os)
+	{
+		for (index_t od = 0; od < max_off; ++od)
+		{
+			for (index_t len = 0; len <= max_len; ++len)
+			{
+				cref_col<double> sv(s.ptr_data() + os, len);
+				ref_col<double> dv(d.ptr_data() + od, len);
+
+				// writer
+
+				for (index_t i = 0; i < n; ++i) d[i] = r[i] = double(i % 5);
+				for (index_t j = 0; j < len; ++j) r[od + j] = math::sqr(s[os + j]);
+
+				ewise(wkernel).eval(macc_<linear_, U>(), len, 1, out_(dv), in_(sv));
+				ASSERT_VEC_EQ( n, d, r );
+
+				// updater
+
+				for (index_t j = 0; j < len; ++j) r[od + j] += s[os + j];
+
+				ewise(ukernel).eval(macc_<linear_, U>(), len, 1, in_out_(dv), in_(sv));
+				ASSERT_VEC_EQ( n, d, r );
+			}
+		}
 	}
 }
 
 // Specific test cases
 
 
+SIMPLE_CASE( pack_align_variants )
+{
+	typedef pack_align_policy<double, sse_t> sse_policy;
+
+	ASSERT_EQ( sse_policy::choose(0, 3), aligned_packs );
+	ASSERT_EQ( sse_policy::choose(internal::any_pack_offset, 3), aligned_packs );
+	ASSERT_EQ( sse_policy::choose(internal::mixed_pack_offset, 100), unaligned_packs );
+	ASSERT_EQ( sse_policy::choose(4, 100), unaligned_packs );
+	ASSERT_EQ( sse_policy::choose(8, 4), unaligned_packs );
+	ASSERT_EQ( sse_policy::choose(8, 5), peeled_packs );
+	ASSERT_EQ( sse_policy::npeel(8), 1 );
+
+#ifdef LMAT_HAS_AVX
+	typedef pack_align_policy<float, avx_t> avx_policy;
+
+	ASSERT_EQ( avx_policy::choose(4, 100), peeled_packs );
+	ASSERT_EQ( avx_policy::npeel(4), 7 );
+	ASSERT_EQ( avx_policy::npeel(28), 1 );
+#endif
+}
+
+
 MN_CASE( linear_ewise_scalar_cont_cont  )
 {
 	test_linear_ewise_cont_cont<scalar_, M, N>();
@@ -214,6 +398,71 @@ N_CASE( linear_ewise_scalar_steprow_steprow  )
 }
 
 
+N_CASE( linear_ewise_sse_cont_stepcol  )
+{
+	test_linear_ewise_col<simd_<sse_t>, cont, grid, N>();
+}
+
+N_CASE( linear_ewise_sse_stepcol_cont  )
+{
+	test_linear_ewise_col<simd_<sse_t>, grid, cont, N>();
+}
+
+N_CASE( linear_ewise_sse_stepcol_stepcol  )
+{
+	test_linear_ewise_col<simd_<sse_t>, grid, grid, N>();
+}
+
+N_CASE( linear_ewise_sse_cont_steprow  )
+{
+	test_linear_ewise_row<simd_<sse_t>, cont, bloc, N>();
+}
+
+N_CASE( linear_ewise_sse_steprow_cont  )
+{
+	test_linear_ewise_row<simd_<sse_t>, bloc, cont, N>();
+}
+
+N_CASE( linear_ewise_sse_steprow_steprow  )
+{
+	test_linear_ewise_row<simd_<sse_t>, bloc, bloc, N>();
+}
+
+#ifdef LMAT_HAS_AVX
+
+N_CASE( linear_ewise_avx_cont_stepcol  )
+{
+	test_linear_ewise_col<simd_<avx_t>, cont, grid, N>();
+}
+
+N_CASE( linear_ewise_avx_stepcol_cont  )
+{
+	test_linear_ewise_col<simd_<avx_t>, grid, cont, N>();
+}
+
+N_CASE( linear_ewise_avx_stepcol_stepcol  )
+{
+	test_linear_ewise_col<simd_<avx_t>, grid, grid, N>();
+}
+
+N_CASE( linear_ewise_avx_cont_steprow  )
+{
+	test_linear_ewise_row<simd_<avx_t>, cont, bloc, N>();
+}
+
+N_CASE( linear_ewise_avx_steprow_cont  )
+{
+	test_linear_ewise_row<simd_<avx_t>, bloc, cont, N>();
+}
+
+N_CASE( linear_ewise_avx_steprow_steprow  )
+{
+	test_linear_ewise_row<simd_<avx_t>, bloc, bloc, N>();
+}
+
+#endif
+
+
 MN_CASE( linear_ewise_sse_cont_cont  )
 {
 	test_linear_ewise_cont_cont<simd_<sse_t>, M, N>();
@@ -266,6 +515,59 @@ SIMPLE_CASE( linear_ewise_varysize_avx )
 }
 #endif
 
+SIMPLE_CASE( linear_ewise_varysize_step_scalar )
+{
+	test_linear_ewise_varysize_step<scalar_>();
+}
+
+SIMPLE_CASE( linear_ewise_varysize_step_sse )
+{
+	test_linear_ewise_varysize_step<simd_<sse_t> >();
+}
+
+#ifdef LMAT_HAS_AVX
+SIMPLE_CASE( linear_ewise_varysize_step_avx )
+{
+	test_linear_ewise_varysize_step<simd_<avx_t> >();
+}
+#endif
+
+SIMPLE_CASE( linear_ewise_static_sse )
+{
+	test_linear_ewise_static<simd_<sse_t> >();
+}
+
+#ifdef LMAT_HAS_AVX
+SIMPLE_CASE( linear_ewise_static_avx )
+{
+	test_linear_ewise_static<simd_<avx_t> >();
+}
+#endif
+
+SIMPLE_CASE( linear_ewise_streaming_sse )
+{
+	test_linear_ewise_streaming<simd_<sse_t> >();
+}
+
+#ifdef LMAT_HAS_AVX
+SIMPLE_CASE( linear_ewise_streaming_avx )
+{
+	test_linear_ewise_streaming<simd_<avx_t> >();
+}
+#endif
+
+SIMPLE_CASE( linear_ewise_offsets_sse )
+{
+	test_linear_ewise_offsets<simd_<sse_t> >();
+}
+
+#ifdef LMAT_HAS_AVX
+SIMPLE_CASE( linear_ewise_offsets_avx )
+{
+	test_linear_ewise_offsets<simd_<avx_t> >();
+}
+#endif
+
 
 // Test packs
 
@@ -306,6 +608,71 @@ AUTO_TPACK( linear_ewise_scalar_steprow_steprow )
 }
 
 
+AUTO_TPACK( linear_ewise_sse_cont_stepcol )
+{
+	ADD_N_CASE_3( linear_ewise_sse_cont_stepcol, DM )
+}
+
+AUTO_TPACK( linear_ewise_sse_stepcol_cont )
+{
+	ADD_N_CASE_3( linear_ewise_sse_stepcol_cont, DM )
+}
+
+AUTO_TPACK( linear_ewise_sse_stepcol_stepcol )
+{
+	ADD_N_CASE_3( linear_ewise_sse_stepcol_stepcol, DM )
+}
+
+AUTO_TPACK( linear_ewise_sse_cont_steprow )
+{
+	ADD_N_CASE_3( linear_ewise_sse_cont_steprow, DN )
+}
+
+AUTO_TPACK( linear_ewise_sse_steprow_cont )
+{
+	ADD_N_CASE_3( linear_ewise_sse_steprow_cont, DN )
+}
+
+AUTO_TPACK( linear_ewise_sse_steprow_steprow )
+{
+	ADD_N_CASE_3( linear_ewise_sse_steprow_steprow, DN )
+}
+
+#ifdef LMAT_HAS_AVX
+
+AUTO_TPACK( linear_ewise_avx_cont_stepcol )
+{
+	ADD_N_CASE_3( linear_ewise_avx_cont_stepcol, DM )
+}
+
+AUTO_TPACK( linear_ewise_avx_stepcol_cont )
+{
+	ADD_N_CASE_3( linear_ewise_avx_stepcol_cont, DM )
+}
+
+AUTO_TPACK( linear_ewise_avx_stepcol_stepcol )
+{
+	ADD_N_CASE_3( linear_ewise_avx_stepcol_stepcol, DM )
+}
+
+AUTO_TPACK( linear_ewise_avx_cont_steprow )
+{
+	ADD_N_CASE_3( linear_ewise_avx_cont_steprow, DN )
+}
+
+AUTO_TPACK( linear_ewise_avx_steprow_cont )
+{
+	ADD_N_CASE_3( linear_ewise_avx_steprow_cont, DN )
+}
+
+AUTO_TPACK( linear_ewise_avx_steprow_steprow )
+{
+	ADD_N_CASE_3( linear_ewise_avx_steprow_steprow, DN )
+}
+
+#endif
+
+
 AUTO_TPACK( linear_ewise_sse_cont_cont )
 {
 	ADD_MN_CASE_3X3( linear_ewise_sse_cont_cont, DM, DN )
@@ -347,8 +714,31 @@ AUTO_TPACK( linear_ewise_varysize )
 	ADD_SIMPLE_CASE( linear_ewise_varysize_sse )
 #ifdef LMAT_HAS_AVX
 	ADD_SIMPLE_CASE( linear_ewise_varysize_avx )
+#endif
+	ADD_SIMPLE_CASE( linear_ewise_varysize_step_scalar )
+	ADD_SIMPLE_CASE( linear_ewise_varysize_step_sse )
+#ifdef LMAT_HAS_AVX
+	ADD_SIMPLE_CASE( linear_ewise_varysize_step_avx )
+#endif
+	ADD_SIMPLE_CASE( linear_ewise_static_sse )
+#ifdef LMAT_HAS_AVX
+	ADD_SIMPLE_CASE( linear_ewise_static_avx )
 #endif
 }
 
+AUTO_TPACK( linear_ewise_streaming )
+{
+	ADD_SIMPLE_CASE( linear_ewise_streaming_sse )
+#ifdef LMAT_HAS_AVX
+	ADD_SIMPLE_CASE( linear_ewise_streaming_avx )
+#endif
+}
 
-
+AUTO_TPACK( linear_ewise_offsets )
+{
+	ADD_SIMPLE_CASE( pack_align_variants )
+	ADD_SIMPLE_CASE( linear_ewise_offsets_sse )
+#ifdef LMAT_HAS_AVX
+	ADD_SIMPLE_CASE( linear_ewise_offsets_avx )
+#endif
+}
@@ -109,22 +109,37 @@ inline bool my_use_linear(grid, matrix_shape<CM, CN>)
 	return CN == 1 || CM == 1;
 }
 
+// the tail of a length that is not a multiple of the pack width is
+// folded in by an overlapping pack or a scalar loop, unless the whole
+// length is shorter than a pack
+
+inline bool my_simd_len(index_t L)
+{
+	return L % 4 == 0 || L > 4;
+}
+
 template<index_t CM, index_t CN>
 inline bool my_use_simd(cont, matrix_shape<CM, CN>)
 {
-	return (CM * CN) % 4 == 0;
+	return my_simd_len(CM * CN);
 }
 
+// folding a strided operand (a row of a block, or a grid) with a
+// single arithmetic operation per element does not pay for the
+// strided packs, unless they are gathered (see LMAT_STRIDED_SIMD_COST)
+
 template<index_t CM, index_t CN>
 inline bool my_use_simd(bloc, matrix_shape<CM, CN>)
 {
-	return CM % 4 == 0;
+	if (CM == 1 && CN != 1 && LMAT_STRIDED_SIMD_COST > 1) return false;
+	return my_use_linear(bloc(), matrix_shape<CM, CN>()) ? my_simd_len(CM * CN) : my_simd_len(CM);
 }
 
 template<index_t CM, index_t CN>
 inline bool my_use_simd(grid, matrix_shape<CM, CN>)
 {
-	return false;
+	if (LMAT_STRIDED_SIMD_COST > 1) return false;
+	return my_use_linear(grid(), matrix_shape<CM, CN>()) ? my_simd_len(CM * CN) : my_simd_len(CM);
 }
 
 
@@ -193,6 +208,102 @@ void test_folder()
 
 
 
+// folds over all lengths up to a few packs, such that the tails
+// (with an overlapping last pack for idempotent kernels) are covered,
+// with the extreme values placed at either end
+
+template<class KTT, typename U>
+void test_folder_varysize()
+{
+	typedef typename KTT::kernel_type kernel_t;
+	kernel_t fker;
+
+	const index_t max_len = 40;
+
+	dense_col<double> a(max_len), b(max_len);
+	for (index_t i = 0; i < max_len; ++i)
+	{
+		a[i] = double((i * 7) % 11) + 0.5 * double(i);
+		b[i] = double((i * 5) % 13) - 0.5 * double(i);
+	}
+
+	for (index_t len = 1; len <= max_len; ++len)
+	{
+		cref_col<double> av(a.ptr_data(), len);
+		cref_col<double> bv(b.ptr_data(), len);
+
+		double ra = fold(fker).eval(macc_<linear_, U>(), len, 1, in_(av));
+		ASSERT_APPROX( ra, KTT::eval(av), KTT::tol() );
+
+		double rb = fold(fker).eval(macc_<linear_, U>(), len, 1, in_(bv));
+		ASSERT_APPROX( rb, KTT::eval(bv), KTT::tol() );
+	}
+}
+
+// static lengths, which are fully unrolled up to LMAT_UNROLL_MAX_LEN
+// (32 by default)
+
+template<class KTT, typename U, int L>
+void test_folder_static_len()
+{
+	typedef typename KTT::kernel_type kernel_t;
+	kernel_t fker;
+
+	dense_col<double, L> a(L);
+	for (index_t i = 0; i < L; ++i)
+	{
+		a[i] = double((i * 7) % 11) + 0.5 * double(i);
+	}
+
+	double r = fold(fker).eval(macc_<linear_, U>(), a.shape(), in_(a));
+	ASSERT_APPROX( r, KTT::eval(a), KTT::tol() );
+}
+
+template<class KTT, typename U>
+void test_folder_static()
+{
+	test_folder_static_len<KTT, U, 1>();
+	test_folder_static_len<KTT, U, 3>();
+	test_folder_static_len<KTT, U, 4>();
+	test_folder_static_len<KTT, U, 7>();
+	test_folder_static_len<KTT, U, 16>();
+	test_folder_static_len<KTT, U, 19>();
+	test_folder_static_len<KTT, U, 32>();
+	test_folder_static_len<KTT, U, 35>();
+}
+
+SIMPLE_CASE( fold_static_sse )
+{
+	test_folder_static<sum_tt, simd_<sse_t> >();
+	test_folder_static<max_tt, simd_<sse_t> >();
+	test_folder_static<min_tt, simd_<sse_t> >();
+}
+
+#ifdef LMAT_HAS_AVX
+SIMPLE_CASE( fold_static_avx )
+{
+	test_folder_static<sum_tt, simd_<avx_t> >();
+	test_folder_static<max_tt, simd_<avx_t> >();
+	test_folder_static<min_tt, simd_<avx_t> >();
+}
+#endif
+
+SIMPLE_CASE( fold_varysize_sse )
+{
+	test_folder_varysize<sum_tt, simd_<sse_t> >();
+	test_folder_varysize<max_tt, simd_<sse_t> >();
+	test_folder_varysize<min_tt, simd_<sse_t> >();
+}
+
+#ifdef LMAT_HAS_AVX
+SIMPLE_CASE( fold_varysize_avx )
+{
+	test_folder_varysize<sum_tt, simd_<avx_t> >();
+	test_folder_varysize<max_tt, simd_<avx_t> >();
+	test_folder_varysize<min_tt, simd_<avx_t> >();
+}
+#endif
+
 
 // specific cases
 
@@ -729,4 +840,14 @@ AUTO_TPACK( min_auto )
 	ADD_MN_CASE_3X3( min_auto_grid, DM, DN )
 }
 
-
+AUTO_TPACK( fold_varysize )
+{
+	ADD_SIMPLE_CASE( fold_varysize_sse )
+#ifdef LMAT_HAS_AVX
+	ADD_SIMPLE_CASE( fold_varysize_avx )
+#endif
+	ADD_SIMPLE_CASE( fold_static_sse )
+#ifdef LMAT_HAS_AVX
+	ADD_SIMPLE_CASE( fold_static_avx )
+#endif
+}
@@ -0,0 +1,392 @@
+/**
+ * @file test_mat_histogram.cpp
+ *
+ * @brief Unit testing of bin counts, histograms and quantile sketches
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/mateval/mat_histogram.h>
+#include <light_mat/common/exec.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <limits>
+
+using namespace lmat;
+using namespace lmat::test;
+
+inline double randunif()
+{
+	return (double)std::rand() / double(RAND_MAX);
+}
+
+template<class Mat, typename T>
+void fill_rand(IRegularMatrix<Mat, T>& mat, double lo, double hi)
+{
+	for (index_t j = 0; j < mat.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < mat.nrows(); ++i)
+		{
+			mat(i, j) = T(lo + (hi - lo) * randunif());
+		}
+	}
+}
+
+
+// reference implementations
+
+template<class A>
+dense_col<index_t> ref_bincount(const A& a, index_t n)
+{
+	dense_col<index_t> c(n, zero());
+	for (index_t j = 0; j < a.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < a.nrows(); ++i)
+		{
+			index_t v = (index_t)a(i, j);
+			if (v >= 0 && v < n) ++ c[v];
+		}
+	}
+	return c;
+}
+
+template<typename T, class A>
+dense_col<index_t> ref_histogram(const A& a, const std::vector<T>& e)
+{
+	const index_t nb = (index_t)e.size() - 1;
+	dense_col<index_t> c(nb, zero());
+	for (index_t j = 0; j < a.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < a.nrows(); ++i)
+		{
+			T x = a(i, j);
+			for (index_t k = 0; k < nb; ++k)
+			{
+				if (x >= e[k] && (x < e[k+1] || (k == nb - 1 && x == e[k+1])))
+				{
+					++ c[k];
+					break;
+				}
+			}
+		}
+	}
+	return c;
+}
+
+template<typename T>
+std::vector<T> uniform_edges(T lo, T hi, index_t n)
+{
+	std::vector<T> e(n + 1);
+	T scale = T(n) / (hi - lo);
+	for (index_t k = 1; k < n; ++k) e[k] = lo + T(k) / scale;
+	e[0] = lo;
+	e[n] = hi;
+
+	// the edges that the multiplication would assign to the bin below
+	for (index_t k = 1; k < n; ++k)
+	{
+		while (index_t((e[k] - lo) * scale) < k) e[k] = std::nextafter(e[k], hi);
+		while (e[k] > lo && index_t((std::nextafter(e[k], lo) - lo) * scale) >= k) e[k] = std::nextafter(e[k], lo);
+	}
+	return e;
+}
+
+
+SIMPLE_CASE( tbincount )
+{
+	const index_t m = 37;
+	const index_t n = 5;
+	const index_t nb = 9;
+
+	dense_matrix<int> a(m + 3, n);
+	for (index_t i = 0; i < a.nelems(); ++i) a[i] = (std::rand() % (nb + 4)) - 2;
+
+	ref_block<int> ab = a(range(0, m), whole());
+	dense_matrix<int> ac(ab);
+
+	dense_col<index_t> r = ref_bincount(ac, nb);
+
+	dense_col<index_t> c = bincount(ac, nb);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	c = bincount(ab, nb);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	dense_col<index_t> c2 = bincount(ac + 1, nb + 1);
+	for (index_t k = 0; k < nb; ++k) ASSERT_EQ( c2[k + 1], r[k] );
+
+	dense_col<double> cd(nb);
+	bincount(ac, nb, cd);
+	for (index_t k = 0; k < nb; ++k) ASSERT_EQ( cd[k], double(r[k]) );
+}
+
+SIMPLE_CASE( thistogram_edges )
+{
+	const index_t m = 53;
+	const index_t n = 7;
+
+	dense_matrix<double> a(m + 1, n);
+	fill_rand(a, -1.5, 3.5);
+	a(0, 0) = 0.0;
+	a(1, 0) = 3.0;
+	a(2, 0) = 1.0;
+	a(3, 0) = std::numeric_limits<double>::quiet_NaN();
+
+	ref_block<double> ab = a(range(0, m), whole());
+	dense_matrix<double> ac(ab);
+
+	std::vector<double> ev = { 0.0, 0.25, 1.0, 1.5, 2.0, 3.0 };
+	const index_t nb = (index_t)ev.size() - 1;
+	dense_row<double> e(nb + 1);
+	for (index_t k = 0; k <= nb; ++k) e[k] = ev[k];
+
+	dense_col<index_t> r = ref_histogram(ac, ev);
+
+	dense_col<index_t> c = histogram(ac, e);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	c = histogram(ab, e);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	c = histogram(ab * 1.0, e);
+	ASSERT_VEC_EQ( nb, c, r );
+}
+
+template<typename T>
+void test_histogram_uniform(T lo, T hi, index_t nb)
+{
+	const index_t n = 6;
+
+	dense_matrix<T> a(70, n);
+	fill_rand(a, double(lo) - 0.5, double(hi) + 0.5);
+	a(0, 0) = lo;
+	a(1, 0) = hi;
+	a(2, 0) = std::numeric_limits<T>::quiet_NaN();
+
+	std::vector<T> ev = uniform_edges(lo, hi, nb);
+	for (index_t k = 1; k < nb; ++k) a(2 + k, 1) = ev[k];
+
+	uniform_bins<T> bins(lo, hi, nb);
+
+	index_t ms[] = { 1, 3, 4, 7, 8, 9, 16, 17, 69 };
+	for (unsigned u = 0; u < sizeof(ms) / sizeof(index_t); ++u)
+	{
+		const index_t m = ms[u];
+		ref_block<T> ab = a(range(0, m), whole());
+		dense_matrix<T> ac(ab);
+
+		dense_col<index_t> r = ref_histogram(ac, ev);
+
+		dense_col<index_t> c = histogram(ac, bins);
+		ASSERT_VEC_EQ( nb, c, r );
+
+		c = histogram(ab, bins);
+		ASSERT_VEC_EQ( nb, c, r );
+
+		c = histogram(ab * T(1), bins);
+		ASSERT_VEC_EQ( nb, c, r );
+	}
+}
+
+SIMPLE_CASE( thistogram_uniform )
+{
+	test_histogram_uniform<double>(-1.0, 2.0, 7);
+	test_histogram_uniform<double>(0.0, 1.0, 1);
+}
+
+SIMPLE_CASE( thistogram_uniform_f32 )
+{
+	test_histogram_uniform<float>(-1.0f, 2.0f, 7);
+	test_histogram_uniform<float>(0.5f, 100.0f, 33);
+}
+
+SIMPLE_CASE( thistogram_par )
+{
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	const index_t len = 100003;
+	dense_col<double> a(len);
+	fill_rand(a, -0.1, 1.1);
+
+	dense_matrix<double> am(101, 990);
+	fill_rand(am, -0.1, 1.1);
+	ref_block<double> ab = am(range(0, 100), whole());
+
+	const index_t nb = 10;
+	std::vector<double> ev = uniform_edges(0.0, 1.0, nb);
+	uniform_bins<double> bins(0.0, 1.0, nb);
+
+	dense_col<index_t> r = ref_histogram(a, ev);
+	dense_col<index_t> c = histogram(par_(), a, bins);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	c = histogram(par_(1000), a, bins);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	dense_row<double> e(nb + 1);
+	for (index_t k = 0; k <= nb; ++k) e[k] = ev[k];
+	c = histogram(par_(777), a, e);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	r = ref_histogram(ab, ev);
+	c = histogram(par_(777), ab, bins);
+	ASSERT_VEC_EQ( nb, c, r );
+
+	dense_matrix<int> ai(100, 990);
+	for (index_t i = 0; i < ai.nelems(); ++i) ai[i] = std::rand() % 20;
+	r = ref_bincount(ai, 15);
+	c = bincount(par_(), ai, 15);
+	ASSERT_VEC_EQ( 15, c, r );
+}
+
+SIMPLE_CASE( thistogram_args )
+{
+	dense_col<double> a(10, zero());
+
+	bool thrown = false;
+	try { uniform_bins<double>(1.0, 1.0, 3); }
+	catch (invalid_argument&) { thrown = true; }
+	ASSERT_TRUE( thrown );
+
+	dense_col<double> e(3);
+	e[0] = 0.0; e[1] = 2.0; e[2] = 1.0;
+
+	thrown = false;
+	try { histogram(a, e); }
+	catch (invalid_argument&) { thrown = true; }
+	ASSERT_TRUE( thrown );
+}
+
+
+// quantile sketches
+
+template<typename T>
+double true_rank(const std::vector<T>& sorted, T x)
+{
+	return double(std::upper_bound(sorted.begin(), sorted.end(), x) - sorted.begin()) / double(sorted.size());
+}
+
+template<typename T>
+void check_sketch(const quantile_sketch<T>& s, const std::vector<T>& sorted, double tol)
+{
+	ASSERT_EQ( s.count(), (int64_t)sorted.size() );
+
+	for (int i = 0; i <= 20; ++i)
+	{
+		double q = i / 20.0;
+		T v = s.quantile(q);
+		double rk = true_rank(sorted, v);
+		ASSERT_TRUE( std::abs(rk - q) <= tol );
+	}
+}
+
+SIMPLE_CASE( tquantile_sketch_small )
+{
+	quantile_sketch<double> s(50);
+	ASSERT_TRUE( s.empty() );
+	ASSERT_TRUE( std::isnan(s.quantile(0.5)) );
+
+	std::vector<double> v;
+	for (int i = 0; i < 40; ++i) v.push_back(double((i * 7) % 40));
+	for (size_t i = 0; i < v.size(); ++i) s.update(v[i]);
+	s.update(std::numeric_limits<double>::quiet_NaN());
+
+	std::sort(v.begin(), v.end());
+
+	// no compaction has happened, hence the quantiles are exact
+	ASSERT_EQ( s.nretained(), 40 );
+	ASSERT_EQ( s.quantile(0.0), 0.0 );
+	ASSERT_EQ( s.quantile(0.5), 19.0 );
+	ASSERT_EQ( s.quantile(1.0), 39.0 );
+	ASSERT_EQ( s.rank(9.0), 0.25 );
+	check_sketch(s, v, 1.0 / 40);
+}
+
+SIMPLE_CASE( tquantile_sketch )
+{
+	const index_t len = 200000;
+
+	dense_matrix<double> a(400, len / 400);
+	fill_rand(a, 0.0, 1.0);
+	for (index_t i = 0; i < a.nelems(); ++i) a[i] = a[i] * a[i];
+
+	std::vector<double> v(a.ptr_data(), a.ptr_data() + len);
+	std::sort(v.begin(), v.end());
+
+	quantile_sketch<double> s;
+	for (index_t i = 0; i < len; ++i) s.update(a[i]);
+
+	ASSERT_TRUE( s.nretained() < 3 * LMAT_QSKETCH_K );
+	check_sketch(s, v, 0.02);
+
+	quantile_sketch<double> sf = fold(quantile_sketch_kernel<double>())(a.shape(), in_(a));
+	check_sketch(sf, v, 0.02);
+
+	sf = sketch_quantiles(a * 1.0);
+	check_sketch(sf, v, 0.02);
+
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	quantile_sketch<double> sp = sketch_quantiles(par_(), a);
+	check_sketch(sp, v, 0.02);
+
+	sp = sketch_quantiles(par_(3000), a(range(0, 400), whole()));
+	check_sketch(sp, v, 0.02);
+}
+
+SIMPLE_CASE( tquantile_sketch_merge )
+{
+	quantile_sketch<int> s(20);
+
+	bool thrown = false;
+	try { s.quantile(0.5); }
+	catch (invalid_argument&) { thrown = true; }
+	ASSERT_TRUE( thrown );
+
+	std::vector<int> v;
+	for (int i = 0; i < 1000; ++i)
+	{
+		s.update(i);
+		v.push_back(i);
+		v.push_back(i);
+	}
+
+	// merging a sketch with itself counts every value twice
+	s.update(s);
+	ASSERT_EQ( s.count(), int64_t(2000) );
+	check_sketch(s, v, 0.1);
+
+	quantile_sketch<int> t(20);
+	t.update(t);
+	ASSERT_TRUE( t.empty() );
+}
+
+
+AUTO_TPACK( mat_histogram )
+{
+	ADD_SIMPLE_CASE( tbincount )
+	ADD_SIMPLE_CASE( thistogram_edges )
+	ADD_SIMPLE_CASE( thistogram_uniform )
+	ADD_SIMPLE_CASE( thistogram_uniform_f32 )
+	ADD_SIMPLE_CASE( thistogram_args )
+}
+
+AUTO_TPACK( mat_histogram_par )
+{
+	ADD_SIMPLE_CASE( thistogram_par )
+}
+
+AUTO_TPACK( quantile_sketch )
+{
+	ADD_SIMPLE_CASE( tquantile_sketch_small )
+	ADD_SIMPLE_CASE( tquantile_sketch )
+	ADD_SIMPLE_CASE( tquantile_sketch_merge )
+}
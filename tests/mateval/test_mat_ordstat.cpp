@@ -10,6 +10,7 @@
 #include <light_mat/matrix/matrix_classes.h>
 #include <light_mat/mateval/matrix_sort.h>
 #include <light_mat/mateval/matrix_ordstats.h>
+#include <light_mat/common/exec.h>
 
 #include <cstdlib>
 
@@ -134,6 +135,28 @@ SIMPLE_CASE( colwise_nth_elem )
 	}
 }
 
+SIMPLE_CASE( colwise_nth_elem_par )
+{
+	const index_t m = DM;
+	const index_t n = DN;
+
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	dense_matrix<double> a(m, n);
+	fill_ran(a);
+
+	dense_matrix<double> sx = colwise_sorted(a);
+
+	for (index_t k = 0; k < m; ++k)
+	{
+		dense_row<double> r(n, zero());
+		colwise_nth_element(par_(1), a, k, r);
+		ASSERT_VEC_EQ( n, r, sx.row(k) );
+	}
+}
+
+
 
 SIMPLE_CASE( vec_median_odd )
 {
@@ -204,6 +227,128 @@ SIMPLE_CASE( colwise_median_even )
 	ASSERT_VEC_APPROX( n, r, r0, 1.0e-15 );
 }
 
+SIMPLE_CASE( colwise_median_par )
+{
+	const index_t m = DM2;
+	const index_t n = DN;
+
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	dense_matrix<double> a(m, n);
+	fill_ran(a);
+
+	dense_row<double> r0(n, zero());
+	colwise_median(a, r0);
+
+	dense_row<double> r(n, zero());
+	colwise_median(par_(3), a, r);
+
+	ASSERT_VEC_EQ( n, r, r0 );
+}
+
+
+
+SIMPLE_CASE( vec_topk )
+{
+	const index_t n = DM;
+
+	dense_col<double> a(n);
+	fill_ran(a);
+
+	dense_col<index_t> si = sorted_idx(a, desc_());
+
+	for (index_t k = 0; k <= n; ++k)
+	{
+		dense_col<double> rv(k, zero());
+		dense_col<index_t> ri(k, zero());
+		topk(a, k, rv, ri);
+
+		for (index_t i = 0; i < k; ++i)
+		{
+			ASSERT_EQ( ri[i], si[i] );
+			ASSERT_EQ( rv[i], a[si[i]] );
+		}
+	}
+
+	dense_col<double> r = topk(a, 5);
+	ASSERT_EQ( r.nelems(), 5 );
+	for (index_t i = 0; i < 5; ++i) ASSERT_EQ( r[i], a[si[i]] );
+}
+
+SIMPLE_CASE( vec_topk_long )
+{
+	const index_t n = 1000;
+	const index_t k = 10;
+
+	dense_col<double> a(n);
+	fill_ran(a);
+
+	dense_col<index_t> si = sorted_idx(a, desc_());
+
+	dense_col<double> rv(k, zero());
+	dense_col<index_t> ri(k, zero());
+	topk(a, k, rv, ri);
+
+	for (index_t i = 0; i < k; ++i)
+	{
+		ASSERT_EQ( ri[i], si[i] );
+		ASSERT_EQ( rv[i], a[si[i]] );
+	}
+}
+
+SIMPLE_CASE( mat_colwise_topk )
+{
+	const index_t m = DM;
+	const index_t n = DN;
+	const index_t k = 4;
+
+	dense_matrix<double> a(m, n);
+	fill_ran(a);
+
+	dense_matrix<index_t> si = colwise_sorted_idx(a, desc_());
+	dense_matrix<double> sx = colwise_sorted(a, desc_());
+
+	dense_matrix<double> rv(k, n, zero());
+	dense_matrix<index_t> ri(k, n, zero());
+	colwise_topk(a, k, rv, ri);
+
+	ASSERT_MAT_EQ( k, n, ri, si(range(0, k), whole()) );
+	ASSERT_MAT_EQ( k, n, rv, sx(range(0, k), whole()) );
+
+	dense_matrix<double> rv2(k, n, zero());
+	colwise_topk(a, k, rv2);
+	ASSERT_MAT_EQ( k, n, rv2, sx(range(0, k), whole()) );
+}
+
+SIMPLE_CASE( mat_colwise_topk_par )
+{
+	const index_t m = DM;
+	const index_t n = DN;
+	const index_t k = 4;
+
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	dense_matrix<double> a(m, n);
+	fill_ran(a);
+
+	dense_matrix<index_t> si = colwise_sorted_idx(a, desc_());
+	dense_matrix<double> sx = colwise_sorted(a, desc_());
+
+	dense_matrix<double> rv(k, n, zero());
+	dense_matrix<index_t> ri(k, n, zero());
+	colwise_topk(par_(1), a, k, rv, ri);
+
+	ASSERT_MAT_EQ( k, n, ri, si(range(0, k), whole()) );
+	ASSERT_MAT_EQ( k, n, rv, sx(range(0, k), whole()) );
+
+	dense_matrix<double> rv2(k, n, zero());
+	colwise_topk(par_(), a, k, rv2);
+	ASSERT_MAT_EQ( k, n, rv2, sx(range(0, k), whole()) );
+}
+
+
 
 AUTO_TPACK( test_find_max_min )
 {
@@ -215,6 +360,7 @@ AUTO_TPACK( test_nth_elem )
 {
 	ADD_SIMPLE_CASE( vec_nth_elem )
 	ADD_SIMPLE_CASE( colwise_nth_elem )
+	ADD_SIMPLE_CASE( colwise_nth_elem_par )
 }
 
 AUTO_TPACK( test_median )
@@ -223,8 +369,13 @@ AUTO_TPACK( test_median )
 	ADD_SIMPLE_CASE( vec_median_even )
 	ADD_SIMPLE_CASE( colwise_median_odd )
 	ADD_SIMPLE_CASE( colwise_median_even )
+	ADD_SIMPLE_CASE( colwise_median_par )
 }
 
-
-
-
+AUTO_TPACK( test_topk )
+{
+	ADD_SIMPLE_CASE( vec_topk )
+	ADD_SIMPLE_CASE( vec_topk_long )
+	ADD_SIMPLE_CASE( mat_colwise_topk )
+	ADD_SIMPLE_CASE( mat_colwise_topk_par )
+}
@@ -0,0 +1,272 @@
+/**
+ * @file test_mat_scan.cpp
+ *
+ * @brief Unit testing of cumulative sums, products, maxima and minima
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/mateval/mat_scan.h>
+#include <light_mat/common/exec.h>
+
+#include <cstdlib>
+#include <string>
+
+using namespace lmat;
+using namespace lmat::test;
+
+inline double randunif()
+{
+	double u = (double)std::rand() / double(RAND_MAX);
+	return u * 2.0 - 1.0;
+}
+
+// values around 1 for products, such that they neither vanish nor blow up
+
+template<class Mat, typename T>
+void fill_rand(IRegularMatrix<Mat, T>& mat, bool near_one)
+{
+	for (index_t j = 0; j < mat.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < mat.nrows(); ++i)
+		{
+			double u = randunif();
+			mat(i, j) = T(near_one ? 1.0 + 0.1 * u : u);
+		}
+	}
+}
+
+const index_t max_nrows = 33;
+index_t test_nrows[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33 };
+const unsigned int ntest_nrows = sizeof(test_nrows) / sizeof(index_t);
+
+
+// reference implementation
+
+template<class Kernel, class A>
+dense_matrix<typename Kernel::value_type> ref_scan(const A& a, scandir::linear_)
+{
+	dense_matrix<typename Kernel::value_type> r(a.nrows(), a.ncolumns());
+	Kernel kernel;
+	for (index_t k = 0; k < a.nelems(); ++k)
+	{
+		index_t i = k % a.nrows();
+		index_t j = k / a.nrows();
+		r[k] = a(i, j);
+		if (k > 0) kernel(r[k], r[k-1]);
+	}
+	return r;
+}
+
+template<class Kernel, class A>
+dense_matrix<typename Kernel::value_type> ref_scan(const A& a, scandir::colwise_)
+{
+	dense_matrix<typename Kernel::value_type> r(a.nrows(), a.ncolumns());
+	Kernel kernel;
+	for (index_t j = 0; j < a.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < a.nrows(); ++i)
+		{
+			r(i, j) = a(i, j);
+			if (i > 0) kernel(r(i, j), r(i-1, j));
+		}
+	}
+	return r;
+}
+
+template<class Kernel, class A>
+dense_matrix<typename Kernel::value_type> ref_scan(const A& a, scandir::rowwise_)
+{
+	dense_matrix<typename Kernel::value_type> r(a.nrows(), a.ncolumns());
+	Kernel kernel;
+	for (index_t j = 0; j < a.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < a.nrows(); ++i)
+		{
+			r(i, j) = a(i, j);
+			if (j > 0) kernel(r(i, j), r(i, j-1));
+		}
+	}
+	return r;
+}
+
+
+#define DEFINE_SCAN_CASE( Name, Dir, Fun ) \
+	SIMPLE_CASE( t##Fun ) { \
+		const index_t n = 5; \
+		const bool nr1 = std::string(#Name) == "cumprod"; \
+		dense_matrix<double> src(max_nrows, n); \
+		fill_rand(src, nr1); \
+		for (unsigned k = 0; k < ntest_nrows; ++k) { \
+			index_t m = test_nrows[k]; \
+			ref_col<double> s1 = src(range(0, m), 0); \
+			ref_block<double> sn = src(range(0, m), whole()); \
+			dense_matrix<double> c1(s1); \
+			dense_matrix<double> cn(sn); \
+			dense_matrix<double> r1 = ref_scan<Name##_kernel<double> >(s1, scandir::Dir()); \
+			dense_matrix<double> rn = ref_scan<Name##_kernel<double> >(sn, scandir::Dir()); \
+			dense_matrix<double> d1 = Fun(s1); \
+			ASSERT_MAT_APPROX( m, 1, d1, r1, 1.0e-12 ); \
+			dense_matrix<double> dn = Fun(sn); \
+			ASSERT_MAT_APPROX( m, n, dn, rn, 1.0e-12 ); \
+			dn = Fun(cn); \
+			ASSERT_MAT_APPROX( m, n, dn, rn, 1.0e-12 ); \
+			dense_matrix<double> bb(max_nrows + 1, n, zero()); \
+			ref_block<double> bn = bb(range(0, m), whole()); \
+			bn = Fun(sn * 1.0); \
+			ASSERT_MAT_APPROX( m, n, bn, rn, 1.0e-12 ); \
+			cn = Fun(cn); \
+			ASSERT_MAT_APPROX( m, n, cn, rn, 1.0e-12 ); } }
+
+#define DEFINE_SCAN_CASE_F32( Name, Dir, Fun ) \
+	SIMPLE_CASE( t##Fun##_f32 ) { \
+		const index_t n = 5; \
+		const bool nr1 = std::string(#Name) == "cumprod"; \
+		dense_matrix<float> src(max_nrows, n); \
+		fill_rand(src, nr1); \
+		for (unsigned k = 0; k < ntest_nrows; ++k) { \
+			index_t m = test_nrows[k]; \
+			ref_block<float> sn = src(range(0, m), whole()); \
+			dense_matrix<float> cn(sn); \
+			dense_matrix<float> rn = ref_scan<Name##_kernel<float> >(sn, scandir::Dir()); \
+			dense_matrix<float> dn = Fun(sn); \
+			ASSERT_MAT_APPROX( m, n, dn, rn, 1.0e-4f ); \
+			dn = Fun(cn); \
+			ASSERT_MAT_APPROX( m, n, dn, rn, 1.0e-4f ); } }
+
+#define DEFINE_PAR_SCAN_CASE( Name, Dir, Fun ) \
+	SIMPLE_CASE( t##Fun##_par ) { \
+		exec::thread_pool pool(4); \
+		exec::executor_scope xs(pool); \
+		const index_t n = 23; \
+		const bool nr1 = std::string(#Name) == "cumprod"; \
+		dense_matrix<double> src(max_nrows, n); \
+		fill_rand(src, nr1); \
+		for (unsigned k = 0; k < ntest_nrows; ++k) { \
+			index_t m = test_nrows[k]; \
+			ref_col<double> s1 = src(range(0, m), 0); \
+			ref_block<double> sn = src(range(0, m), whole()); \
+			dense_matrix<double> cn(sn); \
+			dense_matrix<double> r1 = ref_scan<Name##_kernel<double> >(s1, scandir::Dir()); \
+			dense_matrix<double> rn = ref_scan<Name##_kernel<double> >(sn, scandir::Dir()); \
+			dense_matrix<double> d1 = Fun(par_(3), s1); \
+			ASSERT_MAT_APPROX( m, 1, d1, r1, 1.0e-12 ); \
+			dense_matrix<double> dn = Fun(par_(3), sn); \
+			ASSERT_MAT_APPROX( m, n, dn, rn, 1.0e-12 ); \
+			dn = Fun(par_(3), cn); \
+			ASSERT_MAT_APPROX( m, n, dn, rn, 1.0e-12 ); \
+			dn = Fun(par_(), cn); \
+			ASSERT_MAT_APPROX( m, n, dn, rn, 1.0e-12 ); } }
+
+
+DEFINE_SCAN_CASE( cumsum, linear_, cumsum )
+DEFINE_SCAN_CASE( cumprod, linear_, cumprod )
+DEFINE_SCAN_CASE( cummax, linear_, cummax )
+DEFINE_SCAN_CASE( cummin, linear_, cummin )
+
+DEFINE_SCAN_CASE( cumsum, colwise_, colwise_cumsum )
+DEFINE_SCAN_CASE( cumprod, colwise_, colwise_cumprod )
+DEFINE_SCAN_CASE( cummax, colwise_, colwise_cummax )
+DEFINE_SCAN_CASE( cummin, colwise_, colwise_cummin )
+
+DEFINE_SCAN_CASE( cumsum, rowwise_, rowwise_cumsum )
+DEFINE_SCAN_CASE( cumprod, rowwise_, rowwise_cumprod )
+DEFINE_SCAN_CASE( cummax, rowwise_, rowwise_cummax )
+DEFINE_SCAN_CASE( cummin, rowwise_, rowwise_cummin )
+
+DEFINE_SCAN_CASE_F32( cumsum, linear_, cumsum )
+DEFINE_SCAN_CASE_F32( cummax, linear_, cummax )
+DEFINE_SCAN_CASE_F32( cumsum, colwise_, colwise_cumsum )
+DEFINE_SCAN_CASE_F32( cumprod, colwise_, colwise_cumprod )
+DEFINE_SCAN_CASE_F32( cummin, rowwise_, rowwise_cummin )
+
+DEFINE_PAR_SCAN_CASE( cumsum, linear_, cumsum )
+DEFINE_PAR_SCAN_CASE( cummax, linear_, cummax )
+DEFINE_PAR_SCAN_CASE( cumprod, colwise_, colwise_cumprod )
+DEFINE_PAR_SCAN_CASE( cumsum, rowwise_, rowwise_cumsum )
+
+
+SIMPLE_CASE( tcumsum_int )
+{
+	const index_t m = 7;
+	const index_t n = 3;
+
+	dense_matrix<int> a(m, n);
+	for (index_t i = 0; i < a.nelems(); ++i) a[i] = int(i % 5) - 2;
+
+	dense_matrix<int> r = ref_scan<cumsum_kernel<int> >(a, scandir::linear_());
+	dense_matrix<int> d = cumsum(a);
+	ASSERT_MAT_EQ( m, n, d, r );
+
+	r = ref_scan<cummax_kernel<int> >(a, scandir::colwise_());
+	d = colwise_cummax(a);
+	ASSERT_MAT_EQ( m, n, d, r );
+}
+
+
+// long vectors, over many blocks of the two-pass scan
+
+SIMPLE_CASE( tcumsum_par_long )
+{
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	const index_t len = 100003;
+	dense_col<double> a(len);
+	for (index_t i = 0; i < len; ++i) a[i] = double(i % 7) - 3.0;
+
+	dense_col<double> r = ref_scan<cumsum_kernel<double> >(a, scandir::linear_());
+
+	dense_col<double> d = cumsum(par_(), a);
+	ASSERT_VEC_EQ( len, d, r );
+
+	d = cumsum(par_(1000), a);
+	ASSERT_VEC_EQ( len, d, r );
+
+	dense_matrix<double> am(101, 990);
+	for (index_t i = 0; i < am.nelems(); ++i) am[i] = double(i % 5);
+	ref_block<double> ab = am(range(0, 100), whole());
+
+	dense_matrix<double> rm = ref_scan<cumsum_kernel<double> >(ab, scandir::linear_());
+	dense_matrix<double> dm = cumsum(par_(777), ab);
+	ASSERT_MAT_EQ( 100, 990, dm, rm );
+}
+
+
+AUTO_TPACK( mat_scan )
+{
+	ADD_SIMPLE_CASE( tcumsum )
+	ADD_SIMPLE_CASE( tcumprod )
+	ADD_SIMPLE_CASE( tcummax )
+	ADD_SIMPLE_CASE( tcummin )
+
+	ADD_SIMPLE_CASE( tcolwise_cumsum )
+	ADD_SIMPLE_CASE( tcolwise_cumprod )
+	ADD_SIMPLE_CASE( tcolwise_cummax )
+	ADD_SIMPLE_CASE( tcolwise_cummin )
+
+	ADD_SIMPLE_CASE( trowwise_cumsum )
+	ADD_SIMPLE_CASE( trowwise_cumprod )
+	ADD_SIMPLE_CASE( trowwise_cummax )
+	ADD_SIMPLE_CASE( trowwise_cummin )
+
+	ADD_SIMPLE_CASE( tcumsum_f32 )
+	ADD_SIMPLE_CASE( tcummax_f32 )
+	ADD_SIMPLE_CASE( tcolwise_cumsum_f32 )
+	ADD_SIMPLE_CASE( tcolwise_cumprod_f32 )
+	ADD_SIMPLE_CASE( trowwise_cummin_f32 )
+
+	ADD_SIMPLE_CASE( tcumsum_int )
+}
+
+AUTO_TPACK( mat_scan_par )
+{
+	ADD_SIMPLE_CASE( tcumsum_par )
+	ADD_SIMPLE_CASE( tcummax_par )
+	ADD_SIMPLE_CASE( tcolwise_cumprod_par )
+	ADD_SIMPLE_CASE( trowwise_cumsum_par )
+	ADD_SIMPLE_CASE( tcumsum_par_long )
+}
@@ -189,6 +189,33 @@ MN_CASE( mat_colwise_inplace_sort )
 	ASSERT_TRUE( test_cw_sorted(a0, a, asc_()) );
 }
 
+MN_CASE( mat_colwise_par_sort )
+{
+	index_t m = M == 0 ? DM : M;
+	index_t n = N == 0 ? DN : N;
+
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	dense_matrix<double, M, N> a(m, n);
+	dense_matrix<double, M, N> a0(m, n, zero());
+
+	fill_ran(a);
+	copy(a, a0);
+	colwise_sort(par_(1), a, asc_());
+	ASSERT_TRUE( test_cw_sorted(a0, a, asc_()) );
+
+	fill_ran(a);
+	copy(a, a0);
+	colwise_sort(par_(2), a, desc_());
+	ASSERT_TRUE( test_cw_sorted(a0, a, desc_()) );
+
+	fill_ran(a);
+	copy(a, a0);
+	colwise_sort(par_(), a);
+	ASSERT_TRUE( test_cw_sorted(a0, a, asc_()) );
+}
+
 MN_CASE( mat_copy_sort )
 {
 	index_t m = M == 0 ? DM : M;
@@ -369,6 +396,11 @@ AUTO_TPACK( mat_colwise_inplace_sort )
 	ADD_MN_CASE_3X3( mat_colwise_inplace_sort, DM, DN )
 }
 
+AUTO_TPACK( mat_colwise_par_sort )
+{
+	ADD_MN_CASE_3X3( mat_colwise_par_sort, DM, DN )
+}
+
 AUTO_TPACK( mat_copy_sort )
 {
 	ADD_MN_CASE_3X3( mat_copy_sort, DM, DN )
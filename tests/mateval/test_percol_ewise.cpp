@@ -226,15 +226,25 @@ DEFINE_PERCOL_EWISE_SCALAR_TEST( grid, grid )
 
 DEFINE_PERCOL_EWISE_SIMD_TEST( sse, cont, cont )
 DEFINE_PERCOL_EWISE_SIMD_TEST( sse, cont, bloc )
+DEFINE_PERCOL_EWISE_SIMD_TEST( sse, cont, grid )
 DEFINE_PERCOL_EWISE_SIMD_TEST( sse, bloc, cont )
 DEFINE_PERCOL_EWISE_SIMD_TEST( sse, bloc, bloc )
+DEFINE_PERCOL_EWISE_SIMD_TEST( sse, bloc, grid )
+DEFINE_PERCOL_EWISE_SIMD_TEST( sse, grid, cont )
+DEFINE_PERCOL_EWISE_SIMD_TEST( sse, grid, bloc )
+DEFINE_PERCOL_EWISE_SIMD_TEST( sse, grid, grid )
 
 #ifdef LMAT_HAS_AVX
 
 DEFINE_PERCOL_EWISE_SIMD_TEST( avx, cont, cont )
 DEFINE_PERCOL_EWISE_SIMD_TEST( avx, cont, bloc )
+DEFINE_PERCOL_EWISE_SIMD_TEST( avx, cont, grid )
 DEFINE_PERCOL_EWISE_SIMD_TEST( avx, bloc, cont )
 DEFINE_PERCOL_EWISE_SIMD_TEST( avx, bloc, bloc )
+DEFINE_PERCOL_EWISE_SIMD_TEST( avx, bloc, grid )
+DEFINE_PERCOL_EWISE_SIMD_TEST( avx, grid, cont )
+DEFINE_PERCOL_EWISE_SIMD_TEST( avx, grid, bloc )
+DEFINE_PERCOL_EWISE_SIMD_TEST( avx, grid, grid )
 
 #endif
 
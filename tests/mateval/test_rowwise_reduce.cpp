@@ -113,6 +113,55 @@ DEFINE_ROWWISE_REDUCE_CASE_2( diff_sqsum )
 
 DEFINE_ROWWISE_REDUCE_CASE_2( dot )
 
+// tall matrices (reduced strip by strip)
+
+SIMPLE_CASE( trowwise_tall )
+{
+	const index_t blen = internal::rowwise_block_len<double>::value;
+	const index_t m = 3 * blen + 5;
+	const index_t n = 7;
+
+	dense_matrix<double> src(m + 3, n);
+	fill_rand(src);
+	auto a = src(range(1, m), whole());
+
+	dense_col<double> r_sum(m), r_max(m), r_min(m), r_sqsum(m);
+	for (index_t i = 0; i < m; ++i)
+	{
+		double s = 0, mx = a(i, 0), mn = a(i, 0), sq = 0;
+		for (index_t j = 0; j < n; ++j)
+		{
+			double v = a(i, j);
+			s += v;
+			sq += v * v;
+			if (v > mx) mx = v;
+			if (v < mn) mn = v;
+		}
+		r_sum[i] = s;
+		r_max[i] = mx;
+		r_min[i] = mn;
+		r_sqsum[i] = sq;
+	}
+
+	dense_col<double> d(m);
+
+	rowwise_sum(a, d);
+	ASSERT_VEC_APPROX(m, d, r_sum, 1.0e-12);
+
+	rowwise_mean(a, d);
+	for (index_t i = 0; i < m; ++i) r_sum[i] /= double(n);
+	ASSERT_VEC_APPROX(m, d, r_sum, 1.0e-12);
+
+	rowwise_maximum(a, d);
+	ASSERT_VEC_EQ(m, d, r_max);
+
+	rowwise_minimum(a, d);
+	ASSERT_VEC_EQ(m, d, r_min);
+
+	rowwise_sqsum(a, d);
+	ASSERT_VEC_APPROX(m, d, r_sqsum, 1.0e-12);
+}
+
 
 AUTO_TPACK( rowwise_reduce )
 {
@@ -132,6 +181,8 @@ AUTO_TPACK( rowwise_reduce )
 	ADD_SIMPLE_CASE( trowwise_diff_sqsum )
 
 	ADD_SIMPLE_CASE( trowwise_dot )
+
+	ADD_SIMPLE_CASE( trowwise_tall )
 }
 
 
@@ -0,0 +1,184 @@
+/**
+ * @file test_simd_dispatch.cpp
+ *
+ * @brief Unit testing of the run-time SIMD dispatch
+ *
+ * This is meant to be compiled without AVX, and with
+ * LMAT_ENABLE_SIMD_DISPATCH. Run it with LMAT_SIMD set to
+ * sse2 or avx to test each of the code paths.
+ *
+ * @author Dahua Lin
+ */
+
+#define LMAT_ENABLE_INSTRUMENTATION
+
+#include "../test_base.h"
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/matrix/matrix_transpose.h>
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/mateval/mat_reduce.h>
+
+#include <cstdlib>
+
+using namespace lmat;
+using namespace lmat::test;
+
+
+inline unsigned long long count_dispatched()
+{
+	return instrument::query(instrument::simd_path_, "dispatch.avx").count;
+}
+
+inline bool expect_dispatched()
+{
+#ifdef LMAT_DISPATCH_AVX
+	return runtime_simd_level() >= 7;
+#else
+	return false;
+#endif
+}
+
+
+SIMPLE_CASE( simd_level )
+{
+	ASSERT_EQ( internal::_parse_simd_level("sse2"), 2 );
+	ASSERT_EQ( internal::_parse_simd_level("sse4.2"), 6 );
+	ASSERT_EQ( internal::_parse_simd_level("avx"), 7 );
+	ASSERT_EQ( internal::_parse_simd_level("avx2"), 8 );
+	ASSERT_EQ( internal::_parse_simd_level("avx512"), 9 );
+	ASSERT_EQ( internal::_parse_simd_level("5"), 5 );
+	ASSERT_EQ( internal::_parse_simd_level("neon"), -1 );
+
+	const int detected = internal::_detect_simd_level();
+	ASSERT_TRUE( detected >= 2 );
+	ASSERT_TRUE( runtime_simd_level() <= detected );
+
+	if (!std::getenv("LMAT_SIMD"))
+	{
+		ASSERT_EQ( runtime_simd_level(), detected );
+	}
+
+	ASSERT_EQ( std::string(simd_level_name(8)), std::string("avx2") );
+}
+
+
+T_CASE( dispatch_ewise )
+{
+	const index_t m = 37;
+	const index_t n = 6;
+
+	dense_matrix<T> a(m, n), b(m, n), r(m, n), r0(m, n);
+	for (index_t i = 0; i < m * n; ++i)
+	{
+		a[i] = T(i + 1) * T(0.5);
+		b[i] = T(i % 7) - T(3);
+		r0[i] = a[i] * b[i] + a[i];
+	}
+
+	instrument::reset();
+
+	r = a * b + a;
+	ASSERT_MAT_EQ( m, n, r, r0 );
+	ASSERT_EQ( count_dispatched() > 0, expect_dispatched() );
+
+	// per-column
+
+	const index_t ldim = 40;
+	dense_matrix<T> as(ldim, n, zero()), bs(ldim, n, zero());
+	for (index_t j = 0; j < n; ++j)
+	{
+		for (index_t i = 0; i < m; ++i)
+		{
+			as(i, j) = a(i, j);
+			bs(i, j) = b(i, j);
+		}
+	}
+
+	ref_block<T> ab(as.ptr_data(), m, n, ldim);
+	ref_block<T> bb(bs.ptr_data(), m, n, ldim);
+
+	dense_matrix<T> rb(m, n);
+	rb = ab * bb + ab;
+	ASSERT_MAT_EQ( m, n, rb, r0 );
+
+	// static size
+
+	dense_matrix<T, 8, 2> sa(8, 2), sr(8, 2), sr0(8, 2);
+	for (index_t i = 0; i < 16; ++i)
+	{
+		sa[i] = T(i) - T(4);
+		sr0[i] = sa[i] * sa[i];
+	}
+
+	sr = sa * sa;
+	ASSERT_MAT_EQ( 8, 2, sr, sr0 );
+}
+
+
+T_CASE( dispatch_fold )
+{
+	const index_t m = 29;
+	const index_t n = 7;
+
+	dense_matrix<T> a(m, n);
+	T s0(0);
+	T mx0 = T(-1000);
+	for (index_t i = 0; i < m * n; ++i)
+	{
+		a[i] = T((i * 7) % 23) - T(11);
+		s0 += a[i];
+		if (a[i] > mx0) mx0 = a[i];
+	}
+
+	instrument::reset();
+
+	ASSERT_APPROX( sum(a), s0, T(1.0e-4) );
+	ASSERT_EQ( maximum(a), mx0 );
+	ASSERT_EQ( count_dispatched() > 0, expect_dispatched() );
+}
+
+
+T_CASE( dispatch_fill )
+{
+	const index_t m = 23;
+	const index_t n = 3;
+
+	instrument::reset();
+
+	dense_matrix<T> a(m, n);
+	fill(a, T(2.5));
+
+	for (index_t i = 0; i < m * n; ++i) ASSERT_EQ( a[i], T(2.5) );
+	ASSERT_EQ( count_dispatched() > 0, expect_dispatched() );
+}
+
+
+T_CASE( dispatch_transpose )
+{
+	const index_t m = 19;
+	const index_t n = 13;
+
+	dense_matrix<T> a(m, n);
+	for (index_t i = 0; i < m * n; ++i) a[i] = T(i + 1);
+
+	dense_matrix<T> r0(n, m);
+	for (index_t i = 0; i < m; ++i)
+		for (index_t j = 0; j < n; ++j) r0(j, i) = a(i, j);
+
+	instrument::reset();
+
+	dense_matrix<T> r(n, m);
+	transpose(a, r);
+	ASSERT_MAT_EQ( n, m, r, r0 );
+	ASSERT_EQ( count_dispatched() > 0, expect_dispatched() );
+}
+
+
+AUTO_TPACK( simd_dispatch )
+{
+	ADD_SIMPLE_CASE( simd_level )
+	ADD_T_CASE_FP( dispatch_ewise )
+	ADD_T_CASE_FP( dispatch_fold )
+	ADD_T_CASE_FP( dispatch_fill )
+	ADD_T_CASE_FP( dispatch_transpose )
+}
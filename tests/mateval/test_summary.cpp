@@ -0,0 +1,228 @@
+/**
+ * @file test_summary.cpp
+ *
+ * Test of single-pass summary statistics
+ *
+ * @author Dahua Lin
+ */
+
+#include "../test_base.h"
+#include <light_mat/matrix/matrix_classes.h>
+#include <light_mat/mateval/mat_reduce.h>
+#include <light_mat/mateval/mat_summary.h>
+#include <cstdlib>
+
+using namespace lmat;
+using namespace lmat::test;
+
+inline double randunif()
+{
+	double u = (double)std::rand() / double(RAND_MAX);
+	return u * 2.0 - 1.0;
+}
+
+template<class Mat, typename T>
+void fill_rand(IRegularMatrix<Mat, T>& mat)
+{
+	for (index_t j = 0; j < mat.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < mat.nrows(); ++i)
+		{
+			mat(i, j) = T(randunif());
+		}
+	}
+}
+
+// two-pass reference, in column-major order
+
+template<class Mat, typename T>
+summary<double> ref_summary(const IRegularMatrix<Mat, T>& a)
+{
+	summary<double> r;
+	const index_t n = a.nelems();
+	r.count = n;
+	r.sum = 0;
+	r.l1norm = 0;
+	r.l2norm = 0;
+	r.argmin = 0;
+	r.argmax = 0;
+	r.min_value = a(0, 0);
+	r.max_value = a(0, 0);
+
+	index_t k = 0;
+	for (index_t j = 0; j < a.ncolumns(); ++j)
+	{
+		for (index_t i = 0; i < a.nrows(); ++i, ++k)
+		{
+			double x = a(i, j);
+			r.sum += x;
+			r.l1norm += math::abs(x);
+			r.l2norm += x * x;
+			if (x < r.min_value) { r.min_value = x; r.argmin = k; }
+			if (x > r.max_value) { r.max_value = x; r.argmax = k; }
+		}
+	}
+
+	r.mean = r.sum / double(n);
+	r.l2norm = math::sqrt(r.l2norm);
+
+	double v = 0;
+	for (index_t j = 0; j < a.ncolumns(); ++j)
+		for (index_t i = 0; i < a.nrows(); ++i)
+			v += math::sqr(a(i, j) - r.mean);
+	r.var = n > 1 ? v / double(n - 1) : 0.0;
+
+	return r;
+}
+
+template<typename T>
+void check_summary(const summary<T>& s, const summary<double>& r, double tol)
+{
+	ASSERT_EQ( s.count, r.count );
+	ASSERT_APPROX( s.sum, r.sum, tol );
+	ASSERT_APPROX( s.mean, r.mean, tol );
+	ASSERT_APPROX( s.var, r.var, tol );
+	ASSERT_EQ( s.min_value, T(r.min_value) );
+	ASSERT_EQ( s.max_value, T(r.max_value) );
+	ASSERT_EQ( s.argmin, r.argmin );
+	ASSERT_EQ( s.argmax, r.argmax );
+	ASSERT_APPROX( s.l1norm, r.l1norm, tol );
+	ASSERT_APPROX( s.l2norm, r.l2norm, tol );
+}
+
+
+T_CASE( summary_dense )
+{
+	const index_t lens[] = {1, 2, 7, 32, 1000, 2048, 5003};
+	const double tol = sizeof(T) == 4 ? 1.0e-2 : 1.0e-9;
+
+	for (size_t t = 0; t < sizeof(lens) / sizeof(index_t); ++t)
+	{
+		index_t m = lens[t];
+
+		dense_matrix<T> a(m, 3);
+		fill_rand(a);
+
+		check_summary(summarize(a), ref_summary(a), tol);
+	}
+}
+
+
+T_CASE( summary_view )
+{
+	const index_t m = 2500;
+	const index_t n = 4;
+	const double tol = sizeof(T) == 4 ? 1.0e-2 : 1.0e-9;
+
+	dense_matrix<T> a0(m + 3, n);
+	fill_rand(a0);
+	auto a = a0(range(1, m), whole());
+
+	check_summary(summarize(a), ref_summary(a), tol);
+}
+
+
+T_CASE( summary_ties )
+{
+	const index_t len = 6001;
+
+	dense_col<T> a(len, fill(T(0)));
+	a[10] = T(-2);
+	a[3000] = T(-2);
+	a[100] = T(3);
+	a[4000] = T(3);
+	a[5999] = T(3);
+
+	summary<T> s = summarize(a);
+	ASSERT_EQ( s.argmin, 10 );
+	ASSERT_EQ( s.argmax, 100 );
+
+	// large offset, such that Welford matters
+
+	for (index_t i = 0; i < len; ++i) a[i] = T(1.0e4) + T(i % 2);
+
+	s = summarize(a);
+	ASSERT_APPROX( s.var, 0.25 * double(len) / double(len - 1), 1.0e-4 );
+	ASSERT_EQ( s.argmin, 0 );
+	ASSERT_EQ( s.argmax, 1 );
+}
+
+
+SIMPLE_CASE( summary_empty )
+{
+	dense_matrix<double> a(0, 3);
+
+	summary<double> s = summarize(a);
+	ASSERT_EQ( s.count, 0 );
+	ASSERT_EQ( s.sum, 0.0 );
+	ASSERT_EQ( s.argmin, -1 );
+	ASSERT_EQ( s.argmax, -1 );
+	ASSERT_TRUE( s.min_value > 0 );
+	ASSERT_TRUE( s.max_value < 0 );
+
+	dense_row<summary<double> > cs(3);
+	colwise_summarize(a, cs);
+	for (index_t j = 0; j < 3; ++j)
+	{
+		ASSERT_EQ( cs[j].count, 0 );
+		ASSERT_EQ( cs[j].argmax, -1 );
+	}
+}
+
+
+T_CASE( summary_colwise )
+{
+	const index_t m = 3001;
+	const index_t n = 5;
+	const double tol = sizeof(T) == 4 ? 1.0e-2 : 1.0e-9;
+
+	dense_matrix<T> a(m, n);
+	fill_rand(a);
+
+	dense_row<summary<T> > cs(n);
+	colwise_summarize(a, cs);
+
+	for (index_t j = 0; j < n; ++j)
+	{
+		check_summary(cs[j], ref_summary(a.column(j)), tol);
+	}
+}
+
+
+T_CASE( summary_with_kernel )
+{
+	const index_t m = 1027;
+	const index_t n = 3;
+	const double tol = sizeof(T) == 4 ? 1.0e-2 : 1.0e-9;
+
+	dense_matrix<T> a(m, n);
+	fill_rand(a);
+
+	T mx(0);
+	summary<T> s = summarize(a, maximum_kernel<T>(), mx);
+	check_summary(s, ref_summary(a), tol);
+	ASSERT_EQ( mx, maximum(a) );
+
+	// fused kernels through matrix_folder
+
+	auto r = fold(fuse(sum_kernel<T>(), minmax_kernel<T>()))(a.shape(), in_(a));
+	ASSERT_APPROX( r.first, sum(a), tol );
+	ASSERT_EQ( r.second.min_value, minimum(a) );
+	ASSERT_EQ( r.second.max_value, maximum(a) );
+}
+
+
+AUTO_TPACK( summary )
+{
+	ADD_T_CASE( summary_dense, float )
+	ADD_T_CASE( summary_dense, double )
+	ADD_T_CASE( summary_view, float )
+	ADD_T_CASE( summary_view, double )
+	ADD_T_CASE( summary_ties, float )
+	ADD_T_CASE( summary_ties, double )
+	ADD_SIMPLE_CASE( summary_empty )
+	ADD_T_CASE( summary_colwise, float )
+	ADD_T_CASE( summary_colwise, double )
+	ADD_T_CASE( summary_with_kernel, float )
+	ADD_T_CASE( summary_with_kernel, double )
+}
@@ -0,0 +1,71 @@
+/**
+ * @file counted_fun.h
+ *
+ * @brief Map functors that count their invocations (for testing)
+ *
+ * @author Dahua Lin
+ */
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIGHTMAT_COUNTED_FUN_H_
+#define LIGHTMAT_COUNTED_FUN_H_
+
+#include "../test_base.h"
+
+#include <light_mat/matexpr/map_expr.h>
+
+int counted_calls = 0;
+
+// counted_ is declared costly, while counted_cheap_ has the default cost
+
+struct counted_ { };
+struct counted_cheap_ { };
+
+template<typename T>
+struct counted_fun
+{
+	typedef T result_type;
+
+	LMAT_ENSURE_INLINE
+	T operator() (const T& x) const
+	{
+		++ counted_calls;
+		return x * x + x;
+	}
+};
+
+namespace lmat
+{
+	template<typename T>
+	struct fun_map<counted_, T>
+	{
+		typedef counted_fun<T> type;
+	};
+
+	template<typename T>
+	struct fun_map<counted_cheap_, T>
+	{
+		typedef counted_fun<T> type;
+	};
+
+	LMAT_DEF_SIMD_SUPPORT( counted_fun )
+
+	LMAT_DEF_FUN_COST( counted_, 100 )
+}
+
+template<typename T, class X>
+inline lmat::map_expr<counted_, X> counted(const lmat::IEWiseMatrix<X, T>& x)
+{
+	return lmat::make_map_expr(counted_(), x);
+}
+
+template<typename T, class X>
+inline lmat::map_expr<counted_cheap_, X> counted_cheap(const lmat::IEWiseMatrix<X, T>& x)
+{
+	return lmat::make_map_expr(counted_cheap_(), x);
+}
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file test_expr_plan.cpp
+ *
+ * Unit testing of the evaluation planning of map expressions
+ *
+ * @author Dahua Lin
+ */
+
+#include "counted_fun.h"
+
+#include <light_mat/matexpr/repvec_expr.h>
+#include <light_mat/matexpr/mat_arith.h>
+
+using namespace lmat;
+using namespace lmat::test;
+
+inline double cfun(double x)
+{
+	return x * x + x;
+}
+
+
+SIMPLE_CASE( plan_flags )
+{
+	typedef dense_matrix<double> mat_t;
+	typedef repcol_expr<mat_t, 0> rc_t;
+	typedef reprow_expr<mat_t, 0> rr_t;
+
+	typedef map_expr<counted_, rc_t> e1_t;
+	typedef map_expr<ftags::mul_, e1_t, mat_t> e2_t;
+	typedef map_expr<counted_cheap_, rc_t> e3_t;
+	typedef map_expr<ftags::add_, map_expr<counted_, rr_t>, e2_t> e4_t;
+
+	ASSERT_TRUE(( std::is_same<internal::plan_kind<e1_t>::type, internal::plan_repcol_>::value ));
+	ASSERT_TRUE(( std::is_same<internal::plan_kind<e2_t>::type, internal::plan_rewrite_>::value ));
+	ASSERT_TRUE(( std::is_same<internal::plan_kind<e3_t>::type, internal::plan_keep_>::value ));
+
+	ASSERT_TRUE( internal::plan_flags<e4_t>::mat_col );
+	ASSERT_TRUE( internal::plan_flags<e4_t>::mat_row );
+}
+
+
+SIMPLE_CASE( plan_repcol )
+{
+	const index_t m = 10;
+	const index_t n = 7;
+
+	dense_matrix<double> v(m, 1), a(m, n);
+	for (index_t i = 0; i < m; ++i) v[i] = double(i + 1);
+	for (index_t i = 0; i < m * n; ++i) a[i] = double(i % 3) + 0.5;
+
+	dense_matrix<double> r0(m, n);
+	for (index_t j = 0; j < n; ++j)
+		for (index_t i = 0; i < m; ++i)
+			r0(i, j) = cfun(v[i]) * 2.0 * a(i, j);
+
+	counted_calls = 0;
+	dense_matrix<double> r = counted(repcol(v, n)) * 2.0 * a;
+	ASSERT_TRUE( counted_calls <= m );
+	ASSERT_MAT_EQ( m, n, r, r0 );
+
+	// cheap functions are recomputed
+
+	counted_calls = 0;
+	r = counted_cheap(repcol(v, n)) * 2.0 * a;
+	ASSERT_TRUE( counted_calls > m );
+	ASSERT_MAT_EQ( m, n, r, r0 );
+
+	// no repetition
+
+	dense_matrix<double> r1 = counted(repcol(v, 1)) * 2.0 * a.column(0);
+	ASSERT_MAT_EQ( m, 1, r1, r0.column(0) );
+}
+
+
+SIMPLE_CASE( plan_reprow )
+{
+	const index_t m = 9;
+	const index_t n = 6;
+
+	dense_matrix<double> v(1, n), a(m, n);
+	for (index_t j = 0; j < n; ++j) v[j] = double(j) - 2.0;
+	for (index_t i = 0; i < m * n; ++i) a[i] = double(i % 4);
+
+	dense_matrix<double> r0(m, n);
+	for (index_t j = 0; j < n; ++j)
+		for (index_t i = 0; i < m; ++i)
+			r0(i, j) = cfun(v[j]) + a(i, j);
+
+	counted_calls = 0;
+	dense_matrix<double> r = counted(reprow(v, m)) + a;
+	ASSERT_TRUE( counted_calls <= n );
+	ASSERT_MAT_EQ( m, n, r, r0 );
+}
+
+
+SIMPLE_CASE( plan_mixed )
+{
+	const index_t m = 8;
+	const index_t n = 5;
+
+	dense_matrix<double> u(m, 1), v(1, n);
+	for (index_t i = 0; i < m; ++i) u[i] = double(i) * 0.5;
+	for (index_t j = 0; j < n; ++j) v[j] = double(j) + 1.0;
+
+	dense_matrix<double> r0(m, n);
+	for (index_t j = 0; j < n; ++j)
+		for (index_t i = 0; i < m; ++i)
+			r0(i, j) = cfun(u[i]) - cfun(v[j]);
+
+	counted_calls = 0;
+	dense_matrix<double> r = counted(repcol(u, n)) - counted(reprow(v, m));
+	ASSERT_TRUE( counted_calls <= m + n );
+	ASSERT_MAT_EQ( m, n, r, r0 );
+}
+
+
+AUTO_TPACK( expr_plan )
+{
+	ADD_SIMPLE_CASE( plan_flags )
+	ADD_SIMPLE_CASE( plan_repcol )
+	ADD_SIMPLE_CASE( plan_reprow )
+	ADD_SIMPLE_CASE( plan_mixed )
+}
@@ -53,30 +53,47 @@ bool my_use_linear(const map_expr<FTag, A, B>& expr, const Dst& dmat)
 }
 
 
+// non-contiguous operands are accessed with strided packs, which pays
+// off when the work per element (1 for sqr_ and sub_) is at least
+// LMAT_STRIDED_SIMD_COST per strided operand; otherwise only the
+// vector length matters: a length that is not a multiple of the pack
+// width is evaluated with a masked tail, unless it is shorter than a pack
+
+inline bool my_simd_len(int L, int pw)
+{
+	return L % pw == 0 || L > pw;
+}
+
+template<class A>
+inline int my_strided()
+{
+	return meta::is_contiguous<A>::value ||
+			(meta::is_percol_contiguous<A>::value && !meta::is_row<A>::value) ? 0 : 1;
+}
+
+inline bool my_strided_pays(int nstrided)
+{
+	return nstrided == 0 || 1 >= LMAT_STRIDED_SIMD_COST * nstrided;
+}
+
 template<class FTag, class A, class Dst>
 bool my_use_simd(const map_expr<FTag, A>& expr, const Dst& dmat)
 {
 	bool use_linear = my_use_linear(expr, dmat);
 
+	if (!my_strided_pays(my_strided<A>() + my_strided<Dst>())) return false;
+
 	int pw = simd_traits<double, default_simd_kind>::pack_width;
 
 	if (use_linear)
 	{
 		const int L = meta::nelems<A>::value;
-		const bool is_cont =
-				meta::is_contiguous<A>::value &&
-				meta::is_contiguous<Dst>::value;
-
-		return is_cont && (L % pw == 0);
+		return my_simd_len(L, pw);
 	}
 	else
 	{
 		const int M = meta::nrows<A>::value;
-		const bool is_cont_pc =
-				meta::is_percol_contiguous<A>::value &&
-				meta::is_percol_contiguous<Dst>::value;
-
-		return is_cont_pc && (M % pw == 0);
+		return my_simd_len(M, pw);
 	}
 }
 
@@ -85,27 +102,19 @@ bool my_use_simd(const map_expr<FTag, A, B>& expr, const Dst& dmat)
 {
 	bool use_linear = my_use_linear(expr, dmat);
 
+	if (!my_strided_pays(my_strided<A>() + my_strided<B>() + my_strided<Dst>())) return false;
+
 	int pw = simd_traits<double, default_simd_kind>::pack_width;
 
 	if (use_linear)
 	{
 		const int L = meta::common_nelems<A, B>::value;
-		const bool is_cont =
-				meta::is_contiguous<A>::value &&
-				meta::is_contiguous<B>::value &&
-				meta::is_contiguous<Dst>::value;
-
-		return is_cont && (L % pw == 0);
+		return my_simd_len(L, pw);
 	}
 	else
 	{
 		const int M = meta::common_nrows<A, B>::value;
-		const bool is_cont_pc =
-				meta::is_percol_contiguous<A>::value &&
-				meta::is_percol_contiguous<B>::value &&
-				meta::is_percol_contiguous<Dst>::value;
-
-		return is_cont_pc && (M % pw == 0);
+		return my_simd_len(M, pw);
 	}
 }
 
@@ -256,7 +256,7 @@ MN_CASE( mat_cond_m )
 	const int pw = simd_traits<double, default_simd_kind>::pack_width;
 	ASSERT_TRUE( use_linear_acc(policy) );
 
-	bool expect_use_simd = ((M * N) % pw == 0);
+	bool expect_use_simd = ((M * N) % pw == 0 || M * N > pw);
 	ASSERT_EQ( use_simd(policy), expect_use_simd );
 
 	mat_t R1 = cond(A == B, X, Y);
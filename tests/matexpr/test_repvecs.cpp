@@ -11,6 +11,7 @@
 
 #include <light_mat/matexpr/repvec_expr.h>
 #include <light_mat/matexpr/map_expr.h>
+#include <light_mat/matexpr/mat_arith.h>
 
 using namespace lmat;
 using namespace lmat::test;
@@ -146,4 +147,111 @@ TEST_REPROWS( grid, bloc, grid_to_blk )
 TEST_REPROWS( grid, grid, grid_to_grid )
 
 
+// short columns, evaluated in tiles
 
+const index_t tile_nrows[] = { 1, 2, 3, 4, 5, 7, 8, 9, 16, 17, 31, 32, 33 };
+const index_t tile_ncols[] = { 1, 2, 37, 300 };
+
+template<typename T>
+void test_repvec_tiles(index_t m, index_t n)
+{
+	dense_matrix<T> a(m + 2, n);
+	for (index_t i = 0; i < a.nelems(); ++i) a[i] = T(i % 11) - T(4);
+
+	ref_block<T> ab = a(range(0, m), whole());
+	dense_matrix<T> ac(ab);
+
+	dense_matrix<T> vm(m, 2);
+	dense_matrix<T> wm(2, n);
+	for (index_t i = 0; i < vm.nelems(); ++i) vm[i] = T(i + 1);
+	for (index_t i = 0; i < wm.nelems(); ++i) wm[i] = T(i % 5) + T(0.5);
+
+	dense_col<T> v(vm.column(0));
+	dense_row<T> w(wm.row(0));
+
+	dense_matrix<T> r_bias(m, n), r_scale(m, n), r_mixed(m, n), r_rc(m, n), r_rr(m, n);
+	for (index_t j = 0; j < n; ++j)
+	{
+		for (index_t i = 0; i < m; ++i)
+		{
+			r_bias(i, j) = ac(i, j) + v[i];
+			r_scale(i, j) = ac(i, j) * w[j];
+			r_mixed(i, j) = (v[i] - ac(i, j)) * w[j] + T(2);
+			r_rc(i, j) = v[i];
+			r_rr(i, j) = w[j];
+		}
+	}
+
+	dense_matrix<T> r = ac + repcol(v, n);
+	ASSERT_MAT_EQ( m, n, r, r_bias );
+
+	r = ac * reprow(w, m);
+	ASSERT_MAT_EQ( m, n, r, r_scale );
+
+	r = (repcol(v, n) - ac) * reprow(w, m) + T(2);
+	ASSERT_MAT_EQ( m, n, r, r_mixed );
+
+	r = repcol(v, n);
+	ASSERT_MAT_EQ( m, n, r, r_rc );
+
+	r = reprow(w, m);
+	ASSERT_MAT_EQ( m, n, r, r_rr );
+
+	// strided vectors
+
+	r = ac + repcol(vm(whole(), 1), n) - repcol(vm(whole(), 1), n) + repcol(v, n);
+	ASSERT_MAT_EQ( m, n, r, r_bias );
+
+	r = ac * reprow(wm(0, whole()), m);
+	ASSERT_MAT_EQ( m, n, r, r_scale );
+
+	// non-contiguous operands and destinations
+
+	r = ab + repcol(v, n);
+	ASSERT_MAT_EQ( m, n, r, r_bias );
+
+	dense_matrix<T> b(m + 1, n, zero());
+	ref_block<T> bb = b(range(0, m), whole());
+	bb = ac * reprow(w, m);
+	ASSERT_MAT_EQ( m, n, bb, r_scale );
+
+	bb = repcol(v, n);
+	ASSERT_MAT_EQ( m, n, bb, r_rc );
+
+	// in place
+
+	ac += repcol(v, n);
+	ASSERT_MAT_EQ( m, n, ac, r_bias );
+}
+
+SIMPLE_CASE( repvec_tiles )
+{
+	for (index_t u = 0; u < index_t(sizeof(tile_nrows) / sizeof(index_t)); ++u)
+	{
+		for (index_t v = 0; v < index_t(sizeof(tile_ncols) / sizeof(index_t)); ++v)
+		{
+			test_repvec_tiles<double>(tile_nrows[u], tile_ncols[v]);
+		}
+	}
+}
+
+SIMPLE_CASE( repvec_tiles_f32 )
+{
+	for (index_t u = 0; u < index_t(sizeof(tile_nrows) / sizeof(index_t)); ++u)
+	{
+		test_repvec_tiles<float>(tile_nrows[u], 300);
+	}
+}
+
+SIMPLE_CASE( repvec_tiles_int )
+{
+	test_repvec_tiles<int32_t>(3, 300);
+	test_repvec_tiles<int32_t>(8, 37);
+}
+
+AUTO_TPACK( repvec_tiles )
+{
+	ADD_SIMPLE_CASE( repvec_tiles )
+	ADD_SIMPLE_CASE( repvec_tiles_f32 )
+	ADD_SIMPLE_CASE( repvec_tiles_int )
+}
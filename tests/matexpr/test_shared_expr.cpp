@@ -0,0 +1,207 @@
+/**
+ * @file test_shared_expr.cpp
+ *
+ * Unit testing of shared sub-expressions
+ *
+ * @author Dahua Lin
+ */
+
+#include "counted_fun.h"
+
+#include <light_mat/matexpr/shared_expr.h>
+#include <light_mat/matexpr/mat_arith.h>
+#include <light_mat/matexpr/mat_emath.h>
+#include <light_mat/mateval/mat_reduce.h>
+#include <light_mat/common/exec.h>
+#include <vector>
+
+using namespace lmat;
+using namespace lmat::test;
+
+template<class XMat, class DMat>
+void test_shared_on(const XMat& x, const XMat& y, const XMat& z, DMat& r, DMat& r0)
+{
+	counted_calls = 0;
+	r0 = counted(x) * y + counted(x) * z;
+	const int c0 = counted_calls;
+
+	counted_calls = 0;
+	auto cx = shared_(counted(x));
+	r = cx * y + cx * z;
+	const int c1 = counted_calls;
+
+	ASSERT_EQ( c0, 2 * c1 );
+}
+
+
+SIMPLE_CASE( shared_linear )
+{
+	const index_t m = 13;
+	const index_t n = 6;
+
+	dense_matrix<double> x(m, n), y(m, n), z(m, n);
+	for (index_t i = 0; i < m * n; ++i)
+	{
+		x[i] = double(i + 1) * 0.1;
+		y[i] = double(i % 7);
+		z[i] = double(i % 5) - 2.0;
+	}
+
+	dense_matrix<double> r(m, n), r0(m, n);
+	test_shared_on(x, y, z, r, r0);
+
+	ASSERT_MAT_EQ( m, n, r, r0 );
+
+	// reused after the arguments are changed
+
+	auto cx = shared_(counted(x));
+	x[0] = 10.0;
+	r = cx * y + cx * z;
+	r0 = counted(x) * y + counted(x) * z;
+	ASSERT_MAT_EQ( m, n, r, r0 );
+}
+
+
+SIMPLE_CASE( shared_percol )
+{
+	const index_t m = 11;
+	const index_t n = 5;
+	const index_t ldim = 16;
+
+	dense_matrix<double> xs(ldim, n), ys(ldim, n), zs(ldim, n);
+	for (index_t i = 0; i < ldim * n; ++i)
+	{
+		xs[i] = double(i + 1) * 0.1;
+		ys[i] = double(i % 7);
+		zs[i] = double(i % 5) - 2.0;
+	}
+
+	cref_block<double> x(xs.ptr_data(), m, n, ldim);
+	cref_block<double> y(ys.ptr_data(), m, n, ldim);
+	cref_block<double> z(zs.ptr_data(), m, n, ldim);
+
+	dense_matrix<double> r(m, n), r0(m, n);
+	test_shared_on(x, y, z, r, r0);
+
+	ASSERT_MAT_EQ( m, n, r, r0 );
+}
+
+
+SIMPLE_CASE( shared_evaluate )
+{
+	const index_t m = 9;
+	const index_t n = 4;
+
+	dense_matrix<float> x(m, n);
+	for (index_t i = 0; i < m * n; ++i) x[i] = float(i) * 0.5f;
+
+	auto cx = shared_(counted(x));
+	ASSERT_EQ( cx.nrows(), m );
+	ASSERT_EQ( cx.ncolumns(), n );
+
+	dense_matrix<float> r = cx;
+	dense_matrix<float> r0 = counted(x);
+	ASSERT_MAT_EQ( m, n, r, r0 );
+}
+
+
+SIMPLE_CASE( shared_blocks )
+{
+	// spans multiple blocks, with distinct and nested shared expressions
+
+	const index_t m = 100;
+	const index_t n = 7;
+	const index_t len = m * n;
+
+	dense_matrix<double> x(m, n), y(m, n), z(m, n);
+	for (index_t i = 0; i < len; ++i)
+	{
+		x[i] = double(i % 13) * 0.1;
+		y[i] = double(i % 7);
+		z[i] = double(i % 5) - 2.0;
+	}
+
+	dense_matrix<double> r(m, n), r0(m, n);
+	test_shared_on(x, y, z, r, r0);
+	ASSERT_MAT_EQ( m, n, r, r0 );
+
+	auto cx = shared_(counted(x));
+	auto cy = shared_(counted(y));
+
+	counted_calls = 0;
+	r0 = counted(x) * counted(y) + counted(x) * z + counted(y);
+	int c0 = counted_calls;
+
+	counted_calls = 0;
+	r = cx * cy + cx * z + cy;
+	int c1 = counted_calls;
+
+	ASSERT_EQ( c0, 2 * c1 );
+	ASSERT_MAT_EQ( m, n, r, r0 );
+
+	auto sxy = cx + cy;
+	auto cc = shared_(counted(sxy));
+
+	counted_calls = 0;
+	r0 = counted(counted(x) + counted(y)) * counted(x) + counted(counted(x) + counted(y));
+	c0 = counted_calls;
+
+	counted_calls = 0;
+	r = cc * cx + cc;
+	c1 = counted_calls;
+
+	ASSERT_EQ( 3 * c0, 7 * c1 );
+	ASSERT_MAT_EQ( m, n, r, r0 );
+}
+
+
+SIMPLE_CASE( shared_concurrent )
+{
+	const index_t m = 300;
+	const index_t n = 9;
+	const index_t nr = 8;
+
+	dense_matrix<double> x(m, n), y(m, n), z(m, n);
+	for (index_t i = 0; i < m * n; ++i)
+	{
+		x[i] = double(i % 17) * 0.05;
+		y[i] = double(i % 7);
+		z[i] = double(i % 5) - 2.0;
+	}
+
+	auto ex = shared_(exp(x));
+
+	dense_matrix<double> r0 = exp(x) * y + exp(x) * z;
+	dense_row<double> s0(n);
+	colwise_sum(r0, s0);
+
+	exec::thread_pool pool(4);
+	exec::executor_scope xs(pool);
+
+	// the same expression evaluated from multiple threads at once
+
+	std::vector<dense_matrix<double> > rs(nr, dense_matrix<double>(m, n));
+	exec::parallel_for(range(0, nr), 1, [&](const range& g)
+	{
+		for (index_t k = g.begin_index(); k < g.end_index(); ++k) rs[k] = ex * y + ex * z;
+	});
+
+	for (index_t k = 0; k < nr; ++k)
+	{
+		ASSERT_MAT_APPROX( m, n, rs[k], r0, 1.0e-12 );
+	}
+
+	dense_row<double> s(n);
+	colwise_sum(par_(), ex * y + ex * z, s);
+	ASSERT_MAT_APPROX( 1, n, s, s0, 1.0e-9 );
+}
+
+
+AUTO_TPACK( shared_expr )
+{
+	ADD_SIMPLE_CASE( shared_linear )
+	ADD_SIMPLE_CASE( shared_percol )
+	ADD_SIMPLE_CASE( shared_evaluate )
+	ADD_SIMPLE_CASE( shared_blocks )
+	ADD_SIMPLE_CASE( shared_concurrent )
+}
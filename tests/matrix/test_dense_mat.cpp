@@ -9,6 +9,7 @@
 #include "../test_base.h"
 
 #include <light_mat/matrix/dense_matrix.h>
+#include <light_mat/common/arena_alloc.h>
 
 using namespace lmat;
 using namespace lmat::test;
@@ -19,6 +20,8 @@ template class lmat::dense_matrix<double, 0, 0>;
 template class lmat::dense_matrix<double, 0, 4>;
 template class lmat::dense_matrix<double, 3, 0>;
 template class lmat::dense_matrix<double, 3, 4>;
+template class lmat::dense_matrix<double, 0, 0, arena_allocator<double> >;
+template class lmat::dense_matrix<double, 0, 0, pool_allocator<double> >;
 
 static_assert(lmat::meta::is_mat_xpr<lmat::dense_matrix<double> >::value, "Interface verification failed.");
 static_assert(lmat::meta::is_regular_mat<lmat::dense_matrix<double> >::value, "Interface verification failed.");
@@ -413,6 +416,63 @@ MN_CASE( dense_mat_swap )
 }
 
 
+SIMPLE_CASE( dense_mat_with_arena )
+{
+	typedef dense_matrix<double, 0, 0, arena_allocator<double> > amat_t;
+
+	const index_t m = 3;
+	const index_t n = 4;
+
+	dblock<double> s(m * n);
+	for (index_t i = 0; i < m * n; ++i) s[i] = double(i + 2);
+
+	memory_arena arena;
+
+	{
+		arena_scope sc(arena);
+
+		amat_t a(m, n, copy_from(s.ptr_data()));
+		ASSERT_TRUE( arena.used_bytes() >= size_t(m * n) * sizeof(double) );
+		ASSERT_VEC_EQ( m * n, a, s );
+
+		amat_t b(a);
+		ASSERT_NE( b.ptr_data(), a.ptr_data() );
+		ASSERT_VEC_EQ( m * n, b, s );
+
+		amat_t c(std::move(b));
+		ASSERT_EQ( b.ptr_data(), 0 );
+		ASSERT_VEC_EQ( m * n, c, s );
+
+		c.require_size(n, m);
+		ASSERT_EQ( c.nrows(), n );
+		ASSERT_EQ( c.ncolumns(), m );
+	}
+
+	ASSERT_EQ( arena.used_bytes(), 0 );
+}
+
+SIMPLE_CASE( dense_mat_with_pool )
+{
+	typedef dense_matrix<double, 0, 0, pool_allocator<double> > pmat_t;
+
+	const index_t m = 3;
+	const index_t n = 4;
+
+	memory_pool pool;
+	pool_scope sc(pool);
+
+	const double *p0 = 0;
+	{
+		pmat_t a(m, n, fill(1.0));
+		p0 = a.ptr_data();
+	}
+
+	pmat_t b(m, n, fill(2.0));
+	ASSERT_EQ( b.ptr_data(), p0 );
+	ASSERT_EQ( b(m-1, n-1), 2.0 );
+}
+
+
 AUTO_TPACK( dense_mat_constructs )
 {
 	ADD_MN_CASE_3X3( dense_mat_constructs, 3, 4 )
@@ -464,3 +524,9 @@ AUTO_TPACK( dense_mat_swap )
 	ADD_MN_CASE_3X3( dense_mat_swap, 3, 4 )
 }
 
+AUTO_TPACK( dense_mat_alloc )
+{
+	ADD_SIMPLE_CASE( dense_mat_with_arena )
+	ADD_SIMPLE_CASE( dense_mat_with_pool )
+}
+
@@ -67,6 +67,54 @@ void test_direct_trans()
 }
 
 
+// larger sizes, such that the tiled (in-register) transposition is used
+
+template<typename T>
+void test_tiled_trans(index_t m, index_t n)
+{
+	const index_t ldim = m + 3;
+
+	dense_matrix<T> sbuf(ldim, n);
+	for (index_t i = 0; i < ldim * n; ++i) sbuf[i] = T(i + 1);
+
+	dense_matrix<T> rmat(n, m);
+	for (index_t i = 0; i < m; ++i)
+	{
+		for (index_t j = 0; j < n; ++j) rmat(j, i) = sbuf(i, j);
+	}
+
+	// contiguous --> contiguous
+
+	dense_matrix<T> smat = cref_block<T>(sbuf.ptr_data(), m, n, ldim);
+	dense_matrix<T> dmat(n, m, zero());
+
+	transpose(smat, dmat);
+	ASSERT_MAT_EQ(n, m, dmat, rmat);
+
+	// block --> block
+
+	const index_t dldim = n + 5;
+	dense_matrix<T> dbuf(dldim, m, zero());
+	ref_block<T> dblk(dbuf.ptr_data(), n, m, dldim);
+
+	transpose(cref_block<T>(sbuf.ptr_data(), m, n, ldim), dblk);
+	ASSERT_MAT_EQ(n, m, dblk, rmat);
+}
+
+T_CASE( direct_trans_tiled )
+{
+	test_tiled_trans<T>(37, 21);
+	test_tiled_trans<T>(21, 37);
+	test_tiled_trans<T>(16, 8);
+	test_tiled_trans<T>(3, 19);
+}
+
+AUTO_TPACK( direct_trans_tiled )
+{
+	ADD_T_CASE_FP( direct_trans_tiled )
+}
+
+
 #define TEST_DIRECT_TRANS( sform, dform, name ) \
 	MN_CASE( direct_trans_##name ) \
 	{ test_direct_trans<sform, dform, M, N>(); } \
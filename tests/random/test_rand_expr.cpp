@@ -29,7 +29,7 @@ inline void check_policy(const rand_expr<Distr, RStream, M, N>& expr)
 
 	const unsigned int L = (unsigned int)(M * N);
 	const unsigned int W = simd_traits<T, default_simd_kind>::pack_width;
-	bool expect_usimd = is_simdizable<Distr, default_simd_kind>::value && (L % W == 0);
+	bool expect_usimd = is_simdizable<Distr, default_simd_kind>::value && (L % W == 0 || L > W);
 
 	ref_matrix<T> _dmat(0, expr.nrows(), expr.ncolumns());
 	auto policy = get_preferred_expr_macc_policy(expr, _dmat);
@@ -214,3 +214,54 @@ AUTO_TPACK( test_randg )
 
 
 
+
+// randi (uniform integers, filled in batches)
+
+template<class Mat>
+void check_randi(const Mat& R, index_t m, index_t n, int32_t a, int32_t b)
+{
+	dense_col<double> expect_p(b - a + 1);
+	dense_col<double> actual_p(b - a + 1, zero());
+
+	for (index_t k = 0; k <= b - a; ++k) expect_p[k] = 1.0 / double(b - a + 1);
+
+	for (index_t j = 0; j < n; ++j)
+	{
+		for (index_t i = 0; i < m; ++i)
+		{
+			int32_t x = R(i, j);
+			ASSERT_TRUE( x >= a && x <= b );
+			actual_p[x - a] += 1.0 / double(m * n);
+		}
+	}
+
+	ASSERT_VEC_APPROX( b - a + 1, actual_p, expect_p, 5.0 / std::sqrt(double(m * n)) );
+}
+
+SIMPLE_CASE( test_randi )
+{
+	const index_t m = 301;
+	const index_t n = 203;
+	uniform_int_distr<int32_t> distr(-3, 3);
+
+	dense_matrix<int32_t> R = rand_mat(distr, rstream, m, n);
+	check_randi(R, m, n, -3, 3);
+
+	dense_matrix<int32_t> B(m + 2, n);
+	ref_block<int32_t> Bb = B(range(1, m + 1), whole());
+	Bb = rand_mat(distr, rstream, m, n);
+	check_randi(Bb, m, n, -3, 3);
+
+	dense_matrix<int32_t> S(n, m);
+	ref_block<int32_t, 1, 0> Sr = S.row(2);
+	Sr = rand_mat(distr, rstream, 1, m);
+	check_randi(Sr, 1, m, -3, 3);
+
+	dense_matrix<uint32_t> U = rand_mat(std_uniform_int_distr<uint32_t>(9), rstream, m, n);
+	for (index_t i = 0; i < U.nelems(); ++i) ASSERT_TRUE( U[i] <= 9 );
+}
+
+AUTO_TPACK( test_randi )
+{
+	ADD_SIMPLE_CASE( test_randi )
+}
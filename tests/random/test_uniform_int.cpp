@@ -8,6 +8,8 @@
 
 #include "distr_test_base.h"
 #include <light_mat/random/uniform_int_distr.h>
+#include <limits>
+#include <cmath>
 
 default_rand_stream rstream;
 const index_t N = 200000;
@@ -22,7 +24,7 @@ T_CASE( test_std_uniform_int )
 
 	ASSERT_EQ( distr.a(), 0 );
 	ASSERT_EQ( distr.b(), b );
-	ASSERT_EQ( distr.span(), s );
+	ASSERT_EQ( distr.span(), (typename std::make_unsigned<T>::type)(s) );
 	ASSERT_EQ( distr.mean(), double(b) / 2 );
 	ASSERT_EQ( distr.var(),  double((s * s - 1)) / 12 );
 
@@ -40,7 +42,7 @@ T_CASE( test_uniform_int )
 
 	ASSERT_EQ( distr.a(), a );
 	ASSERT_EQ( distr.b(), b );
-	ASSERT_EQ( distr.span(), s );
+	ASSERT_EQ( distr.span(), (typename std::make_unsigned<T>::type)(s) );
 	ASSERT_EQ( distr.mean(), double(a + b) / 2 );
 	ASSERT_EQ( distr.var(),  double((s * s - 1)) / 12 );
 
@@ -48,6 +50,115 @@ T_CASE( test_uniform_int )
 	test_discrete_rng(distr, rstream, N, b+1, ptol);
 }
 
+// with a span of 3 * 2^(w-2), x % span would draw [0, 2^(w-2)) twice as often
+
+T_CASE( test_uniform_int_unbiased )
+{
+	typedef typename std::make_unsigned<T>::type UT;
+	const UT q = UT(1) << (sizeof(T) * 8 - 2);
+
+	std_uniform_int_distr<UT> distr(UT(3) * q - 1);
+
+	index_t c = 0;
+	for (index_t i = 0; i < N; ++i)
+	{
+		UT x = distr(rstream);
+		ASSERT_TRUE( x <= distr.b() );
+		if (x < q) ++c;
+	}
+
+	ASSERT_APPROX( double(c) / double(N), 1.0 / 3, get_p_tol(N) );
+}
+
+T_CASE( test_uniform_int_fullrange )
+{
+	typedef typename std::make_unsigned<T>::type UT;
+	const double w = std::ldexp(1.0, int(sizeof(T) * 8));
+
+	uniform_int_distr<T> distr(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+	ASSERT_EQ( distr.span(), UT(0) );
+	ASSERT_EQ( distr.p(T(0)), 1.0 / w );
+	ASSERT_EQ( distr.var(), (w * w - 1.0) / 12 );
+
+	std_uniform_int_distr<T> sdistr(std::numeric_limits<T>::max());
+	ASSERT_EQ( sdistr.b(), std::numeric_limits<T>::max() );
+	ASSERT_EQ( sdistr.p(std::numeric_limits<T>::max()), 1.0 / (double(std::numeric_limits<T>::max()) + 1.0) );
+	ASSERT_TRUE( sdistr.var() > 0.0 );
+
+	index_t c = 0;
+	for (index_t i = 0; i < N; ++i)
+	{
+		if (distr(rstream) < T(std::numeric_limits<T>::min() / 2 + std::numeric_limits<T>::max() / 2)) ++c;
+	}
+
+	ASSERT_APPROX( double(c) / double(N), 0.5, get_p_tol(N) );
+}
+
+template<class Distr>
+struct batch_distr  // draws from the batch generator one by one
+{
+	typedef typename Distr::result_type result_type;
+	typedef typename simdize_map<Distr, sse_t>::type batch_gen_t;
+
+	const Distr& distr;
+	batch_gen_t gen;
+	mutable result_type buf[4];
+	mutable int i;
+
+	batch_distr(const Distr& d)
+	: distr(d), gen(simdize_map<Distr, sse_t>::get(d)), i(4) { }
+
+	double p(result_type x) const { return distr.p(x); }
+
+	template<class RStream>
+	result_type operator() (RStream& rs) const
+	{
+		if (i == 4) { gen(rs, buf); i = 0; }
+		return buf[i++];
+	}
+};
+
+T_CASE( test_uniform_int_batch )
+{
+	ASSERT_TRUE( is_batch_simdizable<uniform_int_distr<T> >::value );
+
+	std_uniform_int_distr<T> d0(6);
+	test_discrete_rng(batch_distr<std_uniform_int_distr<T> >(d0), rstream, N, 7, get_p_tol(N));
+
+	uniform_int_distr<T> d1(2, 6);
+	test_discrete_rng(batch_distr<uniform_int_distr<T> >(d1), rstream, N, 7, get_p_tol(N));
+
+	// nearly the whole range, where lanes are often rejected
+
+	typedef typename std::make_unsigned<T>::type UT;
+	const UT q = UT(1) << 30;
+
+	uniform_int_distr<T> d2(T(0), T(UT(3) * q - 1));
+	batch_distr<uniform_int_distr<T> > bd2(d2);
+
+	index_t c = 0;
+	for (index_t i = 0; i < N; ++i)
+	{
+		if (UT(bd2(rstream)) < q) ++c;
+	}
+	ASSERT_APPROX( double(c) / double(N), 1.0 / 3, get_p_tol(N) );
+}
+
+AUTO_TPACK( test_uniform_int_unbiased )
+{
+	ADD_T_CASE( test_uniform_int_unbiased, uint32_t )
+	ADD_T_CASE( test_uniform_int_unbiased, uint64_t )
+	ADD_T_CASE( test_uniform_int_fullrange, int32_t )
+	ADD_T_CASE( test_uniform_int_fullrange, uint8_t )
+	ADD_T_CASE( test_uniform_int_fullrange, int64_t )
+}
+
+AUTO_TPACK( test_uniform_int_batch )
+{
+	ADD_T_CASE( test_uniform_int_batch, uint32_t )
+	ADD_T_CASE( test_uniform_int_batch, int32_t )
+}
+
 AUTO_TPACK( test_uniform_int )
 {
 	ADD_T_CASE( test_std_uniform_int, uint32_t )
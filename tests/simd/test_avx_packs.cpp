@@ -159,6 +159,37 @@ T_CASE( avx_pack_stores )
 }
 
 
+T_CASE( avx_pack_strided )
+{
+	typedef simd_pack<T, avx_t> pack_t;
+	const unsigned int width = pack_t::pack_width;
+
+	// interleaved triples, as in RGB data
+
+	const index_t step = 3;
+	const unsigned int len = width * step;
+
+	T src[len];
+	for (unsigned i = 0; i < len; ++i) src[i] = T(1.5 + i);
+
+	T r[width];
+	for (unsigned i = 0; i < width; ++i) r[i] = src[i * step + 1];
+
+	pack_t pk;
+	pk.load_strided(src + 1, step);
+	ASSERT_SIMD_EQ(pk, r);
+
+	T dst[len];
+	for (unsigned i = 0; i < len; ++i) dst[i] = T(0);
+	pk.store_strided(dst + 2, step);
+
+	T rd[len];
+	for (unsigned i = 0; i < len; ++i) rd[i] = T(0);
+	for (unsigned i = 0; i < width; ++i) rd[i * step + 2] = r[i];
+	ASSERT_VEC_EQ(len, dst, rd);
+}
+
+
 TI_CASE( avx_pack_load_parts )
 {
 	typedef simd_pack<T, avx_t> pack_t;
@@ -202,6 +233,56 @@ TI_CASE( avx_pack_store_parts )
 	ASSERT_VEC_EQ( width, dst, r );
 }
 
+T_CASE( avx_pack_load_parts_dyn )
+{
+	typedef simd_pack<T, avx_t> pack_t;
+	const unsigned int width = pack_t::pack_width;
+
+	LMAT_ALIGN_AVX T src_base[width + 1];
+	T *src = src_base + 1;
+	for (unsigned i = 0; i < width; ++i) src[i] = T(2.4 + i);
+
+	for (index_t n = 1; n <= (index_t)width; ++n)
+	{
+		pack_t pk;
+		pk.load_part(n, src);
+
+		T r[width];
+		for (unsigned i = 0; i < width; ++i) r[i] = T(0);
+		for (index_t i = 0; i < n; ++i) r[i] = src[i];
+
+		ASSERT_SIMD_EQ( pk, r );
+	}
+}
+
+T_CASE( avx_pack_store_parts_dyn )
+{
+	typedef simd_pack<T, avx_t> pack_t;
+	const unsigned int width = pack_t::pack_width;
+
+	LMAT_ALIGN_AVX T src[width];
+	for (unsigned i = 0; i < width; ++i) src[i] = T(2.4 + i);
+
+	pack_t pk;
+	pk.load_a(src);
+
+	T v = T(2.3);
+
+	for (index_t n = 1; n <= (index_t)width; ++n)
+	{
+		T r[width];
+		for (unsigned i = 0; i < width; ++i) r[i] = v;
+		for (index_t i = 0; i < n; ++i) r[i] = src[i];
+
+		LMAT_ALIGN_AVX T dst_base[width + 1];
+		T *dst = dst_base + 1;
+		for (unsigned i = 0; i < width; ++i) dst[i] = v;
+
+		pk.store_part(n, dst);
+		ASSERT_VEC_EQ( width, dst, r );
+	}
+}
+
 T_CASE( avx_pack_to_scalar )
 {
 	typedef simd_pack<T, avx_t> pack_t;
@@ -256,6 +337,7 @@ AUTO_TPACK( avx_basics )
 	ADD_T_CASE_FP( avx_pack_sets )
 	ADD_T_CASE_FP( avx_pack_loads )
 	ADD_T_CASE_FP( avx_pack_stores )
+	ADD_T_CASE_FP( avx_pack_strided )
 }
 
 AUTO_TPACK( avx_parts )
@@ -287,6 +369,9 @@ AUTO_TPACK( avx_parts )
 	ADD_TI_CASE( avx_pack_store_parts, double, 2 )
 	ADD_TI_CASE( avx_pack_store_parts, double, 3 )
 	ADD_TI_CASE( avx_pack_store_parts, double, 4 )
+
+	ADD_T_CASE_FP( avx_pack_load_parts_dyn )
+	ADD_T_CASE_FP( avx_pack_store_parts_dyn )
 }
 
 AUTO_TPACK( avx_elems )
@@ -159,6 +159,37 @@ T_CASE( sse_pack_stores )
 }
 
 
+T_CASE( sse_pack_strided )
+{
+	typedef simd_pack<T, sse_t> pack_t;
+	const unsigned int width = pack_t::pack_width;
+
+	// interleaved triples, as in RGB data
+
+	const index_t step = 3;
+	const unsigned int len = width * step;
+
+	T src[len];
+	for (unsigned i = 0; i < len; ++i) src[i] = T(1.5 + i);
+
+	T r[width];
+	for (unsigned i = 0; i < width; ++i) r[i] = src[i * step + 1];
+
+	pack_t pk;
+	pk.load_strided(src + 1, step);
+	ASSERT_SIMD_EQ(pk, r);
+
+	T dst[len];
+	for (unsigned i = 0; i < len; ++i) dst[i] = T(0);
+	pk.store_strided(dst + 2, step);
+
+	T rd[len];
+	for (unsigned i = 0; i < len; ++i) rd[i] = T(0);
+	for (unsigned i = 0; i < width; ++i) rd[i * step + 2] = r[i];
+	ASSERT_VEC_EQ(len, dst, rd);
+}
+
+
 TI_CASE( sse_pack_load_parts )
 {
 	typedef simd_pack<T, sse_t> pack_t;
@@ -202,6 +233,56 @@ TI_CASE( sse_pack_store_parts )
 	ASSERT_VEC_EQ( width, dst, r );
 }
 
+T_CASE( sse_pack_load_parts_dyn )
+{
+	typedef simd_pack<T, sse_t> pack_t;
+	const unsigned int width = pack_t::pack_width;
+
+	LMAT_ALIGN_SSE T src_base[width + 1];
+	T *src = src_base + 1;
+	for (unsigned i = 0; i < width; ++i) src[i] = T(2.4 + i);
+
+	for (index_t n = 1; n <= (index_t)width; ++n)
+	{
+		pack_t pk;
+		pk.load_part(n, src);
+
+		T r[width];
+		for (unsigned i = 0; i < width; ++i) r[i] = T(0);
+		for (index_t i = 0; i < n; ++i) r[i] = src[i];
+
+		ASSERT_SIMD_EQ( pk, r );
+	}
+}
+
+T_CASE( sse_pack_store_parts_dyn )
+{
+	typedef simd_pack<T, sse_t> pack_t;
+	const unsigned int width = pack_t::pack_width;
+
+	LMAT_ALIGN_SSE T src[width];
+	for (unsigned i = 0; i < width; ++i) src[i] = T(2.4 + i);
+
+	pack_t pk;
+	pk.load_a(src);
+
+	T v = T(2.3);
+
+	for (index_t n = 1; n <= (index_t)width; ++n)
+	{
+		T r[width];
+		for (unsigned i = 0; i < width; ++i) r[i] = v;
+		for (index_t i = 0; i < n; ++i) r[i] = src[i];
+
+		LMAT_ALIGN_SSE T dst_base[width + 1];
+		T *dst = dst_base + 1;
+		for (unsigned i = 0; i < width; ++i) dst[i] = v;
+
+		pk.store_part(n, dst);
+		ASSERT_VEC_EQ( width, dst, r );
+	}
+}
+
 T_CASE( sse_pack_to_scalar )
 {
 	typedef simd_pack<T, sse_t> pack_t;
@@ -257,6 +338,7 @@ AUTO_TPACK( sse_basics )
 	ADD_T_CASE_FP( sse_pack_sets )
 	ADD_T_CASE_FP( sse_pack_loads )
 	ADD_T_CASE_FP( sse_pack_stores )
+	ADD_T_CASE_FP( sse_pack_strided )
 }
 
 AUTO_TPACK( sse_parts )
@@ -276,6 +358,9 @@ AUTO_TPACK( sse_parts )
 
 	ADD_TI_CASE( sse_pack_store_parts, double, 1 )
 	ADD_TI_CASE( sse_pack_store_parts, double, 2 )
+
+	ADD_T_CASE_FP( sse_pack_load_parts_dyn )
+	ADD_T_CASE_FP( sse_pack_store_parts_dyn )
 }
 
 AUTO_TPACK( sse_elems )